@@ -13,6 +13,10 @@ struct evpl_bind;
 
 struct iovec;
 
+/*
+ * Timestamps are kernel timestamps in nanoseconds since the epoch, or zero
+ * when timestamping is off or the protocol cannot provide them.
+ */
 struct evpl_notify {
     unsigned int notify_type;
     int          notify_status;
@@ -22,19 +26,42 @@ struct evpl_notify {
             unsigned int         niov;
             unsigned int         length;
             struct evpl_address *addr;
+            uint64_t             timestamp;
         } recv_msg;
+        struct {
+            uint64_t timestamp;   /* of the latest data read */
+        } recv_data;
         struct {
             unsigned long bytes;
             unsigned long msgs;
+            uint64_t      timestamp;
         } sent;
+        struct {
+            int fd;
+        } recv_fd;
     };
 };
 
-#define EVPL_NOTIFY_CONNECTED    1
-#define EVPL_NOTIFY_DISCONNECTED 2
-#define EVPL_NOTIFY_RECV_DATA    3
-#define EVPL_NOTIFY_RECV_MSG     4
-#define EVPL_NOTIFY_SENT         5
+#define EVPL_NOTIFY_CONNECTED      1
+#define EVPL_NOTIFY_DISCONNECTED   2
+#define EVPL_NOTIFY_RECV_DATA      3
+#define EVPL_NOTIFY_RECV_MSG       4
+#define EVPL_NOTIFY_SENT           5
+#define EVPL_NOTIFY_SEND_BLOCKED   6
+#define EVPL_NOTIFY_WRITABLE       7
+
+/*
+ * A transmit timestamp, reported after the matching EVPL_NOTIFY_SENT.
+ * sent.bytes on streams, or sent.msgs on datagram binds, counts everything
+ * sent on the bind up to and including what the timestamp applies to.
+ */
+#define EVPL_NOTIFY_SENT_TIMESTAMP 8
+
+/*
+ * A descriptor passed by the peer of a unix socket bind, reported ahead
+ * of the data it was sent with.  recv_fd.fd now belongs to the application.
+ */
+#define EVPL_NOTIFY_RECV_FD        9
 
 typedef void (*evpl_notify_callback_t)(
     struct evpl        *evpl,
@@ -101,6 +128,29 @@ void evpl_bind_request_send_notifications(
     struct evpl      *evpl,
     struct evpl_bind *bind);
 
+/*
+ * Deliver EVPL_NOTIFY_SEND_BLOCKED from within the send call that brings
+ * the bytes queued on the bind to 'high' or more, then EVPL_NOTIFY_WRITABLE
+ * once the transport has drained them to 'low' or less.  A high watermark
+ * of zero disables both notifications.
+ */
+void evpl_bind_set_send_watermarks(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    uint64_t          high,
+    uint64_t          low);
+
+/*
+ * Stop reading from a stream bind without a segment callback while 'max'
+ * or more received bytes wait to be consumed, so a slow consumer pushes
+ * back on the peer rather than into memory.  Reading resumes once the
+ * application consumes below the cap.  Zero disables the cap.
+ */
+void evpl_bind_set_recv_max(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    uint64_t          max);
+
 void evpl_send(
     struct evpl      *evpl,
     struct evpl_bind *bind,
@@ -144,6 +194,32 @@ void evpl_sendtoepv(
     int                   nbufvecs,
     int                   length);
 
+/*
+ * Queue 'length' bytes of the file open on 'fd', starting at 'offset', to
+ * be sent on a stream bind after everything queued ahead of it.  Protocols
+ * that support it send the range straight from the page cache, others
+ * read it into buffers here.  The descriptor is duplicated if needed, so
+ * the caller may close it as soon as this returns.
+ */
+void evpl_sendfile(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    int               fd,
+    uint64_t          offset,
+    uint64_t          length);
+
+/*
+ * Pass a copy of 'fd' to the peer of a unix socket bind, with the next
+ * data written to the socket, so it arrives no later than the data queued
+ * after this call.  Nothing is passed until some data is sent.  The caller
+ * may close 'fd' as soon as this returns.  Returns 0, ENOTSUP if the bind
+ * cannot pass descriptors, or ENOBUFS if too many are already waiting.
+ */
+int evpl_send_fd(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    int               fd);
+
 int evpl_peek(
     struct evpl      *evpl,
     struct evpl_bind *bind,
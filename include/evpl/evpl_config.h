@@ -13,6 +13,20 @@
 struct evpl_global_config;
 struct evpl_thread_config;
 
+/*
+ * Page backing for allocator slabs.  Hugetlb backings fall back
+ * to the next smaller page size, then to transparent huge pages,
+ * then to regular pages if the requested pages are unavailable.
+ */
+
+enum evpl_slab_backing {
+    EVPL_SLAB_BACKING_DEFAULT     = 0,
+    EVPL_SLAB_BACKING_THP         = 1,
+    EVPL_SLAB_BACKING_HUGETLB     = 2,
+    EVPL_SLAB_BACKING_HUGETLB_2MB = 3,
+    EVPL_SLAB_BACKING_HUGETLB_1GB = 4,
+};
+
 struct evpl_global_config *
 evpl_global_config_init(
     void);
@@ -20,6 +34,10 @@ evpl_global_config_init(
 void evpl_global_config_release(
     struct evpl_global_config *config);
 
+void evpl_global_config_set_max_pending(
+    struct evpl_global_config *config,
+    unsigned int               max_pending);
+
 void evpl_global_config_set_max_datagram_size(
     struct evpl_global_config *config,
     unsigned int               size);
@@ -28,6 +46,122 @@ void evpl_global_config_set_huge_pages(
     struct evpl_global_config *config,
     int                        huge_pages);
 
+void evpl_global_config_set_slab_backing(
+    struct evpl_global_config *config,
+    enum evpl_slab_backing     backing);
+
+void evpl_global_config_set_slab_prefault(
+    struct evpl_global_config *config,
+    int                        prefault);
+
+void evpl_global_config_set_long_lived_buffer_size(
+    struct evpl_global_config *config,
+    unsigned int               size);
+
+void evpl_global_config_set_compact_max_length(
+    struct evpl_global_config *config,
+    unsigned int               length);
+
+/*
+ * Defaults for evpl_bind_set_send_watermarks() and evpl_bind_set_recv_max()
+ * applied to every new bind.  Both are disabled by default.
+ */
+void evpl_global_config_set_send_watermarks(
+    struct evpl_global_config *config,
+    uint64_t                   high,
+    uint64_t                   low);
+
+void evpl_global_config_set_recv_max(
+    struct evpl_global_config *config,
+    uint64_t                   max);
+
+/*
+ * Stream sends no longer than this are copied into a per-bind buffer and
+ * appended to the previous small send, so bursts of small writes reach the
+ * transport as a few large segments.  Larger sends are queued by reference
+ * as before.  Zero disables coalescing.
+ */
+void evpl_global_config_set_send_coalesce_max(
+    struct evpl_global_config *config,
+    unsigned int               length);
+
+/*
+ * Age after which a resolved host name is refreshed in the background.
+ * The cached address keeps being used until the refresh completes.
+ */
+void evpl_global_config_set_resolve_timeout_ms(
+    struct evpl_global_config *config,
+    unsigned int               timeout_ms);
+
+/*
+ * Send large TCP writes with MSG_ZEROCOPY, holding buffer references until
+ * the kernel reports completion.  Writes smaller than the minimum length
+ * are copied as usual.
+ */
+void evpl_global_config_set_socket_zerocopy(
+    struct evpl_global_config *config,
+    int                        zerocopy);
+
+void evpl_global_config_set_socket_zerocopy_min(
+    struct evpl_global_config *config,
+    unsigned int               length);
+
+/*
+ * Coalesce runs of equal sized UDP datagrams to the same destination into
+ * a single UDP_SEGMENT send, and accept UDP_GRO coalesced receives, which
+ * are split back into individual datagrams.  Both are enabled by default
+ * and turned off per socket when the kernel does not support them.
+ */
+void evpl_global_config_set_socket_udp_gso(
+    struct evpl_global_config *config,
+    int                        enable);
+
+void evpl_global_config_set_socket_udp_gro(
+    struct evpl_global_config *config,
+    int                        enable);
+
+#define EVPL_TIMESTAMP_RX       0x01
+#define EVPL_TIMESTAMP_TX       0x02
+#define EVPL_TIMESTAMP_HARDWARE 0x04
+
+/*
+ * Ask the kernel for SO_TIMESTAMPING timestamps on socket protocol binds.
+ * Receive timestamps are reported with EVPL_NOTIFY_RECV_DATA and
+ * EVPL_NOTIFY_RECV_MSG, transmit timestamps with EVPL_NOTIFY_SENT_TIMESTAMP.
+ * With EVPL_TIMESTAMP_HARDWARE, NIC timestamps are preferred where the
+ * device has been configured to take them.  Off by default.
+ */
+void evpl_global_config_set_socket_timestamping(
+    struct evpl_global_config *config,
+    unsigned int               flags);
+
+/*
+ * On TCP binds with a segment callback, raise SO_RCVLOWAT to the rest of a
+ * partly received message so it completes in a single wakeup.  Enabled by
+ * default.
+ */
+void evpl_global_config_set_socket_tcp_rcvlowat(
+    struct evpl_global_config *config,
+    int                        enable);
+
+/*
+ * Let unix socket binds pass descriptors with evpl_send_fd() and report
+ * those received with EVPL_NOTIFY_RECV_FD.  Receiving them takes a
+ * recvmsg() per read rather than a readv(), so it is off by default.
+ */
+void evpl_global_config_set_socket_unix_pass_fds(
+    struct evpl_global_config *config,
+    int                        enable);
+
+/*
+ * Bytes of shared memory each side of a DATAGRAM_SHM or STREAM_SHM
+ * connection sends through, rounded down to a power of two number of
+ * 64KB chunks.  Defaults to 16MB.
+ */
+void evpl_global_config_set_shm_segment_size(
+    struct evpl_global_config *config,
+    uint64_t                   size);
+
 void evpl_global_config_set_rdmacm_tos(
     struct evpl_global_config *config,
     uint8_t                    tos);
@@ -46,3 +180,11 @@ evpl_thread_config_init(
 
 void evpl_thread_config_release(
     struct evpl_thread_config *config);
+
+void evpl_thread_config_set_spin_ns(
+    struct evpl_thread_config *config,
+    unsigned int               spin_ns);
+
+void evpl_thread_config_set_wait_ms(
+    struct evpl_thread_config *config,
+    int                        wait_ms);
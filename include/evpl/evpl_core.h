@@ -9,21 +9,37 @@
 #endif /* ifndef EVPL_INCLUDED */
 
 enum evpl_framework_id {
-    EVPL_FRAMEWORK_RDMACM   = 0,
-    EVPL_FRAMEWORK_XLIO     = 1,
-    EVPL_FRAMEWORK_IO_URING = 2,
-    EVPL_FRAMEWORK_VFIO     = 3,
-    EVPL_NUM_FRAMEWORK      = 4
+    EVPL_FRAMEWORK_RDMACM    = 0,
+    EVPL_FRAMEWORK_XLIO      = 1,
+    EVPL_FRAMEWORK_IO_URING  = 2,
+    EVPL_FRAMEWORK_VFIO      = 3,
+    EVPL_FRAMEWORK_XDP       = 4,
+    EVPL_FRAMEWORK_LIBFABRIC = 5,
+    EVPL_FRAMEWORK_SHM       = 6,
+    EVPL_FRAMEWORK_LOOPBACK  = 7,
+    EVPL_NUM_FRAMEWORK       = 8
 };
 
 enum evpl_protocol_id {
-    EVPL_DATAGRAM_SOCKET_UDP = 0,
-    EVPL_DATAGRAM_RDMACM_RC  = 1,
-    EVPL_DATAGRAM_RDMACM_UD  = 2,
-    EVPL_STREAM_SOCKET_TCP   = 3,
-    EVPL_STREAM_XLIO_TCP     = 4,
-    EVPL_STREAM_RDMACM_RC    = 5,
-    EVPL_NUM_PROTO           = 6
+    EVPL_DATAGRAM_SOCKET_UDP    = 0,
+    EVPL_DATAGRAM_RDMACM_RC     = 1,
+    EVPL_DATAGRAM_RDMACM_UD     = 2,
+    EVPL_STREAM_SOCKET_TCP      = 3,
+    EVPL_STREAM_XLIO_TCP        = 4,
+    EVPL_STREAM_RDMACM_RC       = 5,
+    EVPL_STREAM_IO_URING_TCP    = 6,
+    EVPL_DATAGRAM_IO_URING_UDP  = 7,
+    EVPL_DATAGRAM_XDP_UDP       = 8,
+    EVPL_DATAGRAM_LIBFABRIC_RDM = 9,
+    EVPL_DATAGRAM_LIBFABRIC_MSG = 10,
+    EVPL_STREAM_LIBFABRIC_MSG   = 11,
+    EVPL_DATAGRAM_SHM           = 12,
+    EVPL_STREAM_SHM             = 13,
+    EVPL_DATAGRAM_SOCKET_UNIX   = 14,
+    EVPL_STREAM_SOCKET_UNIX     = 15,
+    EVPL_DATAGRAM_LOOPBACK      = 16,
+    EVPL_STREAM_LOOPBACK        = 17,
+    EVPL_NUM_PROTO              = 18
 };
 
 enum evpl_block_protocol_id {
@@ -72,6 +72,9 @@ void evpl_event_mark_error(
     struct evpl       *evpl,
     struct evpl_event *event);
 
+void evpl_event_clear_error(
+    struct evpl_event *event);
+
 void evpl_accept(
     struct evpl      *evpl,
     struct evpl_bind *bind,
@@ -155,3 +158,8 @@ evpl_defer(
 
 
 
+
+void
+evpl_remove_deferral(
+    struct evpl          *evpl,
+    struct evpl_deferral *deferral);
@@ -9,6 +9,12 @@
 #endif
 
 struct evpl_buffer;
+struct evpl_memory;
+
+typedef void (*evpl_memory_release_callback_t)(
+    void    *ptr,
+    uint64_t length,
+    void    *private_data);
 
 struct evpl_iovec
 {
@@ -18,6 +24,37 @@ struct evpl_iovec
     void            *private; /* for internal use by livbevpl only */
 };
 
+/*
+ * Hint for how long the caller expects to hold an allocation.
+ * Long lived allocations are carved from a separate arena of
+ * small buffers so that they do not pin large receive/send buffers.
+ */
+
+enum evpl_iovec_lifetime {
+    EVPL_IOVEC_LIFETIME_SHORT = 0,
+    EVPL_IOVEC_LIFETIME_LONG  = 1,
+};
+
+/*
+ * References are counted per buffer, not per byte, so the bytes still
+ * live in a buffer are not known.  Buffers are carved from front to back
+ * and only reused once every reference is gone, so 'allocated' is a high
+ * water mark.  Once it reaches 'pinned' nothing more will be carved, and
+ * the buffer is kept resident by its remaining 'refs' alone.
+ */
+
+struct evpl_iovec_usage {
+    unsigned long pinned;    /* bytes kept resident by the backing buffer */
+    unsigned long allocated; /* bytes carved from it since it was last reused */
+    unsigned int  refs;      /* outstanding references to the backing buffer */
+};
+
+struct evpl_slab_usage {
+    unsigned long          size;       /* bytes in the slab */
+    enum evpl_slab_backing backing;    /* page backing actually obtained */
+    int                    prefaulted; /* pages were faulted in up front */
+};
+
 int evpl_iovec_alloc(
     struct evpl *evpl,
     unsigned int length,
@@ -25,6 +62,26 @@ int evpl_iovec_alloc(
     unsigned int max_iovecs,
     struct evpl_iovec *r_iovec);
 
+int evpl_iovec_alloc_lifetime(
+    struct evpl *evpl,
+    unsigned int length,
+    unsigned int alignment,
+    unsigned int max_iovecs,
+    enum evpl_iovec_lifetime lifetime,
+    struct evpl_iovec *r_iovec);
+
+/*
+ * Allocate a single contiguous iovec of 'length' bytes from a
+ * power-of-two block of registered memory, for transfers larger
+ * than a buffer.  Returns 1 on success or 0 if 'length' exceeds
+ * the largest block a slab can hold.
+ */
+
+int evpl_iovec_alloc_contiguous(
+    struct evpl *evpl,
+    unsigned int length,
+    struct evpl_iovec *r_iovec);
+
 int evpl_iovec_reserve(
     struct evpl *evpl,
     unsigned int length,
@@ -53,6 +110,106 @@ evpl_iovec_length(
 void evpl_iovec_addref(
     struct evpl_iovec *iovec);
 
+/*
+ * Replace small iovecs that pin large buffers with copies
+ * in the long lived arena. Returns the number of iovecs replaced.
+ */
+
+int evpl_iovec_compact(
+    struct evpl *evpl,
+    struct evpl_iovec *iovecs,
+    int niovs);
+
+void evpl_iovec_usage(
+    const struct evpl_iovec *iovec,
+    struct evpl_iovec_usage *usage);
+
 void *
 evpl_slab_alloc(
-    void);
\ No newline at end of file
+    void);
+
+/*
+ * Fill up to 'max_usage' entries describing the slabs allocated so far.
+ * Returns the total number of slabs, which may exceed 'max_usage'.
+ */
+
+int evpl_slab_usage(
+    struct evpl_slab_usage *usage,
+    int max_usage);
+
+/*
+ * Register application owned memory, such as an mmap'd file or a
+ * cache arena, with every framework so that it can be sent without
+ * copying.  Registrations may not overlap.  'release_cb' is called once
+ * the memory has been unregistered and every iovec referencing it has
+ * been released.  Returns NULL if the range cannot be registered.
+ */
+
+struct evpl_memory *
+evpl_memory_register(
+    void *ptr,
+    uint64_t length,
+    evpl_memory_release_callback_t release_cb,
+    void *private_data);
+
+void evpl_memory_unregister(
+    struct evpl_memory *memory);
+
+/*
+ * Wrap 'length' bytes at 'ptr' within registered memory as an iovec.
+ * Returns 1 on success or 0 if the range is not registered.
+ */
+
+int evpl_memory_iovec(
+    const void *ptr,
+    unsigned int length,
+    struct evpl_iovec *r_iovec);
+
+/*
+ * Memory accounting.  Internal allocations are tagged by what they
+ * are for and counted per thread; buffer statistics are gathered from
+ * the allocators when a snapshot is taken.
+ */
+
+enum evpl_memory_tag {
+    EVPL_MEMORY_TAG_CORE = 0,  /* evpl instances and event arrays */
+    EVPL_MEMORY_TAG_BIND = 1,  /* binds and their protocol private state */
+    EVPL_MEMORY_TAG_RING = 2,  /* bind send, receive and datagram rings */
+    EVPL_MEMORY_TAG_RPC2 = 3,  /* rpc2 servers, connections and dbufs */
+    EVPL_MEMORY_TAG_HTTP = 4,  /* http servers, requests and headers */
+    EVPL_MEMORY_TAG_MAX  = 5
+};
+
+struct evpl_memory_tag_usage {
+    int64_t  bytes;  /* bytes currently allocated */
+    uint64_t allocs; /* allocations made */
+    uint64_t frees;  /* allocations freed */
+};
+
+struct evpl_memory_snapshot {
+    struct evpl_memory_tag_usage tags[EVPL_MEMORY_TAG_MAX];
+    uint64_t                     slabs;            /* slabs allocated */
+    uint64_t                     slab_bytes;       /* bytes in all slabs */
+    uint64_t                     free_buffers;     /* buffers on free lists */
+    uint64_t                     used_buffers;     /* buffers held by references */
+    uint64_t                     pinned_bytes;     /* bytes held by references */
+    uint64_t                     registered_bytes; /* application memory registered */
+};
+
+typedef void (*evpl_memory_thread_callback_t)(
+    unsigned long                       thread_id,
+    const struct evpl_memory_tag_usage *tags,
+    void                               *private_data);
+
+void evpl_memory_snapshot(
+    struct evpl_memory_snapshot *snapshot);
+
+/*
+ * Report the tagged allocation counters of each live thread.  Memory
+ * freed on a different thread than it was allocated on makes the
+ * per-thread byte counts net rather than absolute.
+ */
+
+void evpl_memory_snapshot_threads(
+    evpl_memory_thread_callback_t callback,
+    void *private_data);
@@ -8,35 +8,71 @@
 #include "core/buffer.h"
 #include "core/iovec_ring.h"
 #include "core/dgram_ring.h"
+#include "core/endpoint.h"
 #include "evpl/evpl.h"
 
 #define EVPL_MAX_PRIVATE         4096
 
+/* Minimum interval between sweeps releasing idle bind rings */
+#define EVPL_BIND_TRIM_NS        NS_PER_S
+
+/* Size of the chunks small stream sends are coalesced into */
+#define EVPL_BIND_COALESCE_SIZE  4096
+
 #define EVPL_BIND_PENDING_CLOSED 0x01
 #define EVPL_BIND_CLOSED         0x02
 #define EVPL_BIND_FINISH         0x04
 #define EVPL_BIND_SENT_NOTIFY    0x08
+#define EVPL_BIND_SEND_BLOCKED   0x10
+#define EVPL_BIND_RECV_PAUSED    0x20
+#define EVPL_BIND_RESOLVING      0x40
+
+/*
+ * A file range queued by evpl_sendfile on a protocol that sends it from
+ * the file itself.  The range goes out once the 'gap' iovec bytes queued
+ * ahead of it have been written.
+ */
+struct evpl_sendfile {
+    int                   fd;
+    uint64_t              offset;
+    uint64_t              length;
+    uint64_t              gap;
+    struct evpl_sendfile *next;
+};
 
 struct evpl_bind {
-    struct evpl_protocol   *protocol;
-    uint64_t                flags;
-    struct evpl_deferral    flush_deferral;
-    struct evpl_deferral    close_deferral;
-    evpl_notify_callback_t  notify_callback;
-    evpl_segment_callback_t segment_callback;   /* only for dgram-on-stream */
-    evpl_accept_callback_t  accept_callback;   /* only for listeners */
-    void                   *private_data;
+    struct evpl_protocol     *protocol;
+    uint64_t                  flags;
+    struct evpl_deferral      flush_deferral;
+    struct evpl_deferral      close_deferral;
+    evpl_notify_callback_t    notify_callback;
+    evpl_segment_callback_t   segment_callback;   /* only for dgram-on-stream */
+    evpl_accept_callback_t    accept_callback;   /* only for listeners */
+    void                     *private_data;
+
+    struct evpl_bind         *prev;
+    struct evpl_bind         *next;
+
+    struct evpl_iovec_ring    iovec_send;
+    struct evpl_iovec_ring    iovec_recv;
+
+    struct evpl_dgram_ring    dgram_send;
+
+    /* unused tail of the chunk small sends are copied into */
+    struct evpl_iovec         coalesce;
 
-    struct evpl_bind       *prev;
-    struct evpl_bind       *next;
+    struct evpl_sendfile     *sendfile;     /* pending file ranges, in order */
+    uint64_t                  sendfile_gap; /* sum of their gaps */
 
-    struct evpl_iovec_ring  iovec_send;
-    struct evpl_iovec_ring  iovec_recv;
+    uint64_t                  send_high;   /* 0 if send watermarks are off */
+    uint64_t                  send_low;
+    uint64_t                  recv_max;    /* 0 if receive is never paused */
 
-    struct evpl_dgram_ring  dgram_send;
+    struct evpl_address      *local;
+    struct evpl_address      *remote;
 
-    struct evpl_address    *local;
-    struct evpl_address    *remote;
+    /* connect waiting on the resolver, while EVPL_BIND_RESOLVING */
+    struct evpl_resolve_wait  resolve;
     /* protocol specific private data follows */
 };
 
@@ -56,3 +92,118 @@ evpl_bind_destroy(
 #define evpl_bind_private(bind) ((void *) ((bind) + 1))
 #define evpl_private2bind(ptr)  (((struct evpl_bind *) (ptr)) - 1)
 
+static inline void
+evpl_bind_coalesce_release(struct evpl_bind *bind)
+{
+    if (bind->coalesce.private) {
+        evpl_iovec_decref(&bind->coalesce);
+        bind->coalesce.private = NULL;
+        bind->coalesce.length  = 0;
+    }
+} // evpl_bind_coalesce_release
+
+void
+evpl_bind_sendfile_done(
+    struct evpl      *evpl,
+    struct evpl_bind *bind);
+
+/* True iff there is nothing left to write on the bind */
+static inline int
+evpl_bind_send_empty(const struct evpl_bind *bind)
+{
+    return evpl_iovec_ring_is_empty(&bind->iovec_send) && !bind->sendfile;
+} // evpl_bind_send_empty
+
+/*
+ * Returns how many queued iovec bytes may be written before the next
+ * file range must be sent, or UINT64_MAX if no file range is pending
+ */
+static inline uint64_t
+evpl_bind_sendfile_limit(const struct evpl_bind *bind)
+{
+    return bind->sendfile ? bind->sendfile->gap : UINT64_MAX;
+} // evpl_bind_sendfile_limit
+
+/* Called after writing 'length' iovec bytes ahead of any file range */
+static inline void
+evpl_bind_sendfile_advance(
+    struct evpl_bind *bind,
+    uint64_t          length)
+{
+    if (bind->sendfile) {
+        bind->sendfile->gap -= length;
+        bind->sendfile_gap  -= length;
+    }
+} // evpl_bind_sendfile_advance
+
+void
+evpl_bind_send_blocked(
+    struct evpl      *evpl,
+    struct evpl_bind *bind);
+
+void
+evpl_bind_sent_notify(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    uint64_t          bytes,
+    uint64_t          msgs);
+
+void
+evpl_bind_recv_resume(
+    struct evpl      *evpl,
+    struct evpl_bind *bind);
+
+/* Called after queueing a send to apply the high watermark */
+static inline void
+evpl_bind_check_send_high(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    if (unlikely(bind->send_high &&
+                 bind->iovec_send.length >= bind->send_high &&
+                 !(bind->flags & EVPL_BIND_SEND_BLOCKED))) {
+        evpl_bind_send_blocked(evpl, bind);
+    }
+} // evpl_bind_check_send_high
+
+/*
+ * Called by protocols as sends complete, to deliver EVPL_NOTIFY_SENT when
+ * requested and EVPL_NOTIFY_WRITABLE when the low watermark is reached
+ */
+static inline void
+evpl_bind_sent(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    uint64_t          bytes,
+    uint64_t          msgs)
+{
+    if (bind->flags & (EVPL_BIND_SENT_NOTIFY | EVPL_BIND_SEND_BLOCKED)) {
+        evpl_bind_sent_notify(evpl, bind, bytes, msgs);
+    }
+} // evpl_bind_sent
+
+/*
+ * True iff a stream bind holds as much unconsumed data as it may buffer,
+ * in which case the protocol should stop reading and set RECV_PAUSED.
+ * Binds with a segment callback consume whole messages as they arrive
+ * and are never paused.
+ */
+static inline int
+evpl_bind_recv_full(const struct evpl_bind *bind)
+{
+    return bind->recv_max && !bind->segment_callback &&
+           bind->iovec_recv.length >= bind->recv_max;
+} // evpl_bind_recv_full
+
+/* Called after the application consumes received data */
+static inline void
+evpl_bind_recv_consumed(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    if (unlikely(bind->flags & EVPL_BIND_RECV_PAUSED) &&
+        !evpl_bind_recv_full(bind)) {
+        evpl_bind_recv_resume(evpl, bind);
+    }
+} // evpl_bind_recv_consumed
+
@@ -6,6 +6,9 @@
 #include <pthread.h>
 #include <sys/mman.h>
 #include <linux/memfd.h>
+#include <linux/mman.h>
+#include <stdio.h>
+#include <limits.h>
 #include <unistd.h>
 
 #include "uthash/utlist.h"
@@ -19,14 +22,74 @@
 
 extern struct evpl_shared *evpl_shared;
 
+#define EVPL_SLAB_HUGE_2MB (2UL * 1024 * 1024)
+#define EVPL_SLAB_HUGE_1GB (1024UL * 1024 * 1024)
+
+__thread struct evpl_buffer_owner *evpl_buffer_owner_self
+__attribute__((tls_model("initial-exec")));
+
+/*
+ * Register a slab with every framework that has been initialized.
+ * Frameworks may be asked to register the same slab again when they
+ * are initialized later, in which case they receive their previous
+ * registration in framework_private.
+ */
+
+static void
+evpl_slab_register(struct evpl_slab *slab)
+{
+    struct evpl_framework *framework;
+    int                    i;
+
+    for (i = 0; i < EVPL_NUM_FRAMEWORK; ++i) {
+
+        framework = evpl_shared->framework[i];
+
+        if (!framework || !framework->register_memory ||
+            !evpl_shared->framework_private[i]) {
+            continue;
+        }
+
+        slab->framework_private[i] = framework->register_memory(
+            slab->data, slab->size,
+            slab->framework_private[i],
+            evpl_shared->framework_private[i]);
+    }
+} /* evpl_slab_register */
+
+static void
+evpl_slab_unregister(struct evpl_slab *slab)
+{
+    struct evpl_framework *framework;
+    int                    i;
+
+    for (i = 0; i < EVPL_NUM_FRAMEWORK; ++i) {
+
+        framework = evpl_shared->framework[i];
+
+        if (!framework || !framework->unregister_memory ||
+            !evpl_shared->framework_private[i]) {
+            continue;
+        }
+
+        framework->unregister_memory(
+            slab->framework_private[i],
+            evpl_shared->framework_private[i]);
+    }
+} /* evpl_slab_unregister */
+
 struct evpl_allocator *
-evpl_allocator_create()
+evpl_allocator_create(
+    uint64_t     slab_size,
+    unsigned int buffer_size)
 {
     struct evpl_allocator *allocator = evpl_zalloc(sizeof(*allocator));
 
     pthread_mutex_init(&allocator->lock, NULL);
 
-    allocator->hugepages = evpl_shared->config->huge_pages;
+    allocator->slab_size   = slab_size;
+    allocator->buffer_size = buffer_size;
+    allocator->backing     = evpl_shared->config->slab_backing;
 
     return allocator;
 
@@ -35,10 +98,8 @@ evpl_allocator_create()
 void
 evpl_allocator_destroy(struct evpl_allocator *allocator)
 {
-    struct evpl_slab      *slab;
-    struct evpl_buffer    *buffer;
-    struct evpl_framework *framework;
-    int                    i;
+    struct evpl_slab   *slab;
+    struct evpl_buffer *buffer;
 
     while (allocator->free_buffers) {
         buffer = allocator->free_buffers;
@@ -56,25 +117,16 @@ evpl_allocator_destroy(struct evpl_allocator *allocator)
 
         LL_DELETE(allocator->slabs, slab);
 
-        for (i = 0; i < EVPL_NUM_FRAMEWORK; ++i) {
-
-            framework = evpl_shared->framework[i];
-
-            if (!framework || !framework->unregister_memory ||
-                !evpl_shared->framework_private[i]) {
-                continue;
-            }
-
-            framework->unregister_memory(
-                slab->framework_private[i],
-                evpl_shared->framework_private[i]);
-
+        if (slab->buddy_free) {
+            evpl_free(slab->buddy_free);
         }
 
-        if (slab->hugepages) {
-            munmap(slab->data, evpl_shared->config->slab_size);
-        } else {
+        evpl_slab_unregister(slab);
+
+        if (slab->backing == EVPL_SLAB_BACKING_DEFAULT) {
             evpl_free(slab->data);
+        } else {
+            munmap(slab->data, slab->size);
         }
         evpl_free(slab);
     }
@@ -83,58 +135,193 @@ evpl_allocator_destroy(struct evpl_allocator *allocator)
     evpl_free(allocator);
 } /* evpl_allocator_destroy */
 
-static struct evpl_slab *
-evpl_allocator_create_slab(struct evpl_allocator *allocator)
+static const char *
+evpl_slab_backing_name(enum evpl_slab_backing backing)
 {
-    struct evpl_slab      *slab;
-    struct evpl_framework *framework;
-    int                    i;
+    switch (backing) {
+        case EVPL_SLAB_BACKING_THP:
+            return "transparent huge pages";
+        case EVPL_SLAB_BACKING_HUGETLB:
+            return "hugetlb pages";
+        case EVPL_SLAB_BACKING_HUGETLB_2MB:
+            return "2MB hugetlb pages";
+        case EVPL_SLAB_BACKING_HUGETLB_1GB:
+            return "1GB hugetlb pages";
+        default:
+            return "regular pages";
+    } /* switch */
+} /* evpl_slab_backing_name */
+
+static int
+evpl_slab_thp_enabled(void)
+{
+    char  mode[128];
+    FILE *fp;
+    int   enabled = 0;
 
-    slab            = evpl_zalloc(sizeof(*slab));
-    slab->size      = evpl_shared->config->slab_size;
-    slab->allocator = allocator;
+    fp = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
 
- again:
+    if (!fp) {
+        return 0;
+    }
 
-    if (allocator->hugepages) {
+    if (fgets(mode, sizeof(mode), fp)) {
+        enabled = !strstr(mode, "[never]");
+    }
 
-        slab->data = mmap(NULL, evpl_shared->config->slab_size,
-                          PROT_READ | PROT_WRITE,
-                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
-                          -1, 0);
+    fclose(fp);
 
-        if (slab->data == MAP_FAILED) {
-            evpl_core_info("Could not allocate huge pages, disabling...");
-            allocator->hugepages = 0;
-            goto again;
-        }
+    return enabled;
+} /* evpl_slab_thp_enabled */
 
-        *(uint64_t *) slab->data = 0;
+static void *
+evpl_slab_map_hugetlb(
+    uint64_t size,
+    int      flags,
+    uint64_t page_size,
+    int      prefault)
+{
+    void *data;
 
-        slab->hugepages = 1;
-    } else {
+    if (size & (page_size - 1)) {
+        return NULL;
+    }
 
-        slab->data = evpl_valloc(evpl_shared->config->slab_size,
-                                 evpl_shared->config->page_size);
+    if (prefault) {
+        flags |= MAP_POPULATE;
+    }
+
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | flags, -1, 0);
 
+    if (data == MAP_FAILED) {
+        return NULL;
     }
 
-    for (i = 0; i < EVPL_NUM_FRAMEWORK; ++i) {
+    /* Hugetlb reservations can still fail at fault time, find out now */
+    *(uint64_t *) data = 0;
 
-        framework = evpl_shared->framework[i];
+    return data;
+} /* evpl_slab_map_hugetlb */
 
-        if (!framework || !framework->register_memory ||
-            !evpl_shared->framework_private[i]) {
-            continue;
-        }
+/*
+ * Transparent huge pages are only used for 2MB aligned ranges,
+ * so over-map by a huge page and trim the unaligned ends.
+ */
 
-        slab->framework_private[i] = framework->register_memory(
-            slab->data, slab->size,
-            slab->framework_private[i],
-            evpl_shared->framework_private[i]);
+static void *
+evpl_slab_map_thp(uint64_t size)
+{
+    void     *data;
+    uintptr_t start, aligned, end;
 
+    data = mmap(NULL, size + EVPL_SLAB_HUGE_2MB, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (data == MAP_FAILED) {
+        return NULL;
     }
 
+    start   = (uintptr_t) data;
+    aligned = (start + EVPL_SLAB_HUGE_2MB - 1) & ~(EVPL_SLAB_HUGE_2MB - 1);
+    end     = start + size + EVPL_SLAB_HUGE_2MB;
+
+    if (aligned > start) {
+        munmap(data, aligned - start);
+    }
+
+    if (end > aligned + size) {
+        munmap((void *) (aligned + size), end - (aligned + size));
+    }
+
+    if (madvise((void *) aligned, size, MADV_HUGEPAGE)) {
+        munmap((void *) aligned, size);
+        return NULL;
+    }
+
+    return (void *) aligned;
+} /* evpl_slab_map_thp */
+
+static void
+evpl_slab_prefault(struct evpl_slab *slab)
+{
+    uint64_t page_size = evpl_shared->config->page_size;
+    uint64_t off;
+
+    for (off = 0; off < slab->size; off += page_size) {
+        *(volatile char *) (slab->data + off) = 0;
+    }
+} /* evpl_slab_prefault */
+
+static struct evpl_slab *
+evpl_allocator_create_slab(struct evpl_allocator *allocator)
+{
+    struct evpl_slab *slab;
+    int               prefault;
+
+    slab            = evpl_zalloc(sizeof(*slab));
+    slab->size      = allocator->slab_size;
+    slab->allocator = allocator;
+
+    prefault = evpl_shared->config->slab_prefault;
+
+ again:
+
+    switch (allocator->backing) {
+        case EVPL_SLAB_BACKING_HUGETLB_1GB:
+            slab->data = evpl_slab_map_hugetlb(slab->size, MAP_HUGE_1GB,
+                                               EVPL_SLAB_HUGE_1GB, prefault);
+            if (!slab->data) {
+                evpl_core_info("Could not allocate 1GB huge pages, trying 2MB...");
+                allocator->backing = EVPL_SLAB_BACKING_HUGETLB_2MB;
+                goto again;
+            }
+            break;
+        case EVPL_SLAB_BACKING_HUGETLB_2MB:
+        case EVPL_SLAB_BACKING_HUGETLB:
+            slab->data = evpl_slab_map_hugetlb(slab->size,
+                                               allocator->backing ==
+                                               EVPL_SLAB_BACKING_HUGETLB_2MB ?
+                                               MAP_HUGE_2MB : 0,
+                                               EVPL_SLAB_HUGE_2MB, prefault);
+            if (!slab->data) {
+                evpl_core_info("Could not allocate huge pages, trying transparent huge pages...");
+                allocator->backing = EVPL_SLAB_BACKING_THP;
+                goto again;
+            }
+            break;
+        case EVPL_SLAB_BACKING_THP:
+            slab->data = evpl_slab_thp_enabled() ?
+                evpl_slab_map_thp(slab->size) : NULL;
+
+            if (!slab->data) {
+                evpl_core_info("Transparent huge pages unavailable, disabling...");
+                allocator->backing = EVPL_SLAB_BACKING_DEFAULT;
+                goto again;
+            }
+
+            if (prefault) {
+                evpl_slab_prefault(slab);
+            }
+            break;
+        default:
+            slab->data = evpl_valloc(slab->size,
+                                     evpl_shared->config->page_size);
+
+            if (prefault) {
+                evpl_slab_prefault(slab);
+            }
+    } /* switch */
+
+    slab->backing    = allocator->backing;
+    slab->prefaulted = !!prefault;
+
+    evpl_core_debug("Allocated %lu MB slab backed by %s%s",
+                    slab->size >> 20, evpl_slab_backing_name(slab->backing),
+                    slab->prefaulted ? ", prefaulted" : "");
+
+    evpl_slab_register(slab);
+
     LL_PREPEND(allocator->slabs, slab);
 
     return slab;
@@ -143,10 +330,9 @@ evpl_allocator_create_slab(struct evpl_allocator *allocator)
 struct evpl_buffer *
 evpl_allocator_alloc(struct evpl_allocator *allocator)
 {
-    struct evpl_global_config *config = evpl_shared->config;
-    struct evpl_slab          *slab;
-    struct evpl_buffer        *buffer;
-    void                      *ptr;
+    struct evpl_slab   *slab;
+    struct evpl_buffer *buffer;
+    void               *ptr;
 
     pthread_mutex_lock(&allocator->lock);
 
@@ -156,18 +342,21 @@ evpl_allocator_alloc(struct evpl_allocator *allocator)
 
         ptr = slab->data;
 
-        while (ptr + config->buffer_size <= slab->data + slab->size) {
+        while (ptr + allocator->buffer_size <= slab->data + slab->size) {
 
             buffer       = evpl_zalloc(sizeof(*buffer));
             buffer->data = ptr;
             buffer->slab = slab;
             buffer->used = 0;
-            buffer->size = config->buffer_size;
+            buffer->size = allocator->buffer_size;
 
-            ptr += config->buffer_size;
+            ptr += allocator->buffer_size;
 
             slab->refcnt++;
 
+            allocator->num_buffers++;
+            allocator->num_free++;
+
             LL_PREPEND(allocator->free_buffers, buffer);
         }
 
@@ -176,6 +365,8 @@ evpl_allocator_alloc(struct evpl_allocator *allocator)
     buffer = allocator->free_buffers;
     LL_DELETE(allocator->free_buffers, buffer);
 
+    allocator->num_free--;
+
     pthread_mutex_unlock(&allocator->lock);
 
     return buffer;
@@ -185,29 +376,13 @@ evpl_allocator_alloc(struct evpl_allocator *allocator)
 void
 evpl_allocator_reregister(struct evpl_allocator *allocator)
 {
-    struct evpl_slab      *slab;
-    struct evpl_framework *framework;
-    int                    i;
+    struct evpl_slab *slab;
 
     pthread_mutex_lock(&allocator->lock);
 
     LL_FOREACH(allocator->slabs, slab)
     {
-
-        for (i = 0; i < EVPL_NUM_FRAMEWORK; ++i) {
-
-            framework = evpl_shared->framework[i];
-
-            if (!framework || !framework->register_memory ||
-                !evpl_shared->framework_private[i]) {
-                continue;
-            }
-
-            slab->framework_private[i] = framework->register_memory(
-                slab->data, slab->size,
-                slab->framework_private[i],
-                evpl_shared->framework_private[i]);
-        }
+        evpl_slab_register(slab);
     }
 
     pthread_mutex_unlock(&allocator->lock);
@@ -221,9 +396,525 @@ evpl_allocator_free(
 {
     pthread_mutex_lock(&allocator->lock);
     LL_PREPEND(allocator->free_buffers, buffer);
+    allocator->num_free++;
     pthread_mutex_unlock(&allocator->lock);
 } /* evpl_allocator_free */
 
+static inline int
+evpl_buddy_order(uint64_t size)
+{
+    return __builtin_ctzl(size) - EVPL_BUDDY_MIN_SHIFT;
+} // evpl_buddy_order
+
+static inline uint64_t
+evpl_buddy_index(struct evpl_buffer *block)
+{
+    return (block->data - block->slab->data) >> EVPL_BUDDY_MIN_SHIFT;
+} // evpl_buddy_index
+
+static void
+evpl_buddy_insert(
+    struct evpl_buddy  *buddy,
+    struct evpl_buffer *block)
+{
+    DL_APPEND(buddy->free[evpl_buddy_order(block->size)], block);
+    block->slab->buddy_free[evpl_buddy_index(block)] = block;
+} /* evpl_buddy_insert */
+
+static void
+evpl_buddy_remove(
+    struct evpl_buddy  *buddy,
+    struct evpl_buffer *block)
+{
+    DL_DELETE(buddy->free[evpl_buddy_order(block->size)], block);
+    block->slab->buddy_free[evpl_buddy_index(block)] = NULL;
+} /* evpl_buddy_remove */
+
+static struct evpl_buffer *
+evpl_buddy_block(
+    struct evpl_buddy *buddy,
+    struct evpl_slab  *slab,
+    void              *data,
+    uint64_t           size)
+{
+    struct evpl_buffer *block = evpl_zalloc(sizeof(*block));
+
+    block->data      = data;
+    block->size      = size;
+    block->slab      = slab;
+    block->external1 = buddy;
+
+    return block;
+} /* evpl_buddy_block */
+
+static void
+evpl_buddy_add_slab(struct evpl_buddy *buddy)
+{
+    struct evpl_slab *slab;
+    uint64_t          off = 0, size;
+    int               order;
+
+    pthread_mutex_lock(&buddy->allocator->lock);
+    slab = evpl_allocator_create_slab(buddy->allocator);
+    pthread_mutex_unlock(&buddy->allocator->lock);
+
+    slab->buddy_free = evpl_zalloc((slab->size >> EVPL_BUDDY_MIN_SHIFT) *
+                                   sizeof(struct evpl_buffer *));
+
+    /* Offsets only ever grow by decreasing powers of two,
+     * so each block is naturally aligned to its own size */
+    for (order = buddy->max_order; order >= 0; --order) {
+
+        size = 1UL << (EVPL_BUDDY_MIN_SHIFT + order);
+
+        while (off + size <= slab->size) {
+            evpl_buddy_insert(buddy, evpl_buddy_block(buddy, slab,
+                                                      slab->data + off, size));
+            off += size;
+        }
+    }
+
+} /* evpl_buddy_add_slab */
+
+static void
+evpl_buddy_release(struct evpl_buffer *block)
+{
+    struct evpl_buddy  *buddy = block->external1;
+    struct evpl_slab   *slab  = block->slab;
+    struct evpl_buffer *peer;
+    uint64_t            off, peer_off;
+
+    pthread_mutex_lock(&buddy->lock);
+
+    slab->refcnt--;
+
+    buddy->used_blocks--;
+    buddy->used_bytes -= block->size;
+
+    while (evpl_buddy_order(block->size) < buddy->max_order) {
+
+        off      = block->data - slab->data;
+        peer_off = off ^ block->size;
+
+        if (peer_off + block->size > slab->size) {
+            break;
+        }
+
+        peer = slab->buddy_free[peer_off >> EVPL_BUDDY_MIN_SHIFT];
+
+        if (!peer || peer->size != block->size) {
+            break;
+        }
+
+        evpl_buddy_remove(buddy, peer);
+
+        if (peer->data < block->data) {
+            block->data = peer->data;
+        }
+
+        block->size <<= 1;
+
+        evpl_free(peer);
+    }
+
+    evpl_buddy_insert(buddy, block);
+
+    pthread_mutex_unlock(&buddy->lock);
+
+} /* evpl_buddy_release */
+
+struct evpl_buddy *
+evpl_buddy_create(uint64_t slab_size)
+{
+    struct evpl_buddy *buddy = evpl_zalloc(sizeof(*buddy));
+
+    pthread_mutex_init(&buddy->lock, NULL);
+
+    buddy->allocator = evpl_allocator_create(slab_size,
+                                             1UL << EVPL_BUDDY_MIN_SHIFT);
+
+    buddy->max_order = 63 - __builtin_clzl(slab_size) - EVPL_BUDDY_MIN_SHIFT;
+
+    if (buddy->max_order >= EVPL_BUDDY_MAX_ORDER) {
+        buddy->max_order = EVPL_BUDDY_MAX_ORDER - 1;
+    }
+
+    evpl_core_abort_if(buddy->max_order < 0,
+                       "slab size %lu too small for contiguous allocations",
+                       slab_size);
+
+    return buddy;
+} /* evpl_buddy_create */
+
+void
+evpl_buddy_destroy(struct evpl_buddy *buddy)
+{
+    struct evpl_buffer *block;
+    int                 i;
+
+    for (i = 0; i < EVPL_BUDDY_MAX_ORDER; ++i) {
+        while (buddy->free[i]) {
+            block = buddy->free[i];
+            DL_DELETE(buddy->free[i], block);
+            evpl_free(block);
+        }
+    }
+
+    /* Leaked blocks are caught by the slab refcnt check */
+    evpl_allocator_destroy(buddy->allocator);
+
+    pthread_mutex_destroy(&buddy->lock);
+    evpl_free(buddy);
+} /* evpl_buddy_destroy */
+
+struct evpl_buffer *
+evpl_buddy_alloc(
+    struct evpl_buddy *buddy,
+    uint64_t           length)
+{
+    struct evpl_buffer *block, *half;
+    int                 order, i;
+
+    if (length <= (1UL << EVPL_BUDDY_MIN_SHIFT)) {
+        order = 0;
+    } else {
+        order = 64 - __builtin_clzl(length - 1) - EVPL_BUDDY_MIN_SHIFT;
+    }
+
+    if (order > buddy->max_order) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&buddy->lock);
+
+    for (i = order; i <= buddy->max_order && !buddy->free[i]; ++i) {
+    }
+
+    if (i > buddy->max_order) {
+        evpl_buddy_add_slab(buddy);
+
+        for (i = order; !buddy->free[i]; ++i) {
+        }
+    }
+
+    block = buddy->free[i];
+
+    evpl_buddy_remove(buddy, block);
+
+    while (i > order) {
+        --i;
+
+        block->size >>= 1;
+
+        half = evpl_buddy_block(buddy, block->slab, block->data + block->size,
+                                block->size);
+
+        evpl_buddy_insert(buddy, half);
+    }
+
+    block->slab->refcnt++;
+
+    buddy->used_blocks++;
+    buddy->used_bytes += block->size;
+
+    pthread_mutex_unlock(&buddy->lock);
+
+    block->release = evpl_buddy_release;
+
+    return block;
+} /* evpl_buddy_alloc */
+
+struct evpl_memory_map *
+evpl_memory_map_create(void)
+{
+    struct evpl_memory_map *map = evpl_zalloc(sizeof(*map));
+
+    pthread_rwlock_init(&map->lock, NULL);
+
+    map->max_regions = 16;
+    map->regions     = evpl_calloc(map->max_regions,
+                                   sizeof(struct evpl_memory *));
+
+    return map;
+} /* evpl_memory_map_create */
+
+void
+evpl_memory_map_destroy(struct evpl_memory_map *map)
+{
+    /* Drop the references held by registrations never unregistered */
+    while (map->num_regions) {
+        evpl_memory_unregister(map->regions[map->num_regions - 1]);
+    }
+
+    pthread_rwlock_destroy(&map->lock);
+    evpl_free(map->regions);
+    evpl_free(map);
+} /* evpl_memory_map_destroy */
+
+void
+evpl_memory_map_reregister(struct evpl_memory_map *map)
+{
+    int i;
+
+    pthread_rwlock_wrlock(&map->lock);
+
+    for (i = 0; i < map->num_regions; ++i) {
+        evpl_slab_register(&map->regions[i]->slab);
+    }
+
+    pthread_rwlock_unlock(&map->lock);
+} /* evpl_memory_map_reregister */
+
+/*
+ * Index of the first region starting beyond 'ptr', so the region
+ * that could contain 'ptr' is the one just before it.
+ */
+
+static int
+evpl_memory_map_search(
+    struct evpl_memory_map *map,
+    const void             *ptr)
+{
+    int lo = 0, hi = map->num_regions, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+
+        if (map->regions[mid]->slab.data <= ptr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+} /* evpl_memory_map_search */
+
+static void
+evpl_memory_release(struct evpl_buffer *buffer)
+{
+    struct evpl_memory *memory = buffer->external1;
+
+    evpl_slab_unregister(&memory->slab);
+
+    if (memory->release_cb) {
+        memory->release_cb(memory->slab.data, memory->slab.size,
+                           memory->private_data);
+    }
+
+    evpl_free(memory);
+} /* evpl_memory_release */
+
+struct evpl_memory *
+evpl_memory_register(
+    void                          *ptr,
+    uint64_t                       length,
+    evpl_memory_release_callback_t release_cb,
+    void                          *private_data)
+{
+    struct evpl_memory_map *map;
+    struct evpl_memory     *memory, *prev;
+    int                     idx;
+
+    __evpl_init();
+
+    map = evpl_shared->memory_map;
+
+    /* Frameworks take registration lengths as an int */
+    if (!ptr || length == 0 || length > INT_MAX) {
+        return NULL;
+    }
+
+    memory = evpl_zalloc(sizeof(*memory));
+
+    memory->slab.data    = ptr;
+    memory->slab.size    = length;
+    memory->release_cb   = release_cb;
+    memory->private_data = private_data;
+
+    memory->buffer.data      = ptr;
+    memory->buffer.size      = length;
+    memory->buffer.used      = length;
+    memory->buffer.slab      = &memory->slab;
+    memory->buffer.external1 = memory;
+    memory->buffer.release   = evpl_memory_release;
+
+    evpl_buffer_set_shared(&memory->buffer);
+
+    pthread_rwlock_wrlock(&map->lock);
+
+    idx = evpl_memory_map_search(map, ptr);
+
+    prev = idx ? map->regions[idx - 1] : NULL;
+
+    if ((prev && prev->slab.data + prev->slab.size > ptr) ||
+        (idx < map->num_regions &&
+         map->regions[idx]->slab.data < ptr + length)) {
+        pthread_rwlock_unlock(&map->lock);
+        evpl_core_error("Memory registration %p length %lu overlaps "
+                        "an existing registration", ptr, length);
+        evpl_free(memory);
+        return NULL;
+    }
+
+    evpl_slab_register(&memory->slab);
+
+    if (map->num_regions == map->max_regions) {
+        map->max_regions <<= 1;
+        map->regions      = evpl_realloc(map->regions,
+                                         map->max_regions *
+                                         sizeof(struct evpl_memory *));
+    }
+
+    memmove(&map->regions[idx + 1], &map->regions[idx],
+            (map->num_regions - idx) * sizeof(struct evpl_memory *));
+
+    map->regions[idx] = memory;
+    map->num_regions++;
+
+    map->registered_bytes += length;
+
+    pthread_rwlock_unlock(&map->lock);
+
+    return memory;
+} /* evpl_memory_register */
+
+void
+evpl_memory_unregister(struct evpl_memory *memory)
+{
+    struct evpl_memory_map *map = evpl_shared->memory_map;
+    int                     idx;
+
+    pthread_rwlock_wrlock(&map->lock);
+
+    idx = evpl_memory_map_search(map, memory->slab.data) - 1;
+
+    evpl_core_abort_if(idx < 0 || map->regions[idx] != memory,
+                       "Unregistering unknown memory %p", memory);
+
+    memmove(&map->regions[idx], &map->regions[idx + 1],
+            (map->num_regions - idx - 1) * sizeof(struct evpl_memory *));
+
+    map->num_regions--;
+
+    map->registered_bytes -= memory->slab.size;
+
+    pthread_rwlock_unlock(&map->lock);
+
+    /* Outstanding iovecs keep the registration alive until released */
+    evpl_buffer_release(&memory->buffer);
+} /* evpl_memory_unregister */
+
+int
+evpl_memory_iovec(
+    const void        *ptr,
+    unsigned int       length,
+    struct evpl_iovec *r_iovec)
+{
+    struct evpl_memory_map *map;
+    struct evpl_memory     *memory;
+    int                     idx;
+
+    if (unlikely(!evpl_shared)) {
+        return 0;
+    }
+
+    map = evpl_shared->memory_map;
+
+    pthread_rwlock_rdlock(&map->lock);
+
+    idx = evpl_memory_map_search(map, ptr) - 1;
+
+    memory = idx >= 0 ? map->regions[idx] : NULL;
+
+    if (!memory || ptr + length > memory->slab.data + memory->slab.size) {
+        pthread_rwlock_unlock(&map->lock);
+        return 0;
+    }
+
+    evpl_buffer_addref(&memory->buffer);
+
+    pthread_rwlock_unlock(&map->lock);
+
+    r_iovec->data    = (void *) ptr;
+    r_iovec->length  = length;
+    r_iovec->private = &memory->buffer;
+
+    return 1;
+} /* evpl_memory_iovec */
+
+void
+evpl_allocator_stats(
+    struct evpl_allocator       *allocator,
+    struct evpl_memory_snapshot *snapshot)
+{
+    struct evpl_slab *slab;
+
+    pthread_mutex_lock(&allocator->lock);
+
+    LL_FOREACH(allocator->slabs, slab)
+    {
+        snapshot->slabs++;
+        snapshot->slab_bytes += slab->size;
+    }
+
+    snapshot->free_buffers += allocator->num_free;
+    snapshot->used_buffers += allocator->num_buffers - allocator->num_free;
+    snapshot->pinned_bytes += (allocator->num_buffers - allocator->num_free) *
+        allocator->buffer_size;
+
+    pthread_mutex_unlock(&allocator->lock);
+} /* evpl_allocator_stats */
+
+void
+evpl_buddy_stats(
+    struct evpl_buddy           *buddy,
+    struct evpl_memory_snapshot *snapshot)
+{
+    evpl_allocator_stats(buddy->allocator, snapshot);
+
+    pthread_mutex_lock(&buddy->lock);
+    snapshot->used_buffers += buddy->used_blocks;
+    snapshot->pinned_bytes += buddy->used_bytes;
+    pthread_mutex_unlock(&buddy->lock);
+} /* evpl_buddy_stats */
+
+void
+evpl_memory_map_stats(
+    struct evpl_memory_map      *map,
+    struct evpl_memory_snapshot *snapshot)
+{
+    pthread_rwlock_rdlock(&map->lock);
+    snapshot->registered_bytes += map->registered_bytes;
+    pthread_rwlock_unlock(&map->lock);
+} /* evpl_memory_map_stats */
+
+int
+evpl_allocator_slab_usage(
+    struct evpl_allocator  *allocator,
+    struct evpl_slab_usage *usage,
+    int                     max_usage,
+    int                     n)
+{
+    struct evpl_slab *slab;
+
+    pthread_mutex_lock(&allocator->lock);
+
+    LL_FOREACH(allocator->slabs, slab)
+    {
+        if (n < max_usage) {
+            usage[n].size       = slab->size;
+            usage[n].backing    = slab->backing;
+            usage[n].prefaulted = slab->prefaulted;
+        }
+        n++;
+    }
+
+    pthread_mutex_unlock(&allocator->lock);
+
+    return n;
+} /* evpl_allocator_slab_usage */
+
 void *
 evpl_allocator_alloc_slab(struct evpl_allocator *allocator)
 {
@@ -236,3 +927,259 @@ evpl_allocator_alloc_slab(struct evpl_allocator *allocator)
     return slab->data;
 
 } /* evpl_allocator_alloc_slab */
+
+static void
+evpl_buffer_owner_release(
+    struct evpl_buffer_owner *owner,
+    int                       count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    if (atomic_fetch_sub_explicit(&owner->refcnt, count,
+                                  memory_order_acq_rel) == count) {
+        pthread_mutex_destroy(&owner->lock);
+        evpl_free(owner);
+    }
+} /* evpl_buffer_owner_release */
+
+struct evpl_buffer_owner *
+evpl_buffer_owner_attach(void)
+{
+    struct evpl_buffer_owner *owner = evpl_buffer_owner_self;
+
+    if (!owner) {
+        owner = evpl_zalloc(sizeof(*owner));
+
+        pthread_mutex_init(&owner->lock, NULL);
+        atomic_init(&owner->refcnt, 1);
+
+        evpl_buffer_owner_self = owner;
+    }
+
+    atomic_fetch_add_explicit(&owner->nevpl, 1, memory_order_relaxed);
+
+    return owner;
+} /* evpl_buffer_owner_attach */
+
+void
+evpl_buffer_own(struct evpl_buffer *buffer)
+{
+    struct evpl_buffer_owner *owner = evpl_buffer_owner_self;
+
+    if (unlikely(!owner)) {
+        /* Allocated outside of any evpl thread, so always shared */
+        evpl_buffer_set_shared(buffer);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&owner->refcnt, 1, memory_order_relaxed);
+
+    buffer->biased = 1;
+    buffer->home   = owner;
+    atomic_store_explicit(&buffer->refcnt, EVPL_BUFFER_REF_BIAS,
+                          memory_order_relaxed);
+    atomic_store_explicit(&buffer->owner, owner, memory_order_relaxed);
+} /* evpl_buffer_own */
+
+static void
+evpl_buffer_free(struct evpl_buffer *buffer)
+{
+    if (buffer->external1) {
+        buffer->release(buffer);
+    } else {
+        buffer->used = 0;
+        evpl_allocator_free(buffer->slab->allocator, buffer);
+    }
+} /* evpl_buffer_free */
+
+/*
+ * Fold the biased references into the shared count.  Unless forced,
+ * the merge is left to the owner's drain if another thread has already
+ * queued the buffer.  Returns 1 if the merge dropped the last reference
+ * and -1 if it was deferred.
+ */
+
+static int
+evpl_buffer_merge(
+    struct evpl_buffer *buffer,
+    int                 force)
+{
+    uint64_t refset, newset;
+
+    /* Must be cleared before the merge becomes visible, as another
+     * thread may free and reallocate the buffer immediately after */
+    atomic_store_explicit(&buffer->owner, NULL, memory_order_relaxed);
+
+    refset = atomic_load_explicit(&buffer->refcnt, memory_order_relaxed);
+
+    do {
+        if (!force && (refset & EVPL_BUFFER_QUEUED)) {
+            atomic_store_explicit(&buffer->owner, buffer->home,
+                                  memory_order_relaxed);
+            return -1;
+        }
+
+        newset = refset + (int64_t) buffer->biased + EVPL_BUFFER_MERGED;
+
+    } while (!atomic_compare_exchange_weak_explicit(&buffer->refcnt,
+                                                    &refset, newset,
+                                                    memory_order_acq_rel,
+                                                    memory_order_relaxed));
+
+    buffer->biased = 0;
+
+    return evpl_buffer_shared_refs(newset) == 0;
+} /* evpl_buffer_merge */
+
+static int
+evpl_buffer_merge_list(struct evpl_buffer *list)
+{
+    struct evpl_buffer *buffer;
+    int                 n = 0;
+
+    while (list) {
+        buffer = list;
+        list   = buffer->merge_next;
+
+        if (evpl_buffer_merge(buffer, 1)) {
+            evpl_buffer_free(buffer);
+        }
+
+        n++;
+    }
+
+    return n;
+} /* evpl_buffer_merge_list */
+
+void
+evpl_buffer_owner_drain(struct evpl_buffer_owner *owner)
+{
+    struct evpl_buffer *list;
+    int                 n;
+
+    pthread_mutex_lock(&owner->lock);
+    list = atomic_exchange_explicit(&owner->merge_pending, NULL,
+                                    memory_order_relaxed);
+    pthread_mutex_unlock(&owner->lock);
+
+    n = evpl_buffer_merge_list(list);
+
+    evpl_buffer_owner_release(owner, n);
+} /* evpl_buffer_owner_drain */
+
+/*
+ * Called as each evpl is destroyed.  Once the last evpl on a thread
+ * is gone the thread gives up ownership, buffers still queued are
+ * merged now and any queued later are merged by the releasing thread.
+ */
+
+void
+evpl_buffer_owner_detach(struct evpl_buffer_owner *owner)
+{
+    struct evpl_buffer *list;
+    int                 n;
+
+    if (atomic_fetch_sub_explicit(&owner->nevpl, 1,
+                                  memory_order_relaxed) > 1) {
+        return;
+    }
+
+    if (evpl_buffer_owner_self == owner) {
+        evpl_buffer_owner_self = NULL;
+    }
+
+    pthread_mutex_lock(&owner->lock);
+    owner->detached = 1;
+    list            = atomic_exchange_explicit(&owner->merge_pending, NULL,
+                                               memory_order_relaxed);
+    n = evpl_buffer_merge_list(list);
+    pthread_mutex_unlock(&owner->lock);
+
+    evpl_buffer_owner_release(owner, n + 1);
+} /* evpl_buffer_owner_detach */
+
+static void
+evpl_buffer_owner_queue(
+    struct evpl_buffer_owner *owner,
+    struct evpl_buffer       *buffer)
+{
+    int n = 0;
+
+    pthread_mutex_lock(&owner->lock);
+
+    if (owner->detached) {
+        n = evpl_buffer_merge_list(buffer);
+    } else {
+        buffer->merge_next = atomic_load_explicit(&owner->merge_pending,
+                                                  memory_order_relaxed);
+        atomic_store_explicit(&owner->merge_pending, buffer,
+                              memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&owner->lock);
+
+    evpl_buffer_owner_release(owner, n);
+} /* evpl_buffer_owner_queue */
+
+void
+evpl_buffer_release(struct evpl_buffer *buffer)
+{
+    struct evpl_buffer_owner *owner;
+    uint64_t                  refset, newset;
+    int                       rc;
+
+    if (likely(evpl_buffer_owned(buffer))) {
+
+        if (--buffer->biased) {
+            return;
+        }
+
+        owner = buffer->home;
+        rc    = evpl_buffer_merge(buffer, 0);
+
+        if (rc < 0) {
+            return;
+        }
+
+        evpl_buffer_owner_release(owner, 1);
+
+        if (rc) {
+            evpl_buffer_free(buffer);
+        }
+
+        return;
+    }
+
+    refset = atomic_load_explicit(&buffer->refcnt, memory_order_relaxed);
+
+    do {
+        newset = refset - 1;
+
+        if (!(newset & EVPL_BUFFER_MERGED) &&
+            evpl_buffer_shared_refs(newset) < 0) {
+            newset |= EVPL_BUFFER_QUEUED;
+        }
+
+    } while (!atomic_compare_exchange_weak_explicit(&buffer->refcnt,
+                                                    &refset, newset,
+                                                    memory_order_acq_rel,
+                                                    memory_order_relaxed));
+
+    if (newset & EVPL_BUFFER_MERGED) {
+
+        evpl_core_abort_if(evpl_buffer_shared_refs(newset) < 0,
+                           "Released buffer %p with zero refcnt", buffer);
+
+        if (evpl_buffer_shared_refs(newset) == 0) {
+            evpl_buffer_free(buffer);
+        }
+
+    } else if ((newset & EVPL_BUFFER_QUEUED) &&
+               !(refset & EVPL_BUFFER_QUEUED)) {
+        buffer->merge_next = NULL;
+        evpl_buffer_owner_queue(buffer->home, buffer);
+    }
+
+} /* evpl_buffer_release */
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <sys/uio.h>
 #include <stdatomic.h>
+#include <pthread.h>
 
 #include "evpl/evpl.h"
 #include "core/internal.h"
@@ -15,40 +16,140 @@ struct evpl_slab {
     void                  *data;
     struct evpl_allocator *allocator;
     uint64_t               refcnt;
-    uint64_t               size      : 63;
-    uint64_t               hugepages : 1;
+    uint64_t               size       : 55;
+    uint64_t               backing    : 8;
+    uint64_t               prefaulted : 1;
     void                  *framework_private[EVPL_NUM_FRAMEWORK];
+    struct evpl_buffer   **buddy_free;
     struct evpl_slab      *next;
 };
 
+/*
+ * Buffer references are biased toward the thread that allocated
+ * the buffer.  The owning thread counts its references in 'biased'
+ * with plain arithmetic, all other threads use the atomic 'refcnt'.
+ *
+ * The low 32 bits of 'refcnt' hold the shared count offset by
+ * EVPL_BUFFER_REF_BIAS, since other threads may release references
+ * the owner handed them and drive it negative.  When the owner drops
+ * its last biased reference the counts are merged and from then on
+ * every thread uses the atomic count.  When another thread drives
+ * the shared count negative instead, the buffer is queued back to
+ * its owner which merges it on its next pass through evpl_continue().
+ */
+
+#define EVPL_BUFFER_REF_BIAS 0x80000000ULL
+#define EVPL_BUFFER_MERGED   (1ULL << 32)
+#define EVPL_BUFFER_QUEUED   (1ULL << 33)
+
+#define evpl_buffer_shared_refs(refset) \
+        ((int64_t) ((refset) & 0xffffffffULL) - (int64_t) EVPL_BUFFER_REF_BIAS)
+
+struct evpl_buffer_owner {
+    pthread_mutex_t                lock;
+    _Atomic(struct evpl_buffer *) merge_pending;
+    atomic_int                     refcnt;
+    atomic_int                     nevpl;
+    int                            detached;
+};
+
 struct evpl_buffer {
-    void               *data;
-    atomic_int          refcnt;
-    unsigned int        used;
-    unsigned int        size;
+    void                               *data;
+    _Atomic uint64_t                    refcnt;
+    int                                 biased;
+    unsigned int                        used;
+    unsigned int                        size;
+
+    _Atomic(struct evpl_buffer_owner *) owner;
+    struct evpl_buffer_owner           *home;
+    struct evpl_buffer                 *merge_next;
 
-    struct evpl_slab   *slab;
+    struct evpl_slab                   *slab;
 
-    void               *external1;
-    void               *external2;
-    void                (*release)(
+    void                               *external1;
+    void                               *external2;
+    void                                (*release)(
         struct evpl_buffer *);
 
-    struct evpl_buffer *next;
+    struct evpl_buffer                 *prev;
+    struct evpl_buffer                 *next;
 };
 
+extern __thread struct evpl_buffer_owner *evpl_buffer_owner_self
+__attribute__((tls_model("initial-exec")));
+
 struct evpl_allocator {
     struct evpl_slab   *slabs;
     struct evpl_buffer *free_buffers;
-    int                 hugepages;
+    uint64_t            num_buffers;
+    uint64_t            num_free;
+    uint64_t            slab_size;
+    unsigned int        buffer_size;
+    int                 backing;
     pthread_mutex_t     lock;
 };
 
+/*
+ * Contiguous blocks are carved from registered slabs by a buddy
+ * allocator, from 2MB up to the largest power of two in a slab.
+ */
+
+#define EVPL_BUDDY_MIN_SHIFT 21
+#define EVPL_BUDDY_MAX_ORDER 11
+
+struct evpl_buddy {
+    struct evpl_allocator *allocator;
+    struct evpl_buffer    *free[EVPL_BUDDY_MAX_ORDER];
+    uint64_t               used_blocks;
+    uint64_t               used_bytes;
+    int                    max_order;
+    pthread_mutex_t        lock;
+};
+
+/*
+ * Application memory registered via evpl_memory_register() is wrapped
+ * in a standalone slab and one buffer that every iovec into it shares.
+ * Registrations are kept sorted by address so lookups can bisect.
+ */
+
+struct evpl_memory {
+    struct evpl_slab               slab;
+    struct evpl_buffer             buffer;
+    evpl_memory_release_callback_t release_cb;
+    void                          *private_data;
+};
+
+struct evpl_memory_map {
+    pthread_rwlock_t     lock;
+    struct evpl_memory **regions;
+    uint64_t             registered_bytes;
+    int                  num_regions;
+    int                  max_regions;
+};
+
 void evpl_buffer_release(
     struct evpl_buffer *buffer);
 
+void
+evpl_buffer_own(
+    struct evpl_buffer *buffer);
+
+struct evpl_buffer_owner *
+evpl_buffer_owner_attach(
+    void);
+
+void
+evpl_buffer_owner_detach(
+    struct evpl_buffer_owner *owner);
+
+void
+evpl_buffer_owner_drain(
+    struct evpl_buffer_owner *owner);
+
 struct evpl_allocator *
-evpl_allocator_create();
+evpl_allocator_create(
+    uint64_t     slab_size,
+    unsigned int buffer_size);
 
 void
 evpl_allocator_destroy(
@@ -62,6 +163,53 @@ struct evpl_buffer *
 evpl_allocator_alloc(
     struct evpl_allocator *allocator);
 
+int
+evpl_allocator_slab_usage(
+    struct evpl_allocator  *allocator,
+    struct evpl_slab_usage *usage,
+    int                     max_usage,
+    int                     n);
+
+struct evpl_buddy *
+evpl_buddy_create(
+    uint64_t slab_size);
+
+void
+evpl_buddy_destroy(
+    struct evpl_buddy *buddy);
+
+struct evpl_buffer *
+evpl_buddy_alloc(
+    struct evpl_buddy *buddy,
+    uint64_t           length);
+
+struct evpl_memory_map *
+evpl_memory_map_create(
+    void);
+
+void
+evpl_memory_map_destroy(
+    struct evpl_memory_map *map);
+
+void
+evpl_memory_map_reregister(
+    struct evpl_memory_map *map);
+
+void
+evpl_allocator_stats(
+    struct evpl_allocator       *allocator,
+    struct evpl_memory_snapshot *snapshot);
+
+void
+evpl_buddy_stats(
+    struct evpl_buddy           *buddy,
+    struct evpl_memory_snapshot *snapshot);
+
+void
+evpl_memory_map_stats(
+    struct evpl_memory_map      *map,
+    struct evpl_memory_snapshot *snapshot);
+
 void *
 evpl_allocator_alloc_slab(
     struct evpl_allocator *allocator);
@@ -71,6 +219,65 @@ evpl_allocator_free(
     struct evpl_allocator *allocator,
     struct evpl_buffer    *buffer);
 
+static inline int
+evpl_buffer_owned(struct evpl_buffer *buffer)
+{
+    struct evpl_buffer_owner *owner;
+
+    owner = atomic_load_explicit(&buffer->owner, memory_order_relaxed);
+
+    return owner && owner == evpl_buffer_owner_self;
+} // evpl_buffer_owned
+
+static inline void
+evpl_buffer_addref(struct evpl_buffer *buffer)
+{
+    if (likely(evpl_buffer_owned(buffer))) {
+        buffer->biased++;
+    } else {
+        atomic_fetch_add_explicit(&buffer->refcnt, 1, memory_order_relaxed);
+    }
+} // evpl_buffer_addref
+
+/*
+ * Mark a buffer as shared from birth, for buffers that are not
+ * carved from an allocator and so have no owning thread.
+ */
+
+static inline void
+evpl_buffer_set_shared(struct evpl_buffer *buffer)
+{
+    buffer->biased = 0;
+    buffer->home   = NULL;
+    atomic_store_explicit(&buffer->owner, NULL, memory_order_relaxed);
+    atomic_store(&buffer->refcnt,
+                 EVPL_BUFFER_MERGED | (EVPL_BUFFER_REF_BIAS + 1));
+} // evpl_buffer_set_shared
+
+/*
+ * Approximate reference count, for diagnostics only.
+ */
+
+static inline int
+evpl_buffer_refs(struct evpl_buffer *buffer)
+{
+    uint64_t refset = atomic_load_explicit(&buffer->refcnt,
+                                           memory_order_relaxed);
+
+    return buffer->biased + evpl_buffer_shared_refs(refset);
+} // evpl_buffer_refs
+
+static inline void
+evpl_buffer_owner_poll(void)
+{
+    struct evpl_buffer_owner *owner = evpl_buffer_owner_self;
+
+    if (owner && unlikely(atomic_load_explicit(&owner->merge_pending,
+                                               memory_order_relaxed))) {
+        evpl_buffer_owner_drain(owner);
+    }
+} // evpl_buffer_owner_poll
+
 static inline void *
 evpl_buffer_framework_private(
     struct evpl_buffer *buffer,
@@ -129,9 +336,7 @@ evpl_iovec_decref(struct evpl_iovec *iovec)
 static inline void
 evpl_iovec_incref(struct evpl_iovec *iovec)
 {
-    struct evpl_buffer *buffer = evpl_iovec_buffer(iovec);
-
-    atomic_fetch_add_explicit(&buffer->refcnt, 1, memory_order_relaxed);
+    evpl_buffer_addref(evpl_iovec_buffer(iovec));
 
 } // evpl_iovec_incref
 
@@ -6,6 +6,9 @@
 
 #include "core/internal.h"
 #include "evpl/evpl.h"
+#include "core/evpl_shared.h"
+
+extern struct evpl_shared *evpl_shared;
 
 
 struct evpl_global_config *
@@ -16,18 +19,33 @@ evpl_global_config_init(void)
     config->thread_default.spin_ns = 100000UL;
     config->thread_default.wait_ms = -1;
 
-    config->max_pending        = 16;
-    config->max_poll_fd        = 16;
-    config->max_num_iovec      = 128;
-    config->huge_pages         = 0;
-    config->buffer_size        = 2 * 1024 * 1024;
-    config->slab_size          = 1 * 1024 * 1024 * 1024;
-    config->refcnt             = 1;
-    config->iovec_ring_size    = 1024;
-    config->dgram_ring_size    = 256;
-    config->max_datagram_size  = 65536;
-    config->max_datagram_batch = 16;
-    config->resolve_timeout_ms = 5000;
+    config->max_pending            = 16;
+    config->max_poll_fd            = 16;
+    config->max_num_iovec          = 128;
+    config->slab_backing           = EVPL_SLAB_BACKING_DEFAULT;
+    config->slab_prefault          = 0;
+    config->buffer_size            = 2 * 1024 * 1024;
+    config->slab_size              = 1 * 1024 * 1024 * 1024;
+    config->long_lived_buffer_size = 64 * 1024;
+    config->long_lived_slab_size   = 64 * 1024 * 1024;
+    config->compact_max_length     = 4096;
+    config->send_coalesce_max      = 1024;
+    config->send_high_watermark    = 0;
+    config->send_low_watermark     = 0;
+    config->recv_max               = 0;
+    config->refcnt                 = 1;
+    config->iovec_ring_size        = 1024;
+    config->dgram_ring_size        = 256;
+    config->max_datagram_size      = 65536;
+    config->max_datagram_batch     = 16;
+    config->resolve_timeout_ms     = 5000;
+    config->socket_zerocopy        = 0;
+    config->socket_zerocopy_min    = 16384;
+    config->socket_udp_gso         = 1;
+    config->socket_udp_gro         = 1;
+    config->socket_timestamping    = 0;
+    config->socket_tcp_rcvlowat    = 1;
+    config->socket_unix_pass_fds   = 0;
 
     config->page_size = sysconf(_SC_PAGESIZE);
 
@@ -54,9 +72,28 @@ evpl_global_config_init(void)
 
     config->vfio_enabled = 1;
 
+    config->xdp_enabled = 1;
+
+    config->libfabric_enabled  = 1;
+    config->libfabric_cq_size  = 8192;
+    config->libfabric_rx_depth = 128;
+
+    config->shm_enabled      = 1;
+    config->shm_segment_size = 16 * 1024 * 1024;
+
+    config->loopback_enabled = 1;
+
     return config;
 } /* evpl_config_init */
 
+void
+evpl_global_config_set_max_pending(
+    struct evpl_global_config *config,
+    unsigned int               max_pending)
+{
+    config->max_pending = max_pending;
+} /* evpl_global_config_set_max_pending */
+
 void
 evpl_global_config_set_max_datagram_size(
     struct evpl_global_config *config,
@@ -70,9 +107,140 @@ evpl_global_config_set_huge_pages(
     struct evpl_global_config *config,
     int                        huge_pages)
 {
-    config->huge_pages = huge_pages;
+    config->slab_backing = huge_pages ? EVPL_SLAB_BACKING_HUGETLB :
+        EVPL_SLAB_BACKING_DEFAULT;
 } /* evpl_global_config_set_huge_pages */
 
+void
+evpl_global_config_set_slab_backing(
+    struct evpl_global_config *config,
+    enum evpl_slab_backing     backing)
+{
+    config->slab_backing = backing;
+} /* evpl_global_config_set_slab_backing */
+
+void
+evpl_global_config_set_slab_prefault(
+    struct evpl_global_config *config,
+    int                        prefault)
+{
+    config->slab_prefault = prefault;
+} /* evpl_global_config_set_slab_prefault */
+
+void
+evpl_global_config_set_long_lived_buffer_size(
+    struct evpl_global_config *config,
+    unsigned int               size)
+{
+    config->long_lived_buffer_size = size;
+} /* evpl_global_config_set_long_lived_buffer_size */
+
+void
+evpl_global_config_set_compact_max_length(
+    struct evpl_global_config *config,
+    unsigned int               length)
+{
+    config->compact_max_length = length;
+} /* evpl_global_config_set_compact_max_length */
+
+void
+evpl_global_config_set_send_coalesce_max(
+    struct evpl_global_config *config,
+    unsigned int               length)
+{
+    config->send_coalesce_max = length;
+} /* evpl_global_config_set_send_coalesce_max */
+
+void
+evpl_global_config_set_resolve_timeout_ms(
+    struct evpl_global_config *config,
+    unsigned int               timeout_ms)
+{
+    config->resolve_timeout_ms = timeout_ms;
+} /* evpl_global_config_set_resolve_timeout_ms */
+
+void
+evpl_global_config_set_send_watermarks(
+    struct evpl_global_config *config,
+    uint64_t                   high,
+    uint64_t                   low)
+{
+    config->send_high_watermark = high;
+    config->send_low_watermark  = low;
+} /* evpl_global_config_set_send_watermarks */
+
+void
+evpl_global_config_set_recv_max(
+    struct evpl_global_config *config,
+    uint64_t                   max)
+{
+    config->recv_max = max;
+} /* evpl_global_config_set_recv_max */
+
+void
+evpl_global_config_set_socket_zerocopy(
+    struct evpl_global_config *config,
+    int                        zerocopy)
+{
+    config->socket_zerocopy = zerocopy;
+} /* evpl_global_config_set_socket_zerocopy */
+
+void
+evpl_global_config_set_socket_zerocopy_min(
+    struct evpl_global_config *config,
+    unsigned int               length)
+{
+    config->socket_zerocopy_min = length;
+} /* evpl_global_config_set_socket_zerocopy_min */
+
+void
+evpl_global_config_set_socket_udp_gso(
+    struct evpl_global_config *config,
+    int                        enable)
+{
+    config->socket_udp_gso = enable;
+} /* evpl_global_config_set_socket_udp_gso */
+
+void
+evpl_global_config_set_socket_udp_gro(
+    struct evpl_global_config *config,
+    int                        enable)
+{
+    config->socket_udp_gro = enable;
+} /* evpl_global_config_set_socket_udp_gro */
+
+void
+evpl_global_config_set_socket_timestamping(
+    struct evpl_global_config *config,
+    unsigned int               flags)
+{
+    config->socket_timestamping = flags;
+} /* evpl_global_config_set_socket_timestamping */
+
+void
+evpl_global_config_set_socket_tcp_rcvlowat(
+    struct evpl_global_config *config,
+    int                        enable)
+{
+    config->socket_tcp_rcvlowat = enable;
+} /* evpl_global_config_set_socket_tcp_rcvlowat */
+
+void
+evpl_global_config_set_socket_unix_pass_fds(
+    struct evpl_global_config *config,
+    int                        enable)
+{
+    config->socket_unix_pass_fds = enable;
+} /* evpl_global_config_set_socket_unix_pass_fds */
+
+void
+evpl_global_config_set_shm_segment_size(
+    struct evpl_global_config *config,
+    uint64_t                   size)
+{
+    config->shm_segment_size = size;
+} /* evpl_global_config_set_shm_segment_size */
+
 void
 evpl_global_config_set_rdmacm_tos(
     struct evpl_global_config *config,
@@ -96,3 +264,37 @@ evpl_global_config_set_rdmacm_datagram_size_override(
 {
     config->rdmacm_datagram_size_override = size;
 } /* evpl_global_config_set_rdmacm_datagram_size_override */
+
+struct evpl_thread_config *
+evpl_thread_config_init(void)
+{
+    struct evpl_thread_config *config = evpl_zalloc(sizeof(*config));
+
+    __evpl_init();
+
+    *config = evpl_shared->config->thread_default;
+
+    return config;
+} /* evpl_thread_config_init */
+
+void
+evpl_thread_config_release(struct evpl_thread_config *config)
+{
+    evpl_free(config);
+} /* evpl_thread_config_release */
+
+void
+evpl_thread_config_set_spin_ns(
+    struct evpl_thread_config *config,
+    unsigned int               spin_ns)
+{
+    config->spin_ns = spin_ns;
+} /* evpl_thread_config_set_spin_ns */
+
+void
+evpl_thread_config_set_wait_ms(
+    struct evpl_thread_config *config,
+    int                        wait_ms)
+{
+    config->wait_ms = wait_ms;
+} /* evpl_thread_config_set_wait_ms */
@@ -15,6 +15,7 @@ struct evpl_dgram {
 struct evpl_dgram_ring {
     struct evpl_dgram *dgram;
     int                size;
+    int                base_size;
     int                mask;
     int                alignment;
     int                head;
@@ -28,10 +29,10 @@ evpl_dgram_ring_alloc(
     int                     size,
     int                     alignment)
 {
-    ring->dgram = evpl_valloc(size * sizeof(struct evpl_dgram), alignment);
-
-    ring->size      = size;
-    ring->mask      = size - 1;
+    ring->dgram     = NULL;
+    ring->size      = 0;
+    ring->base_size = size;
+    ring->mask      = 0;
     ring->alignment = alignment;
     ring->head      = 0;
     ring->tail      = 0;
@@ -41,9 +42,20 @@ evpl_dgram_ring_alloc(
 static inline void
 evpl_dgram_ring_resize(struct evpl_dgram_ring *ring)
 {
-    int                new_size  = ring->size << 1;
-    struct evpl_dgram *new_dgram = evpl_valloc(
-        new_size * sizeof(struct evpl_dgram), ring->alignment);
+    int                new_size  = ring->size ? ring->size << 1 :
+        ring->base_size;
+    struct evpl_dgram *new_dgram = evpl_valloc_tagged(
+        new_size * sizeof(struct evpl_dgram), ring->alignment,
+        EVPL_MEMORY_TAG_RING);
+
+    if (!ring->dgram) {
+        ring->dgram = new_dgram;
+        ring->size  = new_size;
+        ring->mask  = new_size - 1;
+        ring->head  = 0;
+        ring->tail  = 0;
+        return;
+    }
 
     if (ring->head > ring->tail) {
         memcpy(new_dgram, &ring->dgram[ring->tail], (ring->head - ring->tail) *
@@ -58,7 +70,7 @@ evpl_dgram_ring_resize(struct evpl_dgram_ring *ring)
     ring->head = ring->size - 1;
     ring->tail = 0;
 
-    evpl_free(ring->dgram);
+    evpl_free_tagged(ring->dgram, EVPL_MEMORY_TAG_RING);
 
     ring->dgram = new_dgram;
     ring->size  = new_size;
@@ -68,9 +80,25 @@ evpl_dgram_ring_resize(struct evpl_dgram_ring *ring)
 static inline void
 evpl_dgram_ring_free(struct evpl_dgram_ring *ring)
 {
-    evpl_free(ring->dgram);
+    evpl_free_tagged(ring->dgram, EVPL_MEMORY_TAG_RING);
 } // evpl_dgram_ring_free
 
+static inline void
+evpl_dgram_ring_trim(struct evpl_dgram_ring *ring)
+{
+    if (!ring->dgram || ring->head != ring->tail) {
+        return;
+    }
+
+    evpl_free_tagged(ring->dgram, EVPL_MEMORY_TAG_RING);
+
+    ring->dgram = NULL;
+    ring->size  = 0;
+    ring->mask  = 0;
+    ring->head  = 0;
+    ring->tail  = 0;
+} // evpl_dgram_ring_trim
+
 static inline int
 evpl_dgram_ring_is_empty(const struct evpl_dgram_ring *ring)
 {
@@ -80,7 +108,7 @@ evpl_dgram_ring_is_empty(const struct evpl_dgram_ring *ring)
 static inline int
 evpl_dgram_ring_is_full(const struct evpl_dgram_ring *ring)
 {
-    return ((ring->head + 1) & ring->mask) == ring->tail;
+    return ring->size && ((ring->head + 1) & ring->mask) == ring->tail;
 } // evpl_dgram_ring_is_full
 
 static inline struct evpl_dgram *
@@ -122,7 +150,7 @@ evpl_dgram_ring_add(struct evpl_dgram_ring *ring)
 {
     struct evpl_dgram *res;
 
-    if (evpl_dgram_ring_is_full(ring)) {
+    if (!ring->size || evpl_dgram_ring_is_full(ring)) {
         evpl_dgram_ring_resize(ring);
     }
 
@@ -139,6 +167,34 @@ evpl_dgram_ring_remove(struct evpl_dgram_ring *ring)
     ring->tail = (ring->tail + 1) & ring->mask;
 } // evpl_dgram_ring_remove
 
+/*
+ * Retire the messages covered by 'length' bytes written to a stream and
+ * return how many completed.  A message only partly written is shortened
+ * by the bytes that went out.
+ */
+static inline int
+evpl_dgram_ring_consume(
+    struct evpl_dgram_ring *ring,
+    uint64_t                length)
+{
+    struct evpl_dgram *dgram;
+    int                nmsg = 0;
+
+    while (length && (dgram = evpl_dgram_ring_tail(ring)) != NULL) {
+
+        if (dgram->length > length) {
+            dgram->length -= length;
+            break;
+        }
+
+        length -= dgram->length;
+        nmsg++;
+        evpl_dgram_ring_remove(ring);
+    }
+
+    return nmsg;
+} // evpl_dgram_ring_consume
+
 static inline void
 evpl_dgram_ring_clear(
     struct evpl            *evpl,
@@ -6,11 +6,22 @@
 
 #include <stdio.h>
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <stddef.h>
+#include <arpa/inet.h>
 #include "evpl/evpl.h"
 #include <stdatomic.h>
 
+#include "uthash/uthash.h"
+
 struct addrinfo;
 
+/* How often a thread revalidates the endpoint addresses it has cached */
+#define EVPL_ADDRESS_CACHE_EPOCH_NS (NS_PER_S / 10)
+
+/* Most datagram source addresses a thread keeps interned */
+#define EVPL_ADDRESS_INTERN_MAX     4096
+
 struct evpl_address {
     struct sockaddr        *addr;
     socklen_t               addrlen;
@@ -20,20 +31,90 @@ struct evpl_address {
     struct sockaddr_storage sa;
 };
 
+/*
+ * A bind waiting for its endpoint to be resolved by the background
+ * resolver, which wakes the owning thread once the lookup completes.
+ */
+struct evpl_resolve_wait {
+    struct evpl              *evpl;
+    struct evpl_endpoint     *endpoint;
+    struct evpl_resolve_wait *prev;
+    struct evpl_resolve_wait *next;
+};
+
 struct evpl_endpoint {
-    char                  address[256];
-    int                   port;
-    struct timespec       last_resolved;
-    struct evpl_address  *resolved_addr;
-    pthread_rwlock_t      lock;
-    struct evpl_endpoint *prev;
-    struct evpl_endpoint *next;
+    char                      address[256];
+    int                       port;
+    int                       numeric;        /* literal address, never refreshed */
+    int                       resolve_status; /* getaddrinfo result of last lookup */
+    struct timespec           last_resolved;
+    struct evpl_address      *resolved_addr;
+    atomic_uint_fast64_t      generation;     /* changes with resolved_addr */
+    pthread_rwlock_t          lock;
+
+    /* protected by the resolver lock */
+    atomic_int                resolving;
+    struct evpl_resolve_wait *waiters;
+    struct evpl_endpoint     *resolve_next;
+
+    struct evpl_endpoint     *prev;
+    struct evpl_endpoint     *next;
 };
 
+/*
+ * A thread's private copy of the address of an endpoint, so that sending
+ * to an endpoint touches no shared state between revalidations.
+ */
+struct evpl_address_cache {
+    struct evpl_endpoint *endpoint;
+    struct evpl_address  *address;
+    uint64_t              generation;
+    uint64_t              epoch;
+    UT_hash_handle        hh;
+};
+
+/*
+ * A datagram source address interned by a thread, so repeat peers are
+ * reported with the same address object.  Entries are kept on an LRU
+ * list, most recently seen first.
+ */
+struct evpl_address_intern {
+    struct evpl_address        *address;
+    struct evpl_address_intern *prev;
+    struct evpl_address_intern *next;
+    UT_hash_handle              hh;
+};
+
+/*
+ * Return the address interned for a sockaddr by this thread, with a
+ * reference held, interning a new one if it has not been seen lately.
+ */
+struct evpl_address *
+evpl_address_intern(
+    struct evpl           *evpl,
+    const struct sockaddr *addr,
+    socklen_t              addrlen);
+
+/*
+ * Return the cached address of an endpoint with a reference held, queueing
+ * a background refresh if it is stale.  Returns NULL if the endpoint has
+ * never been resolved, in which case the first lookup is queued.
+ */
 struct evpl_address *
 evpl_endpoint_resolve(
     struct evpl_endpoint *endpoint);
 
+/* As above, also returning the generation of the address under the same lock */
+struct evpl_address *
+evpl_endpoint_resolve_generation(
+    struct evpl_endpoint *endpoint,
+    uint64_t             *generation);
+
+/* As above, but wait for the first lookup rather than returning NULL */
+struct evpl_address *
+evpl_endpoint_resolve_wait(
+    struct evpl_endpoint *endpoint);
+
 struct evpl_address *
 evpl_address_alloc(
     void);
@@ -79,7 +160,9 @@ evpl_address_get_address(
     struct sockaddr     *sa = address->addr;
     struct sockaddr_in  *sin;
     struct sockaddr_in6 *sin6;
+    struct sockaddr_un  *sun;
     char                 addr_str[INET6_ADDRSTRLEN];
+    int                  pathlen;
 
     if (sa->sa_family == AF_INET) {
         sin = (struct sockaddr_in *) sa;
@@ -89,6 +172,17 @@ evpl_address_get_address(
         sin6 = (struct sockaddr_in6 *) sa;
         inet_ntop(AF_INET6, &sin6->sin6_addr, addr_str, sizeof(addr_str));
         snprintf(str, len, "[%s]:%d", addr_str, ntohs(sin6->sin6_port));
+    } else if (sa->sa_family == AF_UNIX) {
+        sun     = (struct sockaddr_un *) sa;
+        pathlen = address->addrlen - offsetof(struct sockaddr_un, sun_path);
+
+        if (pathlen <= 0) {
+            snprintf(str, len, "unnamed");
+        } else if (sun->sun_path[0] == '\0') {
+            snprintf(str, len, "@%.*s", pathlen - 1, sun->sun_path + 1);
+        } else {
+            snprintf(str, len, "%.*s", pathlen, sun->sun_path);
+        }
     }
 } /* evpl_bind_get_local_address */
 
@@ -29,6 +29,7 @@
 #include "core/buffer.h"
 #include "core/bind.h"
 #include "core/endpoint.h"
+#include "core/resolver.h"
 
 #ifdef HAVE_IO_URING
 #include "io_uring/io_uring.h"
@@ -46,8 +47,19 @@
 #include "xlio/xlio.h"
 #endif /* ifdef HAVE_XLIO */
 
+#ifdef HAVE_XDP
+#include "xdp/xdp.h"
+#endif /* ifdef HAVE_XDP */
+
+#ifdef HAVE_LIBFABRIC
+#include "libfabric/libfabric.h"
+#endif /* ifdef HAVE_LIBFABRIC */
+
 #include "socket/udp.h"
 #include "socket/tcp.h"
+#include "socket/unix.h"
+#include "shm/shm.h"
+#include "loopback/loopback.h"
 
 pthread_once_t      evpl_shared_once = PTHREAD_ONCE_INIT;
 struct evpl_shared *evpl_shared      = NULL;
@@ -93,7 +105,18 @@ evpl_shared_init(struct evpl_global_config *config)
 
     evpl_shared->config = config;
 
-    evpl_shared->allocator = evpl_allocator_create();
+    evpl_shared->allocator = evpl_allocator_create(config->slab_size,
+                                                   config->buffer_size);
+
+    evpl_shared->long_lived_allocator = evpl_allocator_create(
+        config->long_lived_slab_size,
+        config->long_lived_buffer_size);
+
+    evpl_shared->buddy = evpl_buddy_create(config->slab_size);
+
+    evpl_shared->memory_map = evpl_memory_map_create();
+
+    evpl_shared->resolver = evpl_resolver_create();
 
     evpl_protocol_init(evpl_shared, EVPL_DATAGRAM_SOCKET_UDP,
                        &evpl_socket_udp);
@@ -101,6 +124,12 @@ evpl_shared_init(struct evpl_global_config *config)
     evpl_protocol_init(evpl_shared, EVPL_STREAM_SOCKET_TCP,
                        &evpl_socket_tcp);
 
+    evpl_protocol_init(evpl_shared, EVPL_DATAGRAM_SOCKET_UNIX,
+                       &evpl_socket_unix_datagram);
+
+    evpl_protocol_init(evpl_shared, EVPL_STREAM_SOCKET_UNIX,
+                       &evpl_socket_unix_stream);
+
 #ifdef HAVE_IO_URING
     if (config->io_uring_enabled) {
         evpl_framework_init(evpl_shared, EVPL_FRAMEWORK_IO_URING, &
@@ -108,6 +137,12 @@ evpl_shared_init(struct evpl_global_config *config)
 
         evpl_block_protocol_init(evpl_shared, EVPL_BLOCK_PROTOCOL_IO_URING,
                                  &evpl_block_protocol_io_uring);
+
+        evpl_protocol_init(evpl_shared, EVPL_STREAM_IO_URING_TCP,
+                           &evpl_io_uring_tcp);
+
+        evpl_protocol_init(evpl_shared, EVPL_DATAGRAM_IO_URING_UDP,
+                           &evpl_io_uring_udp);
     }
 #endif /* ifdef HAVE_IO_URING */
 
@@ -143,6 +178,43 @@ evpl_shared_init(struct evpl_global_config *config)
 
 #endif /* ifdef HAVE_XLIO */
 
+#ifdef HAVE_XDP
+    if (config->xdp_enabled) {
+        evpl_framework_init(evpl_shared, EVPL_FRAMEWORK_XDP,
+                            &evpl_framework_xdp);
+        evpl_protocol_init(evpl_shared, EVPL_DATAGRAM_XDP_UDP, &evpl_xdp_udp);
+    }
+#endif /* ifdef HAVE_XDP */
+
+#ifdef HAVE_LIBFABRIC
+    if (config->libfabric_enabled) {
+        evpl_framework_init(evpl_shared, EVPL_FRAMEWORK_LIBFABRIC,
+                            &evpl_framework_libfabric);
+        evpl_protocol_init(evpl_shared, EVPL_DATAGRAM_LIBFABRIC_RDM,
+                           &evpl_libfabric_rdm_datagram);
+        evpl_protocol_init(evpl_shared, EVPL_DATAGRAM_LIBFABRIC_MSG,
+                           &evpl_libfabric_msg_datagram);
+        evpl_protocol_init(evpl_shared, EVPL_STREAM_LIBFABRIC_MSG,
+                           &evpl_libfabric_msg_stream);
+    }
+#endif /* ifdef HAVE_LIBFABRIC */
+
+    if (config->shm_enabled) {
+        evpl_framework_init(evpl_shared, EVPL_FRAMEWORK_SHM,
+                            &evpl_framework_shm);
+        evpl_protocol_init(evpl_shared, EVPL_DATAGRAM_SHM, &evpl_shm_datagram);
+        evpl_protocol_init(evpl_shared, EVPL_STREAM_SHM, &evpl_shm_stream);
+    }
+
+    if (config->loopback_enabled) {
+        evpl_framework_init(evpl_shared, EVPL_FRAMEWORK_LOOPBACK,
+                            &evpl_framework_loopback);
+        evpl_protocol_init(evpl_shared, EVPL_DATAGRAM_LOOPBACK,
+                           &evpl_loopback_datagram);
+        evpl_protocol_init(evpl_shared, EVPL_STREAM_LOOPBACK,
+                           &evpl_loopback_stream);
+    }
+
 } /* evpl_shared_init */
 
 extern evpl_log_fn EvplLog;
@@ -163,7 +235,12 @@ evpl_cleanup()
         evpl_endpoint_close(endpoint);
     }
 
+    evpl_resolver_destroy(evpl_shared->resolver);
+
     evpl_allocator_destroy(evpl_shared->allocator);
+    evpl_allocator_destroy(evpl_shared->long_lived_allocator);
+    evpl_buddy_destroy(evpl_shared->buddy);
+    evpl_memory_map_destroy(evpl_shared->memory_map);
 
     for (i = 0; i < EVPL_NUM_FRAMEWORK; ++i) {
         if (evpl_shared->framework_private[i]) {
@@ -241,6 +318,10 @@ evpl_global_config_release(struct evpl_global_config *config)
     pthread_mutex_unlock(&evpl_shared->lock);
 } /* evpl_release_config */
 
+static void
+evpl_bind_resolve_check(
+    struct evpl *evpl);
+
 static void
 evpl_ipc_callback(
     struct evpl       *evpl,
@@ -291,6 +372,10 @@ evpl_ipc_callback(
 
     pthread_mutex_unlock(&evpl->lock);
 
+    if (evpl->num_resolving_binds) {
+        evpl_bind_resolve_check(evpl);
+    }
+
 } /* evpl_stop_callback */
 
 struct evpl *
@@ -300,18 +385,21 @@ evpl_create(struct evpl_thread_config *config)
 
     __evpl_init();
 
-    evpl = evpl_zalloc(sizeof(*evpl));
+    evpl = evpl_zalloc_tagged(sizeof(*evpl), EVPL_MEMORY_TAG_CORE);
 
     pthread_mutex_init(&evpl->lock, NULL);
 
-    evpl->poll     = evpl_calloc(256, sizeof(struct evpl_poll));
+    evpl->poll = evpl_calloc_tagged(256, sizeof(struct evpl_poll),
+                                    EVPL_MEMORY_TAG_CORE);
     evpl->max_poll = 256;
 
-    evpl->active_events     = evpl_calloc(256, sizeof(struct evpl_event *));
+    evpl->active_events = evpl_calloc_tagged(256, sizeof(struct evpl_event *),
+                                             EVPL_MEMORY_TAG_CORE);
     evpl->max_active_events = 256;
 
-    evpl->active_deferrals = evpl_calloc(256, sizeof(struct
-                                                     evpl_deferral *));
+    evpl->active_deferrals = evpl_calloc_tagged(256,
+                                                sizeof(struct evpl_deferral *),
+                                                EVPL_MEMORY_TAG_CORE);
     evpl->max_active_deferrals = 256;
 
     if (config) {
@@ -322,6 +410,8 @@ evpl_create(struct evpl_thread_config *config)
 
     evpl_core_init(&evpl->core, 64);
 
+    evpl->buffer_owner = evpl_buffer_owner_attach();
+
     evpl->running = 1;
     evpl->eventfd = eventfd(0, EFD_NONBLOCK);
 
@@ -335,6 +425,228 @@ evpl_create(struct evpl_thread_config *config)
     return evpl;
 } /* evpl_init */
 
+static void
+evpl_recv_stage_release(struct evpl *evpl)
+{
+    int i;
+
+    for (i = 0; i < 2; ++i) {
+        if (evpl->recv_stage[i].length) {
+            evpl_iovec_release(&evpl->recv_stage[i]);
+            evpl->recv_stage[i].length = 0;
+        }
+    }
+} /* evpl_recv_stage_release */
+
+/*
+ * Revalidate a cached endpoint address against the shared endpoint.  Its
+ * private copy is only replaced when the endpoint's generation changes.
+ */
+static struct evpl_address *
+evpl_address_cache_refresh(
+    struct evpl               *evpl,
+    struct evpl_endpoint      *endpoint,
+    struct evpl_address_cache *entry)
+{
+    struct evpl_address *shared;
+    uint64_t             generation;
+
+    if (!entry) {
+        entry           = evpl_zalloc(sizeof(*entry));
+        entry->endpoint = endpoint;
+        HASH_ADD_PTR(evpl->address_cache, endpoint, entry);
+    }
+
+    shared = evpl_endpoint_resolve_generation(endpoint, &generation);
+
+    if (!shared) {
+        return NULL;
+    }
+
+    if (generation != entry->generation) {
+
+        if (entry->address) {
+            evpl_address_release(entry->address);
+        }
+
+        entry->address    = evpl_address_init(shared->addr, shared->addrlen);
+        entry->generation = generation;
+    }
+
+    evpl_address_release(shared);
+
+    entry->epoch = evpl->address_epoch;
+
+    return entry->address;
+} /* evpl_address_cache_refresh */
+
+static inline struct evpl_address *
+evpl_address_cache_lookup(
+    struct evpl          *evpl,
+    struct evpl_endpoint *endpoint)
+{
+    struct evpl_address_cache *entry;
+
+    HASH_FIND_PTR(evpl->address_cache, &endpoint, entry);
+
+    /*
+     * The generation is unique to the endpoint's current address, so an
+     * entry left behind by a closed endpoint whose memory was reused for
+     * this one can never match.
+     */
+    if (likely(entry && entry->epoch == evpl->address_epoch &&
+               entry->generation == endpoint->generation)) {
+        return entry->address;
+    }
+
+    return evpl_address_cache_refresh(evpl, endpoint, entry);
+} /* evpl_address_cache_lookup */
+
+static void
+evpl_address_cache_free(
+    struct evpl               *evpl,
+    struct evpl_address_cache *entry)
+{
+    HASH_DEL(evpl->address_cache, entry);
+
+    if (entry->address) {
+        evpl_address_release(entry->address);
+    }
+
+    evpl_free(entry);
+} /* evpl_address_cache_free */
+
+static void
+evpl_address_cache_tick(struct evpl *evpl)
+{
+    struct evpl_address_cache *entry, *tmp;
+    struct timespec            now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (evpl_ts_interval(&now, &evpl->address_epoch_ts) >=
+        EVPL_ADDRESS_CACHE_EPOCH_NS) {
+        evpl->address_epoch_ts = now;
+        evpl->address_epoch++;
+
+        /*
+         * Entries are stamped on their first use in an epoch, so one
+         * not used for a whole epoch is dropped.  Nothing sends to a
+         * closed endpoint, so this is also what reclaims their entries.
+         */
+        HASH_ITER(hh, evpl->address_cache, entry, tmp)
+        {
+            if (entry->epoch + 1 < evpl->address_epoch) {
+                evpl_address_cache_free(evpl, entry);
+            }
+        }
+    }
+} /* evpl_address_cache_tick */
+
+static void
+evpl_address_cache_destroy(struct evpl *evpl)
+{
+    struct evpl_address_cache *entry, *tmp;
+
+    HASH_ITER(hh, evpl->address_cache, entry, tmp)
+    {
+        evpl_address_cache_free(evpl, entry);
+    }
+} /* evpl_address_cache_destroy */
+
+struct evpl_address *
+evpl_address_intern(
+    struct evpl           *evpl,
+    const struct sockaddr *addr,
+    socklen_t              addrlen)
+{
+    struct evpl_address_intern *entry;
+
+    if (unlikely(addrlen > sizeof(struct sockaddr_storage))) {
+        addrlen = sizeof(struct sockaddr_storage);
+    }
+
+    HASH_FIND(hh, evpl->address_intern, addr, addrlen, entry);
+
+    if (likely(entry)) {
+        if (entry != evpl->address_lru) {
+            DL_DELETE(evpl->address_lru, entry);
+            DL_PREPEND(evpl->address_lru, entry);
+        }
+    } else {
+
+        if (evpl->num_address_intern < EVPL_ADDRESS_INTERN_MAX) {
+            entry = evpl_zalloc(sizeof(*entry));
+            evpl->num_address_intern++;
+        } else {
+            /* Evict the least recently seen, its users keep their references */
+            entry = evpl->address_lru->prev;
+            HASH_DELETE(hh, evpl->address_intern, entry);
+            DL_DELETE(evpl->address_lru, entry);
+            evpl_address_release(entry->address);
+        }
+
+        entry->address = evpl_address_init((struct sockaddr *) addr, addrlen);
+
+        HASH_ADD_KEYPTR(hh, evpl->address_intern, entry->address->addr,
+                        addrlen, entry);
+        DL_PREPEND(evpl->address_lru, entry);
+    }
+
+    evpl_address_incref(entry->address);
+
+    return entry->address;
+} /* evpl_address_intern */
+
+static void
+evpl_address_intern_destroy(struct evpl *evpl)
+{
+    struct evpl_address_intern *entry, *tmp;
+
+    HASH_ITER(hh, evpl->address_intern, entry, tmp)
+    {
+        HASH_DELETE(hh, evpl->address_intern, entry);
+        evpl_address_release(entry->address);
+        evpl_free(entry);
+    }
+
+    evpl->address_lru        = NULL;
+    evpl->num_address_intern = 0;
+} /* evpl_address_intern_destroy */
+
+static void
+evpl_trim_idle(struct evpl *evpl)
+{
+    struct evpl_bind *bind;
+    struct timespec   now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (evpl_ts_interval(&now, &evpl->last_trim_ts) < EVPL_BIND_TRIM_NS) {
+        return;
+    }
+
+    evpl->last_trim_ts = now;
+
+    /*
+     * Give back receive staging and any bind rings that are currently
+     * empty.  Busy binds simply reallocate their rings on next use.
+     */
+
+    evpl_recv_stage_release(evpl);
+
+    DL_FOREACH(evpl->binds, bind)
+    {
+        if (evpl_iovec_ring_is_empty(&bind->iovec_send)) {
+            evpl_bind_coalesce_release(bind);
+        }
+
+        evpl_iovec_ring_trim(&bind->iovec_send);
+        evpl_iovec_ring_trim(&bind->iovec_recv);
+        evpl_dgram_ring_trim(&bind->dgram_send);
+    }
+} /* evpl_trim_idle */
+
 void
 evpl_continue(struct evpl *evpl)
 {
@@ -347,6 +659,12 @@ evpl_continue(struct evpl *evpl)
     struct timespec       now;
     uint64_t              elapsed;
 
+    evpl_buffer_owner_poll();
+
+    if (evpl->address_cache) {
+        evpl_address_cache_tick(evpl);
+    }
+
     if (evpl->num_poll) {
 
         clock_gettime(CLOCK_MONOTONIC, &now);
@@ -403,6 +721,11 @@ evpl_continue(struct evpl *evpl)
 
     } else {
 
+        if (msecs) {
+            /* Nothing is pending, so we are about to block */
+            evpl_trim_idle(evpl);
+        }
+
         n = evpl_core_wait(&evpl->core, msecs);
 
         if (evpl->pending_close_binds && n == 0) {
@@ -419,6 +742,14 @@ evpl_continue(struct evpl *evpl)
     for (i = 0; i < evpl->num_active_events;) {
         event = evpl->active_events[i];
 
+        /* Removed while active */
+        if (unlikely(!event)) {
+            evpl->active_events[i] =
+                evpl->active_events[evpl->num_active_events - 1];
+            --evpl->num_active_events;
+            continue;
+        }
+
         if ((event->flags & EVPL_READ_READY) == EVPL_READ_READY) {
             event->read_callback(evpl, event);
         }
@@ -512,6 +843,9 @@ evpl_listener_accept(
 
     request->local_address   = listen_bind->local;
     request->remote_address  = remote_address;
+
+    /* Each accepted bind releases its local address when destroyed */
+    evpl_address_incref(listen_bind->local);
     request->protocol        = listen_bind->protocol;
     request->attach_callback = binding->attach_callback;
     request->accepted        = accepted;
@@ -580,10 +914,11 @@ evpl_listener_callback(
 
         listener->binds[listener->num_binds++] = bind;
 
-        evpl_free(request);
-
+        request->done = 1;
     }
 
+    pthread_cond_broadcast(&listener->listened);
+
     pthread_mutex_unlock(&listener->lock);
 
 } /* evpl_listener_callback */
@@ -622,6 +957,7 @@ evpl_listener_create(void)
     listener = evpl_zalloc(sizeof(*listener));
 
     pthread_mutex_init(&listener->lock, NULL);
+    pthread_cond_init(&listener->listened, NULL);
 
     listener->thread = evpl_thread_create(NULL, evpl_listener_init, NULL, listener);
 
@@ -645,6 +981,7 @@ evpl_listener_destroy(struct evpl_listener *listener)
     evpl_core_abort_if(listener->num_attached,
                        "evpl_listener_destroy called with attached evpl contexts");
 
+    pthread_cond_destroy(&listener->listened);
     pthread_mutex_destroy(&listener->lock);
     evpl_free(listener->binds);
     evpl_free(listener->attached);
@@ -716,17 +1053,26 @@ evpl_listen(
     request = evpl_zalloc(sizeof(*request));
 
     request->protocol_id = protocol_id;
-    request->address     = evpl_endpoint_resolve(endpoint);
+    request->address     = evpl_endpoint_resolve_wait(endpoint);
 
     pthread_mutex_lock(&listener->lock);
     DL_APPEND(listener->requests, request);
-    pthread_mutex_unlock(&listener->lock);
 
     rc = write(listener->eventfd, &value, sizeof(value));
 
     evpl_core_abort_if(rc != sizeof(value),
                        "evpl_listen: write to eventfd failed");
 
+    /* Return only once the address accepts connections, so that a
+     * connect issued right after cannot race the listener thread */
+    while (!request->done) {
+        pthread_cond_wait(&listener->listened, &listener->lock);
+    }
+
+    pthread_mutex_unlock(&listener->lock);
+
+    evpl_free(request);
+
 } /* evpl_listen */
 
 struct evpl_endpoint *
@@ -745,6 +1091,12 @@ evpl_endpoint_create(
 
     pthread_rwlock_init(&ep->lock, NULL);
 
+    /* Literal addresses need no lookup and never go stale */
+    if (evpl_resolver_lookup(ep, AI_NUMERICHOST, &ep->resolved_addr) == 0) {
+        ep->numeric    = 1;
+        ep->generation = atomic_fetch_add(&evpl_shared->generation, 1) + 1;
+    }
+
     pthread_mutex_lock(&evpl_shared->lock);
     DL_APPEND(evpl_shared->endpoints, ep);
     pthread_mutex_unlock(&evpl_shared->lock);
@@ -755,6 +1107,8 @@ evpl_endpoint_create(
 void
 evpl_endpoint_close(struct evpl_endpoint *endpoint)
 {
+    evpl_resolver_cancel(evpl_shared->resolver, endpoint);
+
     pthread_rwlock_wrlock(&endpoint->lock);
 
     pthread_mutex_lock(&evpl_shared->lock);
@@ -771,84 +1125,136 @@ evpl_endpoint_close(struct evpl_endpoint *endpoint)
 } /* evpl_endpoint_close */
 
 struct evpl_address *
-evpl_endpoint_resolve(struct evpl_endpoint *endpoint)
+evpl_endpoint_resolve_generation(
+    struct evpl_endpoint *endpoint,
+    uint64_t             *generation)
 {
-    char                 port_str[8];
-    struct addrinfo      hints, *ai, *p, **pp;
     struct evpl_address *addr;
     struct timespec      now;
     uint64_t             age_ms;
-    int                  rc, i, n;
-
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    int                  stale;
 
     pthread_rwlock_rdlock(&endpoint->lock);
 
-    if (likely(endpoint->resolved_addr)) {
+    addr        = endpoint->resolved_addr;
+    *generation = endpoint->generation;
+
+    if (likely(addr)) {
+        evpl_address_incref(addr);
+    }
+
+    if (likely(endpoint->numeric)) {
+        pthread_rwlock_unlock(&endpoint->lock);
+        return addr;
+    }
+
+    if (addr) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
         age_ms = (now.tv_sec - endpoint->last_resolved.tv_sec) * 1000 +
             (now.tv_nsec - endpoint->last_resolved.tv_nsec) / 1000000;
 
-        if (likely(age_ms <= evpl_shared->config->resolve_timeout_ms)) {
-            addr = endpoint->resolved_addr;
-            evpl_address_incref(addr);
-            pthread_rwlock_unlock(&endpoint->lock);
-            return addr;
-        }
+        stale = age_ms > evpl_shared->config->resolve_timeout_ms;
+    } else {
+        stale = 1;
     }
 
     pthread_rwlock_unlock(&endpoint->lock);
-    pthread_rwlock_wrlock(&endpoint->lock);
 
-    if (endpoint->resolved_addr) {
-        evpl_address_release(endpoint->resolved_addr);
+    /* Keep serving a stale address while it is refreshed in the background */
+    if (unlikely(stale)) {
+        evpl_resolver_request(evpl_shared->resolver, endpoint);
     }
 
-    snprintf(port_str, sizeof(port_str), "%d", endpoint->port);
+    return addr;
+} /* evpl_endpoint_resolve_generation */
+
+struct evpl_address *
+evpl_endpoint_resolve(struct evpl_endpoint *endpoint)
+{
+    uint64_t generation;
+
+    return evpl_endpoint_resolve_generation(endpoint, &generation);
+} /* evpl_endpoint_resolve */
 
-    memset(&hints, 0, sizeof hints);
-    hints.ai_family   = AF_INET;
-    hints.ai_socktype = 0; // SOCK_DGRAM;
-    hints.ai_flags    = 0;
+struct evpl_address *
+evpl_endpoint_resolve_wait(struct evpl_endpoint *endpoint)
+{
+    struct evpl_address *addr;
+    int                  rc;
 
-    rc = getaddrinfo(endpoint->address, port_str, &hints, &ai);
+    addr = evpl_endpoint_resolve(endpoint);
 
-    if (unlikely(rc < 0)) {
-        pthread_rwlock_unlock(&endpoint->lock);
-        return NULL;
+    if (addr) {
+        return addr;
     }
 
-    n = 0;
+    rc = evpl_resolver_lookup(endpoint, 0, &addr);
 
-    for (p = ai; p != NULL; p = p->ai_next) {
-        n++;
+    if (rc) {
+        evpl_core_error("failed to resolve %s: %s",
+                        endpoint->address, gai_strerror(rc));
+        return NULL;
     }
 
-    if (n) {
-        pp = alloca(n * sizeof(struct addrinfo *));
+    return addr;
+} /* evpl_endpoint_resolve_wait */
 
-        for (p = ai, i = 0; p != NULL; p = p->ai_next, i++) {
-            pp[i] = p;
-        }
+/*
+ * Destroy a bind whose remote never resolved.  The protocol never saw
+ * it, so there is nothing for the protocol to close.
+ */
+static void
+evpl_bind_abandon(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    bind->flags &= ~EVPL_BIND_RESOLVING;
+    bind->flags |= EVPL_BIND_PENDING_CLOSED;
+    evpl->num_resolving_binds--;
 
-        p = pp[rand() % n];
+    DL_DELETE(evpl->binds, bind);
+    DL_APPEND(evpl->pending_close_binds, bind);
 
-        addr = evpl_address_init(p->ai_addr, p->ai_addrlen);
+    evpl_bind_destroy(evpl, bind);
+} /* evpl_bind_abandon */
 
-        endpoint->resolved_addr = addr;
-        endpoint->last_resolved = now;
+static void
+evpl_bind_resolve_check(struct evpl *evpl)
+{
+    struct evpl_bind    *bind, *tmp;
+    struct evpl_address *addr;
 
-        evpl_address_incref(addr);
+    DL_FOREACH_SAFE(evpl->binds, bind, tmp)
+    {
+        if (!(bind->flags & EVPL_BIND_RESOLVING)) {
+            continue;
+        }
 
-    } else {
-        addr = NULL;
-    }
+        if (!evpl_resolver_poll(evpl_shared->resolver, &bind->resolve, &addr)) {
+            continue;
+        }
 
-    pthread_rwlock_unlock(&endpoint->lock);
+        if (!addr) {
+            evpl_core_error("connect to %s failed, address did not resolve",
+                            bind->resolve.endpoint->address);
+            evpl_bind_abandon(evpl, bind);
+            continue;
+        }
 
-    freeaddrinfo(ai);
+        bind->flags &= ~EVPL_BIND_RESOLVING;
+        evpl->num_resolving_binds--;
 
-    return addr;
-} /* evpl_endpoint_resolve */
+        bind->remote = addr;
+
+        bind->protocol->connect(evpl, bind);
+
+        /* Anything sent while we were resolving can go out now */
+        if (!evpl_bind_send_empty(bind)) {
+            evpl_defer(evpl, &bind->flush_deferral);
+        }
+    }
+} /* evpl_bind_resolve_check */
 
 struct evpl_bind *
 evpl_connect(
@@ -867,12 +1273,21 @@ evpl_connect(
                        "Called evpl_connect with non-connection oriented protocol");
 
     bind = evpl_bind_prepare(evpl, protocol,
-                             local_endpoint ? evpl_endpoint_resolve(local_endpoint) : NULL,
+                             local_endpoint ? evpl_endpoint_resolve_wait(local_endpoint) : NULL,
                              evpl_endpoint_resolve(remote_endpoint));
     bind->notify_callback  = notify_callback;
     bind->segment_callback = segment_callback;
     bind->private_data     = private_data;
 
+    if (unlikely(!bind->remote)) {
+        /* Connect once the resolver wakes us with an address */
+        bind->flags |= EVPL_BIND_RESOLVING;
+        evpl->num_resolving_binds++;
+        evpl_resolver_wait(evpl_shared->resolver, evpl, remote_endpoint,
+                           &bind->resolve);
+        return bind;
+    }
+
     bind->protocol->connect(evpl, bind);
 
     return bind;
@@ -892,7 +1307,7 @@ evpl_bind(
     evpl_core_abort_if(!protocol->bind,
                        "Called evpl_bind with connection oriented protocol");
 
-    bind = evpl_bind_prepare(evpl, protocol, evpl_endpoint_resolve(endpoint), NULL);
+    bind = evpl_bind_prepare(evpl, protocol, evpl_endpoint_resolve_wait(endpoint), NULL);
 
     bind->notify_callback  = callback;
     bind->segment_callback = NULL;
@@ -913,6 +1328,13 @@ evpl_destroy(struct evpl *evpl)
     /* Push any open binds into pending close state */
     while (evpl->binds) {
         bind = evpl->binds;
+
+        if (bind->flags & EVPL_BIND_RESOLVING) {
+            evpl_resolver_unwait(evpl_shared->resolver, &bind->resolve);
+            evpl_bind_abandon(evpl, bind);
+            continue;
+        }
+
         bind->protocol->pending_close(evpl, bind);
         bind->flags |= EVPL_BIND_PENDING_CLOSED;
         DL_DELETE(evpl->binds, bind);
@@ -920,18 +1342,20 @@ evpl_destroy(struct evpl *evpl)
     }
 
     /* Pump events until we have no pending close binds */
-    while (evpl->pending_close_binds) {
+    while (evpl->pending_close_binds || evpl->num_lingering) {
         evpl_continue(evpl);
     }
 
-    while (evpl->free_binds) {
-        bind = evpl->free_binds;
-        DL_DELETE(evpl->free_binds, bind);
-
-        evpl_iovec_ring_free(&bind->iovec_send);
-        evpl_iovec_ring_free(&bind->iovec_recv);
-        evpl_dgram_ring_free(&bind->dgram_send);
-        evpl_free(bind);
+    for (i = 0; i < EVPL_NUM_PROTO; ++i) {
+        while (evpl->free_binds[i]) {
+            bind = evpl->free_binds[i];
+            DL_DELETE(evpl->free_binds[i], bind);
+
+            evpl_iovec_ring_free(&bind->iovec_send);
+            evpl_iovec_ring_free(&bind->iovec_recv);
+            evpl_dgram_ring_free(&bind->dgram_send);
+            evpl_free_tagged(bind, EVPL_MEMORY_TAG_BIND);
+        }
     }
 
     for (i = 0; i < EVPL_NUM_FRAMEWORK; ++i) {
@@ -948,18 +1372,29 @@ evpl_destroy(struct evpl *evpl)
         evpl_buffer_release(evpl->current_buffer);
     }
 
+    if (evpl->long_lived_buffer) {
+        evpl_buffer_release(evpl->long_lived_buffer);
+    }
+
     if (evpl->datagram_buffer) {
         evpl_buffer_release(evpl->datagram_buffer);
     }
 
+    evpl_recv_stage_release(evpl);
+
+    evpl_address_cache_destroy(evpl);
+    evpl_address_intern_destroy(evpl);
+
+    evpl_buffer_owner_detach(evpl->buffer_owner);
+
     evpl_core_destroy(&evpl->core);
 
     close(evpl->eventfd);
 
-    evpl_free(evpl->active_events);
-    evpl_free(evpl->active_deferrals);
-    evpl_free(evpl->poll);
-    evpl_free(evpl);
+    evpl_free_tagged(evpl->active_events, EVPL_MEMORY_TAG_CORE);
+    evpl_free_tagged(evpl->active_deferrals, EVPL_MEMORY_TAG_CORE);
+    evpl_free_tagged(evpl->poll, EVPL_MEMORY_TAG_CORE);
+    evpl_free_tagged(evpl, EVPL_MEMORY_TAG_CORE);
 } /* evpl_destroy */
 
 static void
@@ -976,6 +1411,12 @@ evpl_bind_close_deferral(
                        "bind %p in close deferral but not pending close ", bind)
     ;
 
+    if (bind->flags & EVPL_BIND_RESOLVING) {
+        evpl_resolver_unwait(evpl_shared->resolver, &bind->resolve);
+        evpl_bind_abandon(evpl, bind);
+        return;
+    }
+
     DL_DELETE(evpl->binds, bind);
     DL_APPEND(evpl->pending_close_binds, bind);
     bind->protocol->pending_close(evpl, bind);
@@ -988,15 +1429,32 @@ evpl_bind_flush_deferral(
 {
     struct evpl_bind *conn = private_data;
 
+    evpl_core_abort_if(conn->flags & EVPL_BIND_CLOSED,
+                       "bind %p flushed after close", conn);
+
     if (unlikely(evpl->running == 0)) {
         return;
     }
 
+    /* Sends queue up until the connection is made */
+    if (unlikely(conn->flags & EVPL_BIND_RESOLVING)) {
+        return;
+    }
+
     if (conn->protocol->flush) {
         conn->protocol->flush(evpl, conn);
     }
 } /* evpl_bind_flush_deferral */
 
+void
+evpl_framework_reregister(void)
+{
+    evpl_allocator_reregister(evpl_shared->allocator);
+    evpl_allocator_reregister(evpl_shared->long_lived_allocator);
+    evpl_allocator_reregister(evpl_shared->buddy->allocator);
+    evpl_memory_map_reregister(evpl_shared->memory_map);
+} /* evpl_framework_reregister */
+
 void
 evpl_attach_framework_shared(enum evpl_framework_id framework_id)
 {
@@ -1008,7 +1466,7 @@ evpl_attach_framework_shared(enum evpl_framework_id framework_id)
 
         evpl_shared->framework_private[framework->id] = framework->init();
 
-        evpl_allocator_reregister(evpl_shared->allocator);
+        evpl_framework_reregister();
     }
 
     pthread_mutex_unlock(&evpl_shared->lock);
@@ -1037,19 +1495,25 @@ evpl_bind_prepare(
     struct evpl_address  *local,
     struct evpl_address  *remote)
 {
-    struct evpl_framework *framework = protocol->framework;
+    struct evpl_framework *framework    = protocol->framework;
+    unsigned int           private_size = protocol->bind_private_size;
     struct evpl_bind      *bind;
 
     if (framework) {
         evpl_attach_framework(evpl, framework->id);
     }
 
-    if (evpl->free_binds) {
-        bind = evpl->free_binds;
-        DL_DELETE(evpl->free_binds, bind);
+    if (!private_size) {
+        private_size = EVPL_MAX_PRIVATE;
+    }
+
+    if (evpl->free_binds[protocol->id]) {
+        bind = evpl->free_binds[protocol->id];
+        DL_DELETE(evpl->free_binds[protocol->id], bind);
     } else {
 
-        bind = evpl_zalloc(sizeof(*bind) + EVPL_MAX_PRIVATE);
+        bind = evpl_zalloc_tagged(sizeof(*bind) + private_size,
+                                  EVPL_MEMORY_TAG_BIND);
 
         evpl_iovec_ring_alloc(
             &bind->iovec_send,
@@ -1084,8 +1548,11 @@ evpl_bind_prepare(
     bind->local    = local;
     bind->remote   = remote;
 
+    bind->send_high = evpl_shared->config->send_high_watermark;
+    bind->send_low  = evpl_shared->config->send_low_watermark;
+    bind->recv_max  = evpl_shared->config->recv_max;
 
-    memset(bind + 1, 0, EVPL_MAX_PRIVATE);
+    memset(bind + 1, 0, private_size);
 
     return bind;
 } /* evpl_bind_prepare */
@@ -1221,14 +1688,22 @@ evpl_event_mark_error(
 
 } /* evpl_event_mark_error */
 
+void
+evpl_event_clear_error(struct evpl_event *event)
+{
+    event->flags &= ~EVPL_ERROR;
+} /* evpl_event_clear_error */
+
 static struct evpl_buffer *
-evpl_buffer_alloc(struct evpl *evpl)
+evpl_buffer_alloc(
+    struct evpl           *evpl,
+    struct evpl_allocator *allocator)
 {
     struct evpl_buffer *buffer;
 
-    buffer = evpl_allocator_alloc(evpl_shared->allocator);
+    buffer = evpl_allocator_alloc(allocator);
 
-    atomic_store(&buffer->refcnt, 1);
+    evpl_buffer_own(buffer);
     buffer->used      = 0;
     buffer->external1 = NULL;
     buffer->external2 = NULL;
@@ -1236,26 +1711,51 @@ evpl_buffer_alloc(struct evpl *evpl)
     return buffer;
 } /* evpl_buffer_alloc */
 
-int
-evpl_iovec_reserve(
-    struct evpl       *evpl,
-    unsigned int       length,
-    unsigned int       alignment,
-    unsigned int       max_iovecs,
-    struct evpl_iovec *r_iovec)
+/*
+ * Each arena is a buffer we are currently carving iovecs from
+ * plus the allocator that replaces it once it fills up.
+ * Short lived allocations come from large buffers, long lived
+ * allocations from small ones so that a lingering reference
+ * pins as little memory as possible.
+ */
+
+static inline struct evpl_buffer **
+evpl_iovec_arena(
+    struct evpl             *evpl,
+    enum evpl_iovec_lifetime lifetime,
+    struct evpl_allocator  **r_allocator)
 {
-    struct evpl_buffer *buffer = evpl->current_buffer;
+    if (lifetime == EVPL_IOVEC_LIFETIME_LONG) {
+        *r_allocator = evpl_shared->long_lived_allocator;
+        return &evpl->long_lived_buffer;
+    } else {
+        *r_allocator = evpl_shared->allocator;
+        return &evpl->current_buffer;
+    }
+} /* evpl_iovec_arena */
+
+static int
+evpl_iovec_reserve_arena(
+    struct evpl           *evpl,
+    struct evpl_buffer   **current,
+    struct evpl_allocator *allocator,
+    unsigned int           length,
+    unsigned int           alignment,
+    unsigned int           max_iovecs,
+    struct evpl_iovec     *r_iovec)
+{
+    struct evpl_buffer *buffer = *current;
     int                 pad, left = length, chunk;
     int                 niovs = 0;
     struct evpl_iovec  *iovec;
 
     do{
 
-        if (evpl->current_buffer == NULL) {
-            evpl->current_buffer = evpl_buffer_alloc(evpl);
+        if (*current == NULL) {
+            *current = evpl_buffer_alloc(evpl, allocator);
         }
 
-        buffer = evpl->current_buffer;
+        buffer = *current;
 
         pad = evpl_buffer_pad(buffer, alignment);
 
@@ -1263,7 +1763,7 @@ evpl_iovec_reserve(
 
         if (chunk < pad + left && niovs + 1 <= max_iovecs) {
             evpl_buffer_release(buffer);
-            evpl->current_buffer = NULL;
+            *current = NULL;
             continue;
         }
 
@@ -1285,20 +1785,21 @@ evpl_iovec_reserve(
 
         if (left) {
             evpl_buffer_release(buffer);
-            evpl->current_buffer = NULL;
+            *current = NULL;
         }
 
     } while (left);
 
     return niovs;
-} /* evpl_iovec_reserve */
+} /* evpl_iovec_reserve_arena */
 
-void
-evpl_iovec_commit(
-    struct evpl       *evpl,
-    unsigned int       alignment,
-    struct evpl_iovec *iovecs,
-    int                niovs)
+static void
+evpl_iovec_commit_arena(
+    struct evpl         *evpl,
+    struct evpl_buffer **current,
+    unsigned int         alignment,
+    struct evpl_iovec   *iovecs,
+    int                  niovs)
 {
     int                 i;
     struct evpl_iovec  *iovec;
@@ -1310,42 +1811,81 @@ evpl_iovec_commit(
 
         buffer = evpl_iovec_buffer(iovec);
 
-        if (buffer) {
-
-        }
-        atomic_fetch_add_explicit(&buffer->refcnt, 1, memory_order_relaxed);
+        evpl_buffer_addref(buffer);
 
         buffer->used  = (iovec->data + iovec->length) - buffer->data;
         buffer->used += evpl_buffer_pad(buffer, alignment);
     }
 
-    buffer = evpl->current_buffer;
+    buffer = *current;
 
     if (buffer && buffer->size - buffer->used < 64) {
         evpl_buffer_release(buffer);
-        evpl->current_buffer = NULL;
+        *current = NULL;
     }
-} /* evpl_iovec_commit */
+} /* evpl_iovec_commit_arena */
 
 int
-evpl_iovec_alloc(
+evpl_iovec_reserve(
     struct evpl       *evpl,
     unsigned int       length,
     unsigned int       alignment,
     unsigned int       max_iovecs,
     struct evpl_iovec *r_iovec)
 {
-    int niovs;
+    return evpl_iovec_reserve_arena(evpl, &evpl->current_buffer,
+                                    evpl_shared->allocator,
+                                    length, alignment, max_iovecs, r_iovec);
+} /* evpl_iovec_reserve */
+
+void
+evpl_iovec_commit(
+    struct evpl       *evpl,
+    unsigned int       alignment,
+    struct evpl_iovec *iovecs,
+    int                niovs)
+{
+    evpl_iovec_commit_arena(evpl, &evpl->current_buffer, alignment,
+                            iovecs, niovs);
+} /* evpl_iovec_commit */
 
-    niovs = evpl_iovec_reserve(evpl, length, alignment, max_iovecs, r_iovec);
+int
+evpl_iovec_alloc_lifetime(
+    struct evpl             *evpl,
+    unsigned int             length,
+    unsigned int             alignment,
+    unsigned int             max_iovecs,
+    enum evpl_iovec_lifetime lifetime,
+    struct evpl_iovec       *r_iovec)
+{
+    struct evpl_allocator *allocator;
+    struct evpl_buffer   **current;
+    int                    niovs;
+
+    current = evpl_iovec_arena(evpl, lifetime, &allocator);
+
+    niovs = evpl_iovec_reserve_arena(evpl, current, allocator, length,
+                                     alignment, max_iovecs, r_iovec);
 
     if (unlikely(niovs < 0)) {
         return niovs;
     }
 
-    evpl_iovec_commit(evpl, alignment, r_iovec, niovs);
+    evpl_iovec_commit_arena(evpl, current, alignment, r_iovec, niovs);
 
     return niovs;
+} /* evpl_iovec_alloc_lifetime */
+
+int
+evpl_iovec_alloc(
+    struct evpl       *evpl,
+    unsigned int       length,
+    unsigned int       alignment,
+    unsigned int       max_iovecs,
+    struct evpl_iovec *r_iovec)
+{
+    return evpl_iovec_alloc_lifetime(evpl, length, alignment, max_iovecs,
+                                     EVPL_IOVEC_LIFETIME_SHORT, r_iovec);
 } /* evpl_iovec_alloc */
 
 void
@@ -1355,13 +1895,38 @@ evpl_iovec_alloc_whole(
 {
     struct evpl_buffer *buffer;
 
-    buffer = evpl_buffer_alloc(evpl);
+    buffer = evpl_buffer_alloc(evpl, evpl_shared->allocator);
 
     r_iovec->data    = buffer->data;
     r_iovec->length  = buffer->size;
     r_iovec->private = buffer;
 } /* evpl_iovec_alloc_whole */
 
+int
+evpl_iovec_alloc_contiguous(
+    struct evpl       *evpl,
+    unsigned int       length,
+    struct evpl_iovec *r_iovec)
+{
+    struct evpl_buffer *buffer;
+
+    buffer = evpl_buddy_alloc(evpl_shared->buddy, length);
+
+    if (unlikely(!buffer)) {
+        return 0;
+    }
+
+    evpl_buffer_own(buffer);
+
+    buffer->used = length;
+
+    r_iovec->data    = buffer->data;
+    r_iovec->length  = length;
+    r_iovec->private = buffer;
+
+    return 1;
+} /* evpl_iovec_alloc_contiguous */
+
 void
 evpl_iovec_alloc_datagram(
     struct evpl       *evpl,
@@ -1371,7 +1936,8 @@ evpl_iovec_alloc_datagram(
     struct evpl_buffer *buffer;
 
     if (!evpl->datagram_buffer) {
-        evpl->datagram_buffer = evpl_buffer_alloc(evpl);
+        evpl->datagram_buffer = evpl_buffer_alloc(evpl,
+                                                  evpl_shared->allocator);
     }
 
     buffer = evpl->datagram_buffer;
@@ -1381,7 +1947,7 @@ evpl_iovec_alloc_datagram(
     r_iovec->private = buffer;
 
     buffer->used += size;
-    atomic_fetch_add_explicit(&buffer->refcnt, 1, memory_order_relaxed);
+    evpl_buffer_addref(buffer);
 
     if (buffer->size - buffer->used < evpl_shared->config->max_datagram_size) {
         evpl_buffer_release(evpl->datagram_buffer);
@@ -1391,39 +1957,137 @@ evpl_iovec_alloc_datagram(
 } /* evpl_iovec_alloc_datagram */
 
 void
-evpl_buffer_release(struct evpl_buffer *buffer)
+evpl_iovec_release(struct evpl_iovec *iovec)
 {
-    int refset;
+    evpl_iovec_decref(iovec);
+} /* evpl_iovec_release */
 
-    evpl_core_abort_if(atomic_load_explicit(&buffer->refcnt,
-                                            memory_order_relaxed) == 0,
-                       "Released buffer %p with zero refcnt", buffer);
+void
+evpl_iovec_addref(struct evpl_iovec *iovec)
+{
+    evpl_iovec_incref(iovec);
+} /* evpl_iovec_addref */
 
-    refset = atomic_fetch_sub_explicit(&buffer->refcnt, 1, memory_order_relaxed)
-    ;
+int
+evpl_iovec_compact(
+    struct evpl       *evpl,
+    struct evpl_iovec *iovecs,
+    int                niovs)
+{
+    struct evpl_global_config *config = evpl_shared->config;
+    struct evpl_buffer        *buffer;
+    struct evpl_iovec          copy;
+    int                        i, rc, ncompacted = 0;
 
-    if (refset == 1) {
-        if (buffer->external1) {
-            buffer->release(buffer);
-        } else {
-            buffer->used = 0;
-            evpl_allocator_free(buffer->slab->allocator, buffer);
+    for (i = 0; i < niovs; ++i) {
+
+        buffer = evpl_iovec_buffer(&iovecs[i]);
+
+        /* Only worth copying if the slice is small and the buffer
+         * it is keeping alive is bigger than what we would replace it with,
+         * and only possible if the slice fits in one long lived buffer */
+
+        if (iovecs[i].length > config->compact_max_length ||
+            iovecs[i].length > config->long_lived_buffer_size ||
+            buffer->size <= config->long_lived_buffer_size) {
+            continue;
         }
+
+        rc = evpl_iovec_alloc_lifetime(evpl, iovecs[i].length, 0, 1,
+                                       EVPL_IOVEC_LIFETIME_LONG, &copy);
+
+        if (unlikely(rc != 1)) {
+            continue;
+        }
+
+        memcpy(copy.data, iovecs[i].data, iovecs[i].length);
+
+        evpl_iovec_release(&iovecs[i]);
+
+        iovecs[i] = copy;
+
+        ncompacted++;
     }
 
-} /* evpl_buffer_release */
+    return ncompacted;
+} /* evpl_iovec_compact */
 
 void
-evpl_iovec_release(struct evpl_iovec *iovec)
+evpl_iovec_usage(
+    const struct evpl_iovec *iovec,
+    struct evpl_iovec_usage *usage)
 {
-    evpl_iovec_decref(iovec);
-} /* evpl_iovec_release */
+    struct evpl_buffer *buffer = evpl_iovec_buffer(iovec);
 
-void
-evpl_iovec_addref(struct evpl_iovec *iovec)
+    usage->pinned    = buffer->size;
+    usage->allocated = buffer->used;
+    usage->refs      = evpl_buffer_refs(buffer);
+} /* evpl_iovec_usage */
+
+/*
+ * Returns the longest send that will be copied into the bind's coalescing
+ * chunk rather than queued by reference, or 0 if the protocol cannot
+ * merge sends.
+ */
+static inline unsigned int
+evpl_bind_coalesce_max(const struct evpl_bind *bind)
 {
-    evpl_iovec_incref(iovec);
-} /* evpl_iovec_addref */
+    unsigned int max = evpl_shared->config->send_coalesce_max;
+
+    if (!bind->protocol->coalesce_sends) {
+        return 0;
+    }
+
+    return max < EVPL_BIND_COALESCE_SIZE ? max : EVPL_BIND_COALESCE_SIZE;
+} // evpl_bind_coalesce_max
+
+/*
+ * Copy a small send into the bind's coalescing chunk.  When the newest
+ * queued iovec ends where the chunk continues it is simply extended, so
+ * a burst of small sends reaches the transport as one segment.
+ */
+static void
+evpl_bind_coalesce(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    const void       *data,
+    unsigned int      length)
+{
+    struct evpl_iovec *head, chunk;
+    int                niov;
+
+    if (!bind->coalesce.private || bind->coalesce.length < length) {
+        evpl_bind_coalesce_release(bind);
+
+        niov = evpl_iovec_alloc(evpl, EVPL_BIND_COALESCE_SIZE, 0, 1,
+                                &bind->coalesce);
+
+        evpl_core_abort_if(niov != 1, "failed to allocate coalesce space");
+    }
+
+    memcpy(bind->coalesce.data, data, length);
+
+    head = evpl_iovec_ring_head(&bind->iovec_send);
+
+    /* Never grow an iovec that must go out ahead of a queued file range */
+    if (bind->sendfile && bind->sendfile_gap == bind->iovec_send.length) {
+        head = NULL;
+    }
+
+    if (head && head->private == bind->coalesce.private &&
+        head->data + head->length == bind->coalesce.data) {
+        head->length            += length;
+        bind->iovec_send.length += length;
+    } else {
+        chunk        = bind->coalesce;
+        chunk.length = length;
+        evpl_iovec_incref(&chunk);
+        evpl_iovec_ring_add(&bind->iovec_send, &chunk);
+    }
+
+    bind->coalesce.data    = bind->coalesce.data + length;
+    bind->coalesce.length -= length;
+} /* evpl_bind_coalesce */
 
 void
 evpl_send(
@@ -1432,8 +2096,23 @@ evpl_send(
     const void       *buffer,
     unsigned int      length)
 {
-    struct evpl_iovec iovecs[4];
-    int               niov;
+    struct evpl_iovec  iovecs[4];
+    struct evpl_dgram *dgram;
+    int                niov;
+
+    if (length && length <= evpl_bind_coalesce_max(bind)) {
+        evpl_bind_coalesce(evpl, bind, buffer, length);
+
+        dgram         = evpl_dgram_ring_add(&bind->dgram_send);
+        dgram->niov   = 0;
+        dgram->length = length;
+        dgram->addr   = bind->remote;
+
+        evpl_bind_check_send_high(evpl, bind);
+
+        evpl_defer(evpl, &bind->flush_deferral);
+        return;
+    }
 
     niov = evpl_iovec_alloc(evpl, length, 0, 4, iovecs);
 
@@ -1497,14 +2176,33 @@ evpl_sendv(
 {
     struct evpl_dgram *dgram;
     struct evpl_iovec *iovec;
-    int                i, left = length;
+    unsigned int       coalesce_max = evpl_bind_coalesce_max(bind);
+    int                i, left = length, queued = 0;
 
     if (unlikely(niovs == 0)) {
         return;
     }
 
     for (i = 0; left && i < niovs; ++i) {
+
+        if (iovecs[i].length <= coalesce_max && coalesce_max) {
+            /* Small pieces are merged by copy, dropping the caller's ref */
+            if (iovecs[i].length > left) {
+                iovecs[i].length = left;
+            }
+
+            if (iovecs[i].length) {
+                evpl_bind_coalesce(evpl, bind, iovecs[i].data,
+                                   iovecs[i].length);
+            }
+
+            left -= iovecs[i].length;
+            evpl_iovec_release(&iovecs[i]);
+            continue;
+        }
+
         iovec = evpl_iovec_ring_add(&bind->iovec_send, &iovecs[i]);
+        queued++;
 
         if (iovec->length <= left) {
             left -= iovec->length;
@@ -1519,8 +2217,9 @@ evpl_sendv(
                        "evpl_send provided iov %d bytes short of covering length of %d",
                        left, length);
 
+    /* Coalesced pieces share the chunk's iovec and are not counted */
     dgram         = evpl_dgram_ring_add(&bind->dgram_send);
-    dgram->niov   = i;
+    dgram->niov   = queued;
     dgram->length = length;
     dgram->addr   = bind->remote;
 
@@ -1530,6 +2229,8 @@ evpl_sendv(
         evpl_iovec_release(&iovecs[i]);
     }
 
+    evpl_bind_check_send_high(evpl, bind);
+
 } /* evpl_sendv */
 
 void
@@ -1577,6 +2278,8 @@ evpl_sendtov(
         evpl_iovec_release(&iovecs[i]);
     }
 
+    evpl_bind_check_send_high(evpl, bind);
+
 } /* evpl_sendtov */
 
 void
@@ -1588,9 +2291,153 @@ evpl_sendtoepv(
     int                   nbufvecs,
     int                   length)
 {
-    evpl_sendtov(evpl, bind, evpl_endpoint_resolve(endpoint), iovecs, nbufvecs, length);
+    struct evpl_address *address = evpl_address_cache_lookup(evpl, endpoint);
+    int                  i;
+
+    if (unlikely(!address)) {
+        /* Not resolved yet, so drop it as the network might have */
+        for (i = 0; i < nbufvecs; ++i) {
+            evpl_iovec_release(&iovecs[i]);
+        }
+        return;
+    }
+
+    /* The reference is thread private, so this touches no shared line */
+    evpl_address_incref(address);
+
+    evpl_sendtov(evpl, bind, address, iovecs, nbufvecs, length);
 } /* evpl_sendtoepv */
 
+/* Largest piece of a file read into buffers at once by evpl_sendfile */
+#define EVPL_SENDFILE_COPY_CHUNK (1024 * 1024)
+
+static void
+evpl_sendfile_copy(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    int               fd,
+    uint64_t          offset,
+    uint64_t          length)
+{
+    struct evpl_iovec iovecs[8];
+    struct iovec      iov[8];
+    ssize_t           res;
+    int               i, niov, chunk;
+
+    while (length) {
+
+        chunk = length < EVPL_SENDFILE_COPY_CHUNK ?
+            length : EVPL_SENDFILE_COPY_CHUNK;
+
+        niov = evpl_iovec_alloc(evpl, chunk, 0, 8, iovecs);
+
+        evpl_core_abort_if(niov < 1, "failed to allocate sendfile space");
+
+        for (i = 0; i < niov; ++i) {
+            iov[i].iov_base = iovecs[i].data;
+            iov[i].iov_len  = iovecs[i].length;
+        }
+
+        res = preadv(fd, iov, niov, offset);
+
+        if (res != chunk) {
+            evpl_core_error("sendfile read failed at offset %lu: %s",
+                            offset, res < 0 ? strerror(errno) : "short read");
+
+            for (i = 0; i < niov; ++i) {
+                evpl_iovec_release(&iovecs[i]);
+            }
+
+            evpl_close(evpl, bind);
+            return;
+        }
+
+        evpl_sendv(evpl, bind, iovecs, niov, chunk);
+
+        offset += chunk;
+        length -= chunk;
+    }
+} /* evpl_sendfile_copy */
+
+void
+evpl_sendfile(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    int               fd,
+    uint64_t          offset,
+    uint64_t          length)
+{
+    struct evpl_sendfile *sf;
+    struct evpl_dgram    *dgram;
+
+    if (unlikely(length == 0)) {
+        return;
+    }
+
+    if (!bind->protocol->sendfile) {
+        evpl_sendfile_copy(evpl, bind, fd, offset, length);
+        return;
+    }
+
+    sf = evpl_zalloc_tagged(sizeof(*sf), EVPL_MEMORY_TAG_BIND);
+
+    /* Hold our own descriptor so the caller may close theirs at once */
+    sf->fd = dup(fd);
+
+    evpl_core_abort_if(sf->fd < 0, "failed to dup sendfile fd: %s",
+                       strerror(errno));
+
+    sf->offset = offset;
+    sf->length = length;
+    sf->gap    = bind->iovec_send.length - bind->sendfile_gap;
+
+    bind->sendfile_gap += sf->gap;
+
+    LL_APPEND(bind->sendfile, sf);
+
+    dgram         = evpl_dgram_ring_add(&bind->dgram_send);
+    dgram->niov   = 0;
+    dgram->length = length;
+    dgram->addr   = bind->remote;
+
+    evpl_defer(evpl, &bind->flush_deferral);
+} /* evpl_sendfile */
+
+int
+evpl_send_fd(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    int               fd)
+{
+    int rc;
+
+    if (unlikely(!bind->protocol->send_fd)) {
+        return ENOTSUP;
+    }
+
+    rc = bind->protocol->send_fd(evpl, bind, fd);
+
+    if (rc == 0) {
+        evpl_defer(evpl, &bind->flush_deferral);
+    }
+
+    return rc;
+} /* evpl_send_fd */
+
+void
+evpl_bind_sendfile_done(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_sendfile *sf = bind->sendfile;
+
+    LL_DELETE(bind->sendfile, sf);
+
+    close(sf->fd);
+
+    evpl_free_tagged(sf, EVPL_MEMORY_TAG_BIND);
+} /* evpl_bind_sendfile_done */
+
 void
 evpl_close(
     struct evpl      *evpl,
@@ -1610,7 +2457,7 @@ evpl_finish(
 
     bind->flags |= EVPL_BIND_FINISH;
 
-    if (evpl_iovec_ring_is_empty(&bind->iovec_send)) {
+    if (evpl_bind_send_empty(bind)) {
         evpl_close(evpl, bind);
     }
 
@@ -1622,6 +2469,7 @@ evpl_bind_destroy(
     struct evpl_bind *bind)
 {
     struct evpl_notify notify;
+    struct evpl_dgram *dgram;
 
     evpl_core_abort_if(!(bind->flags & EVPL_BIND_PENDING_CLOSED),
                        "bind %p not pending closed at destroy", bind);
@@ -1633,10 +2481,34 @@ evpl_bind_destroy(
         bind->notify_callback(evpl, bind, &notify, bind->private_data);
     }
 
+    /* The bind may be recycled before either would have run */
+    evpl_remove_deferral(evpl, &bind->flush_deferral);
+    evpl_remove_deferral(evpl, &bind->close_deferral);
+
+    /* Unconnected datagrams still queued hold their destination */
+    if (!bind->protocol->connected) {
+        while ((dgram = evpl_dgram_ring_tail(&bind->dgram_send)) != NULL) {
+            evpl_address_release(dgram->addr);
+            evpl_dgram_ring_remove(&bind->dgram_send);
+        }
+    }
+
     evpl_iovec_ring_clear(evpl, &bind->iovec_recv);
     evpl_iovec_ring_clear(evpl, &bind->iovec_send);
     evpl_dgram_ring_clear(evpl, &bind->dgram_send);
 
+    evpl_bind_coalesce_release(bind);
+
+    while (bind->sendfile) {
+        evpl_bind_sendfile_done(evpl, bind);
+    }
+
+    bind->sendfile_gap = 0;
+
+    evpl_iovec_ring_trim(&bind->iovec_recv);
+    evpl_iovec_ring_trim(&bind->iovec_send);
+    evpl_dgram_ring_trim(&bind->dgram_send);
+
     bind->flags |= EVPL_BIND_CLOSED;
 
     if (bind->local) {
@@ -1647,7 +2519,7 @@ evpl_bind_destroy(
         evpl_address_release(bind->remote);
     }
     DL_DELETE(evpl->pending_close_binds, bind);
-    DL_PREPEND(evpl->free_binds, bind);
+    DL_PREPEND(evpl->free_binds[bind->protocol->id], bind);
 } /* evpl_bind_destroy */
 
 int
@@ -1687,6 +2559,7 @@ evpl_peek(
 
         memcpy(ptr, cur->data, chunk);
 
+        ptr  += chunk;
         left -= chunk;
 
         cur = evpl_iovec_ring_next(&bind->iovec_recv, cur);
@@ -1753,6 +2626,8 @@ evpl_consume(
     int               length)
 {
     evpl_iovec_ring_consume(evpl, &bind->iovec_recv, length);
+
+    evpl_bind_recv_consumed(evpl, bind);
 } /* evpl_consume */
 
 int
@@ -1801,6 +2676,8 @@ evpl_read(
         evpl_iovec_ring_consume(evpl, &bind->iovec_recv, chunk);
     }
 
+    evpl_bind_recv_consumed(evpl, bind);
+
     return copied;
 
 } /* evpl_read */
@@ -1850,15 +2727,15 @@ evpl_readv(
         out->data    = cur->data;
         out->length  = chunk;
         out->private = cur->private;
-        atomic_fetch_add_explicit(&evpl_iovec_buffer(out)->refcnt, 1,
-                                  memory_order_relaxed)
-        ;
+        evpl_buffer_addref(evpl_iovec_buffer(out));
 
         left -= chunk;
 
         evpl_iovec_ring_consume(evpl, &bind->iovec_recv, chunk);
     }
 
+    evpl_bind_recv_consumed(evpl, bind);
+
     return niovs;
 
 } /* evpl_readv */
@@ -1891,6 +2768,7 @@ evpl_recv(
 
         memcpy(ptr, cur->data, chunk);
 
+        ptr  += chunk;
         left -= chunk;
 
         cur = evpl_iovec_ring_next(&bind->iovec_recv, cur);
@@ -1898,6 +2776,8 @@ evpl_recv(
 
     evpl_iovec_ring_consume(evpl, &bind->iovec_recv, length);
 
+    evpl_bind_recv_consumed(evpl, bind);
+
     return length;
 
 } /* evpl_recv */
@@ -1937,9 +2817,7 @@ evpl_recvv(
         out->data    = cur->data;
         out->length  = chunk;
         out->private = cur->private;
-        atomic_fetch_add_explicit(&evpl_iovec_buffer(out)->refcnt, 1,
-                                  memory_order_relaxed)
-        ;
+        evpl_buffer_addref(evpl_iovec_buffer(out));
 
         left -= chunk;
 
@@ -1952,6 +2830,8 @@ evpl_recvv(
 
     evpl_iovec_ring_consume(evpl, &bind->iovec_recv, length);
 
+    evpl_bind_recv_consumed(evpl, bind);
+
     return niovs;
 } /* evpl_recvv */
 
@@ -2051,8 +2931,27 @@ evpl_remove_event(
     struct evpl       *evpl,
     struct evpl_event *event)
 {
+    int i;
+
     evpl_core_remove(&evpl->core, event);
     evpl->num_events--;
+
+    /*
+     * The event's memory may be freed once we return, so it must not be
+     * left behind on the active list.  Its slot is cleared rather than
+     * filled since we may be called from within the active list walk.
+     */
+    if (event->flags & EVPL_ACTIVE) {
+        for (i = 0; i < evpl->num_active_events; ++i) {
+            if (evpl->active_events[i] == event) {
+                evpl->active_events[i] = NULL;
+                break;
+            }
+        }
+    }
+
+    event->flags &= ~(EVPL_READABLE | EVPL_WRITABLE | EVPL_ERROR |
+                      EVPL_ACTIVE);
 } /* evpl_remove_event */
 
 struct evpl_poll *
@@ -2167,6 +3066,92 @@ evpl_bind_request_send_notifications(
     bind->flags |= EVPL_BIND_SENT_NOTIFY;
 } /* evpl_bind_request_send_notifications */
 
+void
+evpl_bind_set_send_watermarks(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    uint64_t          high,
+    uint64_t          low)
+{
+    bind->send_high = high;
+    bind->send_low  = low;
+
+    if (!high) {
+        bind->flags &= ~EVPL_BIND_SEND_BLOCKED;
+    }
+} /* evpl_bind_set_send_watermarks */
+
+void
+evpl_bind_set_recv_max(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    uint64_t          max)
+{
+    bind->recv_max = max;
+
+    evpl_bind_recv_consumed(evpl, bind);
+} /* evpl_bind_set_recv_max */
+
+void
+evpl_bind_send_blocked(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_notify notify;
+
+    bind->flags |= EVPL_BIND_SEND_BLOCKED;
+
+    if (bind->notify_callback) {
+        notify.notify_type   = EVPL_NOTIFY_SEND_BLOCKED;
+        notify.notify_status = 0;
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+} /* evpl_bind_send_blocked */
+
+void
+evpl_bind_sent_notify(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    uint64_t          bytes,
+    uint64_t          msgs)
+{
+    struct evpl_notify notify;
+
+    if (bind->flags & EVPL_BIND_SENT_NOTIFY) {
+        notify.notify_type    = EVPL_NOTIFY_SENT;
+        notify.notify_status  = 0;
+        notify.sent.bytes     = bytes;
+        notify.sent.msgs      = msgs;
+        notify.sent.timestamp = 0;
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+
+    if ((bind->flags & EVPL_BIND_SEND_BLOCKED) &&
+        bind->iovec_send.length <= bind->send_low) {
+
+        bind->flags &= ~EVPL_BIND_SEND_BLOCKED;
+
+        if (bind->notify_callback) {
+            notify.notify_type   = EVPL_NOTIFY_WRITABLE;
+            notify.notify_status = 0;
+            bind->notify_callback(evpl, bind, &notify, bind->private_data);
+        }
+    }
+} /* evpl_bind_sent_notify */
+
+void
+evpl_bind_recv_resume(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    bind->flags &= ~EVPL_BIND_RECV_PAUSED;
+
+    if (bind->protocol->resume_recv &&
+        !(bind->flags & EVPL_BIND_PENDING_CLOSED)) {
+        bind->protocol->resume_recv(evpl, bind);
+    }
+} /* evpl_bind_recv_resume */
+
 int
 evpl_protocol_is_stream(enum evpl_protocol_id id)
 {
@@ -2359,3 +3344,40 @@ evpl_slab_alloc(void)
     return evpl_allocator_alloc_slab(evpl_shared->allocator);
 } /* evpl_slab_alloc */
 
+int
+evpl_slab_usage(
+    struct evpl_slab_usage *usage,
+    int                     max_usage)
+{
+    int n;
+
+    if (!evpl_shared) {
+        return 0;
+    }
+
+    n = evpl_allocator_slab_usage(evpl_shared->allocator, usage, max_usage, 0);
+    n = evpl_allocator_slab_usage(evpl_shared->long_lived_allocator, usage,
+                                  max_usage, n);
+    n = evpl_allocator_slab_usage(evpl_shared->buddy->allocator, usage,
+                                  max_usage, n);
+
+    return n;
+} /* evpl_slab_usage */
+
+void
+evpl_memory_snapshot(struct evpl_memory_snapshot *snapshot)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    evpl_memory_tag_usage(snapshot->tags);
+
+    if (!evpl_shared) {
+        return;
+    }
+
+    evpl_allocator_stats(evpl_shared->allocator, snapshot);
+    evpl_allocator_stats(evpl_shared->long_lived_allocator, snapshot);
+    evpl_buddy_stats(evpl_shared->buddy, snapshot);
+    evpl_memory_map_stats(evpl_shared->memory_map, snapshot);
+} /* evpl_memory_snapshot */
+
@@ -4,13 +4,23 @@
 
 #pragma once
 
+#include <stdatomic.h>
+
 struct evpl_allocator;
+struct evpl_buddy;
+struct evpl_memory_map;
+struct evpl_resolver;
 
 struct evpl_shared {
     pthread_mutex_t             lock;
     struct evpl_global_config  *config;
     struct evpl_endpoint       *endpoints;
     struct evpl_allocator      *allocator;
+    struct evpl_allocator      *long_lived_allocator;
+    struct evpl_buddy          *buddy;
+    struct evpl_memory_map     *memory_map;
+    struct evpl_resolver       *resolver;
+    atomic_uint_fast64_t        generation; /* source of endpoint generations */
     struct evpl_framework      *framework[EVPL_NUM_FRAMEWORK];
     void                       *framework_private[EVPL_NUM_FRAMEWORK];
     struct evpl_protocol       *protocol[EVPL_NUM_PROTO];
@@ -5,14 +5,19 @@
 #define _GNU_SOURCE
 
 #include <stdio.h>
+#include <string.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <sys/types.h>
 
 #include "core/internal.h"
 #include "evpl/evpl.h"
+#include "uthash/utlist.h"
 
 static const char *level_string[] = {
     "none",
@@ -176,6 +181,20 @@ evpl_calloc(
     return p;
 } /* evpl_calloc */
 
+void *
+evpl_realloc(
+    void        *p,
+    unsigned int size)
+{
+    p = realloc(p, size);
+
+    if (!p) {
+        evpl_core_fatal("Failed to reallocate %u bytes\n", size);
+    }
+
+    return p;
+} /* evpl_realloc */
+
 void *
 evpl_valloc(
     unsigned int size,
@@ -198,3 +217,248 @@ evpl_free(void *p)
 {
     free(p);
 } /* evpl_free */
+
+/*
+ * Tagged allocation counters are kept per thread and only ever
+ * written by their own thread, so updates need no atomic read-modify-
+ * write.  Counters of exited threads are folded into a retired set.
+ */
+
+struct evpl_memory_counters {
+    _Atomic int64_t              bytes[EVPL_MEMORY_TAG_MAX];
+    _Atomic uint64_t             allocs[EVPL_MEMORY_TAG_MAX];
+    _Atomic uint64_t             frees[EVPL_MEMORY_TAG_MAX];
+    unsigned long                thread_id;
+    struct evpl_memory_counters *prev;
+    struct evpl_memory_counters *next;
+};
+
+static pthread_mutex_t              evpl_memory_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t               evpl_memory_once = PTHREAD_ONCE_INIT;
+static pthread_key_t                evpl_memory_key;
+static struct evpl_memory_counters *evpl_memory_threads;
+static struct evpl_memory_counters  evpl_memory_retired;
+static __thread struct evpl_memory_counters *evpl_memory_local;
+static __thread int                          evpl_memory_exited;
+
+static void
+evpl_memory_thread_exit(void *arg)
+{
+    struct evpl_memory_counters *counters = arg;
+    int                          i;
+
+    pthread_mutex_lock(&evpl_memory_lock);
+
+    for (i = 0; i < EVPL_MEMORY_TAG_MAX; ++i) {
+        evpl_memory_retired.bytes[i]  += counters->bytes[i];
+        evpl_memory_retired.allocs[i] += counters->allocs[i];
+        evpl_memory_retired.frees[i]  += counters->frees[i];
+    }
+
+    DL_DELETE(evpl_memory_threads, counters);
+
+    pthread_mutex_unlock(&evpl_memory_lock);
+
+    /* Anything freed by later thread exit handlers goes to the retired set */
+    evpl_memory_local  = NULL;
+    evpl_memory_exited = 1;
+
+    free(counters);
+} /* evpl_memory_thread_exit */
+
+static void
+evpl_memory_key_init(void)
+{
+    pthread_key_create(&evpl_memory_key, evpl_memory_thread_exit);
+} /* evpl_memory_key_init */
+
+static struct evpl_memory_counters *
+evpl_memory_counters(void)
+{
+    struct evpl_memory_counters *counters = evpl_memory_local;
+
+    if (likely(counters) || evpl_memory_exited) {
+        return counters;
+    }
+
+    pthread_once(&evpl_memory_once, evpl_memory_key_init);
+
+    counters            = evpl_zalloc(sizeof(*counters));
+    counters->thread_id = gettid();
+
+    pthread_mutex_lock(&evpl_memory_lock);
+    DL_APPEND(evpl_memory_threads, counters);
+    pthread_mutex_unlock(&evpl_memory_lock);
+
+    pthread_setspecific(evpl_memory_key, counters);
+
+    evpl_memory_local = counters;
+
+    return counters;
+} /* evpl_memory_counters */
+
+static inline void
+evpl_memory_counter_add(
+    _Atomic int64_t *counter,
+    int64_t          value)
+{
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter,
+                                               memory_order_relaxed) + value,
+                          memory_order_relaxed);
+} // evpl_memory_counter_add
+
+static inline void
+evpl_memory_counter_inc(_Atomic uint64_t *counter)
+{
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter,
+                                               memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+} // evpl_memory_counter_inc
+
+void
+evpl_memory_account(
+    enum evpl_memory_tag tag,
+    int64_t              bytes)
+{
+    struct evpl_memory_counters *counters = evpl_memory_counters();
+
+    if (unlikely(!counters)) {
+        /* This thread's counters are already retired */
+        pthread_mutex_lock(&evpl_memory_lock);
+        counters = &evpl_memory_retired;
+    }
+
+    evpl_memory_counter_add(&counters->bytes[tag], bytes);
+
+    if (bytes >= 0) {
+        evpl_memory_counter_inc(&counters->allocs[tag]);
+    } else {
+        evpl_memory_counter_inc(&counters->frees[tag]);
+    }
+
+    if (unlikely(counters == &evpl_memory_retired)) {
+        pthread_mutex_unlock(&evpl_memory_lock);
+    }
+} /* evpl_memory_account */
+
+void *
+evpl_malloc_tagged(
+    unsigned int         size,
+    enum evpl_memory_tag tag)
+{
+    void *p = evpl_malloc(size);
+
+    evpl_memory_account(tag, malloc_usable_size(p));
+
+    return p;
+} /* evpl_malloc_tagged */
+
+void *
+evpl_zalloc_tagged(
+    unsigned int         size,
+    enum evpl_memory_tag tag)
+{
+    void *p = evpl_zalloc(size);
+
+    evpl_memory_account(tag, malloc_usable_size(p));
+
+    return p;
+} /* evpl_zalloc_tagged */
+
+void *
+evpl_calloc_tagged(
+    unsigned int         n,
+    unsigned int         size,
+    enum evpl_memory_tag tag)
+{
+    void *p = evpl_calloc(n, size);
+
+    evpl_memory_account(tag, malloc_usable_size(p));
+
+    return p;
+} /* evpl_calloc_tagged */
+
+void *
+evpl_valloc_tagged(
+    unsigned int         size,
+    unsigned int         alignment,
+    enum evpl_memory_tag tag)
+{
+    void *p = evpl_valloc(size, alignment);
+
+    evpl_memory_account(tag, malloc_usable_size(p));
+
+    return p;
+} /* evpl_valloc_tagged */
+
+void
+evpl_free_tagged(
+    void                *p,
+    enum evpl_memory_tag tag)
+{
+    if (!p) {
+        return;
+    }
+
+    evpl_memory_account(tag, -(int64_t) malloc_usable_size(p));
+
+    free(p);
+} /* evpl_free_tagged */
+
+static void
+evpl_memory_counters_sum(
+    struct evpl_memory_tag_usage      *tags,
+    const struct evpl_memory_counters *counters)
+{
+    int i;
+
+    for (i = 0; i < EVPL_MEMORY_TAG_MAX; ++i) {
+        tags[i].bytes  += atomic_load_explicit(&counters->bytes[i],
+                                               memory_order_relaxed);
+        tags[i].allocs += atomic_load_explicit(&counters->allocs[i],
+                                               memory_order_relaxed);
+        tags[i].frees  += atomic_load_explicit(&counters->frees[i],
+                                               memory_order_relaxed);
+    }
+} /* evpl_memory_counters_sum */
+
+void
+evpl_memory_tag_usage(struct evpl_memory_tag_usage *tags)
+{
+    struct evpl_memory_counters *counters;
+
+    memset(tags, 0, EVPL_MEMORY_TAG_MAX * sizeof(*tags));
+
+    pthread_mutex_lock(&evpl_memory_lock);
+
+    evpl_memory_counters_sum(tags, &evpl_memory_retired);
+
+    DL_FOREACH(evpl_memory_threads, counters)
+    {
+        evpl_memory_counters_sum(tags, counters);
+    }
+
+    pthread_mutex_unlock(&evpl_memory_lock);
+} /* evpl_memory_tag_usage */
+
+void
+evpl_memory_snapshot_threads(
+    evpl_memory_thread_callback_t callback,
+    void                         *private_data)
+{
+    struct evpl_memory_counters *counters;
+    struct evpl_memory_tag_usage tags[EVPL_MEMORY_TAG_MAX];
+
+    pthread_mutex_lock(&evpl_memory_lock);
+
+    DL_FOREACH(evpl_memory_threads, counters)
+    {
+        memset(tags, 0, sizeof(tags));
+        evpl_memory_counters_sum(tags, counters);
+        callback(counters->thread_id, tags, private_data);
+    }
+
+    pthread_mutex_unlock(&evpl_memory_lock);
+} /* evpl_memory_snapshot_threads */
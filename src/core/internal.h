@@ -35,8 +35,16 @@ struct evpl_global_config {
     unsigned int              max_poll_fd;
     unsigned int              max_num_iovec;
     unsigned int              buffer_size;
-    unsigned int              huge_pages;
+    enum evpl_slab_backing    slab_backing;
+    unsigned int              slab_prefault;
     uint64_t                  slab_size;
+    unsigned int              long_lived_buffer_size;
+    uint64_t                  long_lived_slab_size;
+    unsigned int              compact_max_length;
+    unsigned int              send_coalesce_max;
+    uint64_t                  send_high_watermark;
+    uint64_t                  send_low_watermark;
+    uint64_t                  recv_max;
     unsigned int              page_size;
     unsigned int              max_datagram_size;
     unsigned int              max_datagram_batch;
@@ -45,6 +53,14 @@ struct evpl_global_config {
     unsigned int              dgram_ring_size;
     unsigned int              resolve_timeout_ms;
 
+    unsigned int              socket_zerocopy;
+    unsigned int              socket_zerocopy_min;
+    unsigned int              socket_udp_gso;
+    unsigned int              socket_udp_gro;
+    unsigned int              socket_timestamping;
+    unsigned int              socket_tcp_rcvlowat;
+    unsigned int              socket_unix_pass_fds;
+
     unsigned int              io_uring_enabled;
 
     unsigned int              rdmacm_enabled;
@@ -63,6 +79,17 @@ struct evpl_global_config {
     unsigned int              xlio_enabled;
 
     unsigned int              vfio_enabled;
+
+    unsigned int              xdp_enabled;
+
+    unsigned int              libfabric_enabled;
+    unsigned int              libfabric_cq_size;
+    unsigned int              libfabric_rx_depth;
+
+    unsigned int              shm_enabled;
+    uint64_t                  shm_segment_size;
+
+    unsigned int              loopback_enabled;
 };
 
 typedef void (*evpl_accept_callback_t)(
@@ -104,10 +131,30 @@ struct evpl {
     int                          max_active_deferrals;
 
     struct evpl_buffer          *current_buffer;
+    struct evpl_buffer          *long_lived_buffer;
     struct evpl_buffer          *datagram_buffer;
-    struct evpl_bind            *free_binds;
+    struct evpl_buffer_owner    *buffer_owner;
+    struct evpl_bind            *free_binds[EVPL_NUM_PROTO];
     struct evpl_bind            *binds;
     struct evpl_bind            *pending_close_binds;
+    int                          num_resolving_binds;
+
+    /* closed descriptors the kernel may still be sending from */
+    int                          num_lingering;
+
+    /* thread private endpoint addresses for evpl_sendtoep() */
+    struct evpl_address_cache   *address_cache;
+    uint64_t                     address_epoch;
+    struct timespec              address_epoch_ts;
+
+    /* interned datagram source addresses */
+    struct evpl_address_intern  *address_intern;
+    struct evpl_address_intern  *address_lru;
+    int                          num_address_intern;
+
+    /* receive staging shared by all stream sockets on this thread */
+    struct evpl_iovec            recv_stage[2];
+    struct timespec              last_trim_ts;
 
     struct evpl_thread_config    config;
 
@@ -118,6 +165,7 @@ struct evpl {
 struct evpl_listen_request {
     enum evpl_protocol_id protocol_id;
     struct evpl_address        *address;
+    int                         done;
     struct evpl_listen_request *prev;
     struct evpl_listen_request *next;
 };
@@ -153,6 +201,7 @@ struct evpl_listener {
     int                           max_attached;
     int                           rotor;
     pthread_mutex_t               lock;
+    pthread_cond_t                listened;
 
 };
 
@@ -163,12 +212,46 @@ void * evpl_zalloc(
 void * evpl_calloc(
     unsigned int n,
     unsigned int size);
+void * evpl_realloc(
+    void        *p,
+    unsigned int size);
 void * evpl_valloc(
     unsigned int size,
     unsigned int alignment);
 void evpl_free(
     void *p);
 
+/*
+ * Tagged variants of the above are counted in evpl_memory_snapshot(),
+ * and must be freed with evpl_free_tagged() using the same tag.
+ */
+
+void * evpl_malloc_tagged(
+    unsigned int         size,
+    enum evpl_memory_tag tag);
+void * evpl_zalloc_tagged(
+    unsigned int         size,
+    enum evpl_memory_tag tag);
+void * evpl_calloc_tagged(
+    unsigned int         n,
+    unsigned int         size,
+    enum evpl_memory_tag tag);
+void * evpl_valloc_tagged(
+    unsigned int         size,
+    unsigned int         alignment,
+    enum evpl_memory_tag tag);
+void evpl_free_tagged(
+    void                *p,
+    enum evpl_memory_tag tag);
+
+/* Account memory obtained outside of the evpl allocation wrappers */
+void evpl_memory_account(
+    enum evpl_memory_tag tag,
+    int64_t              bytes);
+
+void evpl_memory_tag_usage(
+    struct evpl_memory_tag_usage *tags);
+
 #define EVPL_LOG_NONE  0
 #define EVPL_LOG_DEBUG 1
 #define EVPL_LOG_INFO  2
@@ -243,6 +326,8 @@ void evpl_abort(
 #define likely(x)                       __builtin_expect(!!(x), 1)
 #endif // ifndef likely
 
+/* libfabric headers bring their own, without the type check */
+#undef container_of
 #define container_of(ptr, type, member) ({            \
         typeof(((type *) 0)->member) * __mptr = (ptr); \
         (type *) ((char *) __mptr - offsetof(type, member)); })
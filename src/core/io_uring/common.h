@@ -0,0 +1,203 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#pragma once
+
+#include <sys/socket.h>
+#include <liburing.h>
+
+#include "core/internal.h"
+#include "evpl/evpl.h"
+
+#define evpl_io_uring_debug(...) evpl_debug("io_uring", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_io_uring_info(...)  evpl_info("io_uring", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_io_uring_error(...) evpl_error("io_uring", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_io_uring_fatal(...) evpl_fatal("io_uring", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_io_uring_abort(...) evpl_abort("io_uring", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_io_uring_fatal_if(cond, ...) \
+        evpl_fatal_if(cond, "io_uring", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_io_uring_abort_if(cond, ...) \
+        evpl_abort_if(cond, "io_uring", __FILE__, __LINE__, __VA_ARGS__)
+
+/* Provided buffer rings used by multishot receives */
+#define EVPL_IO_URING_STREAM_BGID     0
+#define EVPL_IO_URING_STREAM_BUFS     256
+#define EVPL_IO_URING_STREAM_BUF_SIZE 16384
+#define EVPL_IO_URING_DGRAM_BGID      1
+#define EVPL_IO_URING_DGRAM_BUFS      64
+
+/* Sparse registered file table shared by all sockets of a thread */
+#define EVPL_IO_URING_MAX_FILES       4096
+
+struct evpl_io_uring_op;
+
+typedef void (*evpl_io_uring_op_callback_t)(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe);
+
+/*
+ * Every SQE we submit carries a pointer to one of these as its user data,
+ * so block requests and socket operations can share the completion ring.
+ * SQEs whose completions need no handling carry a user data of zero.
+ */
+struct evpl_io_uring_op {
+    evpl_io_uring_op_callback_t callback;
+    void                       *private_data;
+};
+
+struct evpl_io_uring_request;
+
+/*
+ * A ring of buffers the kernel picks from for multishot receives, each
+ * one an evpl_iovec we hold a reference on until its data is handed off
+ */
+struct evpl_io_uring_buf_ring {
+    struct io_uring_buf_ring *ring;
+    struct evpl_iovec        *bufs;
+    int                       bgid;
+    int                       nbufs;
+    unsigned int              size;
+};
+
+struct evpl_io_uring_socket {
+    int                     fd;
+    int                     file_index;
+    int                     connected;
+    int                     closing;
+    int                     sending;
+    int                     inflight;
+    int                     recv_armed;
+    struct evpl_io_uring_op connect_op;
+    struct evpl_io_uring_op accept_op;
+    struct evpl_io_uring_op recv_op;
+    struct msghdr           recv_msg;
+};
+
+/*
+ * One send in flight on a socket.  Zero copy sends stay allocated until
+ * the kernel reports it has finished with the pages, and datagram sends
+ * take over the iovecs and address of the datagram they carry.
+ */
+struct evpl_io_uring_send {
+    struct evpl_io_uring_op    op;
+    struct evpl_bind          *bind;
+    struct evpl_address       *addr;
+    struct msghdr              msg;
+    int                        zerocopy;
+    int                        nheld;
+    struct iovec              *iov;
+    struct evpl_iovec         *held;
+    struct evpl_io_uring_send *next;
+};
+
+struct evpl_io_uring_context {
+    struct io_uring               ring;
+    int                           eventfd;
+    struct evpl_event             event;
+    struct evpl_deferral          flush;
+    struct evpl_io_uring_request *free_requests;
+
+    /* Socket state, set up when the first socket is created */
+    struct evpl_io_uring_buf_ring stream_bufs;
+    struct evpl_io_uring_buf_ring dgram_bufs;
+    struct evpl_io_uring_send    *free_sends;
+    int                          *free_files;
+    int                           num_free_files;
+    int                           sockets_ready;
+};
+
+static inline struct io_uring_sqe *
+evpl_io_uring_get_sqe(struct evpl_io_uring_context *ctx)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = io_uring_get_sqe(&ctx->ring);
+
+    if (unlikely(!sqe)) {
+        /* Submission queue is full, push it to the kernel and retry */
+        io_uring_submit(&ctx->ring);
+        sqe = io_uring_get_sqe(&ctx->ring);
+    }
+
+    evpl_io_uring_abort_if(!sqe, "io_uring_get_sqe");
+
+    return sqe;
+} // evpl_io_uring_get_sqe
+
+void
+evpl_io_uring_reap(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx);
+
+static inline int
+evpl_io_uring_socket_fd(const struct evpl_io_uring_socket *s)
+{
+    return s->file_index >= 0 ? s->file_index : s->fd;
+} // evpl_io_uring_socket_fd
+
+static inline void
+evpl_io_uring_socket_sqe(
+    struct io_uring_sqe               *sqe,
+    const struct evpl_io_uring_socket *s,
+    void                              *user_data)
+{
+    if (s->file_index >= 0) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+
+    io_uring_sqe_set_data64(sqe, (uint64_t) user_data);
+} // evpl_io_uring_socket_sqe
+
+void
+evpl_io_uring_buf_ring_init(
+    struct evpl                   *evpl,
+    struct evpl_io_uring_context  *ctx,
+    struct evpl_io_uring_buf_ring *br,
+    int                            bgid,
+    int                            nbufs,
+    unsigned int                   size);
+
+void
+evpl_io_uring_buf_ring_provide(
+    struct evpl                   *evpl,
+    struct evpl_io_uring_buf_ring *br,
+    int                            bid);
+
+void
+evpl_io_uring_sockets_cleanup(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx);
+
+struct evpl_io_uring_send *
+evpl_io_uring_send_alloc(
+    struct evpl_io_uring_context *ctx,
+    evpl_io_uring_op_callback_t   callback);
+
+void
+evpl_io_uring_send_free(
+    struct evpl_io_uring_context *ctx,
+    struct evpl_io_uring_send    *req);
+
+void
+evpl_io_uring_socket_init(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_io_uring_socket  *s,
+    int                           fd,
+    evpl_io_uring_op_callback_t   recv_callback,
+    evpl_io_uring_op_callback_t   connect_callback,
+    evpl_io_uring_op_callback_t   accept_callback);
+
+void
+evpl_io_uring_socket_pending_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind);
+
+void
+evpl_io_uring_socket_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind);
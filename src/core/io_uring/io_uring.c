@@ -19,24 +19,14 @@
 #include "evpl/evpl.h"
 #include "core/protocol.h"
 #include "core/io_uring/io_uring.h"
-
-#define evpl_io_uring_debug(...) evpl_debug("io_uring", __FILE__, __LINE__, __VA_ARGS__)
-#define evpl_io_uring_info(...)  evpl_info("io_uring", __FILE__, __LINE__, __VA_ARGS__)
-#define evpl_io_uring_error(...) evpl_error("io_uring", __FILE__, __LINE__, __VA_ARGS__)
-#define evpl_io_uring_fatal(...) evpl_fatal("io_uring", __FILE__, __LINE__, __VA_ARGS__)
-#define evpl_io_uring_abort(...) evpl_abort("io_uring", __FILE__, __LINE__, __VA_ARGS__)
-
-#define evpl_io_uring_fatal_if(cond, ...) \
-        evpl_fatal_if(cond, "io_uring", __FILE__, __LINE__, __VA_ARGS__)
-
-#define evpl_io_uring_abort_if(cond, ...) \
-        evpl_abort_if(cond, "io_uring", __FILE__, __LINE__, __VA_ARGS__)
+#include "core/io_uring/common.h"
 
 struct evpl_io_uring_shared {
     struct io_uring ring;
 };
 
 struct evpl_io_uring_request {
+    struct evpl_io_uring_op       op;
     void                          (*callback)(
         int   status,
         void *private_data);
@@ -54,20 +44,57 @@ struct evpl_io_uring_device {
     int fd;
 };
 
-struct evpl_io_uring_context {
-    struct io_uring               ring;
-    int                           eventfd;
-    struct evpl_event             event;
-    struct evpl_deferral          flush;
-    struct evpl_io_uring_request *free_requests;
-};
-
 struct evpl_io_uring_queue {
     struct evpl_io_uring_context *ctx;
     int                           fd;
     struct io_uring_sqe          *pending_sqe;
 };
 
+static void
+evpl_io_uring_request_free(
+    struct evpl_io_uring_context *ctx,
+    struct evpl_io_uring_request *req)
+{
+    LL_APPEND(ctx->free_requests, req);
+} /* evpl_io_uring_request_free */
+
+static void
+evpl_io_uring_request_complete(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_request *req = op->private_data;
+    uint64_t                      debounce_offset;
+    int                           rc;
+
+    if (cqe->res >= 0 && cqe->res !=  req->length) {
+        rc = EIO;
+    } else if (cqe->res < 0) {
+        rc = -cqe->res;
+    } else {
+        rc = 0;
+    }
+
+    if (req->need_debounce) {
+        debounce_offset = 0;
+
+        for (int i = 0; i < req->niov; i++) {
+            memcpy(req->iov[i].iov_base, req->bounce + debounce_offset, req->iov[i].iov_len);
+            debounce_offset += req->iov[i].iov_len;
+        }
+    }
+
+    req->callback(rc, req->private_data);
+
+    if (req->bounce) {
+        evpl_free(req->bounce);
+    }
+
+    evpl_io_uring_request_free(ctx, req);
+} /* evpl_io_uring_request_complete */
+
 static struct evpl_io_uring_request *
 evpl_io_uring_request_alloc(struct evpl_io_uring_context *ctx)
 {
@@ -79,6 +106,9 @@ evpl_io_uring_request_alloc(struct evpl_io_uring_context *ctx)
         LL_DELETE(ctx->free_requests, req);
     } else {
         req = evpl_zalloc(sizeof(*req));
+
+        req->op.callback     = evpl_io_uring_request_complete;
+        req->op.private_data = req;
     }
 
     req->bounce        = NULL;
@@ -87,14 +117,6 @@ evpl_io_uring_request_alloc(struct evpl_io_uring_context *ctx)
     return req;
 } /* evpl_io_uring_request_alloc */
 
-static void
-evpl_io_uring_request_free(
-    struct evpl_io_uring_context *ctx,
-    struct evpl_io_uring_request *req)
-{
-    LL_APPEND(ctx->free_requests, req);
-} /* evpl_io_uring_request_free */
-
 static void *
 evpl_io_uring_init(void)
 {
@@ -128,16 +150,33 @@ evpl_io_uring_flush_sqe(
     io_uring_submit(&ctx->ring);
 } /* evpl_io_uring_flush */
 
+void
+evpl_io_uring_reap(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx)
+{
+    struct io_uring_cqe     *cqe;
+    struct evpl_io_uring_op *op;
+
+    while (io_uring_peek_cqe(&ctx->ring, &cqe) == 0) {
+        op = (struct evpl_io_uring_op *) io_uring_cqe_get_data64(cqe);
+
+        if (op) {
+            op->callback(evpl, op, cqe);
+        }
+
+        io_uring_cqe_seen(&ctx->ring, cqe);
+    }
+} /* evpl_io_uring_reap */
+
 static void
 evpl_io_uring_complete(
     struct evpl       *evpl,
     struct evpl_event *event)
 {
     struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
-    uint64_t                      value, debounce_offset;
+    uint64_t                      value;
     int                           rc;
-    struct io_uring_cqe          *cqe;
-    struct evpl_io_uring_request *req;
 
     rc = read(ctx->eventfd, &value, sizeof(value));
 
@@ -146,37 +185,7 @@ evpl_io_uring_complete(
         return;
     }
 
-    while (io_uring_peek_cqe(&ctx->ring, &cqe) == 0) {
-        req = (struct evpl_io_uring_request *) io_uring_cqe_get_data64(cqe);
-
-        if (cqe->res >= 0 && cqe->res !=  req->length) {
-            rc = EIO;
-        } else if (cqe->res < 0) {
-            rc = -cqe->res;
-        } else {
-            rc = 0;
-        }
-
-        if (req->need_debounce) {
-            debounce_offset = 0;
-
-            for (int i = 0; i < req->niov; i++) {
-                memcpy(req->iov[i].iov_base, req->bounce + debounce_offset, req->iov[i].iov_len);
-                debounce_offset += req->iov[i].iov_len;
-            }
-        }
-
-        req->callback(rc, req->private_data);
-
-        if (req->bounce) {
-            evpl_free(req->bounce);
-        }
-
-        io_uring_cqe_seen(&ctx->ring, cqe);
-
-        evpl_io_uring_request_free(ctx, req);
-    } /* evpl_io_uring_complete */
-
+    evpl_io_uring_reap(evpl, ctx);
 
 } /* evpl_io_uring_complete */
 
@@ -191,8 +200,12 @@ evpl_io_uring_create(
     struct io_uring_params        params = { 0 };
 
 
+    /*
+     * Socket completions are posted from task work, which cooperative
+     * task running would leave pending while this thread sleeps in
+     * epoll waiting for the eventfd, so it is not requested here.
+     */
     params.flags  = IORING_SETUP_SINGLE_ISSUER;
-    params.flags |= IORING_SETUP_COOP_TASKRUN;
 
     params.flags |= IORING_SETUP_ATTACH_WQ;
     params.wq_fd  = shared->ring.ring_fd;
@@ -229,6 +242,10 @@ evpl_io_uring_destroy(
     struct evpl_io_uring_context *ctx = private_data;
     struct evpl_io_uring_request *req;
 
+    if (ctx->sockets_ready) {
+        evpl_io_uring_sockets_cleanup(evpl, ctx);
+    }
+
     while (ctx->free_requests) {
         req = ctx->free_requests;
         LL_DELETE(ctx->free_requests, req);
@@ -268,7 +285,7 @@ evpl_io_uring_read(
 
     evpl_io_uring_abort_if(!sqe, "io_uring_get_sqe");
 
-    io_uring_sqe_set_data64(sqe, (uint64_t) req);
+    io_uring_sqe_set_data64(sqe, (uint64_t) &req->op);
 
     for (i = 0; i < niov; i++) {
         req->iov[i].iov_base = iov[i].data;
@@ -336,7 +353,7 @@ evpl_io_uring_write(
 
     evpl_io_uring_abort_if(!sqe, "io_uring_get_sqe");
 
-    io_uring_sqe_set_data64(sqe, (uint64_t) req);
+    io_uring_sqe_set_data64(sqe, (uint64_t) &req->op);
 
     if (need_bounce) {
         req->bounce = evpl_valloc(req->length, 4096);
@@ -380,7 +397,7 @@ evpl_io_uring_flush(
 
     evpl_io_uring_abort_if(!sqe, "io_uring_get_sqe");
 
-    io_uring_sqe_set_data64(sqe, (uint64_t) req);
+    io_uring_sqe_set_data64(sqe, (uint64_t) &req->op);
     io_uring_prep_fsync(sqe, dev->fd, 0);
 
     evpl_defer(evpl, &ctx->flush);
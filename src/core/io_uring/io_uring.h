@@ -5,4 +5,6 @@
 #pragma once
 
 extern struct evpl_framework      evpl_framework_io_uring;
-extern struct evpl_block_protocol evpl_block_protocol_io_uring;
\ No newline at end of file
+extern struct evpl_block_protocol evpl_block_protocol_io_uring;
+extern struct evpl_protocol       evpl_io_uring_tcp;
+extern struct evpl_protocol       evpl_io_uring_udp;
@@ -0,0 +1,294 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "uthash/utlist.h"
+
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/buffer.h"
+#include "core/endpoint.h"
+#include "core/bind.h"
+#include "core/protocol.h"
+#include "core/evpl_shared.h"
+#include "core/io_uring/io_uring.h"
+#include "core/io_uring/common.h"
+
+extern struct evpl_shared *evpl_shared;
+
+void
+evpl_io_uring_buf_ring_provide(
+    struct evpl                   *evpl,
+    struct evpl_io_uring_buf_ring *br,
+    int                            bid)
+{
+    struct evpl_iovec *buf = &br->bufs[bid];
+    int                niov;
+
+    niov = evpl_iovec_alloc(evpl, br->size, 0, 1, buf);
+
+    evpl_io_uring_abort_if(niov != 1, "Failed to allocate receive buffer");
+
+    io_uring_buf_ring_add(br->ring, buf->data, buf->length, bid,
+                          io_uring_buf_ring_mask(br->nbufs), 0);
+
+    io_uring_buf_ring_advance(br->ring, 1);
+} /* evpl_io_uring_buf_ring_provide */
+
+void
+evpl_io_uring_buf_ring_init(
+    struct evpl                   *evpl,
+    struct evpl_io_uring_context  *ctx,
+    struct evpl_io_uring_buf_ring *br,
+    int                            bgid,
+    int                            nbufs,
+    unsigned int                   size)
+{
+    int i, rc;
+
+    br->bgid  = bgid;
+    br->nbufs = nbufs;
+    br->size  = size;
+
+    br->ring = io_uring_setup_buf_ring(&ctx->ring, nbufs, bgid, 0, &rc);
+
+    evpl_io_uring_abort_if(!br->ring,
+                           "Failed to set up provided buffer ring: %s",
+                           strerror(-rc));
+
+    br->bufs = evpl_zalloc(sizeof(struct evpl_iovec) * nbufs);
+
+    for (i = 0; i < nbufs; ++i) {
+        evpl_io_uring_buf_ring_provide(evpl, br, i);
+    }
+} /* evpl_io_uring_buf_ring_init */
+
+static void
+evpl_io_uring_buf_ring_cleanup(
+    struct evpl_io_uring_context  *ctx,
+    struct evpl_io_uring_buf_ring *br)
+{
+    int i;
+
+    if (!br->ring) {
+        return;
+    }
+
+    io_uring_free_buf_ring(&ctx->ring, br->ring, br->nbufs, br->bgid);
+
+    for (i = 0; i < br->nbufs; ++i) {
+        evpl_iovec_release(&br->bufs[i]);
+    }
+
+    evpl_free(br->bufs);
+
+    br->ring = NULL;
+} /* evpl_io_uring_buf_ring_cleanup */
+
+static void
+evpl_io_uring_sockets_init(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx)
+{
+    int i, rc;
+
+    rc = io_uring_register_files_sparse(&ctx->ring, EVPL_IO_URING_MAX_FILES);
+
+    if (rc == 0) {
+        ctx->free_files = evpl_zalloc(sizeof(int) * EVPL_IO_URING_MAX_FILES);
+
+        for (i = 0; i < EVPL_IO_URING_MAX_FILES; ++i) {
+            ctx->free_files[i] = EVPL_IO_URING_MAX_FILES - i - 1;
+        }
+
+        ctx->num_free_files = EVPL_IO_URING_MAX_FILES;
+    } else {
+        evpl_io_uring_debug("registered files unavailable: %s",
+                            strerror(-rc));
+    }
+
+    ctx->sockets_ready = 1;
+} /* evpl_io_uring_sockets_init */
+
+void
+evpl_io_uring_sockets_cleanup(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx)
+{
+    struct evpl_io_uring_send *req;
+
+    evpl_io_uring_buf_ring_cleanup(ctx, &ctx->stream_bufs);
+    evpl_io_uring_buf_ring_cleanup(ctx, &ctx->dgram_bufs);
+
+    while (ctx->free_sends) {
+        req = ctx->free_sends;
+        LL_DELETE(ctx->free_sends, req);
+        evpl_free(req);
+    }
+
+    if (ctx->free_files) {
+        evpl_free(ctx->free_files);
+    }
+
+    ctx->sockets_ready = 0;
+} /* evpl_io_uring_sockets_cleanup */
+
+struct evpl_io_uring_send *
+evpl_io_uring_send_alloc(
+    struct evpl_io_uring_context *ctx,
+    evpl_io_uring_op_callback_t   callback)
+{
+    struct evpl_io_uring_send *req;
+    int                        maxiov = evpl_shared->config->max_num_iovec;
+
+    req = ctx->free_sends;
+
+    if (req) {
+        LL_DELETE(ctx->free_sends, req);
+    } else {
+        req = evpl_zalloc(sizeof(*req) +
+                          maxiov * (sizeof(struct iovec) +
+                                    sizeof(struct evpl_iovec)));
+
+        req->iov  = (struct iovec *) (req + 1);
+        req->held = (struct evpl_iovec *) (req->iov + maxiov);
+
+        req->op.private_data = req;
+    }
+
+    req->op.callback = callback;
+    req->addr        = NULL;
+    req->nheld       = 0;
+    req->zerocopy    = 0;
+
+    return req;
+} /* evpl_io_uring_send_alloc */
+
+void
+evpl_io_uring_send_free(
+    struct evpl_io_uring_context *ctx,
+    struct evpl_io_uring_send    *req)
+{
+    int i;
+
+    for (i = 0; i < req->nheld; ++i) {
+        evpl_iovec_release(&req->held[i]);
+    }
+
+    if (req->addr) {
+        evpl_address_release(req->addr);
+    }
+
+    LL_PREPEND(ctx->free_sends, req);
+} /* evpl_io_uring_send_free */
+
+void
+evpl_io_uring_socket_init(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_io_uring_socket  *s,
+    int                           fd,
+    evpl_io_uring_op_callback_t   recv_callback,
+    evpl_io_uring_op_callback_t   connect_callback,
+    evpl_io_uring_op_callback_t   accept_callback)
+{
+    int index, rc;
+
+    if (!ctx->sockets_ready) {
+        evpl_io_uring_sockets_init(evpl, ctx);
+    }
+
+    s->fd         = fd;
+    s->file_index = -1;
+    s->connected  = 0;
+    s->closing    = 0;
+    s->sending    = 0;
+    s->inflight   = 0;
+
+    if (ctx->num_free_files) {
+        index = ctx->free_files[--ctx->num_free_files];
+
+        rc = io_uring_register_files_update(&ctx->ring, index, &fd, 1);
+
+        if (rc == 1) {
+            s->file_index = index;
+        } else {
+            ctx->free_files[ctx->num_free_files++] = index;
+        }
+    }
+
+    s->recv_op.callback        = recv_callback;
+    s->recv_op.private_data    = s;
+    s->connect_op.callback     = connect_callback;
+    s->connect_op.private_data = s;
+    s->accept_op.callback      = accept_callback;
+    s->accept_op.private_data  = s;
+} /* evpl_io_uring_socket_init */
+
+void
+evpl_io_uring_socket_pending_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s   = evpl_bind_private(bind);
+    struct io_uring_sqe          *sqe;
+    unsigned int                  flags = IORING_ASYNC_CANCEL_ALL;
+
+    s->closing = 1;
+
+    if (!s->inflight) {
+        return;
+    }
+
+    if (s->file_index >= 0) {
+        flags |= IORING_ASYNC_CANCEL_FD_FIXED;
+    }
+
+    sqe = evpl_io_uring_get_sqe(ctx);
+
+    io_uring_prep_cancel_fd(sqe, evpl_io_uring_socket_fd(s), flags);
+
+    io_uring_sqe_set_data64(sqe, 0);
+
+    io_uring_submit(&ctx->ring);
+} /* evpl_io_uring_socket_pending_close */
+
+void
+evpl_io_uring_socket_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s   = evpl_bind_private(bind);
+    int                           unregister = -1;
+
+    /* Operations in flight still point at this bind, wait them out */
+    while (s->inflight) {
+        io_uring_submit_and_wait(&ctx->ring, 1);
+        evpl_io_uring_reap(evpl, ctx);
+    }
+
+    if (s->file_index >= 0) {
+        io_uring_register_files_update(&ctx->ring, s->file_index,
+                                       &unregister, 1);
+
+        ctx->free_files[ctx->num_free_files++] = s->file_index;
+
+        s->file_index = -1;
+    }
+
+    if (s->fd >= 0) {
+        close(s->fd);
+        s->fd = -1;
+    }
+} /* evpl_io_uring_socket_close */
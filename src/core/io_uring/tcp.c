@@ -0,0 +1,607 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "uthash/utlist.h"
+
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/buffer.h"
+#include "core/endpoint.h"
+#include "core/bind.h"
+#include "core/protocol.h"
+#include "core/evpl_shared.h"
+#include "core/io_uring/io_uring.h"
+#include "core/io_uring/common.h"
+
+extern struct evpl_shared *evpl_shared;
+
+struct evpl_io_uring_accepted_socket {
+    int fd;
+};
+
+static void
+evpl_io_uring_tcp_send_complete(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe);
+
+static void
+evpl_io_uring_tcp_arm_recv(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_io_uring_socket  *s)
+{
+    struct io_uring_sqe *sqe;
+
+    if (!ctx->stream_bufs.ring) {
+        evpl_io_uring_buf_ring_init(evpl, ctx, &ctx->stream_bufs,
+                                    EVPL_IO_URING_STREAM_BGID,
+                                    EVPL_IO_URING_STREAM_BUFS,
+                                    EVPL_IO_URING_STREAM_BUF_SIZE);
+    }
+
+    sqe = evpl_io_uring_get_sqe(ctx);
+
+    io_uring_prep_recv_multishot(sqe, evpl_io_uring_socket_fd(s), NULL, 0, 0);
+
+    sqe->flags    |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = EVPL_IO_URING_STREAM_BGID;
+
+    evpl_io_uring_socket_sqe(sqe, s, &s->recv_op);
+
+    s->inflight++;
+    s->recv_armed = 1;
+
+    evpl_defer(evpl, &ctx->flush);
+} /* evpl_io_uring_tcp_arm_recv */
+
+/*
+ * Stop receiving while the application has too much data unconsumed.  The
+ * multishot receive is cancelled and not rearmed until resume_recv.
+ */
+static void
+evpl_io_uring_tcp_pause_recv(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_bind             *bind,
+    struct evpl_io_uring_socket  *s)
+{
+    struct io_uring_sqe *sqe;
+
+    bind->flags |= EVPL_BIND_RECV_PAUSED;
+
+    if (!s->recv_armed) {
+        return;
+    }
+
+    sqe = evpl_io_uring_get_sqe(ctx);
+
+    io_uring_prep_cancel64(sqe, (uint64_t) &s->recv_op, 0);
+
+    io_uring_sqe_set_data64(sqe, 0);
+
+    evpl_defer(evpl, &ctx->flush);
+} /* evpl_io_uring_tcp_pause_recv */
+
+static void
+evpl_io_uring_tcp_resume_recv(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s   = evpl_bind_private(bind);
+
+    /* A receive still being cancelled is rearmed when it completes */
+    if (!s->recv_armed && !s->closing) {
+        evpl_io_uring_tcp_arm_recv(evpl, ctx, s);
+    }
+} /* evpl_io_uring_tcp_resume_recv */
+
+static void
+evpl_io_uring_tcp_send(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_bind             *bind,
+    struct evpl_io_uring_socket  *s)
+{
+    struct evpl_io_uring_send *req;
+    struct io_uring_sqe       *sqe;
+    ssize_t                    total;
+    int                        niov;
+
+    if (s->sending || !s->connected || s->closing ||
+        evpl_iovec_ring_is_empty(&bind->iovec_send)) {
+        return;
+    }
+
+    req = evpl_io_uring_send_alloc(ctx, evpl_io_uring_tcp_send_complete);
+
+    req->bind = bind;
+
+    niov = evpl_iovec_ring_iov(&total, req->iov,
+                               evpl_shared->config->max_num_iovec,
+                               &bind->iovec_send);
+
+    memset(&req->msg, 0, sizeof(req->msg));
+    req->msg.msg_iov    = req->iov;
+    req->msg.msg_iovlen = niov;
+
+    req->zerocopy = total >= evpl_shared->config->socket_zerocopy_min;
+
+    sqe = evpl_io_uring_get_sqe(ctx);
+
+    if (req->zerocopy) {
+        io_uring_prep_sendmsg_zc(sqe, evpl_io_uring_socket_fd(s), &req->msg,
+                                 MSG_NOSIGNAL);
+    } else {
+        io_uring_prep_sendmsg(sqe, evpl_io_uring_socket_fd(s), &req->msg,
+                              MSG_NOSIGNAL);
+    }
+
+    evpl_io_uring_socket_sqe(sqe, s, &req->op);
+
+    s->sending = 1;
+    s->inflight++;
+
+    evpl_defer(evpl, &ctx->flush);
+} /* evpl_io_uring_tcp_send */
+
+/*
+ * Take our own references on the first 'length' bytes of the send ring,
+ * which the kernel may still read after they are consumed from the ring.
+ */
+static void
+evpl_io_uring_tcp_send_hold(
+    struct evpl_io_uring_send *req,
+    struct evpl_bind          *bind,
+    ssize_t                    length)
+{
+    struct evpl_iovec *iovec = evpl_iovec_ring_tail(&bind->iovec_send);
+    struct evpl_iovec *held;
+
+    while (length) {
+        held  = &req->held[req->nheld++];
+        *held = *iovec;
+
+        if (held->length > length) {
+            held->length = length;
+        }
+
+        evpl_iovec_incref(held);
+
+        length -= held->length;
+
+        iovec = evpl_iovec_ring_next(&bind->iovec_send, iovec);
+    }
+} /* evpl_io_uring_tcp_send_hold */
+
+static void
+evpl_io_uring_tcp_sent(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    ssize_t           res)
+{
+    int msg_sent;
+
+    evpl_iovec_ring_consume(evpl, &bind->iovec_send, res);
+
+    /* Small sends may share iovecs, so messages are retired by length */
+    msg_sent = evpl_dgram_ring_consume(&bind->dgram_send, res);
+
+    evpl_bind_sent(evpl, bind, res, msg_sent);
+} /* evpl_io_uring_tcp_sent */
+
+static void
+evpl_io_uring_tcp_send_complete(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe)
+{
+    struct evpl_io_uring_context *ctx  = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_send    *req  = op->private_data;
+    struct evpl_bind             *bind = req->bind;
+    struct evpl_io_uring_socket  *s    = evpl_bind_private(bind);
+    int                           res  = cqe->res;
+
+    if (cqe->flags & IORING_CQE_F_NOTIF) {
+        /* The kernel is done with the pages of a zero copy send */
+        evpl_io_uring_send_free(ctx, req);
+        s->inflight--;
+        return;
+    }
+
+    s->sending = 0;
+
+    if (res > 0 && !s->closing) {
+
+        if (cqe->flags & IORING_CQE_F_MORE) {
+            evpl_io_uring_tcp_send_hold(req, bind, res);
+        }
+
+        evpl_io_uring_tcp_sent(evpl, bind, res);
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        evpl_io_uring_send_free(ctx, req);
+        s->inflight--;
+    }
+
+    if (s->closing) {
+        return;
+    }
+
+    if (res <= 0) {
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    if (evpl_iovec_ring_is_empty(&bind->iovec_send)) {
+        if (bind->flags & EVPL_BIND_FINISH) {
+            evpl_close(evpl, bind);
+        }
+    } else {
+        evpl_io_uring_tcp_send(evpl, ctx, bind, s);
+    }
+} /* evpl_io_uring_tcp_send_complete */
+
+static void
+evpl_io_uring_tcp_deliver(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_notify notify;
+    struct evpl_iovec *iovec;
+    int                i, length, niov;
+
+    if (bind->segment_callback) {
+
+        iovec = alloca(sizeof(struct evpl_iovec) * evpl_shared->config->max_num_iovec);
+
+        while (1) {
+
+            length = bind->segment_callback(evpl, bind, bind->private_data);
+
+            if (length == 0 ||
+                evpl_iovec_ring_bytes(&bind->iovec_recv) < length) {
+                break;
+            }
+
+            if (unlikely(length < 0)) {
+                evpl_close(evpl, bind);
+                return;
+            }
+
+            niov = evpl_iovec_ring_copyv(evpl, iovec, &bind->iovec_recv,
+                                         length);
+
+            notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+            notify.recv_msg.iovec     = iovec;
+            notify.recv_msg.niov      = niov;
+            notify.recv_msg.length    = length;
+            notify.recv_msg.addr      = bind->remote;
+            notify.recv_msg.timestamp = 0;
+
+            bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+            for (i = 0; i < niov; ++i) {
+                evpl_iovec_release(&iovec[i]);
+            }
+
+        }
+
+    } else {
+        notify.notify_type         = EVPL_NOTIFY_RECV_DATA;
+        notify.notify_status       = 0;
+        notify.recv_data.timestamp = 0;
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+} /* evpl_io_uring_tcp_deliver */
+
+static void
+evpl_io_uring_tcp_recv_complete(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe)
+{
+    struct evpl_io_uring_context *ctx  = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s    = op->private_data;
+    struct evpl_bind             *bind = evpl_private2bind(s);
+    struct evpl_iovec             buf;
+    int                           bid, more, delivered = 0;
+
+    more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (!more) {
+        s->inflight--;
+        s->recv_armed = 0;
+    }
+
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+        /* Hand our reference to the receive ring and replace the buffer */
+        buf = ctx->stream_bufs.bufs[bid];
+
+        evpl_io_uring_buf_ring_provide(evpl, &ctx->stream_bufs, bid);
+
+        if (cqe->res > 0 && !s->closing) {
+            buf.length = cqe->res;
+            evpl_iovec_ring_add(&bind->iovec_recv, &buf);
+            delivered = 1;
+        } else {
+            evpl_iovec_release(&buf);
+        }
+    }
+
+    if (s->closing) {
+        return;
+    }
+
+    if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS &&
+                          cqe->res != -ECANCELED)) {
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    if (delivered) {
+        evpl_io_uring_tcp_deliver(evpl, bind);
+
+        if (evpl_bind_recv_full(bind) &&
+            !(bind->flags & EVPL_BIND_RECV_PAUSED)) {
+            evpl_io_uring_tcp_pause_recv(evpl, ctx, bind, s);
+        }
+    }
+
+    /* Multishot receive ends when the buffer ring runs dry, so rearm it */
+    if (!more && !s->recv_armed &&
+        !(bind->flags & (EVPL_BIND_PENDING_CLOSED | EVPL_BIND_RECV_PAUSED))) {
+        evpl_io_uring_tcp_arm_recv(evpl, ctx, s);
+    }
+} /* evpl_io_uring_tcp_recv_complete */
+
+static void
+evpl_io_uring_tcp_connect_complete(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe)
+{
+    struct evpl_io_uring_context *ctx  = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s    = op->private_data;
+    struct evpl_bind             *bind = evpl_private2bind(s);
+    struct evpl_notify            notify;
+
+    s->inflight--;
+
+    if (s->closing) {
+        return;
+    }
+
+    if (cqe->res < 0) {
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    s->connected = 1;
+
+    notify.notify_type   = EVPL_NOTIFY_CONNECTED;
+    notify.notify_status = 0;
+    bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+    evpl_io_uring_tcp_arm_recv(evpl, ctx, s);
+    evpl_io_uring_tcp_send(evpl, ctx, bind, s);
+} /* evpl_io_uring_tcp_connect_complete */
+
+static void
+evpl_io_uring_tcp_arm_accept(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_io_uring_socket  *s)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = evpl_io_uring_get_sqe(ctx);
+
+    io_uring_prep_multishot_accept(sqe, evpl_io_uring_socket_fd(s), NULL, NULL,
+                                   0);
+
+    evpl_io_uring_socket_sqe(sqe, s, &s->accept_op);
+
+    s->inflight++;
+
+    evpl_defer(evpl, &ctx->flush);
+} /* evpl_io_uring_tcp_arm_accept */
+
+static void
+evpl_io_uring_tcp_accept_complete(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe)
+{
+    struct evpl_io_uring_context         *ctx         = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket          *ls          = op->private_data;
+    struct evpl_bind                     *listen_bind = evpl_private2bind(ls);
+    struct evpl_io_uring_accepted_socket *accepted_socket;
+    struct evpl_address                  *remote_addr;
+    int                                   rc, more;
+
+    more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (!more) {
+        ls->inflight--;
+    }
+
+    if (ls->closing) {
+        if (cqe->res >= 0) {
+            close(cqe->res);
+        }
+        return;
+    }
+
+    if (cqe->res >= 0) {
+        remote_addr = evpl_address_alloc();
+
+        remote_addr->addrlen = sizeof(remote_addr->sa);
+
+        rc = getpeername(cqe->res, remote_addr->addr, &remote_addr->addrlen);
+
+        if (rc < 0) {
+            /* Peer went away before we got to it */
+            close(cqe->res);
+            evpl_free(remote_addr);
+        } else {
+            accepted_socket = evpl_zalloc(sizeof(*accepted_socket));
+
+            accepted_socket->fd = cqe->res;
+
+            listen_bind->accept_callback(evpl, listen_bind, remote_addr,
+                                         accepted_socket,
+                                         listen_bind->private_data);
+        }
+    }
+
+    if (!more) {
+        evpl_io_uring_tcp_arm_accept(evpl, ctx, ls);
+    }
+} /* evpl_io_uring_tcp_accept_complete */
+
+static void
+evpl_io_uring_tcp_connect(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s   = evpl_bind_private(bind);
+    struct io_uring_sqe          *sqe;
+    int                           fd, rc, yes = 1;
+
+    fd = socket(bind->remote->addr->sa_family, SOCK_STREAM, 0);
+
+    evpl_io_uring_abort_if(fd < 0, "Failed to create tcp socket: %s",
+                           strerror(errno));
+
+    rc = setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+    evpl_io_uring_abort_if(rc, "Failed to set TCP_NODELAY on socket");
+
+    evpl_io_uring_socket_init(evpl, ctx, s, fd,
+                              evpl_io_uring_tcp_recv_complete,
+                              evpl_io_uring_tcp_connect_complete,
+                              NULL);
+
+    sqe = evpl_io_uring_get_sqe(ctx);
+
+    io_uring_prep_connect(sqe, evpl_io_uring_socket_fd(s), bind->remote->addr,
+                          bind->remote->addrlen);
+
+    evpl_io_uring_socket_sqe(sqe, s, &s->connect_op);
+
+    s->inflight++;
+
+    evpl_defer(evpl, &ctx->flush);
+} /* evpl_io_uring_tcp_connect */
+
+static void
+evpl_io_uring_tcp_attach(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    void             *accepted)
+{
+    struct evpl_io_uring_context         *ctx             = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket          *s               = evpl_bind_private(bind);
+    struct evpl_io_uring_accepted_socket *accepted_socket = accepted;
+    int                                   fd              = accepted_socket->fd;
+    int                                   rc, yes = 1;
+
+    evpl_free(accepted_socket);
+
+    rc = setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+    evpl_io_uring_abort_if(rc, "Failed to set TCP_NODELAY on socket");
+
+    evpl_io_uring_socket_init(evpl, ctx, s, fd,
+                              evpl_io_uring_tcp_recv_complete,
+                              NULL,
+                              NULL);
+
+    s->connected = 1;
+
+    evpl_io_uring_tcp_arm_recv(evpl, ctx, s);
+} /* evpl_io_uring_tcp_attach */
+
+static void
+evpl_io_uring_tcp_listen(
+    struct evpl      *evpl,
+    struct evpl_bind *listen_bind)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s   = evpl_bind_private(listen_bind);
+    int                           fd, rc;
+    const int                     yes = 1;
+
+    fd = socket(listen_bind->local->addr->sa_family, SOCK_STREAM, 0);
+
+    evpl_io_uring_abort_if(fd < 0, "Failed to create tcp listen socket: %s",
+                           strerror(errno));
+
+    rc = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
+
+    evpl_io_uring_abort_if(rc < 0, "Failed to set socket options: %s",
+                           strerror(errno));
+
+    rc = bind(fd, listen_bind->local->addr, listen_bind->local->addrlen);
+
+    evpl_io_uring_abort_if(rc < 0, "Failed to bind listen socket: %s",
+                           strerror(errno));
+
+    rc = listen(fd, evpl_shared->config->max_pending);
+
+    evpl_io_uring_fatal_if(rc, "Failed to listen on listener fd");
+
+    evpl_io_uring_socket_init(evpl, ctx, s, fd,
+                              NULL,
+                              NULL,
+                              evpl_io_uring_tcp_accept_complete);
+
+    evpl_io_uring_tcp_arm_accept(evpl, ctx, s);
+} /* evpl_io_uring_tcp_listen */
+
+static void
+evpl_io_uring_tcp_flush(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s   = evpl_bind_private(bind);
+
+    evpl_io_uring_tcp_send(evpl, ctx, bind, s);
+} /* evpl_io_uring_tcp_flush */
+
+struct evpl_protocol evpl_io_uring_tcp = {
+    .id                = EVPL_STREAM_IO_URING_TCP,
+    .connected         = 1,
+    .stream            = 1,
+    .name              = "STREAM_IO_URING_TCP",
+    .framework         = &evpl_framework_io_uring,
+    .bind_private_size = sizeof(struct evpl_io_uring_socket),
+    .coalesce_sends    = 1,
+    .connect           = evpl_io_uring_tcp_connect,
+    .pending_close     = evpl_io_uring_socket_pending_close,
+    .close             = evpl_io_uring_socket_close,
+    .listen            = evpl_io_uring_tcp_listen,
+    .attach            = evpl_io_uring_tcp_attach,
+    .flush             = evpl_io_uring_tcp_flush,
+    .resume_recv       = evpl_io_uring_tcp_resume_recv,
+};
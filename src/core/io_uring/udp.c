@@ -0,0 +1,313 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/buffer.h"
+#include "core/endpoint.h"
+#include "core/bind.h"
+#include "core/protocol.h"
+#include "core/evpl_shared.h"
+#include "core/io_uring/io_uring.h"
+#include "core/io_uring/common.h"
+
+extern struct evpl_shared *evpl_shared;
+
+static void
+evpl_io_uring_udp_arm_recv(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_io_uring_socket  *s)
+{
+    struct io_uring_sqe *sqe;
+
+    if (!ctx->dgram_bufs.ring) {
+        /* Each buffer holds the recvmsg header and source address too */
+        evpl_io_uring_buf_ring_init(evpl, ctx, &ctx->dgram_bufs,
+                                    EVPL_IO_URING_DGRAM_BGID,
+                                    EVPL_IO_URING_DGRAM_BUFS,
+                                    sizeof(struct io_uring_recvmsg_out) +
+                                    sizeof(struct sockaddr_storage) +
+                                    evpl_shared->config->max_datagram_size);
+    }
+
+    sqe = evpl_io_uring_get_sqe(ctx);
+
+    io_uring_prep_recvmsg_multishot(sqe, evpl_io_uring_socket_fd(s),
+                                    &s->recv_msg, 0);
+
+    sqe->flags    |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = EVPL_IO_URING_DGRAM_BGID;
+
+    evpl_io_uring_socket_sqe(sqe, s, &s->recv_op);
+
+    s->inflight++;
+
+    evpl_defer(evpl, &ctx->flush);
+} /* evpl_io_uring_udp_arm_recv */
+
+static void
+evpl_io_uring_udp_deliver(
+    struct evpl                 *evpl,
+    struct evpl_bind            *bind,
+    struct evpl_io_uring_socket *s,
+    struct evpl_iovec           *buf,
+    int                          length)
+{
+    struct io_uring_recvmsg_out *out;
+    struct evpl_address         *addr;
+    struct evpl_iovec            payload;
+    struct evpl_notify           notify;
+
+    out = io_uring_recvmsg_validate(buf->data, length, &s->recv_msg);
+
+    if (unlikely(!out || (out->flags & MSG_TRUNC))) {
+        return;
+    }
+
+    addr = evpl_address_intern(evpl, io_uring_recvmsg_name(out),
+                               out->namelen);
+
+    /* The payload shares the reference we hold on the whole buffer */
+    payload.data    = io_uring_recvmsg_payload(out, &s->recv_msg);
+    payload.length  = io_uring_recvmsg_payload_length(out, length,
+                                                      &s->recv_msg);
+    payload.private = buf->private;
+
+    notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+    notify.notify_status      = 0;
+    notify.recv_msg.iovec     = &payload;
+    notify.recv_msg.niov      = 1;
+    notify.recv_msg.length    = payload.length;
+    notify.recv_msg.addr      = addr;
+    notify.recv_msg.timestamp = 0;
+
+    bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+    evpl_address_release(addr);
+} /* evpl_io_uring_udp_deliver */
+
+static void
+evpl_io_uring_udp_recv_complete(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe)
+{
+    struct evpl_io_uring_context *ctx  = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s    = op->private_data;
+    struct evpl_bind             *bind = evpl_private2bind(s);
+    struct evpl_iovec             buf;
+    int                           bid, more;
+
+    more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (!more) {
+        s->inflight--;
+    }
+
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+        buf = ctx->dgram_bufs.bufs[bid];
+
+        evpl_io_uring_buf_ring_provide(evpl, &ctx->dgram_bufs, bid);
+
+        if (cqe->res > 0 && !s->closing) {
+            evpl_io_uring_udp_deliver(evpl, bind, s, &buf, cqe->res);
+        }
+
+        evpl_iovec_release(&buf);
+    }
+
+    if (s->closing) {
+        return;
+    }
+
+    if (cqe->res < 0 && cqe->res != -ENOBUFS) {
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    if (!more && !(bind->flags & EVPL_BIND_PENDING_CLOSED)) {
+        evpl_io_uring_udp_arm_recv(evpl, ctx, s);
+    }
+} /* evpl_io_uring_udp_recv_complete */
+
+static void
+evpl_io_uring_udp_send(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_bind             *bind,
+    struct evpl_io_uring_socket  *s);
+
+static void
+evpl_io_uring_udp_send_complete(
+    struct evpl             *evpl,
+    struct evpl_io_uring_op *op,
+    struct io_uring_cqe     *cqe)
+{
+    struct evpl_io_uring_context *ctx  = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_send    *req  = op->private_data;
+    struct evpl_bind             *bind = req->bind;
+    struct evpl_io_uring_socket  *s    = evpl_bind_private(bind);
+    int                           res  = cqe->res;
+
+    s->sending--;
+    s->inflight--;
+
+    if (res >= 0 && !s->closing) {
+        evpl_bind_sent(evpl, bind, res, 1);
+    }
+
+    evpl_io_uring_send_free(ctx, req);
+
+    if (s->closing) {
+        return;
+    }
+
+    if (res < 0) {
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    if (evpl_dgram_ring_is_empty(&bind->dgram_send)) {
+        if (!s->sending && (bind->flags & EVPL_BIND_FINISH)) {
+            evpl_close(evpl, bind);
+        }
+    } else {
+        evpl_io_uring_udp_send(evpl, ctx, bind, s);
+    }
+} /* evpl_io_uring_udp_send_complete */
+
+/*
+ * Queue one sendmsg SQE per datagram, up to the datagram batch size in
+ * flight per socket.  Each send takes over the iovecs and address of its
+ * datagram, so completions may arrive in any order.
+ */
+static void
+evpl_io_uring_udp_send(
+    struct evpl                  *evpl,
+    struct evpl_io_uring_context *ctx,
+    struct evpl_bind             *bind,
+    struct evpl_io_uring_socket  *s)
+{
+    struct evpl_io_uring_send *req;
+    struct evpl_dgram         *dgram;
+    struct evpl_iovec         *iovec;
+    struct io_uring_sqe       *sqe;
+    int                        i, nmsg = 0;
+    int                        maxmsg = evpl_shared->config->max_datagram_batch;
+
+    if (s->closing) {
+        return;
+    }
+
+    while (s->sending < maxmsg &&
+           (dgram = evpl_dgram_ring_tail(&bind->dgram_send)) != NULL) {
+
+        req = evpl_io_uring_send_alloc(ctx, evpl_io_uring_udp_send_complete);
+
+        req->bind = bind;
+        req->addr = dgram->addr;
+
+        for (i = 0; i < dgram->niov; ++i) {
+            iovec = evpl_iovec_ring_tail(&bind->iovec_send);
+
+            req->held[i]         = *iovec;
+            req->iov[i].iov_base = iovec->data;
+            req->iov[i].iov_len  = iovec->length;
+
+            evpl_iovec_ring_remove(&bind->iovec_send);
+        }
+
+        req->nheld = dgram->niov;
+
+        memset(&req->msg, 0, sizeof(req->msg));
+        req->msg.msg_name    = req->addr->addr;
+        req->msg.msg_namelen = req->addr->addrlen;
+        req->msg.msg_iov     = req->iov;
+        req->msg.msg_iovlen  = dgram->niov;
+
+        evpl_dgram_ring_remove(&bind->dgram_send);
+
+        sqe = evpl_io_uring_get_sqe(ctx);
+
+        io_uring_prep_sendmsg(sqe, evpl_io_uring_socket_fd(s), &req->msg,
+                              MSG_NOSIGNAL);
+
+        evpl_io_uring_socket_sqe(sqe, s, &req->op);
+
+        s->sending++;
+        s->inflight++;
+        nmsg++;
+    }
+
+    if (nmsg) {
+        evpl_defer(evpl, &ctx->flush);
+    }
+} /* evpl_io_uring_udp_send */
+
+static void
+evpl_io_uring_udp_flush(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s   = evpl_bind_private(bind);
+
+    evpl_io_uring_udp_send(evpl, ctx, bind, s);
+} /* evpl_io_uring_udp_flush */
+
+static void
+evpl_io_uring_udp_bind(
+    struct evpl      *evpl,
+    struct evpl_bind *evbind)
+{
+    struct evpl_io_uring_context *ctx = evpl_framework_private(evpl, EVPL_FRAMEWORK_IO_URING);
+    struct evpl_io_uring_socket  *s   = evpl_bind_private(evbind);
+    int                           fd, rc;
+
+    fd = socket(evbind->local->addr->sa_family, SOCK_DGRAM, 0);
+
+    evpl_io_uring_abort_if(fd < 0, "Failed to create socket: %s",
+                           strerror(errno));
+
+    rc = bind(fd, evbind->local->addr, evbind->local->addrlen);
+
+    evpl_io_uring_abort_if(rc, "Failed to bind socket: %s", strerror(errno));
+
+    evpl_io_uring_socket_init(evpl, ctx, s, fd,
+                              evpl_io_uring_udp_recv_complete,
+                              NULL,
+                              NULL);
+
+    memset(&s->recv_msg, 0, sizeof(s->recv_msg));
+    s->recv_msg.msg_namelen = sizeof(struct sockaddr_storage);
+
+    evpl_io_uring_udp_arm_recv(evpl, ctx, s);
+} /* evpl_io_uring_udp_bind */
+
+struct evpl_protocol evpl_io_uring_udp = {
+    .id                = EVPL_DATAGRAM_IO_URING_UDP,
+    .connected         = 0,
+    .stream            = 0,
+    .name              = "DATAGRAM_IO_URING_UDP",
+    .framework         = &evpl_framework_io_uring,
+    .bind_private_size = sizeof(struct evpl_io_uring_socket),
+    .bind              = evpl_io_uring_udp_bind,
+    .pending_close     = evpl_io_uring_socket_pending_close,
+    .close             = evpl_io_uring_socket_close,
+    .flush             = evpl_io_uring_udp_flush,
+};
@@ -11,9 +11,15 @@
 #include "evpl/evpl.h"
 #include "core/buffer.h"
 
+/*
+ * Rings are allocated lazily on first use, starting at base_size entries,
+ * and may be trimmed back to no allocation at all while empty.
+ */
+
 struct evpl_iovec_ring {
     struct evpl_iovec *iovec;
     int                size;
+    int                base_size;
     int                mask;
     int                alignment;
     int                head;
@@ -27,10 +33,10 @@ evpl_iovec_ring_alloc(
     int                     size,
     int                     alignment)
 {
-    ring->iovec = evpl_valloc(size * sizeof(struct evpl_iovec), alignment);
-
-    ring->size      = size;
-    ring->mask      = size - 1;
+    ring->iovec     = NULL;
+    ring->size      = 0;
+    ring->base_size = size;
+    ring->mask      = 0;
     ring->alignment = alignment;
     ring->head      = 0;
     ring->tail      = 0;
@@ -41,9 +47,25 @@ evpl_iovec_ring_alloc(
 static inline void
 evpl_iovec_ring_free(struct evpl_iovec_ring *ring)
 {
-    evpl_free(ring->iovec);
+    evpl_free_tagged(ring->iovec, EVPL_MEMORY_TAG_RING);
 } // evpl_iovec_ring_free
 
+static inline void
+evpl_iovec_ring_trim(struct evpl_iovec_ring *ring)
+{
+    if (!ring->iovec || ring->head != ring->tail) {
+        return;
+    }
+
+    evpl_free_tagged(ring->iovec, EVPL_MEMORY_TAG_RING);
+
+    ring->iovec = NULL;
+    ring->size  = 0;
+    ring->mask  = 0;
+    ring->head  = 0;
+    ring->tail  = 0;
+} // evpl_iovec_ring_trim
+
 static inline void
 evpl_iovec_ring_check(const struct evpl_iovec_ring *ring)
 {
@@ -57,7 +79,7 @@ evpl_iovec_ring_check(const struct evpl_iovec_ring *ring)
         bytes += iovec->length;
 
         evpl_core_abort_if(iovec->length < 1, "zero length iovec in ring");
-        evpl_core_abort_if(evpl_iovec_buffer(iovec)->refcnt < 1,
+        evpl_core_abort_if(evpl_buffer_refs(evpl_iovec_buffer(iovec)) < 1,
                            "iovec in ring with no refcnt!");
 
         cur = (cur + 1) & ring->mask;
@@ -72,9 +94,21 @@ evpl_iovec_ring_check(const struct evpl_iovec_ring *ring)
 static inline void
 evpl_iovec_ring_resize(struct evpl_iovec_ring *ring)
 {
-    int                new_size  = ring->size << 1;
-    struct evpl_iovec *new_iovec = evpl_valloc(
-        new_size * sizeof(struct evpl_iovec), ring->alignment);
+    int                new_size  = ring->size ? ring->size << 1 :
+        ring->base_size;
+    struct evpl_iovec *new_iovec = evpl_valloc_tagged(
+        new_size * sizeof(struct evpl_iovec), ring->alignment,
+        EVPL_MEMORY_TAG_RING);
+
+    if (!ring->iovec) {
+        /* First use of a lazily allocated ring */
+        ring->iovec = new_iovec;
+        ring->size  = new_size;
+        ring->mask  = new_size - 1;
+        ring->head  = 0;
+        ring->tail  = 0;
+        return;
+    }
 
     if (ring->head > ring->tail) {
         memcpy(new_iovec, &ring->iovec[ring->tail], (ring->head - ring->tail) *
@@ -89,7 +123,7 @@ evpl_iovec_ring_resize(struct evpl_iovec_ring *ring)
     ring->head = ring->size - 1;
     ring->tail = 0;
 
-    evpl_free(ring->iovec);
+    evpl_free_tagged(ring->iovec, EVPL_MEMORY_TAG_RING);
 
     ring->iovec = new_iovec;
     ring->size  = new_size;
@@ -105,7 +139,7 @@ evpl_iovec_ring_is_empty(const struct evpl_iovec_ring *ring)
 static inline int
 evpl_iovec_ring_is_full(const struct evpl_iovec_ring *ring)
 {
-    return ((ring->head + 1) & ring->mask) == ring->tail;
+    return ring->size && ((ring->head + 1) & ring->mask) == ring->tail;
 } // evpl_iovec_ring_is_full
 
 static inline uint64_t
@@ -161,7 +195,7 @@ evpl_iovec_ring_add(
 {
     struct evpl_iovec *res;
 
-    if (unlikely(evpl_iovec_ring_is_full(ring))) {
+    if (unlikely(!ring->size || evpl_iovec_ring_is_full(ring))) {
         evpl_iovec_ring_resize(ring);
     }
 
@@ -180,7 +214,7 @@ evpl_iovec_ring_add_new(struct evpl_iovec_ring *ring)
 {
     struct evpl_iovec *res;
 
-    if (unlikely(evpl_iovec_ring_is_full(ring))) {
+    if (unlikely(!ring->size || evpl_iovec_ring_is_full(ring))) {
         evpl_iovec_ring_resize(ring);
     }
 
@@ -250,6 +284,41 @@ evpl_iovec_ring_iov(
     return niov;
 } // evpl_iovec_ring_iov
 
+/* As evpl_iovec_ring_iov, but covering at most 'limit' bytes */
+static inline int
+evpl_iovec_ring_iov_limit(
+    ssize_t                *r_total,
+    struct iovec           *iov,
+    int                     max_iov,
+    struct evpl_iovec_ring *ring,
+    uint64_t                limit)
+{
+    struct evpl_iovec *iovec;
+    int                niov  = 0;
+    int                pos   = ring->tail;
+    uint64_t           total = 0;
+
+    while (niov < max_iov && pos != ring->head && total < limit) {
+        iovec = &ring->iovec[pos];
+
+        iov[niov].iov_base = iovec->data;
+        iov[niov].iov_len  = iovec->length;
+
+        if (iov[niov].iov_len > limit - total) {
+            iov[niov].iov_len = limit - total;
+        }
+
+        total += iov[niov].iov_len;
+        niov++;
+
+        pos = (pos + 1) & ring->mask;
+    }
+
+    *r_total = total;
+
+    return niov;
+} // evpl_iovec_ring_iov_limit
+
 static inline int
 evpl_iovec_ring_consume(
     struct evpl            *evpl,
@@ -354,7 +423,9 @@ evpl_iovec_ring_append(
 
     head = evpl_iovec_ring_head(ring);
 
-    if (head && head->data + head->length == append->data) {
+    /* Adjacent memory may still belong to a different buffer */
+    if (head && head->private == append->private &&
+        head->data + head->length == append->data) {
         head->length += length;
     } else {
         head          = evpl_iovec_ring_add_new(ring);
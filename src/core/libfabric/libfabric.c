@@ -0,0 +1,1664 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <rdma/fabric.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_eq.h>
+#include <rdma/fi_errno.h>
+
+#include "uthash/utlist.h"
+
+#include "core/libfabric/libfabric.h"
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/protocol.h"
+#include "core/bind.h"
+#include "core/endpoint.h"
+#include "core/evpl_shared.h"
+
+#define EVPL_LIBFABRIC_VERSION     FI_VERSION(1, 9)
+
+/* Domains we can open across all providers and interfaces */
+#define EVPL_LIBFABRIC_MAX_DOMAINS 16
+
+#define EVPL_LIBFABRIC_MAX_IOV     32
+
+/* Completions taken per fi_cq_read */
+#define EVPL_LIBFABRIC_CQ_BATCH    64
+
+extern struct evpl_shared *evpl_shared;
+
+#define evpl_libfabric_debug(...) evpl_debug("libfabric", __FILE__, __LINE__, \
+                                             __VA_ARGS__)
+#define evpl_libfabric_info(...)  evpl_info("libfabric", __FILE__, __LINE__, \
+                                            __VA_ARGS__)
+#define evpl_libfabric_error(...) evpl_error("libfabric", __FILE__, __LINE__, \
+                                             __VA_ARGS__)
+#define evpl_libfabric_fatal(...) evpl_fatal("libfabric", __FILE__, __LINE__, \
+                                             __VA_ARGS__)
+#define evpl_libfabric_abort(...) evpl_abort("libfabric", __FILE__, __LINE__, \
+                                             __VA_ARGS__)
+
+#define evpl_libfabric_fatal_if(cond, ...) \
+        evpl_fatal_if(cond, "libfabric", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_libfabric_abort_if(cond, ...) \
+        evpl_abort_if(cond, "libfabric", __FILE__, __LINE__, __VA_ARGS__)
+
+/*
+ * A fabric domain, opened by the first bind that needs it and shared
+ * by all threads.  Slabs are registered with every domain that wants
+ * local buffers registered, and RDM domains keep one address vector
+ * for all of their endpoints.
+ */
+struct evpl_libfabric_domain {
+    int                index;
+    struct fi_info    *info;
+    struct fid_fabric *fabric;
+    struct fid_domain *domain;
+    struct fid_av     *av;
+    int                mr_local;
+    int                iov_limit;
+    uint64_t           max_msg_size;
+    uint64_t           next_key;
+};
+
+struct evpl_libfabric_shared {
+    pthread_mutex_t               lock;
+    struct evpl_libfabric_domain *domains[EVPL_LIBFABRIC_MAX_DOMAINS];
+    int                           num_domains;
+};
+
+/* A peer's handle in the address vector of each RDM domain */
+struct evpl_libfabric_peer {
+    fi_addr_t fi_addr[EVPL_LIBFABRIC_MAX_DOMAINS];
+};
+
+/*
+ * Sent ahead of each RDM datagram, RDM providers don't reliably report
+ * the source of a message from a peer we have not sent to
+ */
+struct evpl_libfabric_hdr {
+    uint32_t addrlen;
+    union {
+        struct sockaddr     sa;
+        struct sockaddr_in  sin;
+        struct sockaddr_in6 sin6;
+    } addr;
+};
+
+struct evpl_libfabric_ep;
+
+struct evpl_libfabric_rx {
+    struct fi_context2        context; /* must be first */
+    struct evpl_libfabric_ep *ep;
+    struct evpl_iovec         iovec;
+    int                       posted;
+};
+
+struct evpl_libfabric_sr {
+    struct fi_context2        context; /* must be first */
+    struct evpl_libfabric_ep *ep;
+    uint64_t                  length;
+    int                       nmsg;
+    int                       niov;
+    struct evpl_libfabric_sr *prev;
+    struct evpl_libfabric_sr *next;
+    struct evpl_iovec         iovec[EVPL_LIBFABRIC_MAX_IOV];
+};
+
+/* Per thread state for one domain, or for one RDM endpoint */
+struct evpl_libfabric_device {
+    struct evpl_libfabric_domain *dom;
+    struct fid_cq                *cq;
+    struct fid_eq                *eq;
+    struct evpl_event             cq_event;
+    struct evpl_event             eq_event;
+    struct evpl_deferral          progress;
+    int                           num_ep;
+    struct evpl_libfabric_device *prev;
+    struct evpl_libfabric_device *next;
+};
+
+struct evpl_libfabric {
+    struct evpl_libfabric_shared *shared;
+    struct evpl_libfabric_device *devices[EVPL_LIBFABRIC_MAX_DOMAINS];
+    struct evpl_libfabric_device *device_list;
+    struct evpl_poll             *poll;
+    struct evpl_libfabric_sr     *free_sr;
+};
+
+struct evpl_libfabric_ep {
+    struct evpl_libfabric        *lf;
+    struct evpl_libfabric_device *dev;
+    struct fid_ep                *ep;
+    struct fid_pep               *pep;
+    struct evpl_libfabric_rx     *rx;
+    int                           num_rx;
+    struct evpl_libfabric_sr     *sends;
+    int                           active_sends;
+    struct evpl_iovec             hdr;
+    int                           rdm;
+    int                           stream;
+    int                           connected;
+};
+
+#define evpl_event_libfabric_cq(eventp) \
+        container_of((eventp), struct evpl_libfabric_device, cq_event)
+
+#define evpl_event_libfabric_eq(eventp) \
+        container_of((eventp), struct evpl_libfabric_device, eq_event)
+
+static void
+evpl_libfabric_flush_datagram(
+    struct evpl      *evpl,
+    struct evpl_bind *bind);
+
+static void
+evpl_libfabric_flush_stream(
+    struct evpl      *evpl,
+    struct evpl_bind *bind);
+
+static inline struct evpl_libfabric_sr *
+evpl_libfabric_sr_alloc(
+    struct evpl_libfabric    *lf,
+    struct evpl_libfabric_ep *ep)
+{
+    struct evpl_libfabric_sr *sr;
+
+    if (lf->free_sr) {
+        sr = lf->free_sr;
+        LL_DELETE(lf->free_sr, sr);
+    } else {
+        sr = evpl_zalloc(sizeof(*sr));
+    }
+
+    sr->ep     = ep;
+    sr->length = 0;
+    sr->nmsg   = 0;
+    sr->niov   = 0;
+
+    return sr;
+} /* evpl_libfabric_sr_alloc */
+
+static inline void
+evpl_libfabric_sr_free(
+    struct evpl_libfabric    *lf,
+    struct evpl_libfabric_sr *sr)
+{
+    LL_PREPEND(lf->free_sr, sr);
+} /* evpl_libfabric_sr_free */
+
+/* The memory descriptor for an iovec, if the domain wants one */
+static inline void *
+evpl_libfabric_desc(
+    struct evpl_libfabric_domain *dom,
+    struct evpl_iovec            *iovec)
+{
+    struct fid_mr **mrset;
+
+    if (!dom->mr_local) {
+        return NULL;
+    }
+
+    mrset = evpl_buffer_framework_private(evpl_iovec_buffer(iovec),
+                                          EVPL_FRAMEWORK_LIBFABRIC);
+
+    return fi_mr_desc(mrset[dom->index]);
+} /* evpl_libfabric_desc */
+
+static void *
+evpl_libfabric_addr_dup(const struct evpl_address *address)
+{
+    void *addr;
+
+    /* fi_freeinfo() releases hint addresses with free() */
+    addr = malloc(address->addrlen);
+
+    evpl_libfabric_abort_if(!addr, "Failed to allocate address");
+
+    memcpy(addr, address->addr, address->addrlen);
+
+    return addr;
+} /* evpl_libfabric_addr_dup */
+
+/*
+ * Find a provider for an endpoint of 'type' from 'local' to 'remote',
+ * either of which may be NULL.  evpl addresses are sockaddrs, so only
+ * providers that name endpoints by IP address are asked.
+ */
+static struct fi_info *
+evpl_libfabric_getinfo(
+    enum fi_ep_type      type,
+    struct evpl_address *local,
+    struct evpl_address *remote)
+{
+    struct evpl_address *any = local ? local : remote;
+    struct fi_info      *hints, *list, *info;
+    int                  rc;
+
+    hints = fi_allocinfo();
+
+    evpl_libfabric_abort_if(!hints, "fi_allocinfo failed");
+
+    hints->caps                   = FI_MSG;
+    hints->mode                   = FI_CONTEXT | FI_CONTEXT2;
+    hints->addr_format            = any->addr->sa_family == AF_INET6 ?
+        FI_SOCKADDR_IN6 : FI_SOCKADDR_IN;
+    hints->ep_attr->type          = type;
+    hints->domain_attr->threading = FI_THREAD_SAFE;
+    hints->domain_attr->mr_mode   = FI_MR_LOCAL | FI_MR_ALLOCATED |
+        FI_MR_VIRT_ADDR | FI_MR_PROV_KEY;
+
+    if (local) {
+        hints->src_addr    = evpl_libfabric_addr_dup(local);
+        hints->src_addrlen = local->addrlen;
+    }
+
+    if (remote) {
+        hints->dest_addr    = evpl_libfabric_addr_dup(remote);
+        hints->dest_addrlen = remote->addrlen;
+    }
+
+    rc = fi_getinfo(EVPL_LIBFABRIC_VERSION, NULL, NULL, 0, hints, &list);
+
+    fi_freeinfo(hints);
+
+    evpl_libfabric_abort_if(rc, "No libfabric provider for %s endpoints: %s",
+                            type == FI_EP_RDM ? "RDM" : "MSG",
+                            fi_strerror(-rc));
+
+    /* Providers are listed best first */
+    info = fi_dupinfo(list);
+
+    fi_freeinfo(list);
+
+    evpl_libfabric_abort_if(!info, "fi_dupinfo failed");
+
+    return info;
+} /* evpl_libfabric_getinfo */
+
+/*
+ * Return the shared domain an fi_info names, opening it if this is
+ * its first use.  Memory we already have is registered with a new
+ * domain before any thread can use it.
+ */
+static struct evpl_libfabric_domain *
+evpl_libfabric_domain_get(
+    struct evpl_libfabric_shared *shared,
+    struct fi_info               *info)
+{
+    struct evpl_libfabric_domain *dom;
+    struct fi_av_attr             av_attr;
+    int                           i, rc;
+
+    pthread_mutex_lock(&shared->lock);
+
+    for (i = 0; i < shared->num_domains; ++i) {
+        dom = shared->domains[i];
+
+        if (dom->info->ep_attr->type == info->ep_attr->type &&
+            strcmp(dom->info->fabric_attr->prov_name,
+                   info->fabric_attr->prov_name) == 0 &&
+            strcmp(dom->info->fabric_attr->name,
+                   info->fabric_attr->name) == 0 &&
+            strcmp(dom->info->domain_attr->name,
+                   info->domain_attr->name) == 0) {
+            pthread_mutex_unlock(&shared->lock);
+            return dom;
+        }
+    }
+
+    evpl_libfabric_abort_if(shared->num_domains == EVPL_LIBFABRIC_MAX_DOMAINS,
+                            "Too many libfabric domains");
+
+    dom = evpl_zalloc(sizeof(*dom));
+
+    dom->index    = shared->num_domains;
+    dom->next_key = 1;
+    dom->info     = fi_dupinfo(info);
+
+    evpl_libfabric_abort_if(!dom->info, "fi_dupinfo failed");
+
+    rc = fi_fabric(dom->info->fabric_attr, &dom->fabric, NULL);
+
+    evpl_libfabric_abort_if(rc, "fi_fabric error %s", fi_strerror(-rc));
+
+    rc = fi_domain(dom->fabric, dom->info, &dom->domain, NULL);
+
+    evpl_libfabric_abort_if(rc, "fi_domain error %s", fi_strerror(-rc));
+
+    if (dom->info->ep_attr->type == FI_EP_RDM) {
+
+        memset(&av_attr, 0, sizeof(av_attr));
+        av_attr.type = FI_AV_TABLE;
+
+        rc = fi_av_open(dom->domain, &av_attr, &dom->av, NULL);
+
+        evpl_libfabric_abort_if(rc, "fi_av_open error %s", fi_strerror(-rc));
+    }
+
+    dom->mr_local     = !!(dom->info->domain_attr->mr_mode & FI_MR_LOCAL);
+    dom->max_msg_size = dom->info->ep_attr->max_msg_size;
+    dom->iov_limit    = dom->info->tx_attr->iov_limit;
+
+    if (dom->iov_limit > EVPL_LIBFABRIC_MAX_IOV) {
+        dom->iov_limit = EVPL_LIBFABRIC_MAX_IOV;
+    }
+
+    evpl_libfabric_info("Opened %s domain %s of provider %s",
+                        dom->info->ep_attr->type == FI_EP_RDM ? "RDM" : "MSG",
+                        dom->info->domain_attr->name,
+                        dom->info->fabric_attr->prov_name);
+
+    shared->domains[dom->index] = dom;
+
+    __atomic_store_n(&shared->num_domains, dom->index + 1, __ATOMIC_RELEASE);
+
+    if (dom->mr_local) {
+        evpl_framework_reregister();
+    }
+
+    pthread_mutex_unlock(&shared->lock);
+
+    return dom;
+} /* evpl_libfabric_domain_get */
+
+/*
+ * The handle for an address in an RDM domain's address vector, cached
+ * on the address.  Threads share the vector, so they share handles.
+ */
+static fi_addr_t
+evpl_libfabric_peer_addr(
+    struct evpl_libfabric_domain *dom,
+    struct evpl_address          *address)
+{
+    struct evpl_libfabric_peer *peer, *expected = NULL;
+    fi_addr_t                   fi_addr, expected_addr = FI_ADDR_NOTAVAIL;
+    int                         i, rc;
+
+    peer = __atomic_load_n(
+        (struct evpl_libfabric_peer **) &address->framework_private[EVPL_FRAMEWORK_LIBFABRIC],
+        __ATOMIC_ACQUIRE);
+
+    if (unlikely(!peer)) {
+
+        peer = evpl_zalloc(sizeof(*peer));
+
+        for (i = 0; i < EVPL_LIBFABRIC_MAX_DOMAINS; ++i) {
+            peer->fi_addr[i] = FI_ADDR_NOTAVAIL;
+        }
+
+        if (!__atomic_compare_exchange_n(
+                (struct evpl_libfabric_peer **) &address->framework_private[EVPL_FRAMEWORK_LIBFABRIC],
+                &expected, peer, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            evpl_free(peer);
+            peer = expected;
+        }
+    }
+
+    fi_addr = __atomic_load_n(&peer->fi_addr[dom->index], __ATOMIC_ACQUIRE);
+
+    if (likely(fi_addr != FI_ADDR_NOTAVAIL)) {
+        return fi_addr;
+    }
+
+    rc = fi_av_insert(dom->av, address->addr, 1, &fi_addr, 0, NULL);
+
+    if (unlikely(rc != 1)) {
+        evpl_libfabric_debug("Failed to insert address into address vector");
+        return FI_ADDR_NOTAVAIL;
+    }
+
+    /* Another thread may have inserted the same address meanwhile */
+    if (!__atomic_compare_exchange_n(&peer->fi_addr[dom->index],
+                                     &expected_addr, fi_addr, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        fi_av_remove(dom->av, &fi_addr, 1, 0);
+        fi_addr = expected_addr;
+    }
+
+    return fi_addr;
+} /* evpl_libfabric_peer_addr */
+
+static void
+evpl_libfabric_post_recv(
+    struct evpl              *evpl,
+    struct evpl_libfabric_ep *ep,
+    struct evpl_libfabric_rx *rx)
+{
+    int     size = evpl_shared->config->max_datagram_size;
+    ssize_t rc;
+
+    if (ep->rdm) {
+        size += sizeof(struct evpl_libfabric_hdr);
+    }
+
+    /* Datagram buffers only promise room for the payload, not our header */
+    evpl_iovec_alloc(evpl, size, 0, 1, &rx->iovec);
+
+    rc = fi_recv(ep->ep, rx->iovec.data, rx->iovec.length,
+                 evpl_libfabric_desc(ep->dev->dom, &rx->iovec),
+                 FI_ADDR_UNSPEC, &rx->context);
+
+    evpl_libfabric_abort_if(rc, "fi_recv error %s", fi_strerror(-rc));
+
+    rx->posted = 1;
+} /* evpl_libfabric_post_recv */
+
+static void
+evpl_libfabric_deliver_msg(
+    struct evpl              *evpl,
+    struct evpl_bind         *bind,
+    struct evpl_libfabric_ep *ep,
+    struct evpl_iovec        *iovec)
+{
+    struct evpl_libfabric_hdr *hdr;
+    struct evpl_address       *addr    = bind->remote;
+    struct evpl_iovec          payload = *iovec;
+    struct evpl_notify         notify;
+
+    if (ep->rdm) {
+
+        hdr = iovec->data;
+
+        if (unlikely(iovec->length < sizeof(*hdr) ||
+                     hdr->addrlen < sizeof(sa_family_t) ||
+                     hdr->addrlen > sizeof(hdr->addr))) {
+            evpl_libfabric_debug("Dropping datagram with bad header");
+            return;
+        }
+
+        addr = evpl_address_intern(evpl, &hdr->addr.sa, hdr->addrlen);
+
+        payload.data   += sizeof(*hdr);
+        payload.length -= sizeof(*hdr);
+    }
+
+    notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+    notify.notify_status      = 0;
+    notify.recv_msg.iovec     = &payload;
+    notify.recv_msg.niov      = 1;
+    notify.recv_msg.length    = payload.length;
+    notify.recv_msg.addr      = addr;
+    notify.recv_msg.timestamp = 0;
+
+    bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+    if (ep->rdm) {
+        evpl_address_release(addr);
+    }
+} /* evpl_libfabric_deliver_msg */
+
+static void
+evpl_libfabric_deliver_stream(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_notify notify;
+    struct evpl_iovec *iovec;
+    int                i, length, niov;
+
+    if (bind->segment_callback) {
+
+        iovec = alloca(sizeof(struct evpl_iovec) * evpl_shared->config->max_num_iovec);
+
+        while (1) {
+
+            length = bind->segment_callback(evpl, bind, bind->private_data);
+
+            if (length == 0 ||
+                evpl_iovec_ring_bytes(&bind->iovec_recv) < length) {
+                break;
+            }
+
+            if (unlikely(length < 0)) {
+                evpl_close(evpl, bind);
+                return;
+            }
+
+            niov = evpl_iovec_ring_copyv(evpl, iovec, &bind->iovec_recv,
+                                         length);
+
+            notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+            notify.notify_status      = 0;
+            notify.recv_msg.iovec     = iovec;
+            notify.recv_msg.niov      = niov;
+            notify.recv_msg.length    = length;
+            notify.recv_msg.addr      = bind->remote;
+            notify.recv_msg.timestamp = 0;
+
+            bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+            for (i = 0; i < niov; ++i) {
+                evpl_iovec_release(&iovec[i]);
+            }
+        }
+
+    } else {
+        notify.notify_type         = EVPL_NOTIFY_RECV_DATA;
+        notify.notify_status       = 0;
+        notify.recv_data.timestamp = 0;
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+} /* evpl_libfabric_deliver_stream */
+
+static void
+evpl_libfabric_recv_complete(
+    struct evpl              *evpl,
+    struct evpl_libfabric_rx *rx,
+    size_t                    length)
+{
+    struct evpl_libfabric_ep *ep   = rx->ep;
+    struct evpl_bind         *bind = evpl_private2bind(ep);
+
+    rx->posted       = 0;
+    rx->iovec.length = length;
+
+    if (unlikely(bind->flags & EVPL_BIND_PENDING_CLOSED)) {
+        evpl_iovec_release(&rx->iovec);
+    } else if (ep->stream) {
+
+        if (length) {
+            evpl_iovec_ring_add(&bind->iovec_recv, &rx->iovec);
+            evpl_libfabric_deliver_stream(evpl, bind);
+        } else {
+            evpl_iovec_release(&rx->iovec);
+        }
+
+    } else {
+        evpl_libfabric_deliver_msg(evpl, bind, ep, &rx->iovec);
+        evpl_iovec_release(&rx->iovec);
+    }
+
+    if (ep->ep) {
+        evpl_libfabric_post_recv(evpl, ep, rx);
+    }
+} /* evpl_libfabric_recv_complete */
+
+static void
+evpl_libfabric_send_complete(
+    struct evpl              *evpl,
+    struct evpl_libfabric_sr *sr,
+    int                       status)
+{
+    struct evpl_libfabric_ep *ep   = sr->ep;
+    struct evpl_bind         *bind = evpl_private2bind(ep);
+    int                       i;
+
+    for (i = 0; i < sr->niov; ++i) {
+        evpl_iovec_release(&sr->iovec[i]);
+    }
+
+    --ep->active_sends;
+
+    DL_DELETE(ep->sends, sr);
+
+    if (likely(!status) && !(bind->flags & EVPL_BIND_PENDING_CLOSED)) {
+        evpl_bind_sent(evpl, bind, sr->length, sr->nmsg);
+    }
+
+    evpl_libfabric_sr_free(ep->lf, sr);
+
+    if (bind->flags & EVPL_BIND_PENDING_CLOSED) {
+        return;
+    }
+
+    if (unlikely(status)) {
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    if (evpl_iovec_ring_is_empty(&bind->iovec_send)) {
+        if (!ep->active_sends && (bind->flags & EVPL_BIND_FINISH)) {
+            evpl_close(evpl, bind);
+        }
+    } else {
+        bind->protocol->flush(evpl, bind);
+    }
+} /* evpl_libfabric_send_complete */
+
+static void
+evpl_libfabric_cq_error(
+    struct evpl                  *evpl,
+    struct evpl_libfabric_device *dev)
+{
+    struct fi_cq_err_entry    err;
+    struct evpl_libfabric_rx *rx;
+    struct evpl_bind         *bind;
+
+    memset(&err, 0, sizeof(err));
+
+    if (fi_cq_readerr(dev->cq, &err, 0) != 1) {
+        return;
+    }
+
+    if (err.flags & FI_RECV) {
+
+        rx   = err.op_context;
+        bind = evpl_private2bind(rx->ep);
+
+        rx->posted = 0;
+        evpl_iovec_release(&rx->iovec);
+
+        /* Receives are cancelled when their endpoint is closed */
+        if (err.err != FI_ECANCELED &&
+            !(bind->flags & EVPL_BIND_PENDING_CLOSED)) {
+            evpl_libfabric_error("receive completion error %s",
+                                 fi_strerror(err.err));
+            evpl_close(evpl, bind);
+        }
+
+    } else {
+        evpl_libfabric_error("send completion error %s",
+                             fi_strerror(err.err));
+        evpl_libfabric_send_complete(evpl, err.op_context, err.err);
+    }
+} /* evpl_libfabric_cq_error */
+
+static void
+evpl_libfabric_poll_cq(
+    struct evpl                  *evpl,
+    struct evpl_libfabric_device *dev)
+{
+    struct fi_cq_data_entry entries[EVPL_LIBFABRIC_CQ_BATCH];
+    ssize_t                 n;
+    int                     i;
+
+    while (1) {
+
+        n = fi_cq_read(dev->cq, entries, EVPL_LIBFABRIC_CQ_BATCH);
+
+        if (n == -FI_EAGAIN) {
+            break;
+        }
+
+        if (n == -FI_EAVAIL) {
+            evpl_libfabric_cq_error(evpl, dev);
+            continue;
+        }
+
+        evpl_libfabric_abort_if(n < 0, "fi_cq_read error %s",
+                                fi_strerror(-n));
+
+        evpl_activity(evpl);
+
+        for (i = 0; i < n; ++i) {
+            if (entries[i].flags & FI_RECV) {
+                evpl_libfabric_recv_complete(evpl, entries[i].op_context,
+                                             entries[i].len);
+            } else {
+                evpl_libfabric_send_complete(evpl, entries[i].op_context, 0);
+            }
+        }
+
+        if (n < EVPL_LIBFABRIC_CQ_BATCH) {
+            break;
+        }
+    }
+} /* evpl_libfabric_poll_cq */
+
+static void
+evpl_libfabric_cq_callback(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct evpl_libfabric_device *dev    = evpl_event_libfabric_cq(event);
+    struct fid                   *fids[] = { &dev->cq->fid };
+
+    evpl_libfabric_poll_cq(evpl, dev);
+
+    /* The wait fd only signals again once the provider has rearmed it */
+    if (fi_trywait(dev->dom->fabric, fids, 1) == FI_SUCCESS) {
+        evpl_event_mark_unreadable(event);
+    }
+} /* evpl_libfabric_cq_callback */
+
+static void
+evpl_libfabric_progress(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_libfabric_device *dev = private_data;
+
+    evpl_libfabric_poll_cq(evpl, dev);
+} /* evpl_libfabric_progress */
+
+/*
+ * The provider's transmit queue is full.  Completions will restart the
+ * flush if there are sends in flight, otherwise some providers need
+ * their completion queue read before they can take more, so we drive
+ * progress and retry on the next pass.
+ */
+static void
+evpl_libfabric_send_blocked(
+    struct evpl              *evpl,
+    struct evpl_bind         *bind,
+    struct evpl_libfabric_ep *ep)
+{
+    if (!ep->active_sends) {
+        evpl_defer(evpl, &ep->dev->progress);
+        evpl_defer(evpl, &bind->flush_deferral);
+    }
+} /* evpl_libfabric_send_blocked */
+
+static void
+evpl_libfabric_accept(
+    struct evpl              *evpl,
+    struct evpl_libfabric_ep *listen_ep,
+    struct fi_info           *info)
+{
+    struct evpl_bind    *listen_bind = evpl_private2bind(listen_ep);
+    struct evpl_address *remote_addr;
+
+    if (unlikely(!info->dest_addr)) {
+        evpl_libfabric_error("Rejecting connection request without a peer address");
+        fi_reject(listen_ep->pep, info->handle, NULL, 0);
+        fi_freeinfo(info);
+        return;
+    }
+
+    remote_addr = evpl_address_init(info->dest_addr, info->dest_addrlen);
+
+    /* The info is freed once the connection is accepted on its thread */
+    listen_bind->accept_callback(
+        evpl,
+        listen_bind,
+        remote_addr,
+        info,
+        listen_bind->private_data);
+} /* evpl_libfabric_accept */
+
+static void
+evpl_libfabric_eq_callback(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct evpl_libfabric_device *dev    = evpl_event_libfabric_eq(event);
+    struct fid                   *fids[] = { &dev->eq->fid };
+    struct evpl_libfabric_ep     *ep;
+    struct evpl_bind             *bind;
+    struct fi_eq_cm_entry         entry;
+    struct fi_eq_err_entry        err;
+    struct evpl_notify            notify;
+    uint32_t                      type;
+    ssize_t                       rc;
+
+    while (1) {
+
+        rc = fi_eq_read(dev->eq, &type, &entry, sizeof(entry), 0);
+
+        if (rc == -FI_EAGAIN) {
+
+            if (fi_trywait(dev->dom->fabric, fids, 1) == FI_SUCCESS) {
+                evpl_event_mark_unreadable(event);
+            }
+
+            return;
+        }
+
+        if (rc == -FI_EAVAIL) {
+
+            memset(&err, 0, sizeof(err));
+
+            if (fi_eq_readerr(dev->eq, &err, 0) < 0) {
+                continue;
+            }
+
+            evpl_libfabric_debug("connection error %s", fi_strerror(err.err));
+
+            if (err.fid && err.fid->context) {
+                bind = evpl_private2bind(err.fid->context);
+                evpl_close(evpl, bind);
+            }
+
+            continue;
+        }
+
+        evpl_libfabric_abort_if(rc < 0, "fi_eq_read error %s",
+                                fi_strerror(-rc));
+
+        ep   = entry.fid->context;
+        bind = evpl_private2bind(ep);
+
+        switch (type) {
+            case FI_CONNREQ:
+                evpl_libfabric_accept(evpl, ep, entry.info);
+                break;
+            case FI_CONNECTED:
+
+                if (bind->flags & EVPL_BIND_PENDING_CLOSED) {
+                    break;
+                }
+
+                ep->connected = 1;
+
+                notify.notify_type   = EVPL_NOTIFY_CONNECTED;
+                notify.notify_status = 0;
+                bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+                evpl_defer(evpl, &bind->flush_deferral);
+                break;
+            case FI_SHUTDOWN:
+                evpl_close(evpl, bind);
+                break;
+            default:
+                evpl_libfabric_debug("unhandled libfabric event %u", type);
+        } /* switch */
+    }
+} /* evpl_libfabric_eq_callback */
+
+static struct evpl_libfabric_device *
+evpl_libfabric_device_create(
+    struct evpl                  *evpl,
+    struct evpl_libfabric        *lf,
+    struct evpl_libfabric_domain *dom)
+{
+    struct evpl_libfabric_device *dev;
+    struct fi_cq_attr             cq_attr;
+    struct fi_eq_attr             eq_attr;
+    int                           rc;
+
+    dev = evpl_zalloc(sizeof(*dev));
+
+    dev->dom = dom;
+
+    memset(&cq_attr, 0, sizeof(cq_attr));
+
+    cq_attr.size     = evpl_shared->config->libfabric_cq_size;
+    cq_attr.format   = FI_CQ_FORMAT_DATA;
+    cq_attr.wait_obj = FI_WAIT_FD;
+
+    rc = fi_cq_open(dom->domain, &cq_attr, &dev->cq, dev);
+
+    evpl_libfabric_abort_if(rc, "fi_cq_open error %s", fi_strerror(-rc));
+
+    rc = fi_control(&dev->cq->fid, FI_GETWAIT, &dev->cq_event.fd);
+
+    evpl_libfabric_abort_if(rc, "Provider %s has no completion queue wait fd: %s",
+                            dom->info->fabric_attr->prov_name,
+                            fi_strerror(-rc));
+
+    dev->cq_event.read_callback = evpl_libfabric_cq_callback;
+
+    evpl_add_event(evpl, &dev->cq_event);
+    evpl_event_read_interest(evpl, &dev->cq_event);
+
+    if (dom->info->ep_attr->type == FI_EP_MSG) {
+
+        memset(&eq_attr, 0, sizeof(eq_attr));
+
+        eq_attr.wait_obj = FI_WAIT_FD;
+
+        rc = fi_eq_open(dom->fabric, &eq_attr, &dev->eq, dev);
+
+        evpl_libfabric_abort_if(rc, "fi_eq_open error %s", fi_strerror(-rc));
+
+        rc = fi_control(&dev->eq->fid, FI_GETWAIT, &dev->eq_event.fd);
+
+        evpl_libfabric_abort_if(rc, "Provider %s has no event queue wait fd: %s",
+                                dom->info->fabric_attr->prov_name,
+                                fi_strerror(-rc));
+
+        dev->eq_event.read_callback = evpl_libfabric_eq_callback;
+
+        evpl_add_event(evpl, &dev->eq_event);
+        evpl_event_read_interest(evpl, &dev->eq_event);
+    }
+
+    evpl_deferral_init(&dev->progress, evpl_libfabric_progress, dev);
+
+    DL_APPEND(lf->device_list, dev);
+
+    return dev;
+} /* evpl_libfabric_device_create */
+
+static void
+evpl_libfabric_device_free(
+    struct evpl                  *evpl,
+    struct evpl_libfabric        *lf,
+    struct evpl_libfabric_device *dev)
+{
+    evpl_remove_deferral(evpl, &dev->progress);
+
+    evpl_remove_event(evpl, &dev->cq_event);
+    fi_close(&dev->cq->fid);
+
+    if (dev->eq) {
+        evpl_remove_event(evpl, &dev->eq_event);
+        fi_close(&dev->eq->fid);
+    }
+
+    DL_DELETE(lf->device_list, dev);
+
+    evpl_free(dev);
+} /* evpl_libfabric_device_free */
+
+/*
+ * Return the queues for an endpoint of a domain.  MSG endpoints share
+ * their thread's queues for the domain, created on first use.  RDM
+ * endpoints each get their own, closed along with the endpoint, since
+ * with rxm a fi_trywait() on a completion queue crashes once any
+ * endpoint bound to it has been closed.
+ */
+static struct evpl_libfabric_device *
+evpl_libfabric_device_get(
+    struct evpl                  *evpl,
+    struct evpl_libfabric        *lf,
+    struct evpl_libfabric_domain *dom)
+{
+    struct evpl_libfabric_device *dev = lf->devices[dom->index];
+
+    if (dom->info->ep_attr->type == FI_EP_RDM) {
+        return evpl_libfabric_device_create(evpl, lf, dom);
+    }
+
+    if (likely(dev)) {
+        return dev;
+    }
+
+    dev = evpl_libfabric_device_create(evpl, lf, dom);
+
+    lf->devices[dom->index] = dev;
+
+    return dev;
+} /* evpl_libfabric_device_get */
+
+static void
+evpl_libfabric_ep_init(
+    struct evpl              *evpl,
+    struct evpl_bind         *bind,
+    struct evpl_libfabric_ep *ep)
+{
+    memset(ep, 0, sizeof(*ep));
+
+    ep->lf     = evpl_framework_private(evpl, EVPL_FRAMEWORK_LIBFABRIC);
+    ep->rdm    = bind->protocol->id == EVPL_DATAGRAM_LIBFABRIC_RDM;
+    ep->stream = bind->protocol->stream;
+} /* evpl_libfabric_ep_init */
+
+/* Create an enabled endpoint on this thread's queues, with receives posted */
+static void
+evpl_libfabric_ep_open(
+    struct evpl              *evpl,
+    struct evpl_libfabric_ep *ep,
+    struct fi_info           *info)
+{
+    struct evpl_libfabric_domain *dom;
+    int                           i, rc;
+
+    dom     = evpl_libfabric_domain_get(ep->lf->shared, info);
+    ep->dev = evpl_libfabric_device_get(evpl, ep->lf, dom);
+
+    rc = fi_endpoint(dom->domain, info, &ep->ep, ep);
+
+    evpl_libfabric_abort_if(rc, "fi_endpoint error %s", fi_strerror(-rc));
+
+    rc = fi_ep_bind(ep->ep, &ep->dev->cq->fid, FI_TRANSMIT | FI_RECV);
+
+    evpl_libfabric_abort_if(rc, "fi_ep_bind cq error %s", fi_strerror(-rc));
+
+    if (ep->rdm) {
+        rc = fi_ep_bind(ep->ep, &dom->av->fid, 0);
+    } else {
+        rc = fi_ep_bind(ep->ep, &ep->dev->eq->fid, 0);
+    }
+
+    evpl_libfabric_abort_if(rc, "fi_ep_bind error %s", fi_strerror(-rc));
+
+    rc = fi_enable(ep->ep);
+
+    evpl_libfabric_abort_if(rc, "fi_enable error %s", fi_strerror(-rc));
+
+    ep->num_rx = evpl_shared->config->libfabric_rx_depth;
+
+    if (ep->num_rx > info->rx_attr->size) {
+        ep->num_rx = info->rx_attr->size;
+    }
+
+    ep->rx = evpl_zalloc(sizeof(struct evpl_libfabric_rx) * ep->num_rx);
+
+    for (i = 0; i < ep->num_rx; ++i) {
+        ep->rx[i].ep = ep;
+        evpl_libfabric_post_recv(evpl, ep, &ep->rx[i]);
+    }
+
+    ep->dev->num_ep++;
+} /* evpl_libfabric_ep_open */
+
+static void
+evpl_libfabric_poll(
+    struct evpl *evpl,
+    void        *arg)
+{
+    struct evpl_libfabric        *lf = arg;
+    struct evpl_libfabric_device *dev;
+
+    DL_FOREACH(lf->device_list, dev)
+    {
+        if (dev->num_ep) {
+            evpl_libfabric_poll_cq(evpl, dev);
+        }
+    }
+} /* evpl_libfabric_poll */
+
+void *
+evpl_libfabric_init()
+{
+    struct evpl_libfabric_shared *shared;
+
+    shared = evpl_zalloc(sizeof(*shared));
+
+    pthread_mutex_init(&shared->lock, NULL);
+
+    return shared;
+} /* evpl_libfabric_init */
+
+void
+evpl_libfabric_cleanup(void *private_data)
+{
+    struct evpl_libfabric_shared *shared = private_data;
+    struct evpl_libfabric_domain *dom;
+    int                           i;
+
+    for (i = 0; i < shared->num_domains; ++i) {
+        dom = shared->domains[i];
+
+        if (dom->av) {
+            fi_close(&dom->av->fid);
+        }
+
+        fi_close(&dom->domain->fid);
+        fi_close(&dom->fabric->fid);
+        fi_freeinfo(dom->info);
+        evpl_free(dom);
+    }
+
+    pthread_mutex_destroy(&shared->lock);
+
+    evpl_free(shared);
+} /* evpl_libfabric_cleanup */
+
+void *
+evpl_libfabric_create(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_libfabric *lf;
+
+    lf = evpl_zalloc(sizeof(*lf));
+
+    lf->shared = private_data;
+
+    lf->poll = evpl_add_poll(evpl, NULL, NULL, evpl_libfabric_poll, lf);
+
+    return lf;
+} /* evpl_libfabric_create */
+
+void
+evpl_libfabric_destroy(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_libfabric        *lf = private_data;
+    struct evpl_libfabric_sr     *sr;
+
+    evpl_remove_poll(evpl, lf->poll);
+
+    while (lf->device_list) {
+        evpl_libfabric_device_free(evpl, lf, lf->device_list);
+    }
+
+    while (lf->free_sr) {
+        sr = lf->free_sr;
+        LL_DELETE(lf->free_sr, sr);
+        evpl_free(sr);
+    }
+
+    evpl_free(lf);
+} /* evpl_libfabric_destroy */
+
+void *
+evpl_libfabric_register(
+    void *buffer,
+    int   size,
+    void *buffer_private,
+    void *private_data)
+{
+    struct evpl_libfabric_shared *shared = private_data;
+    struct evpl_libfabric_domain *dom;
+    struct fid_mr               **mrset;
+    int                           i, num_domains, rc;
+
+    if (buffer_private) {
+        mrset = buffer_private;
+    } else {
+        mrset = evpl_zalloc(sizeof(struct fid_mr *) *
+                            EVPL_LIBFABRIC_MAX_DOMAINS);
+    }
+
+    num_domains = __atomic_load_n(&shared->num_domains, __ATOMIC_ACQUIRE);
+
+    for (i = 0; i < num_domains; ++i) {
+        dom = shared->domains[i];
+
+        if (!dom->mr_local || mrset[i]) {
+            continue;
+        }
+
+        /* Keys only need to be unique when the provider doesn't pick them */
+        rc = fi_mr_reg(dom->domain, buffer, size, FI_SEND | FI_RECV, 0,
+                       __atomic_fetch_add(&dom->next_key, 1, __ATOMIC_RELAXED),
+                       0, &mrset[i], NULL);
+
+        evpl_libfabric_abort_if(rc, "fi_mr_reg error %s", fi_strerror(-rc));
+    }
+
+    return mrset;
+} /* evpl_libfabric_register */
+
+void
+evpl_libfabric_unregister(
+    void *buffer_private,
+    void *private_data)
+{
+    struct fid_mr **mrset = buffer_private;
+    int             i;
+
+    for (i = 0; i < EVPL_LIBFABRIC_MAX_DOMAINS; ++i) {
+        if (mrset[i]) {
+            fi_close(&mrset[i]->fid);
+        }
+    }
+
+    evpl_free(mrset);
+} /* evpl_libfabric_unregister */
+
+void
+evpl_libfabric_release_address(
+    void *address_private,
+    void *private_data)
+{
+    struct evpl_libfabric_peer   *peer   = address_private;
+    struct evpl_libfabric_shared *shared = private_data;
+    int                           i;
+
+    for (i = 0; i < shared->num_domains; ++i) {
+        if (peer->fi_addr[i] != FI_ADDR_NOTAVAIL) {
+            fi_av_remove(shared->domains[i]->av, &peer->fi_addr[i], 1, 0);
+        }
+    }
+
+    evpl_free(peer);
+} /* evpl_libfabric_release_address */
+
+void
+evpl_libfabric_listen(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_libfabric_ep     *ep = evpl_bind_private(bind);
+    struct evpl_libfabric_domain *dom;
+    struct fi_info               *info;
+    int                           rc;
+
+    evpl_libfabric_ep_init(evpl, bind, ep);
+
+    info = evpl_libfabric_getinfo(FI_EP_MSG, bind->local, NULL);
+
+    dom     = evpl_libfabric_domain_get(ep->lf->shared, info);
+    ep->dev = evpl_libfabric_device_get(evpl, ep->lf, dom);
+
+    rc = fi_passive_ep(dom->fabric, info, &ep->pep, ep);
+
+    evpl_libfabric_abort_if(rc, "fi_passive_ep error %s", fi_strerror(-rc));
+
+    rc = fi_pep_bind(ep->pep, &ep->dev->eq->fid, 0);
+
+    evpl_libfabric_abort_if(rc, "fi_pep_bind error %s", fi_strerror(-rc));
+
+    rc = fi_listen(ep->pep);
+
+    evpl_libfabric_abort_if(rc, "fi_listen error %s", fi_strerror(-rc));
+
+    fi_freeinfo(info);
+} /* evpl_libfabric_listen */
+
+void
+evpl_libfabric_attach(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    void             *accepted)
+{
+    struct evpl_libfabric_ep *ep   = evpl_bind_private(bind);
+    struct fi_info           *info = accepted;
+    int                       rc;
+
+    evpl_libfabric_ep_init(evpl, bind, ep);
+
+    evpl_libfabric_ep_open(evpl, ep, info);
+
+    rc = fi_accept(ep->ep, NULL, 0);
+
+    evpl_libfabric_abort_if(rc, "fi_accept error %s", fi_strerror(-rc));
+
+    fi_freeinfo(info);
+} /* evpl_libfabric_attach */
+
+void
+evpl_libfabric_connect(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_libfabric_ep *ep = evpl_bind_private(bind);
+    struct fi_info           *info;
+    int                       rc;
+
+    evpl_libfabric_ep_init(evpl, bind, ep);
+
+    info = evpl_libfabric_getinfo(FI_EP_MSG, bind->local, bind->remote);
+
+    evpl_libfabric_ep_open(evpl, ep, info);
+
+    rc = fi_connect(ep->ep, info->dest_addr, NULL, 0);
+
+    evpl_libfabric_abort_if(rc, "fi_connect error %s", fi_strerror(-rc));
+
+    fi_freeinfo(info);
+} /* evpl_libfabric_connect */
+
+void
+evpl_libfabric_bind(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_libfabric_ep  *ep = evpl_bind_private(bind);
+    struct evpl_libfabric_hdr *hdr;
+    struct fi_info            *info;
+    size_t                     addrlen;
+    int                        rc;
+
+    evpl_libfabric_ep_init(evpl, bind, ep);
+
+    info = evpl_libfabric_getinfo(FI_EP_RDM, bind->local, NULL);
+
+    evpl_libfabric_ep_open(evpl, ep, info);
+
+    fi_freeinfo(info);
+
+    /* Our address as the provider bound it, sent with every datagram */
+    evpl_iovec_alloc_lifetime(evpl, sizeof(*hdr), 0, 1,
+                              EVPL_IOVEC_LIFETIME_LONG, &ep->hdr);
+
+    hdr = ep->hdr.data;
+
+    memset(hdr, 0, sizeof(*hdr));
+
+    addrlen = sizeof(hdr->addr);
+
+    rc = fi_getname(&ep->ep->fid, &hdr->addr, &addrlen);
+
+    evpl_libfabric_abort_if(rc, "fi_getname error %s", fi_strerror(-rc));
+
+    hdr->addrlen = addrlen;
+
+    ep->connected = 1;
+} /* evpl_libfabric_bind */
+
+/* Copy a datagram with more fragments than the provider takes */
+static void
+evpl_libfabric_linearize(
+    struct evpl       *evpl,
+    struct evpl_bind  *bind,
+    struct evpl_dgram *dgram,
+    struct evpl_iovec *flat)
+{
+    struct evpl_iovec *cur;
+    void              *ptr;
+    int                i;
+
+    evpl_iovec_alloc_datagram(evpl, flat, dgram->length);
+
+    ptr = flat->data;
+    cur = evpl_iovec_ring_tail(&bind->iovec_send);
+
+    for (i = 0; i < dgram->niov; ++i) {
+        memcpy(ptr, cur->data, cur->length);
+        ptr += cur->length;
+        cur  = evpl_iovec_ring_next(&bind->iovec_send, cur);
+    }
+} /* evpl_libfabric_linearize */
+
+static void
+evpl_libfabric_flush_datagram(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_libfabric_ep     *ep = evpl_bind_private(bind);
+    struct evpl_libfabric_domain *dom;
+    struct evpl_libfabric_sr     *sr;
+    struct evpl_dgram            *dgram;
+    struct evpl_iovec            *cur, flat;
+    struct iovec                  iov[EVPL_LIBFABRIC_MAX_IOV];
+    void                         *desc[EVPL_LIBFABRIC_MAX_IOV];
+    fi_addr_t                     dest = FI_ADDR_UNSPEC;
+    int                           i, n, linear;
+    ssize_t                       rc;
+
+    if (unlikely(!ep->ep || !ep->connected)) {
+        return;
+    }
+
+    dom = ep->dev->dom;
+
+    while ((dgram = evpl_dgram_ring_tail(&bind->dgram_send)) != NULL) {
+
+        if (ep->rdm) {
+
+            dest = evpl_libfabric_peer_addr(dom, dgram->addr);
+
+            if (unlikely(dest == FI_ADDR_NOTAVAIL)) {
+                evpl_iovec_ring_consumev(evpl, &bind->iovec_send, dgram->niov);
+                evpl_address_release(dgram->addr);
+                evpl_dgram_ring_remove(&bind->dgram_send);
+                continue;
+            }
+        }
+
+        n = 0;
+
+        if (ep->rdm) {
+            iov[n].iov_base = ep->hdr.data;
+            iov[n].iov_len  = sizeof(struct evpl_libfabric_hdr);
+            desc[n]         = evpl_libfabric_desc(dom, &ep->hdr);
+            n++;
+        }
+
+        linear = n + dgram->niov > dom->iov_limit;
+
+        if (unlikely(linear)) {
+
+            evpl_libfabric_linearize(evpl, bind, dgram, &flat);
+
+            iov[n].iov_base = flat.data;
+            iov[n].iov_len  = flat.length;
+            desc[n]         = evpl_libfabric_desc(dom, &flat);
+            n++;
+
+        } else {
+
+            cur = evpl_iovec_ring_tail(&bind->iovec_send);
+
+            for (i = 0; i < dgram->niov; ++i) {
+                iov[n].iov_base = cur->data;
+                iov[n].iov_len  = cur->length;
+                desc[n]         = evpl_libfabric_desc(dom, cur);
+                n++;
+
+                cur = evpl_iovec_ring_next(&bind->iovec_send, cur);
+            }
+        }
+
+        sr = evpl_libfabric_sr_alloc(ep->lf, ep);
+
+        rc = fi_sendv(ep->ep, iov, desc, n, dest, &sr->context);
+
+        if (unlikely(rc == -FI_EAGAIN)) {
+
+            evpl_libfabric_sr_free(ep->lf, sr);
+
+            if (linear) {
+                evpl_iovec_release(&flat);
+            }
+
+            evpl_libfabric_send_blocked(evpl, bind, ep);
+            break;
+        }
+
+        evpl_libfabric_abort_if(rc, "fi_sendv error %s", fi_strerror(-rc));
+
+        /* The send now owns the datagram's iovecs */
+        if (unlikely(linear)) {
+            sr->iovec[sr->niov++] = flat;
+            evpl_iovec_ring_consumev(evpl, &bind->iovec_send, dgram->niov);
+        } else {
+            for (i = 0; i < dgram->niov; ++i) {
+                sr->iovec[sr->niov++] = *evpl_iovec_ring_tail(&bind->iovec_send);
+                evpl_iovec_ring_remove(&bind->iovec_send);
+            }
+        }
+
+        sr->length = dgram->length;
+        sr->nmsg   = 1;
+
+        if (ep->rdm) {
+            evpl_address_release(dgram->addr);
+        }
+
+        evpl_dgram_ring_remove(&bind->dgram_send);
+
+        DL_APPEND(ep->sends, sr);
+        ++ep->active_sends;
+    }
+
+    if (!ep->active_sends && evpl_iovec_ring_is_empty(&bind->iovec_send) &&
+        (bind->flags & EVPL_BIND_FINISH)) {
+        evpl_close(evpl, bind);
+    }
+} /* evpl_libfabric_flush_datagram */
+
+/*
+ * Send the stream as messages no larger than the receive buffers our
+ * peer posts, which are datagram sized.
+ */
+static void
+evpl_libfabric_flush_stream(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_libfabric_ep     *ep = evpl_bind_private(bind);
+    struct evpl_libfabric_domain *dom;
+    struct evpl_libfabric_sr     *sr;
+    struct evpl_iovec            *cur;
+    struct iovec                  iov[EVPL_LIBFABRIC_MAX_IOV];
+    void                         *desc[EVPL_LIBFABRIC_MAX_IOV];
+    uint64_t                      max = evpl_shared->config->max_datagram_size;
+    ssize_t                       total, rc;
+    int                           i, n;
+
+    if (unlikely(!ep->ep || !ep->connected)) {
+        return;
+    }
+
+    dom = ep->dev->dom;
+
+    if (max > dom->max_msg_size) {
+        max = dom->max_msg_size;
+    }
+
+    while (!evpl_iovec_ring_is_empty(&bind->iovec_send)) {
+
+        n = evpl_iovec_ring_iov_limit(&total, iov, dom->iov_limit,
+                                      &bind->iovec_send, max);
+
+        cur = evpl_iovec_ring_tail(&bind->iovec_send);
+
+        for (i = 0; i < n; ++i) {
+            desc[i] = evpl_libfabric_desc(dom, cur);
+            cur     = evpl_iovec_ring_next(&bind->iovec_send, cur);
+        }
+
+        sr = evpl_libfabric_sr_alloc(ep->lf, ep);
+
+        rc = fi_sendv(ep->ep, iov, desc, n, FI_ADDR_UNSPEC, &sr->context);
+
+        if (unlikely(rc == -FI_EAGAIN)) {
+            evpl_libfabric_sr_free(ep->lf, sr);
+            evpl_libfabric_send_blocked(evpl, bind, ep);
+            break;
+        }
+
+        evpl_libfabric_abort_if(rc, "fi_sendv error %s", fi_strerror(-rc));
+
+        /* Hold our own references on what was sent, then retire it */
+        cur = evpl_iovec_ring_tail(&bind->iovec_send);
+
+        for (i = 0; i < n; ++i) {
+            sr->iovec[i]        = *cur;
+            sr->iovec[i].length = iov[i].iov_len;
+            evpl_iovec_incref(&sr->iovec[i]);
+
+            cur = evpl_iovec_ring_next(&bind->iovec_send, cur);
+        }
+
+        sr->niov   = n;
+        sr->length = total;
+
+        evpl_iovec_ring_consume(evpl, &bind->iovec_send, total);
+
+        sr->nmsg = evpl_dgram_ring_consume(&bind->dgram_send, total);
+
+        DL_APPEND(ep->sends, sr);
+        ++ep->active_sends;
+    }
+
+    if (!ep->active_sends && evpl_iovec_ring_is_empty(&bind->iovec_send) &&
+        (bind->flags & EVPL_BIND_FINISH)) {
+        evpl_close(evpl, bind);
+    }
+} /* evpl_libfabric_flush_stream */
+
+void
+evpl_libfabric_pending_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_libfabric_ep *ep = evpl_bind_private(bind);
+
+    if (ep->pep) {
+        fi_close(&ep->pep->fid);
+        ep->pep = NULL;
+    }
+
+    if (ep->ep) {
+
+        if (ep->connected && !ep->rdm) {
+            fi_shutdown(ep->ep, 0);
+        }
+
+        fi_close(&ep->ep->fid);
+        ep->ep = NULL;
+
+        /* Reap anything the endpoint left in our completion queue */
+        evpl_libfabric_poll_cq(evpl, ep->dev);
+
+        --ep->dev->num_ep;
+
+        if (ep->rdm) {
+            evpl_libfabric_device_free(evpl, ep->lf, ep->dev);
+            ep->dev = NULL;
+        }
+    }
+} /* evpl_libfabric_pending_close */
+
+void
+evpl_libfabric_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_libfabric_ep *ep = evpl_bind_private(bind);
+    struct evpl_libfabric_sr *sr;
+    int                       i;
+
+    if (ep->rx) {
+
+        for (i = 0; i < ep->num_rx; ++i) {
+            if (ep->rx[i].posted) {
+                evpl_iovec_release(&ep->rx[i].iovec);
+            }
+        }
+
+        evpl_free(ep->rx);
+        ep->rx = NULL;
+    }
+
+    while (ep->sends) {
+        sr = ep->sends;
+
+        for (i = 0; i < sr->niov; ++i) {
+            evpl_iovec_release(&sr->iovec[i]);
+        }
+
+        DL_DELETE(ep->sends, sr);
+        evpl_libfabric_sr_free(ep->lf, sr);
+    }
+
+    if (ep->hdr.private) {
+        evpl_iovec_release(&ep->hdr);
+        ep->hdr.private = NULL;
+    }
+} /* evpl_libfabric_close */
+
+struct evpl_framework evpl_framework_libfabric = {
+    .id                = EVPL_FRAMEWORK_LIBFABRIC,
+    .name              = "LIBFABRIC",
+    .init              = evpl_libfabric_init,
+    .cleanup           = evpl_libfabric_cleanup,
+    .create            = evpl_libfabric_create,
+    .destroy           = evpl_libfabric_destroy,
+    .register_memory   = evpl_libfabric_register,
+    .unregister_memory = evpl_libfabric_unregister,
+    .release_address   = evpl_libfabric_release_address,
+};
+
+struct evpl_protocol  evpl_libfabric_rdm_datagram = {
+    .id                = EVPL_DATAGRAM_LIBFABRIC_RDM,
+    .connected         = 0,
+    .stream            = 0,
+    .name              = "DATAGRAM_LIBFABRIC_RDM",
+    .framework         = &evpl_framework_libfabric,
+    .bind_private_size = sizeof(struct evpl_libfabric_ep),
+    .bind              = evpl_libfabric_bind,
+    .pending_close     = evpl_libfabric_pending_close,
+    .close             = evpl_libfabric_close,
+    .flush             = evpl_libfabric_flush_datagram,
+};
+
+struct evpl_protocol  evpl_libfabric_msg_datagram = {
+    .id                = EVPL_DATAGRAM_LIBFABRIC_MSG,
+    .connected         = 1,
+    .stream            = 0,
+    .name              = "DATAGRAM_LIBFABRIC_MSG",
+    .framework         = &evpl_framework_libfabric,
+    .bind_private_size = sizeof(struct evpl_libfabric_ep),
+    .listen            = evpl_libfabric_listen,
+    .attach            = evpl_libfabric_attach,
+    .connect           = evpl_libfabric_connect,
+    .pending_close     = evpl_libfabric_pending_close,
+    .close             = evpl_libfabric_close,
+    .flush             = evpl_libfabric_flush_datagram,
+};
+
+struct evpl_protocol  evpl_libfabric_msg_stream = {
+    .id                = EVPL_STREAM_LIBFABRIC_MSG,
+    .connected         = 1,
+    .stream            = 1,
+    .name              = "STREAM_LIBFABRIC_MSG",
+    .framework         = &evpl_framework_libfabric,
+    .bind_private_size = sizeof(struct evpl_libfabric_ep),
+    .listen            = evpl_libfabric_listen,
+    .attach            = evpl_libfabric_attach,
+    .connect           = evpl_libfabric_connect,
+    .pending_close     = evpl_libfabric_pending_close,
+    .close             = evpl_libfabric_close,
+    .flush             = evpl_libfabric_flush_stream,
+};
@@ -0,0 +1,10 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#pragma once
+
+extern struct evpl_framework evpl_framework_libfabric;
+extern struct evpl_protocol  evpl_libfabric_rdm_datagram;
+extern struct evpl_protocol  evpl_libfabric_msg_datagram;
+extern struct evpl_protocol  evpl_libfabric_msg_stream;
@@ -0,0 +1,1100 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+
+#include "uthash/utlist.h"
+
+#include "core/loopback/loopback.h"
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/buffer.h"
+#include "core/protocol.h"
+#include "core/bind.h"
+#include "core/endpoint.h"
+#include "core/evpl_shared.h"
+
+extern struct evpl_shared *evpl_shared;
+
+#define evpl_loopback_debug(...) evpl_debug("loopback", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_loopback_info(...)  evpl_info("loopback", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_loopback_error(...) evpl_error("loopback", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_loopback_fatal(...) evpl_fatal("loopback", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_loopback_abort(...) evpl_abort("loopback", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_loopback_fatal_if(cond, ...) \
+        evpl_fatal_if(cond, "loopback", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_loopback_abort_if(cond, ...) \
+        evpl_abort_if(cond, "loopback", __FILE__, __LINE__, __VA_ARGS__)
+
+#define EVPL_LOOPBACK_RING_SIZE 4096
+
+#define EVPL_LOOPBACK_ALIGN     64
+
+/* The datagram continues in the next entry */
+#define EVPL_LOOPBACK_MORE      0x1
+
+struct evpl_loopback_entry {
+    struct evpl_iovec iovec;
+    unsigned int      flags;
+};
+
+struct evpl_loopback_index {
+    _Alignas(EVPL_LOOPBACK_ALIGN) _Atomic uint32_t value;
+};
+
+/*
+ * One direction of a link.  Only the sending thread advances the head
+ * and only the receiving thread the tail.  Each entry carries a
+ * reference the sender took from its send ring, which the receiver
+ * takes over without touching the data.
+ */
+struct evpl_loopback_ring {
+    struct evpl_loopback_index head;
+    struct evpl_loopback_index tail;
+    struct evpl_loopback_entry entry[EVPL_LOOPBACK_RING_SIZE];
+};
+
+/* What each side of a link tells the other */
+struct evpl_loopback_side {
+    struct evpl_loopback_index sleeping; /* its thread may block */
+    struct evpl_loopback_index blocked;  /* its ring is full */
+    struct evpl_loopback_index closed;
+    int                        wake_fd;
+};
+
+/*
+ * The connecting side is side 0 and the accepting side 1, ring[i]
+ * carries what side i sends.  Each side holds a reference, and the
+ * link is freed once both have closed.
+ */
+struct evpl_loopback_link {
+    struct evpl_loopback_ring  ring[2];
+    struct evpl_loopback_side  side[2];
+    struct evpl_loopback_index accepted;
+    atomic_int                 refcnt;
+    struct evpl_address       *remote; /* handed to the accepting side */
+    struct evpl_loopback_link *prev;
+    struct evpl_loopback_link *next;
+};
+
+struct evpl_loopback_conn;
+
+/* Per thread state */
+struct evpl_loopback {
+    struct evpl_event          event; /* eventfd our peers wake us with */
+    struct evpl_poll          *poll;
+    struct evpl_loopback_conn *conns;
+    int                        polling;
+};
+
+/* Listeners by address, which connecting threads look through */
+struct evpl_loopback_shared {
+    pthread_mutex_t            lock;
+    struct evpl_loopback_conn *listeners;
+};
+
+struct evpl_loopback_conn {
+    struct evpl_loopback      *lb;
+    struct evpl_loopback_link *link;
+    int                        side;
+    int                        connected;
+    int                        listening;
+    int                        linked;
+    int                        blocked;
+    uint32_t                   tx_head;
+    uint32_t                   rx_tail;
+    struct evpl_iovec         *rx_msg;
+    int                        rx_msg_niov;
+    int                        rx_msg_max;
+    int                        rx_msg_length;
+
+    /* Connects waiting to be accepted, under the shared lock */
+    struct evpl_loopback_link *pending;
+
+    struct evpl_loopback_conn *prev;
+    struct evpl_loopback_conn *next;
+    struct evpl_loopback_conn *lprev;
+    struct evpl_loopback_conn *lnext;
+};
+
+#define evpl_event_loopback(eventp) container_of((eventp), struct evpl_loopback, event)
+
+static inline uint32_t
+evpl_loopback_load(struct evpl_loopback_index *index)
+{
+    return atomic_load_explicit(&index->value, memory_order_acquire);
+} // evpl_loopback_load
+
+static inline void
+evpl_loopback_store(
+    struct evpl_loopback_index *index,
+    uint32_t                    value)
+{
+    atomic_store_explicit(&index->value, value, memory_order_release);
+} // evpl_loopback_store
+
+static inline void
+evpl_loopback_kick(int fd)
+{
+    if (fd >= 0) {
+        eventfd_write(fd, 1);
+    }
+} // evpl_loopback_kick
+
+static inline struct evpl_loopback_side *
+evpl_loopback_peer(struct evpl_loopback_conn *conn)
+{
+    return &conn->link->side[!conn->side];
+} // evpl_loopback_peer
+
+static inline struct evpl_loopback_ring *
+evpl_loopback_tx(struct evpl_loopback_conn *conn)
+{
+    return &conn->link->ring[conn->side];
+} // evpl_loopback_tx
+
+static inline struct evpl_loopback_ring *
+evpl_loopback_rx(struct evpl_loopback_conn *conn)
+{
+    return &conn->link->ring[!conn->side];
+} // evpl_loopback_rx
+
+static inline uint32_t
+evpl_loopback_room(struct evpl_loopback_conn *conn)
+{
+    struct evpl_loopback_ring *ring = evpl_loopback_tx(conn);
+
+    return EVPL_LOOPBACK_RING_SIZE -
+           (conn->tx_head - evpl_loopback_load(&ring->tail));
+} // evpl_loopback_room
+
+/*
+ * Whether a listener on 'local' takes connects to 'remote', either by
+ * exact address or by port on a wildcard address.
+ */
+static int
+evpl_loopback_match(
+    const struct evpl_address *local,
+    const struct evpl_address *remote)
+{
+    const struct sockaddr_in  *l4, *r4;
+    const struct sockaddr_in6 *l6, *r6;
+
+    if (local->addrlen == remote->addrlen &&
+        memcmp(local->addr, remote->addr, local->addrlen) == 0) {
+        return 1;
+    }
+
+    if (local->addr->sa_family != remote->addr->sa_family) {
+        return 0;
+    }
+
+    switch (local->addr->sa_family) {
+        case AF_INET:
+            l4 = (const struct sockaddr_in *) local->addr;
+            r4 = (const struct sockaddr_in *) remote->addr;
+            return l4->sin_addr.s_addr == htonl(INADDR_ANY) &&
+                   l4->sin_port == r4->sin_port;
+        case AF_INET6:
+            l6 = (const struct sockaddr_in6 *) local->addr;
+            r6 = (const struct sockaddr_in6 *) remote->addr;
+            return IN6_IS_ADDR_UNSPECIFIED(&l6->sin6_addr) &&
+                   l6->sin6_port == r6->sin6_port;
+        default:
+            return 0;
+    } /* switch */
+} /* evpl_loopback_match */
+
+static struct evpl_loopback_link *
+evpl_loopback_link_create(void)
+{
+    struct evpl_loopback_link *link;
+
+    link = evpl_valloc(sizeof(*link), EVPL_LOOPBACK_ALIGN);
+
+    memset(link, 0, sizeof(*link));
+
+    link->side[0].wake_fd = -1;
+    link->side[1].wake_fd = -1;
+
+    atomic_init(&link->refcnt, 2);
+
+    return link;
+} /* evpl_loopback_link_create */
+
+/* Drop a side's reference, releasing whatever was never received */
+static void
+evpl_loopback_link_release(struct evpl_loopback_link *link)
+{
+    struct evpl_loopback_ring *ring;
+    uint32_t                   tail, head;
+    int                        i;
+
+    if (atomic_fetch_sub(&link->refcnt, 1) > 1) {
+        return;
+    }
+
+    for (i = 0; i < 2; ++i) {
+        ring = &link->ring[i];
+        head = evpl_loopback_load(&ring->head);
+
+        for (tail = evpl_loopback_load(&ring->tail); tail != head; tail++) {
+            evpl_iovec_release(
+                &ring->entry[tail & (EVPL_LOOPBACK_RING_SIZE - 1)].iovec);
+        }
+
+        if (link->side[i].wake_fd >= 0) {
+            close(link->side[i].wake_fd);
+        }
+    }
+
+    if (link->remote) {
+        evpl_address_release(link->remote);
+    }
+
+    evpl_free(link);
+} /* evpl_loopback_link_release */
+
+/* Tell a side of the link how to wake our thread, before we may block */
+static void
+evpl_loopback_link_join(
+    struct evpl_loopback_conn *conn,
+    struct evpl_loopback_link *link,
+    int                        side)
+{
+    struct evpl_loopback *lb = conn->lb;
+
+    conn->link = link;
+    conn->side = side;
+
+    link->side[side].wake_fd = fcntl(lb->event.fd, F_DUPFD_CLOEXEC, 0);
+
+    evpl_loopback_abort_if(link->side[side].wake_fd < 0,
+                           "Failed to dup eventfd: %s", strerror(errno));
+
+    evpl_loopback_store(&link->side[side].sleeping, !lb->polling);
+
+    DL_APPEND(lb->conns, conn);
+    conn->linked = 1;
+} /* evpl_loopback_link_join */
+
+static void
+evpl_loopback_conn_init(
+    struct evpl               *evpl,
+    struct evpl_loopback_conn *conn)
+{
+    memset(conn, 0, sizeof(*conn));
+
+    conn->lb = evpl_framework_private(evpl, EVPL_FRAMEWORK_LOOPBACK);
+} /* evpl_loopback_conn_init */
+
+/* Wake our peer if it may be blocked, once we have published something */
+static inline void
+evpl_loopback_notify_peer(
+    struct evpl_loopback_conn *conn,
+    int                        blocked_only)
+{
+    struct evpl_loopback_side *peer = evpl_loopback_peer(conn);
+
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (evpl_loopback_load(&peer->sleeping) &&
+        (!blocked_only || evpl_loopback_load(&peer->blocked))) {
+        evpl_loopback_kick(peer->wake_fd);
+    }
+} // evpl_loopback_notify_peer
+
+static void
+evpl_loopback_deliver_stream(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_notify notify;
+    struct evpl_iovec *iovec;
+    int                i, length, niov;
+
+    if (bind->segment_callback) {
+
+        iovec = alloca(sizeof(struct evpl_iovec) * evpl_shared->config->max_num_iovec);
+
+        while (1) {
+
+            length = bind->segment_callback(evpl, bind, bind->private_data);
+
+            if (length == 0 ||
+                evpl_iovec_ring_bytes(&bind->iovec_recv) < length) {
+                break;
+            }
+
+            if (unlikely(length < 0)) {
+                evpl_close(evpl, bind);
+                return;
+            }
+
+            niov = evpl_iovec_ring_copyv(evpl, iovec, &bind->iovec_recv,
+                                         length);
+
+            notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+            notify.notify_status      = 0;
+            notify.recv_msg.iovec     = iovec;
+            notify.recv_msg.niov      = niov;
+            notify.recv_msg.length    = length;
+            notify.recv_msg.addr      = bind->remote;
+            notify.recv_msg.timestamp = 0;
+
+            bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+            for (i = 0; i < niov; ++i) {
+                evpl_iovec_release(&iovec[i]);
+            }
+        }
+
+    } else {
+        notify.notify_type         = EVPL_NOTIFY_RECV_DATA;
+        notify.notify_status       = 0;
+        notify.recv_data.timestamp = 0;
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+} /* evpl_loopback_deliver_stream */
+
+static void
+evpl_loopback_deliver_msg(
+    struct evpl               *evpl,
+    struct evpl_bind          *bind,
+    struct evpl_loopback_conn *conn)
+{
+    struct evpl_notify notify;
+    int                i;
+
+    notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+    notify.notify_status      = 0;
+    notify.recv_msg.iovec     = conn->rx_msg;
+    notify.recv_msg.niov      = conn->rx_msg_niov;
+    notify.recv_msg.length    = conn->rx_msg_length;
+    notify.recv_msg.addr      = bind->remote;
+    notify.recv_msg.timestamp = 0;
+
+    bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+    for (i = 0; i < conn->rx_msg_niov; ++i) {
+        evpl_iovec_release(&conn->rx_msg[i]);
+    }
+
+    conn->rx_msg_niov   = 0;
+    conn->rx_msg_length = 0;
+} /* evpl_loopback_deliver_msg */
+
+/* Take over what our peer has sent, returns the number of entries taken */
+static int
+evpl_loopback_recv(
+    struct evpl               *evpl,
+    struct evpl_bind          *bind,
+    struct evpl_loopback_conn *conn)
+{
+    struct evpl_loopback_ring  *ring = evpl_loopback_rx(conn);
+    struct evpl_loopback_entry *entry;
+    uint32_t                    head, tail = conn->rx_tail;
+    int                         stream = bind->protocol->stream;
+    int                         n      = 0, data = 0;
+
+    head = evpl_loopback_load(&ring->head);
+
+    while (tail != head) {
+
+        if (stream && evpl_bind_recv_full(bind)) {
+            bind->flags |= EVPL_BIND_RECV_PAUSED;
+            break;
+        }
+
+        entry = &ring->entry[tail & (EVPL_LOOPBACK_RING_SIZE - 1)];
+
+        tail++;
+        n++;
+
+        if (stream) {
+            evpl_iovec_ring_add(&bind->iovec_recv, &entry->iovec);
+            data = 1;
+            continue;
+        }
+
+        if (entry->iovec.length) {
+
+            if (unlikely(conn->rx_msg_niov == conn->rx_msg_max)) {
+                conn->rx_msg_max *= 2;
+                conn->rx_msg      = evpl_realloc(conn->rx_msg,
+                                                 conn->rx_msg_max *
+                                                 sizeof(struct evpl_iovec));
+            }
+
+            conn->rx_msg[conn->rx_msg_niov++] = entry->iovec;
+            conn->rx_msg_length              += entry->iovec.length;
+        } else {
+            evpl_iovec_release(&entry->iovec);
+        }
+
+        if (!(entry->flags & EVPL_LOOPBACK_MORE)) {
+            evpl_loopback_deliver_msg(evpl, bind, conn);
+        }
+    }
+
+    if (n) {
+        conn->rx_tail = tail;
+        evpl_loopback_store(&ring->tail, tail);
+    }
+
+    if (data) {
+        evpl_loopback_deliver_stream(evpl, bind);
+    }
+
+    return n;
+} /* evpl_loopback_recv */
+
+/* Make what we have produced visible and wake our peer if it sleeps */
+static void
+evpl_loopback_publish(
+    struct evpl_loopback_conn *conn,
+    int                        blocked)
+{
+    if (blocked != conn->blocked) {
+        conn->blocked = blocked;
+        evpl_loopback_store(&conn->link->side[conn->side].blocked, blocked);
+    }
+
+    evpl_loopback_store(&evpl_loopback_tx(conn)->head, conn->tx_head);
+
+    evpl_loopback_notify_peer(conn, 0);
+} /* evpl_loopback_publish */
+
+static inline void
+evpl_loopback_put(
+    struct evpl_loopback_conn *conn,
+    const struct evpl_iovec   *iovec,
+    unsigned int               flags)
+{
+    struct evpl_loopback_entry *entry;
+
+    entry = &evpl_loopback_tx(conn)->entry[conn->tx_head++ &
+                                           (EVPL_LOOPBACK_RING_SIZE - 1)];
+
+    entry->iovec = *iovec;
+    entry->flags = flags;
+} // evpl_loopback_put
+
+static void
+evpl_loopback_flush_stream(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_loopback_conn *conn = evpl_bind_private(bind);
+    struct evpl_iovec         *cur;
+    uint64_t                   bytes = 0;
+    uint32_t                   room;
+    int                        msgs = 0, blocked = 0;
+
+    if (unlikely(!conn->connected)) {
+        return;
+    }
+
+    room = evpl_loopback_room(conn);
+
+    while ((cur = evpl_iovec_ring_tail(&bind->iovec_send)) != NULL) {
+
+        if (!room) {
+            blocked = 1;
+            break;
+        }
+
+        bytes += cur->length;
+
+        /* Our send ring's reference goes with it */
+        evpl_loopback_put(conn, cur, 0);
+        evpl_iovec_ring_remove(&bind->iovec_send);
+
+        room--;
+    }
+
+    if (bytes) {
+        msgs = evpl_dgram_ring_consume(&bind->dgram_send, bytes);
+    }
+
+    if (bytes || blocked != conn->blocked) {
+        evpl_loopback_publish(conn, blocked);
+    }
+
+    if (bytes) {
+        evpl_bind_sent(evpl, bind, bytes, msgs);
+    }
+
+    if (evpl_iovec_ring_is_empty(&bind->iovec_send) &&
+        (bind->flags & EVPL_BIND_FINISH)) {
+        evpl_close(evpl, bind);
+    }
+} /* evpl_loopback_flush_stream */
+
+static void
+evpl_loopback_flush_datagram(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_loopback_conn *conn = evpl_bind_private(bind);
+    struct evpl_dgram         *dgram;
+    struct evpl_iovec          empty = { 0 };
+    uint64_t                   bytes = 0;
+    uint32_t                   room;
+    int                        i, need, msgs = 0, blocked = 0;
+
+    if (unlikely(!conn->connected)) {
+        return;
+    }
+
+    room = evpl_loopback_room(conn);
+
+    while ((dgram = evpl_dgram_ring_tail(&bind->dgram_send)) != NULL) {
+
+        /* An empty datagram still takes an entry to mark its end */
+        need = dgram->niov ? dgram->niov : 1;
+
+        evpl_loopback_abort_if(need > EVPL_LOOPBACK_RING_SIZE,
+                               "Datagram of %d iovecs can never fit", need);
+
+        if (need > room) {
+            blocked = 1;
+            break;
+        }
+
+        if (!dgram->niov) {
+            evpl_loopback_put(conn, &empty, 0);
+        }
+
+        for (i = 0; i < dgram->niov; ++i) {
+            evpl_loopback_put(conn, evpl_iovec_ring_tail(&bind->iovec_send),
+                              i + 1 < dgram->niov ? EVPL_LOOPBACK_MORE : 0);
+            evpl_iovec_ring_remove(&bind->iovec_send);
+        }
+
+        room  -= need;
+        bytes += dgram->length;
+        msgs++;
+
+        evpl_dgram_ring_remove(&bind->dgram_send);
+    }
+
+    if (msgs || blocked != conn->blocked) {
+        evpl_loopback_publish(conn, blocked);
+    }
+
+    if (msgs) {
+        evpl_bind_sent(evpl, bind, bytes, msgs);
+    }
+
+    if (evpl_iovec_ring_is_empty(&bind->iovec_send) &&
+        (bind->flags & EVPL_BIND_FINISH)) {
+        evpl_close(evpl, bind);
+    }
+} /* evpl_loopback_flush_datagram */
+
+static void
+evpl_loopback_connected(
+    struct evpl               *evpl,
+    struct evpl_bind          *bind,
+    struct evpl_loopback_conn *conn)
+{
+    struct evpl_notify notify;
+
+    conn->connected = 1;
+
+    if (!bind->protocol->stream) {
+        conn->rx_msg_max = evpl_shared->config->max_num_iovec;
+        conn->rx_msg     = evpl_calloc(conn->rx_msg_max,
+                                       sizeof(struct evpl_iovec));
+    }
+
+    if (conn->side == 0) {
+        notify.notify_type   = EVPL_NOTIFY_CONNECTED;
+        notify.notify_status = 0;
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+
+    evpl_defer(evpl, &bind->flush_deferral);
+} /* evpl_loopback_connected */
+
+/* Everything a connection has to do on a pass, returns nonzero if it did anything */
+static int
+evpl_loopback_conn_poll(
+    struct evpl               *evpl,
+    struct evpl_loopback_conn *conn)
+{
+    struct evpl_bind          *bind = evpl_private2bind(conn);
+    struct evpl_loopback_side *peer;
+    int                        consumed = 0;
+
+    if (unlikely(bind->flags & EVPL_BIND_PENDING_CLOSED) || conn->listening) {
+        return 0;
+    }
+
+    peer = evpl_loopback_peer(conn);
+
+    if (unlikely(!conn->connected)) {
+
+        if (evpl_loopback_load(&conn->link->accepted)) {
+            evpl_loopback_connected(evpl, bind, conn);
+            return 1;
+        }
+
+        if (evpl_loopback_load(&peer->closed)) {
+            evpl_close(evpl, bind);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (!(bind->flags & EVPL_BIND_RECV_PAUSED)) {
+        consumed = evpl_loopback_recv(evpl, bind, conn);
+    }
+
+    if (consumed) {
+        evpl_loopback_notify_peer(conn, 1);
+    }
+
+    if (conn->blocked && evpl_loopback_room(conn)) {
+        bind->protocol->flush(evpl, bind);
+        consumed = 1;
+    }
+
+    /* Our peer published everything before it closed */
+    if (unlikely(evpl_loopback_load(&peer->closed)) &&
+        conn->rx_tail == evpl_loopback_load(&evpl_loopback_rx(conn)->head)) {
+        evpl_close(evpl, bind);
+        return 1;
+    }
+
+    return consumed;
+} /* evpl_loopback_conn_poll */
+
+/* Hand connects made to our listeners to the listener machinery */
+static void
+evpl_loopback_accept(
+    struct evpl               *evpl,
+    struct evpl_loopback_conn *ls)
+{
+    struct evpl_loopback_shared *shared      = evpl_shared->framework_private[EVPL_FRAMEWORK_LOOPBACK];
+    struct evpl_bind            *listen_bind = evpl_private2bind(ls);
+    struct evpl_loopback_link   *pending, *link;
+    struct evpl_address         *remote;
+
+    pthread_mutex_lock(&shared->lock);
+    pending     = ls->pending;
+    ls->pending = NULL;
+    pthread_mutex_unlock(&shared->lock);
+
+    while (pending) {
+        link = pending;
+        DL_DELETE(pending, link);
+
+        remote       = link->remote;
+        link->remote = NULL;
+
+        listen_bind->accept_callback(evpl, listen_bind, remote, link,
+                                     listen_bind->private_data);
+    }
+} /* evpl_loopback_accept */
+
+static void
+evpl_loopback_poll(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_loopback      *lb = private_data;
+    struct evpl_loopback_conn *conn, *tmp;
+
+    DL_FOREACH_SAFE(lb->conns, conn, tmp)
+    {
+        if (evpl_loopback_conn_poll(evpl, conn)) {
+            evpl_activity(evpl);
+        }
+    }
+} /* evpl_loopback_poll */
+
+static void
+evpl_loopback_set_sleeping(
+    struct evpl_loopback *lb,
+    int                   sleeping)
+{
+    struct evpl_loopback_conn *conn;
+
+    DL_FOREACH(lb->conns, conn)
+    {
+        if (!conn->listening) {
+            evpl_loopback_store(&conn->link->side[conn->side].sleeping,
+                                sleeping);
+        }
+    }
+} /* evpl_loopback_set_sleeping */
+
+static void
+evpl_loopback_poll_enter(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_loopback *lb = private_data;
+
+    lb->polling = 1;
+
+    evpl_loopback_set_sleeping(lb, 0);
+} /* evpl_loopback_poll_enter */
+
+/*
+ * We may block from here on, so peers must wake us.  Anything they
+ * published before they could see that needs us to wake ourselves.
+ */
+static void
+evpl_loopback_poll_exit(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_loopback      *lb = private_data;
+    struct evpl_loopback_conn *conn;
+
+    lb->polling = 0;
+
+    evpl_loopback_set_sleeping(lb, 1);
+
+    atomic_thread_fence(memory_order_seq_cst);
+
+    DL_FOREACH(lb->conns, conn)
+    {
+        if (conn->listening) {
+            continue;
+        }
+
+        if (evpl_loopback_load(&evpl_loopback_rx(conn)->head) != conn->rx_tail ||
+            evpl_loopback_load(&evpl_loopback_peer(conn)->closed) ||
+            (!conn->connected && evpl_loopback_load(&conn->link->accepted)) ||
+            (conn->blocked && evpl_loopback_room(conn))) {
+            evpl_loopback_kick(lb->event.fd);
+            break;
+        }
+    }
+} /* evpl_loopback_poll_exit */
+
+static void
+evpl_loopback_wake(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct evpl_loopback      *lb = evpl_event_loopback(event);
+    struct evpl_loopback_conn *conn, *tmp;
+    eventfd_t                  value;
+
+    eventfd_read(event->fd, &value);
+
+    evpl_event_mark_unreadable(event);
+
+    evpl_activity(evpl);
+
+    DL_FOREACH_SAFE(lb->conns, conn, tmp)
+    {
+        if (conn->listening) {
+            evpl_loopback_accept(evpl, conn);
+        }
+    }
+
+    evpl_loopback_poll(evpl, lb);
+} /* evpl_loopback_wake */
+
+static void
+evpl_loopback_connect(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_loopback_shared *shared = evpl_shared->framework_private[EVPL_FRAMEWORK_LOOPBACK];
+    struct evpl_loopback_conn   *conn   = evpl_bind_private(bind);
+    struct evpl_loopback_conn   *ls;
+    struct evpl_loopback_link   *link;
+    struct evpl_bind            *listen_bind;
+
+    evpl_loopback_conn_init(evpl, conn);
+
+    link = evpl_loopback_link_create();
+
+    evpl_loopback_link_join(conn, link, 0);
+
+    pthread_mutex_lock(&shared->lock);
+
+    DL_FOREACH2(shared->listeners, ls, lnext)
+    {
+        listen_bind = evpl_private2bind(ls);
+
+        if (evpl_loopback_match(listen_bind->local, bind->remote)) {
+            break;
+        }
+    }
+
+    if (ls) {
+        /* The accepting side sees us at our own address if we have one */
+        link->remote = bind->local ? bind->local : listen_bind->local;
+        evpl_address_incref(link->remote);
+
+        DL_APPEND(ls->pending, link);
+
+        evpl_loopback_kick(ls->lb->event.fd);
+    }
+
+    pthread_mutex_unlock(&shared->lock);
+
+    if (!ls) {
+        /* Nobody will ever take the other side */
+        evpl_loopback_debug("No loopback listener for connect");
+        atomic_fetch_sub(&link->refcnt, 1);
+        evpl_close(evpl, bind);
+    }
+} /* evpl_loopback_connect */
+
+static void
+evpl_loopback_attach(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    void             *accepted)
+{
+    struct evpl_loopback_conn *conn = evpl_bind_private(bind);
+    struct evpl_loopback_link *link = accepted;
+
+    evpl_loopback_conn_init(evpl, conn);
+
+    evpl_loopback_link_join(conn, link, 1);
+
+    evpl_loopback_connected(evpl, bind, conn);
+
+    evpl_loopback_store(&link->accepted, 1);
+
+    evpl_loopback_kick(link->side[0].wake_fd);
+} /* evpl_loopback_attach */
+
+static void
+evpl_loopback_listen(
+    struct evpl      *evpl,
+    struct evpl_bind *listen_bind)
+{
+    struct evpl_loopback_shared *shared = evpl_shared->framework_private[EVPL_FRAMEWORK_LOOPBACK];
+    struct evpl_loopback_conn   *ls     = evpl_bind_private(listen_bind);
+    struct evpl_loopback_conn   *cur;
+
+    evpl_loopback_conn_init(evpl, ls);
+
+    ls->listening = 1;
+
+    pthread_mutex_lock(&shared->lock);
+
+    DL_FOREACH2(shared->listeners, cur, lnext)
+    {
+        evpl_loopback_abort_if(
+            evpl_loopback_match(evpl_private2bind(cur)->local,
+                                listen_bind->local),
+            "Address already has a loopback listener");
+    }
+
+    DL_APPEND2(shared->listeners, ls, lprev, lnext);
+
+    pthread_mutex_unlock(&shared->lock);
+
+    DL_APPEND(ls->lb->conns, ls);
+    ls->linked = 1;
+} /* evpl_loopback_listen */
+
+static void
+evpl_loopback_resume_recv(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    /* Our next poll picks up where we left off */
+    evpl_activity(evpl);
+} /* evpl_loopback_resume_recv */
+
+static void
+evpl_loopback_pending_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_loopback_shared *shared = evpl_shared->framework_private[EVPL_FRAMEWORK_LOOPBACK];
+    struct evpl_loopback_conn   *conn   = evpl_bind_private(bind);
+    struct evpl_loopback_link   *pending, *link;
+
+    if (conn->linked) {
+        DL_DELETE(conn->lb->conns, conn);
+        conn->linked = 0;
+    }
+
+    if (conn->listening) {
+
+        pthread_mutex_lock(&shared->lock);
+        DL_DELETE2(shared->listeners, conn, lprev, lnext);
+        pending       = conn->pending;
+        conn->pending = NULL;
+        pthread_mutex_unlock(&shared->lock);
+
+        /* Refuse connects we never got to */
+        while (pending) {
+            link = pending;
+            DL_DELETE(pending, link);
+
+            evpl_loopback_store(&link->side[1].closed, 1);
+            evpl_loopback_kick(link->side[0].wake_fd);
+            evpl_loopback_link_release(link);
+        }
+
+        conn->listening = 0;
+        return;
+    }
+
+    if (conn->link) {
+        evpl_loopback_store(&conn->link->side[conn->side].closed, 1);
+
+        atomic_thread_fence(memory_order_seq_cst);
+
+        evpl_loopback_kick(evpl_loopback_peer(conn)->wake_fd);
+    }
+
+    conn->connected = 0;
+} /* evpl_loopback_pending_close */
+
+static void
+evpl_loopback_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_loopback_conn *conn = evpl_bind_private(bind);
+    int                        i;
+
+    for (i = 0; i < conn->rx_msg_niov; ++i) {
+        evpl_iovec_release(&conn->rx_msg[i]);
+    }
+
+    conn->rx_msg_niov = 0;
+
+    if (conn->rx_msg) {
+        evpl_free(conn->rx_msg);
+        conn->rx_msg = NULL;
+    }
+
+    if (conn->link) {
+        evpl_loopback_link_release(conn->link);
+        conn->link = NULL;
+    }
+} /* evpl_loopback_close */
+
+static void *
+evpl_loopback_init(void)
+{
+    struct evpl_loopback_shared *shared;
+
+    shared = evpl_zalloc(sizeof(*shared));
+
+    pthread_mutex_init(&shared->lock, NULL);
+
+    return shared;
+} /* evpl_loopback_init */
+
+static void
+evpl_loopback_cleanup(void *private_data)
+{
+    struct evpl_loopback_shared *shared = private_data;
+
+    pthread_mutex_destroy(&shared->lock);
+
+    evpl_free(shared);
+} /* evpl_loopback_cleanup */
+
+static void *
+evpl_loopback_create(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_loopback *lb;
+
+    lb = evpl_zalloc(sizeof(*lb));
+
+    lb->event.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    evpl_loopback_abort_if(lb->event.fd < 0, "Failed to create eventfd: %s",
+                           strerror(errno));
+
+    lb->event.read_callback = evpl_loopback_wake;
+
+    evpl_add_event(evpl, &lb->event);
+    evpl_event_read_interest(evpl, &lb->event);
+
+    lb->poll = evpl_add_poll(evpl, evpl_loopback_poll_enter,
+                             evpl_loopback_poll_exit, evpl_loopback_poll, lb);
+
+    return lb;
+} /* evpl_loopback_create */
+
+static void
+evpl_loopback_destroy(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_loopback *lb = private_data;
+
+    evpl_remove_poll(evpl, lb->poll);
+
+    evpl_remove_event(evpl, &lb->event);
+
+    close(lb->event.fd);
+
+    evpl_free(lb);
+} /* evpl_loopback_destroy */
+
+struct evpl_framework evpl_framework_loopback = {
+    .id      = EVPL_FRAMEWORK_LOOPBACK,
+    .name    = "LOOPBACK",
+    .init    = evpl_loopback_init,
+    .cleanup = evpl_loopback_cleanup,
+    .create  = evpl_loopback_create,
+    .destroy = evpl_loopback_destroy,
+};
+
+struct evpl_protocol  evpl_loopback_datagram = {
+    .id                = EVPL_DATAGRAM_LOOPBACK,
+    .connected         = 1,
+    .stream            = 0,
+    .name              = "DATAGRAM_LOOPBACK",
+    .framework         = &evpl_framework_loopback,
+    .bind_private_size = sizeof(struct evpl_loopback_conn),
+    .connect           = evpl_loopback_connect,
+    .listen            = evpl_loopback_listen,
+    .attach            = evpl_loopback_attach,
+    .pending_close     = evpl_loopback_pending_close,
+    .close             = evpl_loopback_close,
+    .flush             = evpl_loopback_flush_datagram,
+};
+
+struct evpl_protocol  evpl_loopback_stream = {
+    .id                = EVPL_STREAM_LOOPBACK,
+    .connected         = 1,
+    .stream            = 1,
+    .name              = "STREAM_LOOPBACK",
+    .framework         = &evpl_framework_loopback,
+    .bind_private_size = sizeof(struct evpl_loopback_conn),
+    .connect           = evpl_loopback_connect,
+    .listen            = evpl_loopback_listen,
+    .attach            = evpl_loopback_attach,
+    .pending_close     = evpl_loopback_pending_close,
+    .close             = evpl_loopback_close,
+    .flush             = evpl_loopback_flush_stream,
+    .resume_recv       = evpl_loopback_resume_recv,
+};
@@ -0,0 +1,9 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#pragma once
+
+extern struct evpl_framework evpl_framework_loopback;
+extern struct evpl_protocol  evpl_loopback_datagram;
+extern struct evpl_protocol  evpl_loopback_stream;
@@ -76,6 +76,21 @@ struct evpl_protocol {
     /* pointer to associated framework, or NULL if no framework */
     struct evpl_framework *framework;
 
+    /* bytes of per-bind private state, or 0 for EVPL_MAX_PRIVATE */
+    unsigned int           bind_private_size;
+
+    /*
+     * 1 iff small sends may be merged into shared send iovecs, which
+     * requires the protocol to retire sent messages by byte count
+     */
+    unsigned int           coalesce_sends;
+
+    /*
+     * 1 iff the protocol sends file ranges queued by evpl_sendfile straight
+     * from the file, otherwise they are read into buffers when queued
+     */
+    unsigned int           sendfile;
+
     /*
      * Callbacks needed for all protocols
      */
@@ -93,6 +108,23 @@ struct evpl_protocol {
         struct evpl      *evpl,
         struct evpl_bind *bind);
 
+    /*
+     * Called when a bind the protocol paused with RECV_PAUSED has been
+     * drained below its receive cap and should be read from again
+     */
+    void                   (*resume_recv)(
+        struct evpl      *evpl,
+        struct evpl_bind *bind);
+
+
+    /*
+     * Queue a descriptor to be passed to the peer with the next data sent,
+     * NULL if the protocol cannot pass descriptors
+     */
+    int                    (*send_fd)(
+        struct evpl      *evpl,
+        struct evpl_bind *bind,
+        int               fd);
 
     /*
      * Callbacks for connection-oriented protocols
@@ -234,3 +266,10 @@ void
 evpl_attach_framework(
     struct evpl           *evpl,
     enum evpl_framework_id framework_id);
+
+/*
+ * Offer every slab to the frameworks' register_memory again, for
+ * frameworks that open devices after they have been initialized
+ */
+void
+evpl_framework_reregister(void);
@@ -586,8 +586,9 @@ evpl_rdmacm_poll_cq(
 
                     evpl_iovec_ring_add(&bind->iovec_recv, &req->iovec);
 
-                    notify.notify_type   = EVPL_NOTIFY_RECV_DATA;
-                    notify.notify_status = 0;
+                    notify.notify_type         = EVPL_NOTIFY_RECV_DATA;
+                    notify.notify_status       = 0;
+                    notify.recv_data.timestamp = 0;
 
                     bind->notify_callback(evpl, bind, &notify,
                                           bind->private_data);
@@ -602,12 +603,13 @@ evpl_rdmacm_poll_cq(
                         req->iovec.data   += 40;
                     }
 
-                    notify.notify_type     = EVPL_NOTIFY_RECV_MSG;
-                    notify.notify_status   = 0;
-                    notify.recv_msg.iovec  = &req->iovec;
-                    notify.recv_msg.niov   = 1;
-                    notify.recv_msg.addr   = bind->remote;
-                    notify.recv_msg.length = req->iovec.length;
+                    notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+                    notify.notify_status      = 0;
+                    notify.recv_msg.iovec     = &req->iovec;
+                    notify.recv_msg.niov      = 1;
+                    notify.recv_msg.addr      = bind->remote;
+                    notify.recv_msg.length    = req->iovec.length;
+                    notify.recv_msg.timestamp = 0;
 
                     bind->notify_callback(evpl, bind, &notify,
                                           bind->private_data);
@@ -636,15 +638,7 @@ evpl_rdmacm_poll_cq(
                 if (likely(rdmacm_id->id)) {
                     bind = evpl_private2bind(rdmacm_id);
 
-                    if (bind->flags & EVPL_BIND_SENT_NOTIFY) {
-                        notify.notify_type   = EVPL_NOTIFY_SENT;
-                        notify.notify_status = 0;
-                        notify.sent.bytes    = sr->length;
-                        notify.sent.msgs     = 1;
-
-                        bind->notify_callback(evpl, bind, &notify,
-                                              bind->private_data);
-                    }
+                    evpl_bind_sent(evpl, bind, sr->length, 1);
 
                     if (unlikely(rdmacm_id->active_sends == 0 &&
                                  evpl_iovec_ring_is_empty(&bind->iovec_send))) {
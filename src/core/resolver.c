@@ -0,0 +1,389 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE 1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stddef.h>
+#include <netdb.h>
+
+#include "uthash/utlist.h"
+
+#include "core/internal.h"
+#include "core/endpoint.h"
+#include "core/resolver.h"
+#include "core/evpl_shared.h"
+
+extern struct evpl_shared *evpl_shared;
+
+struct evpl_resolver {
+    pthread_mutex_t       lock;
+    pthread_cond_t        cond;
+    pthread_t             thread;
+    int                   started;
+    int                   shutdown;
+    struct evpl_endpoint *queue;
+    struct evpl_endpoint *current;   /* lookup in progress, if any */
+};
+
+/*
+ * Addresses starting with '/' name a unix socket in the filesystem, and
+ * those starting with '@' one in the abstract namespace.  The port plays
+ * no part in either.
+ */
+static int
+evpl_resolver_lookup_unix(
+    struct evpl_endpoint *endpoint,
+    struct evpl_address **addrp)
+{
+    struct sockaddr_un sun;
+    size_t             len = strlen(endpoint->address);
+
+    if (len >= sizeof(sun.sun_path)) {
+        return EAI_NONAME;
+    }
+
+    memset(&sun, 0, sizeof(sun));
+
+    sun.sun_family = AF_UNIX;
+
+    memcpy(sun.sun_path, endpoint->address, len);
+
+    if (sun.sun_path[0] == '@') {
+        sun.sun_path[0] = '\0';
+    } else {
+        /* Count the terminator, as getsockname() will */
+        len++;
+    }
+
+    *addrp = evpl_address_init((struct sockaddr *) &sun,
+                               offsetof(struct sockaddr_un, sun_path) + len);
+
+    return 0;
+} /* evpl_resolver_lookup_unix */
+
+int
+evpl_resolver_lookup(
+    struct evpl_endpoint *endpoint,
+    int                   flags,
+    struct evpl_address **addrp)
+{
+    char             port_str[8];
+    struct addrinfo  hints, *ai, *p, **pp;
+    int              rc, n;
+
+    if (endpoint->address[0] == '/' || endpoint->address[0] == '@') {
+        return evpl_resolver_lookup_unix(endpoint, addrp);
+    }
+
+    snprintf(port_str, sizeof(port_str), "%d", endpoint->port);
+
+    /*
+     * Ask for any family and take the first answer's, which getaddrinfo
+     * has already ordered by the system's address selection policy.
+     */
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = flags;
+
+    rc = getaddrinfo(endpoint->address, port_str, &hints, &ai);
+
+    if (rc) {
+        return rc;
+    }
+
+    n = 0;
+
+    for (p = ai; p != NULL; p = p->ai_next) {
+        if (p->ai_family == ai->ai_family) {
+            n++;
+        }
+    }
+
+    pp = alloca(n * sizeof(struct addrinfo *));
+
+    n = 0;
+
+    for (p = ai; p != NULL; p = p->ai_next) {
+        if (p->ai_family == ai->ai_family) {
+            pp[n++] = p;
+        }
+    }
+
+    /* Spread load across the addresses of the preferred family */
+    p = pp[rand() % n];
+
+    *addrp = evpl_address_init(p->ai_addr, p->ai_addrlen);
+
+    freeaddrinfo(ai);
+
+    return 0;
+} /* evpl_resolver_lookup */
+
+static void
+evpl_resolver_wake(struct evpl_endpoint *endpoint)
+{
+    struct evpl_resolve_wait *wait;
+    uint64_t                  value = 1;
+    ssize_t                   rc;
+
+    DL_FOREACH(endpoint->waiters, wait)
+    {
+        rc = write(wait->evpl->eventfd, &value, sizeof(value));
+
+        evpl_core_abort_if(rc != sizeof(value),
+                           "evpl_resolver: write to eventfd failed");
+    }
+} /* evpl_resolver_wake */
+
+static void *
+evpl_resolver_thread(void *arg)
+{
+    struct evpl_resolver *resolver = arg;
+    struct evpl_endpoint *endpoint;
+    struct evpl_address  *addr, *old;
+    int                   rc;
+
+    pthread_mutex_lock(&resolver->lock);
+
+    while (!resolver->shutdown) {
+
+        if (!resolver->queue) {
+            pthread_cond_wait(&resolver->cond, &resolver->lock);
+            continue;
+        }
+
+        endpoint = resolver->queue;
+        LL_DELETE2(resolver->queue, endpoint, resolve_next);
+
+        resolver->current = endpoint;
+
+        pthread_mutex_unlock(&resolver->lock);
+
+        /* No locks are held while we wait on the network */
+        rc = evpl_resolver_lookup(endpoint, 0, &addr);
+
+        if (rc) {
+            evpl_core_error("failed to resolve %s: %s",
+                            endpoint->address, gai_strerror(rc));
+        }
+
+        pthread_rwlock_wrlock(&endpoint->lock);
+
+        /* A failed refresh keeps serving the last good address */
+        old = NULL;
+
+        if (rc == 0) {
+            old = endpoint->resolved_addr;
+
+            if (old && old->addrlen == addr->addrlen &&
+                memcmp(old->addr, addr->addr, addr->addrlen) == 0) {
+                /* Unchanged, so threads caching it need not copy it again */
+                old  = addr;
+                addr = endpoint->resolved_addr;
+            } else {
+                endpoint->generation = atomic_fetch_add(
+                    &evpl_shared->generation, 1) + 1;
+            }
+
+            endpoint->resolved_addr = addr;
+        }
+
+        endpoint->resolve_status = rc;
+        clock_gettime(CLOCK_MONOTONIC, &endpoint->last_resolved);
+
+        pthread_rwlock_unlock(&endpoint->lock);
+
+        if (old) {
+            evpl_address_release(old);
+        }
+
+        pthread_mutex_lock(&resolver->lock);
+
+        resolver->current = NULL;
+        atomic_store(&endpoint->resolving, 0);
+
+        evpl_resolver_wake(endpoint);
+
+        pthread_cond_broadcast(&resolver->cond);
+    }
+
+    pthread_mutex_unlock(&resolver->lock);
+
+    return NULL;
+} /* evpl_resolver_thread */
+
+struct evpl_resolver *
+evpl_resolver_create(void)
+{
+    struct evpl_resolver *resolver;
+
+    resolver = evpl_zalloc(sizeof(*resolver));
+
+    pthread_mutex_init(&resolver->lock, NULL);
+    pthread_cond_init(&resolver->cond, NULL);
+
+    return resolver;
+} /* evpl_resolver_create */
+
+void
+evpl_resolver_destroy(struct evpl_resolver *resolver)
+{
+    pthread_mutex_lock(&resolver->lock);
+    resolver->shutdown = 1;
+    pthread_cond_broadcast(&resolver->cond);
+    pthread_mutex_unlock(&resolver->lock);
+
+    if (resolver->started) {
+        pthread_join(resolver->thread, NULL);
+    }
+
+    evpl_core_abort_if(resolver->queue,
+                       "resolver destroyed with lookups still queued");
+
+    pthread_cond_destroy(&resolver->cond);
+    pthread_mutex_destroy(&resolver->lock);
+
+    evpl_free(resolver);
+} /* evpl_resolver_destroy */
+
+void
+evpl_resolver_request(
+    struct evpl_resolver *resolver,
+    struct evpl_endpoint *endpoint)
+{
+    int rc;
+
+    /* Cheap check so callers on a stale address do not all take the lock */
+    if (atomic_load(&endpoint->resolving)) {
+        return;
+    }
+
+    pthread_mutex_lock(&resolver->lock);
+
+    if (!atomic_load(&endpoint->resolving)) {
+
+        atomic_store(&endpoint->resolving, 1);
+
+        LL_APPEND2(resolver->queue, endpoint, resolve_next);
+
+        if (!resolver->started) {
+            rc = pthread_create(&resolver->thread, NULL,
+                                evpl_resolver_thread, resolver);
+
+            evpl_core_abort_if(rc, "failed to start resolver thread");
+
+            resolver->started = 1;
+        }
+
+        pthread_cond_broadcast(&resolver->cond);
+    }
+
+    pthread_mutex_unlock(&resolver->lock);
+} /* evpl_resolver_request */
+
+void
+evpl_resolver_cancel(
+    struct evpl_resolver *resolver,
+    struct evpl_endpoint *endpoint)
+{
+    pthread_mutex_lock(&resolver->lock);
+
+    evpl_core_abort_if(endpoint->waiters,
+                       "endpoint %s closed with connections still resolving",
+                       endpoint->address);
+
+    while (resolver->current == endpoint) {
+        pthread_cond_wait(&resolver->cond, &resolver->lock);
+    }
+
+    if (atomic_load(&endpoint->resolving)) {
+        LL_DELETE2(resolver->queue, endpoint, resolve_next);
+        atomic_store(&endpoint->resolving, 0);
+    }
+
+    pthread_mutex_unlock(&resolver->lock);
+} /* evpl_resolver_cancel */
+
+void
+evpl_resolver_wait(
+    struct evpl_resolver     *resolver,
+    struct evpl              *evpl,
+    struct evpl_endpoint     *endpoint,
+    struct evpl_resolve_wait *wait)
+{
+    uint64_t value = 1;
+    ssize_t  rc;
+
+    wait->evpl     = evpl;
+    wait->endpoint = endpoint;
+
+    pthread_mutex_lock(&resolver->lock);
+
+    DL_APPEND(endpoint->waiters, wait);
+
+    if (!atomic_load(&endpoint->resolving)) {
+        /* Completed before we got here, so wake ourselves */
+        rc = write(evpl->eventfd, &value, sizeof(value));
+
+        evpl_core_abort_if(rc != sizeof(value),
+                           "evpl_resolver: write to eventfd failed");
+    }
+
+    pthread_mutex_unlock(&resolver->lock);
+} /* evpl_resolver_wait */
+
+int
+evpl_resolver_poll(
+    struct evpl_resolver     *resolver,
+    struct evpl_resolve_wait *wait,
+    struct evpl_address     **addrp)
+{
+    struct evpl_endpoint *endpoint = wait->endpoint;
+
+    if (atomic_load(&endpoint->resolving)) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&resolver->lock);
+
+    if (atomic_load(&endpoint->resolving)) {
+        pthread_mutex_unlock(&resolver->lock);
+        return 0;
+    }
+
+    DL_DELETE(endpoint->waiters, wait);
+
+    pthread_mutex_unlock(&resolver->lock);
+
+    pthread_rwlock_rdlock(&endpoint->lock);
+
+    *addrp = endpoint->resolved_addr;
+
+    if (*addrp) {
+        evpl_address_incref(*addrp);
+    }
+
+    pthread_rwlock_unlock(&endpoint->lock);
+
+    return 1;
+} /* evpl_resolver_poll */
+
+void
+evpl_resolver_unwait(
+    struct evpl_resolver     *resolver,
+    struct evpl_resolve_wait *wait)
+{
+    pthread_mutex_lock(&resolver->lock);
+    DL_DELETE(wait->endpoint->waiters, wait);
+    pthread_mutex_unlock(&resolver->lock);
+} /* evpl_resolver_unwait */
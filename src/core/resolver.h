@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#pragma once
+
+#include "core/endpoint.h"
+
+/*
+ * Endpoint names are looked up on a background thread so that event
+ * loops never block in getaddrinfo.  The thread is started on the first
+ * lookup that cannot be answered from a numeric address.
+ */
+struct evpl_resolver;
+
+struct evpl_resolver *
+evpl_resolver_create(
+    void);
+
+void
+evpl_resolver_destroy(
+    struct evpl_resolver *resolver);
+
+/*
+ * Look up the address of an endpoint synchronously.  On success returns 0
+ * and an address with a reference held, otherwise a getaddrinfo error.
+ */
+int
+evpl_resolver_lookup(
+    struct evpl_endpoint *endpoint,
+    int                   flags,
+    struct evpl_address **addrp);
+
+/* Queue a lookup of the endpoint unless one is already queued */
+void
+evpl_resolver_request(
+    struct evpl_resolver *resolver,
+    struct evpl_endpoint *endpoint);
+
+/* Remove the endpoint from the resolver, waiting out a lookup in progress */
+void
+evpl_resolver_cancel(
+    struct evpl_resolver *resolver,
+    struct evpl_endpoint *endpoint);
+
+/*
+ * Register interest in the completion of the lookup of an endpoint.  The
+ * thread's eventfd is written once it completes, or at once if it already
+ * has, after which evpl_resolver_poll() reports the outcome.
+ */
+void
+evpl_resolver_wait(
+    struct evpl_resolver     *resolver,
+    struct evpl              *evpl,
+    struct evpl_endpoint     *endpoint,
+    struct evpl_resolve_wait *wait);
+
+/*
+ * Returns 0 while the lookup is still pending.  Otherwise unregisters the
+ * wait and returns 1 with the resolved address, or NULL if it failed.
+ */
+int
+evpl_resolver_poll(
+    struct evpl_resolver     *resolver,
+    struct evpl_resolve_wait *wait,
+    struct evpl_address     **addrp);
+
+void
+evpl_resolver_unwait(
+    struct evpl_resolver     *resolver,
+    struct evpl_resolve_wait *wait);
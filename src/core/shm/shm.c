@@ -0,0 +1,1632 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "uthash/utlist.h"
+
+#include "core/shm/shm.h"
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/buffer.h"
+#include "core/protocol.h"
+#include "core/bind.h"
+#include "core/endpoint.h"
+#include "core/evpl_shared.h"
+
+extern struct evpl_shared *evpl_shared;
+
+#define evpl_shm_debug(...) evpl_debug("shm", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_shm_info(...)  evpl_info("shm", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_shm_error(...) evpl_error("shm", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_shm_fatal(...) evpl_fatal("shm", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_shm_abort(...) evpl_abort("shm", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_shm_fatal_if(cond, ...) \
+        evpl_fatal_if(cond, "shm", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_shm_abort_if(cond, ...) \
+        evpl_abort_if(cond, "shm", __FILE__, __LINE__, __VA_ARGS__)
+
+#define EVPL_SHM_MAGIC      0x45564c53484d0001ULL
+
+/* Segments are carved into chunks, the unit returned to the sender */
+#define EVPL_SHM_CHUNK_SIZE (64 * 1024)
+
+#define EVPL_SHM_NUM_DESC   4096
+
+/* Datagrams start on a cache line */
+#define EVPL_SHM_ALIGN      64
+
+#define EVPL_SHM_MAX_IOV    64
+
+/* The datagram continues in the next descriptor */
+#define EVPL_SHM_DESC_MORE  0x1
+
+/* The sender will place nothing more in this chunk */
+#define EVPL_SHM_DESC_END   0x2
+
+struct evpl_shm_desc {
+    uint32_t chunk;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t flags;
+};
+
+struct evpl_shm_index {
+    _Alignas(EVPL_SHM_ALIGN) _Atomic uint32_t value;
+};
+
+/*
+ * Each side of a connection creates a segment for the data it sends
+ * and passes it to its peer.  The creator fills chunks and produces
+ * descriptors for them, the peer consumes the descriptors and hands
+ * chunks back through the free ring once it is done with them.
+ *
+ * The header is followed by the descriptor ring, the free ring, and
+ * at a page boundary the chunks themselves.
+ */
+struct evpl_shm_segment {
+    uint64_t              magic;
+    uint64_t              size;
+    uint32_t              num_chunks;
+    uint32_t              chunk_size;
+    uint32_t              num_desc;
+    uint32_t              data_offset;
+
+    struct evpl_shm_index sleeping;  /* creator's thread may block */
+    struct evpl_shm_index blocked;   /* creator is out of chunks or descriptors */
+    struct evpl_shm_index desc_head; /* produced by the creator */
+    struct evpl_shm_index desc_tail; /* produced by the peer */
+    struct evpl_shm_index free_head; /* produced by the peer */
+};
+
+/* Sent once on the control socket along with the segment and an eventfd */
+struct evpl_shm_hello {
+    uint64_t magic;
+    uint64_t size;
+};
+
+/*
+ * The peer's segment as we map it.  Chunks are delivered in place
+ * behind buffers of their own, which may be released on any thread,
+ * so this outlives the bind until the last of them is gone.
+ */
+struct evpl_shm_peer {
+    struct evpl_shm_segment *seg;
+    uint64_t                 size;
+    uint32_t                 num_chunks;
+    uint32_t                 num_desc;
+    struct evpl_shm_desc    *desc;
+    uint32_t                *free;
+    void                    *data;
+    struct evpl_memory      *memory;
+    struct evpl_buffer      *chunks;
+    uint8_t                 *open;     /* chunks the sender is still filling */
+    int32_t                 *next;     /* links of the returned stack */
+    _Atomic int32_t          returned; /* released chunks, -1 if none */
+    atomic_int               refcnt;
+    atomic_int               closed;
+    atomic_int               sleeping; /* our thread may block */
+    int                      wake_fd;
+};
+
+struct evpl_shm_accepted {
+    int fd;
+};
+
+struct evpl_shm_conn;
+
+/* Per thread state */
+struct evpl_shm {
+    struct evpl_event     event; /* eventfd our peers wake us with */
+    struct evpl_poll     *poll;
+    struct evpl_shm_conn *conns;
+    int                   polling;
+};
+
+struct evpl_shm_shared {
+    uid_t uid;
+};
+
+struct evpl_shm_conn {
+    struct evpl_event        event; /* control socket */
+    struct evpl_shm         *shm;
+    int                      connected;
+    int                      connector;
+    int                      linked;
+    int                      peer_wake_fd;
+
+    /* Our segment */
+    struct evpl_shm_segment *tx;
+    uint64_t                 tx_size;
+    int                      tx_memfd;
+    struct evpl_shm_desc    *tx_desc;
+    uint32_t                *tx_ring;
+    void                    *tx_data;
+    uint32_t                 tx_desc_head;
+    uint32_t                 tx_desc_tail; /* as of our last reclaim */
+    uint32_t                 tx_free_tail;
+    int                      tx_chunk;  /* being filled, or -1 */
+    uint32_t                 tx_offset;
+    uint32_t                *tx_free;
+    uint32_t                 tx_num_free;
+    int                      blocked;
+
+    /* Our peer's segment */
+    struct evpl_shm_peer    *rx;
+    uint32_t                 rx_desc_tail;
+    uint32_t                 rx_free_head;
+    struct evpl_iovec       *rx_msg;
+    int                      rx_msg_niov;
+    int                      rx_msg_length;
+
+    struct evpl_shm_conn    *prev;
+    struct evpl_shm_conn    *next;
+};
+
+#define evpl_event_shm_conn(eventp) container_of((eventp), struct evpl_shm_conn, event)
+#define evpl_event_shm(eventp)      container_of((eventp), struct evpl_shm, event)
+
+static inline uint32_t
+evpl_shm_load(struct evpl_shm_index *index)
+{
+    return atomic_load_explicit(&index->value, memory_order_acquire);
+} // evpl_shm_load
+
+static inline void
+evpl_shm_store(
+    struct evpl_shm_index *index,
+    uint32_t               value)
+{
+    atomic_store_explicit(&index->value, value, memory_order_release);
+} // evpl_shm_store
+
+static inline uint32_t
+evpl_shm_align(uint32_t offset)
+{
+    return (offset + EVPL_SHM_ALIGN - 1) & ~(EVPL_SHM_ALIGN - 1);
+} // evpl_shm_align
+
+static uint64_t
+evpl_shm_data_offset(
+    uint32_t num_desc,
+    uint32_t num_chunks)
+{
+    uint64_t page_size = evpl_shared->config->page_size;
+    uint64_t offset;
+
+    offset = sizeof(struct evpl_shm_segment) +
+        (uint64_t) num_desc * sizeof(struct evpl_shm_desc) +
+        (uint64_t) num_chunks * sizeof(uint32_t);
+
+    return (offset + page_size - 1) & ~(page_size - 1);
+} /* evpl_shm_data_offset */
+
+static inline void
+evpl_shm_kick(int fd)
+{
+    eventfd_write(fd, 1);
+} // evpl_shm_kick
+
+/*
+ * The abstract unix socket a listener on 'address' is found at.  Only
+ * processes in the same network namespace can reach it.
+ */
+static socklen_t
+evpl_shm_sockaddr(
+    struct sockaddr_un        *sun,
+    const struct evpl_address *address,
+    int                        wildcard)
+{
+    const struct sockaddr_in  *sin  = (const struct sockaddr_in *) address->addr;
+    const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *) address->addr;
+    char                       host[INET6_ADDRSTRLEN];
+    int                        port, len;
+
+    if (address->addr->sa_family == AF_INET6) {
+        if (wildcard) {
+            strcpy(host, "::");
+        } else {
+            inet_ntop(AF_INET6, &sin6->sin6_addr, host, sizeof(host));
+        }
+        port = ntohs(sin6->sin6_port);
+    } else {
+        if (wildcard) {
+            strcpy(host, "0.0.0.0");
+        } else {
+            inet_ntop(AF_INET, &sin->sin_addr, host, sizeof(host));
+        }
+        port = ntohs(sin->sin_port);
+    }
+
+    memset(sun, 0, sizeof(*sun));
+
+    sun->sun_family = AF_UNIX;
+
+    len = snprintf(sun->sun_path + 1, sizeof(sun->sun_path) - 1,
+                   "evpl-shm-%s:%d", host, port);
+
+    return offsetof(struct sockaddr_un, sun_path) + 1 + len;
+} /* evpl_shm_sockaddr */
+
+static void
+evpl_shm_conn_init(
+    struct evpl          *evpl,
+    struct evpl_shm_conn *conn)
+{
+    memset(conn, 0, sizeof(*conn));
+
+    conn->shm          = evpl_framework_private(evpl, EVPL_FRAMEWORK_SHM);
+    conn->event.fd     = -1;
+    conn->tx_memfd     = -1;
+    conn->peer_wake_fd = -1;
+    conn->tx_chunk     = -1;
+} /* evpl_shm_conn_init */
+
+/* Create the segment for what we send, all of its chunks free */
+static void
+evpl_shm_segment_create(struct evpl_shm_conn *conn)
+{
+    struct evpl_shm_segment *seg;
+    uint64_t                 data_offset;
+    uint32_t                 i, num_chunks = 4;
+    int                      rc;
+
+    while ((uint64_t) num_chunks * 2 * EVPL_SHM_CHUNK_SIZE <=
+           evpl_shared->config->shm_segment_size) {
+        num_chunks <<= 1;
+    }
+
+    data_offset = evpl_shm_data_offset(EVPL_SHM_NUM_DESC, num_chunks);
+
+    conn->tx_size = data_offset + (uint64_t) num_chunks * EVPL_SHM_CHUNK_SIZE;
+
+    conn->tx_memfd = memfd_create("evpl-shm", MFD_CLOEXEC);
+
+    evpl_shm_abort_if(conn->tx_memfd < 0, "Failed to create memfd: %s",
+                      strerror(errno));
+
+    rc = ftruncate(conn->tx_memfd, conn->tx_size);
+
+    evpl_shm_abort_if(rc, "Failed to size memfd: %s", strerror(errno));
+
+    seg = mmap(NULL, conn->tx_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+               conn->tx_memfd, 0);
+
+    evpl_shm_abort_if(seg == MAP_FAILED, "Failed to map memfd: %s",
+                      strerror(errno));
+
+    seg->magic       = EVPL_SHM_MAGIC;
+    seg->size        = conn->tx_size;
+    seg->num_chunks  = num_chunks;
+    seg->chunk_size  = EVPL_SHM_CHUNK_SIZE;
+    seg->num_desc    = EVPL_SHM_NUM_DESC;
+    seg->data_offset = data_offset;
+
+    /* Until our thread says otherwise, assume it needs waking */
+    evpl_shm_store(&seg->sleeping, !conn->shm->polling);
+
+    conn->tx      = seg;
+    conn->tx_desc = (struct evpl_shm_desc *) (seg + 1);
+    conn->tx_ring = (uint32_t *) (conn->tx_desc + EVPL_SHM_NUM_DESC);
+    conn->tx_data = (void *) seg + data_offset;
+
+    conn->tx_free     = evpl_zalloc(sizeof(uint32_t) * num_chunks);
+    conn->tx_num_free = num_chunks;
+
+    for (i = 0; i < num_chunks; ++i) {
+        conn->tx_free[i] = num_chunks - i - 1;
+    }
+} /* evpl_shm_segment_create */
+
+static void
+evpl_shm_peer_unmap(
+    void    *ptr,
+    uint64_t length,
+    void    *private_data)
+{
+    munmap(ptr, length);
+} /* evpl_shm_peer_unmap */
+
+static void
+evpl_shm_peer_release(struct evpl_shm_peer *peer)
+{
+    if (atomic_fetch_sub(&peer->refcnt, 1) > 1) {
+        return;
+    }
+
+    /* Unmapped once nothing else refers to the registration either */
+    evpl_memory_unregister(peer->memory);
+
+    close(peer->wake_fd);
+
+    evpl_free(peer->chunks);
+    evpl_free(peer->open);
+    evpl_free(peer->next);
+    evpl_free(peer);
+} /* evpl_shm_peer_release */
+
+/*
+ * The last reference to a received chunk is gone, on whatever thread
+ * dropped it.  Queue it for the owning thread to return to the sender.
+ */
+static void
+evpl_shm_chunk_release(struct evpl_buffer *buffer)
+{
+    struct evpl_shm_peer *peer = buffer->external1;
+    int32_t               index, head;
+
+    index = buffer - peer->chunks;
+
+    if (!atomic_load(&peer->closed)) {
+
+        head = atomic_load_explicit(&peer->returned, memory_order_relaxed);
+
+        do {
+            peer->next[index] = head;
+        } while (!atomic_compare_exchange_weak_explicit(&peer->returned,
+                                                        &head, index,
+                                                        memory_order_release,
+                                                        memory_order_relaxed));
+
+        if (head < 0 && atomic_load(&peer->sleeping)) {
+            evpl_shm_kick(peer->wake_fd);
+        }
+    }
+
+    evpl_shm_peer_release(peer);
+} /* evpl_shm_chunk_release */
+
+static struct evpl_shm_peer *
+evpl_shm_peer_create(
+    struct evpl_shm         *shm,
+    struct evpl_shm_segment *seg,
+    uint64_t                 size)
+{
+    struct evpl_shm_peer *peer;
+    struct evpl_buffer   *buffer;
+    uint64_t              data_offset;
+    uint32_t              i;
+
+    /* Our peer could change the header under us, so check a copy */
+    struct evpl_shm_segment hdr = *seg;
+
+    data_offset = evpl_shm_data_offset(hdr.num_desc, hdr.num_chunks);
+
+    if (hdr.magic != EVPL_SHM_MAGIC ||
+        hdr.size != size ||
+        hdr.chunk_size != EVPL_SHM_CHUNK_SIZE ||
+        hdr.num_chunks == 0 ||
+        (hdr.num_chunks & (hdr.num_chunks - 1)) ||
+        hdr.num_desc == 0 ||
+        (hdr.num_desc & (hdr.num_desc - 1)) ||
+        hdr.data_offset != data_offset ||
+        data_offset + (uint64_t) hdr.num_chunks * EVPL_SHM_CHUNK_SIZE > size) {
+        evpl_shm_error("Peer sent an invalid segment");
+        munmap(seg, size);
+        return NULL;
+    }
+
+    peer = evpl_zalloc(sizeof(*peer));
+
+    peer->memory = evpl_memory_register(seg, size, evpl_shm_peer_unmap, NULL);
+
+    if (!peer->memory) {
+        munmap(seg, size);
+        evpl_free(peer);
+        return NULL;
+    }
+
+    peer->seg        = seg;
+    peer->size       = size;
+    peer->num_chunks = hdr.num_chunks;
+    peer->num_desc   = hdr.num_desc;
+    peer->desc       = (struct evpl_shm_desc *) (seg + 1);
+    peer->free       = (uint32_t *) (peer->desc + hdr.num_desc);
+    peer->data       = (void *) seg + data_offset;
+    peer->chunks     = evpl_zalloc(sizeof(struct evpl_buffer) * hdr.num_chunks);
+    peer->open       = evpl_zalloc(hdr.num_chunks);
+    peer->next       = evpl_zalloc(sizeof(int32_t) * hdr.num_chunks);
+    peer->wake_fd    = dup(shm->event.fd);
+
+    evpl_shm_abort_if(peer->wake_fd < 0, "Failed to dup eventfd: %s",
+                      strerror(errno));
+
+    atomic_init(&peer->returned, -1);
+    atomic_init(&peer->refcnt, 1);
+    atomic_init(&peer->closed, 0);
+    atomic_init(&peer->sleeping, !shm->polling);
+
+    for (i = 0; i < hdr.num_chunks; ++i) {
+        buffer            = &peer->chunks[i];
+        buffer->data      = peer->data + (uint64_t) i * EVPL_SHM_CHUNK_SIZE;
+        buffer->size      = EVPL_SHM_CHUNK_SIZE;
+        buffer->used      = EVPL_SHM_CHUNK_SIZE;
+        buffer->slab      = &peer->memory->slab;
+        buffer->external1 = peer;
+        buffer->release   = evpl_shm_chunk_release;
+    }
+
+    return peer;
+} /* evpl_shm_peer_create */
+
+static int
+evpl_shm_send_hello(struct evpl_shm_conn *conn)
+{
+    struct evpl_shm_hello hello;
+    struct msghdr         msg;
+    struct iovec          iov;
+    struct cmsghdr       *cmsg;
+    int                   fds[2];
+    ssize_t               res;
+    union {
+        char           buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+
+    hello.magic = EVPL_SHM_MAGIC;
+    hello.size  = conn->tx_size;
+
+    fds[0] = conn->tx_memfd;
+    fds[1] = conn->shm->event.fd;
+
+    iov.iov_base = &hello;
+    iov.iov_len  = sizeof(hello);
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    cmsg             = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type  = SCM_RIGHTS;
+    cmsg->cmsg_len   = CMSG_LEN(sizeof(fds));
+
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    res = sendmsg(conn->event.fd, &msg, MSG_NOSIGNAL);
+
+    /* Our peer holds the memfd now, or we are giving up */
+    close(conn->tx_memfd);
+    conn->tx_memfd = -1;
+
+    return res == sizeof(hello) ? 0 : -1;
+} /* evpl_shm_send_hello */
+
+/*
+ * Take our peer's segment and eventfd from the control socket.
+ * Returns 1 once we have them, 0 if they have yet to arrive,
+ * and -1 if the peer is gone or sent something we can't use.
+ */
+static int
+evpl_shm_recv_hello(struct evpl_shm_conn *conn)
+{
+    struct evpl_shm_hello    hello;
+    struct evpl_shm_segment *seg;
+    struct msghdr            msg;
+    struct iovec             iov;
+    struct cmsghdr          *cmsg;
+    struct stat              st;
+    int                      fds[2] = { -1, -1 };
+    ssize_t                  res;
+    union {
+        char           buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+
+    iov.iov_base = &hello;
+    iov.iov_len  = sizeof(hello);
+
+    memset(&msg, 0, sizeof(msg));
+
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    res = recvmsg(conn->event.fd, &msg, MSG_CMSG_CLOEXEC);
+
+    if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); res > 0 && cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            cmsg->cmsg_len == CMSG_LEN(sizeof(fds))) {
+            memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+        }
+    }
+
+    if (res != sizeof(hello) || hello.magic != EVPL_SHM_MAGIC ||
+        fds[0] < 0 || fds[1] < 0 || (msg.msg_flags & MSG_CTRUNC) ||
+        fstat(fds[0], &st) || (uint64_t) st.st_size < hello.size ||
+        hello.size < sizeof(*seg) || hello.size > INT_MAX) {
+        goto fail;
+    }
+
+    seg = mmap(NULL, hello.size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+
+    if (seg == MAP_FAILED) {
+        goto fail;
+    }
+
+    close(fds[0]);
+
+    conn->rx = evpl_shm_peer_create(conn->shm, seg, hello.size);
+
+    if (!conn->rx) {
+        close(fds[1]);
+        return -1;
+    }
+
+    conn->peer_wake_fd = fds[1];
+
+    conn->rx_msg = evpl_zalloc(sizeof(struct evpl_iovec) *
+                               evpl_shared->config->max_num_iovec);
+
+    return 1;
+
+ fail:
+
+    if (fds[0] >= 0) {
+        close(fds[0]);
+    }
+
+    if (fds[1] >= 0) {
+        close(fds[1]);
+    }
+
+    return -1;
+} /* evpl_shm_recv_hello */
+
+/* Wake our peer if it may be blocked, once we have published something */
+static inline void
+evpl_shm_notify_peer(
+    struct evpl_shm_conn *conn,
+    int                   blocked_only)
+{
+    struct evpl_shm_segment *seg = conn->rx->seg;
+
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (evpl_shm_load(&seg->sleeping) &&
+        (!blocked_only || evpl_shm_load(&seg->blocked))) {
+        evpl_shm_kick(conn->peer_wake_fd);
+    }
+} // evpl_shm_notify_peer
+
+/* Hand chunks our application has finished with back to the sender */
+static int
+evpl_shm_return_chunks(struct evpl_shm_conn *conn)
+{
+    struct evpl_shm_peer *peer = conn->rx;
+    int32_t               index;
+    int                   n = 0;
+
+    if (atomic_load_explicit(&peer->returned, memory_order_relaxed) < 0) {
+        return 0;
+    }
+
+    index = atomic_exchange_explicit(&peer->returned, -1,
+                                     memory_order_acquire);
+
+    while (index >= 0) {
+        peer->free[conn->rx_free_head++ & (peer->num_chunks - 1)] = index;
+
+        index = peer->next[index];
+        n++;
+    }
+
+    evpl_shm_store(&peer->seg->free_head, conn->rx_free_head);
+
+    return n;
+} /* evpl_shm_return_chunks */
+
+static void
+evpl_shm_deliver_stream(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_notify notify;
+    struct evpl_iovec *iovec;
+    int                i, length, niov;
+
+    if (bind->segment_callback) {
+
+        iovec = alloca(sizeof(struct evpl_iovec) * evpl_shared->config->max_num_iovec);
+
+        while (1) {
+
+            length = bind->segment_callback(evpl, bind, bind->private_data);
+
+            if (length == 0 ||
+                evpl_iovec_ring_bytes(&bind->iovec_recv) < length) {
+                break;
+            }
+
+            if (unlikely(length < 0)) {
+                evpl_close(evpl, bind);
+                return;
+            }
+
+            niov = evpl_iovec_ring_copyv(evpl, iovec, &bind->iovec_recv,
+                                         length);
+
+            notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+            notify.notify_status      = 0;
+            notify.recv_msg.iovec     = iovec;
+            notify.recv_msg.niov      = niov;
+            notify.recv_msg.length    = length;
+            notify.recv_msg.addr      = bind->remote;
+            notify.recv_msg.timestamp = 0;
+
+            bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+            for (i = 0; i < niov; ++i) {
+                evpl_iovec_release(&iovec[i]);
+            }
+        }
+
+    } else {
+        notify.notify_type         = EVPL_NOTIFY_RECV_DATA;
+        notify.notify_status       = 0;
+        notify.recv_data.timestamp = 0;
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+} /* evpl_shm_deliver_stream */
+
+static void
+evpl_shm_deliver_msg(
+    struct evpl          *evpl,
+    struct evpl_bind     *bind,
+    struct evpl_shm_conn *conn)
+{
+    struct evpl_notify notify;
+    int                i;
+
+    notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+    notify.notify_status      = 0;
+    notify.recv_msg.iovec     = conn->rx_msg;
+    notify.recv_msg.niov      = conn->rx_msg_niov;
+    notify.recv_msg.length    = conn->rx_msg_length;
+    notify.recv_msg.addr      = bind->remote;
+    notify.recv_msg.timestamp = 0;
+
+    bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+    for (i = 0; i < conn->rx_msg_niov; ++i) {
+        evpl_iovec_release(&conn->rx_msg[i]);
+    }
+
+    conn->rx_msg_niov   = 0;
+    conn->rx_msg_length = 0;
+} /* evpl_shm_deliver_msg */
+
+/* Consume our peer's descriptors, returns the number taken */
+static int
+evpl_shm_recv(
+    struct evpl          *evpl,
+    struct evpl_bind     *bind,
+    struct evpl_shm_conn *conn)
+{
+    struct evpl_shm_peer *peer = conn->rx;
+    struct evpl_shm_desc  desc;
+    struct evpl_buffer   *buffer;
+    struct evpl_iovec     iovec;
+    uint32_t              head, tail = conn->rx_desc_tail;
+    int                   stream = bind->protocol->stream;
+    int                   n      = 0, data = 0;
+
+    head = evpl_shm_load(&peer->seg->desc_head);
+
+    while (tail != head) {
+
+        if (stream && evpl_bind_recv_full(bind)) {
+            bind->flags |= EVPL_BIND_RECV_PAUSED;
+            break;
+        }
+
+        desc = peer->desc[tail & (peer->num_desc - 1)];
+
+        tail++;
+        n++;
+
+        if (unlikely(desc.chunk >= peer->num_chunks ||
+                     desc.offset > EVPL_SHM_CHUNK_SIZE ||
+                     desc.length > EVPL_SHM_CHUNK_SIZE - desc.offset ||
+                     (!stream && desc.length &&
+                      conn->rx_msg_niov == evpl_shared->config->max_num_iovec))) {
+            evpl_shm_error("Peer sent an invalid descriptor");
+            evpl_close(evpl, bind);
+            break;
+        }
+
+        buffer = &peer->chunks[desc.chunk];
+
+        if (!peer->open[desc.chunk]) {
+            /* The sender holds this reference until it ends the chunk */
+            evpl_buffer_set_shared(buffer);
+            atomic_fetch_add(&peer->refcnt, 1);
+            peer->open[desc.chunk] = 1;
+        }
+
+        if (desc.length) {
+
+            evpl_buffer_addref(buffer);
+
+            iovec.data    = buffer->data + desc.offset;
+            iovec.length  = desc.length;
+            iovec.private = buffer;
+
+            if (stream) {
+                evpl_iovec_ring_add(&bind->iovec_recv, &iovec);
+                data = 1;
+            } else {
+                conn->rx_msg[conn->rx_msg_niov++] = iovec;
+                conn->rx_msg_length              += desc.length;
+            }
+        }
+
+        if (desc.flags & EVPL_SHM_DESC_END) {
+            peer->open[desc.chunk] = 0;
+            evpl_buffer_release(buffer);
+        }
+
+        if (!stream && !(desc.flags & EVPL_SHM_DESC_MORE)) {
+            evpl_shm_deliver_msg(evpl, bind, conn);
+        }
+    }
+
+    if (n) {
+        conn->rx_desc_tail = tail;
+        evpl_shm_store(&peer->seg->desc_tail, tail);
+    }
+
+    if (data) {
+        evpl_shm_deliver_stream(evpl, bind);
+    }
+
+    return n;
+} /* evpl_shm_recv */
+
+/* Take back chunks and descriptors our peer is done with */
+static void
+evpl_shm_reclaim(struct evpl_shm_conn *conn)
+{
+    uint32_t head, index, num_chunks = conn->tx->num_chunks;
+
+    conn->tx_desc_tail = evpl_shm_load(&conn->tx->desc_tail);
+
+    head = evpl_shm_load(&conn->tx->free_head);
+
+    while (conn->tx_free_tail != head) {
+
+        index = conn->tx_ring[conn->tx_free_tail++ & (num_chunks - 1)];
+
+        if (likely(index < num_chunks && conn->tx_num_free < num_chunks)) {
+            conn->tx_free[conn->tx_num_free++] = index;
+        }
+    }
+} /* evpl_shm_reclaim */
+
+/* Whether our peer has given back anything since we ran out of room */
+static inline int
+evpl_shm_unblocked(struct evpl_shm_conn *conn)
+{
+    return evpl_shm_load(&conn->tx->free_head) != conn->tx_free_tail ||
+           evpl_shm_load(&conn->tx->desc_tail) != conn->tx_desc_tail;
+} // evpl_shm_unblocked
+
+static inline uint32_t
+evpl_shm_desc_room(struct evpl_shm_conn *conn)
+{
+    return EVPL_SHM_NUM_DESC - (conn->tx_desc_head - conn->tx_desc_tail);
+} // evpl_shm_desc_room
+
+/*
+ * Whether 'length' more bytes fit, continuing the chunk being filled
+ * and then taking fresh ones, each piece needing a descriptor
+ */
+static int
+evpl_shm_fits(
+    struct evpl_shm_conn *conn,
+    uint64_t              length)
+{
+    uint64_t room = conn->tx_chunk >= 0 ? EVPL_SHM_CHUNK_SIZE - conn->tx_offset : 0;
+    uint64_t chunks, descs;
+
+    if (conn->tx_chunk >= 0 && length <= room) {
+        chunks = 0;
+        descs  = 1;
+    } else {
+        chunks = (length - room + EVPL_SHM_CHUNK_SIZE - 1) / EVPL_SHM_CHUNK_SIZE;
+
+        if (chunks == 0) {
+            chunks = 1;
+        }
+
+        descs = chunks + (conn->tx_chunk >= 0);
+    }
+
+    return chunks <= conn->tx_num_free && descs <= evpl_shm_desc_room(conn);
+} /* evpl_shm_fits */
+
+/*
+ * Copy 'length' bytes into our segment, producing a descriptor for
+ * each chunk they land in.  The caller has checked that they fit.
+ */
+static void
+evpl_shm_put(
+    struct evpl_shm_conn *conn,
+    const struct iovec   *iov,
+    uint64_t              length,
+    int                   datagram)
+{
+    struct evpl_shm_desc *desc;
+    uint64_t              remain = length, piece, copied, chunk_left;
+    uint64_t              iov_off = 0, n;
+    void                 *dst;
+    int                   i = 0;
+
+    do {
+
+        if (conn->tx_chunk < 0) {
+            conn->tx_chunk  = conn->tx_free[--conn->tx_num_free];
+            conn->tx_offset = 0;
+        }
+
+        chunk_left = EVPL_SHM_CHUNK_SIZE - conn->tx_offset;
+        piece      = remain < chunk_left ? remain : chunk_left;
+
+        dst = conn->tx_data + (uint64_t) conn->tx_chunk * EVPL_SHM_CHUNK_SIZE +
+            conn->tx_offset;
+
+        for (copied = 0; copied < piece;) {
+            n = iov[i].iov_len - iov_off;
+
+            if (n > piece - copied) {
+                n = piece - copied;
+            }
+
+            memcpy(dst + copied, iov[i].iov_base + iov_off, n);
+
+            copied  += n;
+            iov_off += n;
+
+            if (iov_off == iov[i].iov_len) {
+                i++;
+                iov_off = 0;
+            }
+        }
+
+        desc = &conn->tx_desc[conn->tx_desc_head++ & (EVPL_SHM_NUM_DESC - 1)];
+
+        desc->chunk  = conn->tx_chunk;
+        desc->offset = conn->tx_offset;
+        desc->length = piece;
+        desc->flags  = 0;
+
+        remain          -= piece;
+        conn->tx_offset += piece;
+
+        if (datagram) {
+            if (remain) {
+                desc->flags |= EVPL_SHM_DESC_MORE;
+            } else {
+                conn->tx_offset = evpl_shm_align(conn->tx_offset);
+            }
+        }
+
+        if (conn->tx_offset >= EVPL_SHM_CHUNK_SIZE) {
+            desc->flags   |= EVPL_SHM_DESC_END;
+            conn->tx_chunk = -1;
+        }
+
+    } while (remain);
+} /* evpl_shm_put */
+
+/* Make what we have produced visible and wake our peer if it sleeps */
+static void
+evpl_shm_publish(
+    struct evpl_shm_conn *conn,
+    int                   blocked)
+{
+    if (blocked != conn->blocked) {
+        conn->blocked = blocked;
+        evpl_shm_store(&conn->tx->blocked, blocked);
+    }
+
+    evpl_shm_store(&conn->tx->desc_head, conn->tx_desc_head);
+
+    evpl_shm_notify_peer(conn, 0);
+} /* evpl_shm_publish */
+
+static void
+evpl_shm_flush_stream(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_shm_conn *conn = evpl_bind_private(bind);
+    struct iovec          iov[EVPL_SHM_MAX_IOV];
+    uint64_t              room, bytes = 0;
+    ssize_t               total;
+    int                   msgs = 0, blocked = 0;
+
+    if (unlikely(!conn->connected)) {
+        return;
+    }
+
+    evpl_shm_reclaim(conn);
+
+    while (!evpl_iovec_ring_is_empty(&bind->iovec_send)) {
+
+        if ((conn->tx_chunk < 0 && !conn->tx_num_free) ||
+            !evpl_shm_desc_room(conn)) {
+            blocked = 1;
+            break;
+        }
+
+        room = conn->tx_chunk >= 0 ?
+            EVPL_SHM_CHUNK_SIZE - conn->tx_offset : EVPL_SHM_CHUNK_SIZE;
+
+        evpl_iovec_ring_iov_limit(&total, iov, EVPL_SHM_MAX_IOV,
+                                  &bind->iovec_send, room);
+
+        evpl_shm_put(conn, iov, total, 0);
+
+        evpl_iovec_ring_consume(evpl, &bind->iovec_send, total);
+
+        msgs  += evpl_dgram_ring_consume(&bind->dgram_send, total);
+        bytes += total;
+    }
+
+    if (bytes || blocked != conn->blocked) {
+        evpl_shm_publish(conn, blocked);
+    }
+
+    if (bytes) {
+        evpl_bind_sent(evpl, bind, bytes, msgs);
+    }
+
+    if (evpl_iovec_ring_is_empty(&bind->iovec_send) &&
+        (bind->flags & EVPL_BIND_FINISH)) {
+        evpl_close(evpl, bind);
+    }
+} /* evpl_shm_flush_stream */
+
+static void
+evpl_shm_flush_datagram(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_shm_conn *conn = evpl_bind_private(bind);
+    struct evpl_dgram    *dgram;
+    struct evpl_iovec    *cur;
+    struct iovec         *iov;
+    uint64_t              bytes = 0;
+    int                   i, msgs = 0, blocked = 0;
+
+    if (unlikely(!conn->connected)) {
+        return;
+    }
+
+    evpl_shm_reclaim(conn);
+
+    iov = alloca(sizeof(struct iovec) * evpl_shared->config->max_num_iovec);
+
+    while ((dgram = evpl_dgram_ring_tail(&bind->dgram_send)) != NULL) {
+
+        if (!evpl_shm_fits(conn, dgram->length)) {
+            blocked = 1;
+            break;
+        }
+
+        cur = evpl_iovec_ring_tail(&bind->iovec_send);
+
+        for (i = 0; i < dgram->niov; ++i) {
+            iov[i].iov_base = cur->data;
+            iov[i].iov_len  = cur->length;
+            cur             = evpl_iovec_ring_next(&bind->iovec_send, cur);
+        }
+
+        evpl_shm_put(conn, iov, dgram->length, 1);
+
+        bytes += dgram->length;
+        msgs++;
+
+        evpl_iovec_ring_consumev(evpl, &bind->iovec_send, dgram->niov);
+        evpl_dgram_ring_remove(&bind->dgram_send);
+    }
+
+    if (msgs || blocked != conn->blocked) {
+        evpl_shm_publish(conn, blocked);
+    }
+
+    if (msgs) {
+        evpl_bind_sent(evpl, bind, bytes, msgs);
+    }
+
+    if (evpl_iovec_ring_is_empty(&bind->iovec_send) &&
+        (bind->flags & EVPL_BIND_FINISH)) {
+        evpl_close(evpl, bind);
+    }
+} /* evpl_shm_flush_datagram */
+
+/* Everything a connection has to do on a pass, returns nonzero if it did anything */
+static int
+evpl_shm_conn_poll(
+    struct evpl          *evpl,
+    struct evpl_shm_conn *conn)
+{
+    struct evpl_bind *bind = evpl_private2bind(conn);
+    int               returned, consumed = 0;
+
+    if (unlikely(bind->flags & EVPL_BIND_PENDING_CLOSED)) {
+        return 0;
+    }
+
+    returned = evpl_shm_return_chunks(conn);
+
+    if (!(bind->flags & EVPL_BIND_RECV_PAUSED)) {
+        consumed = evpl_shm_recv(evpl, bind, conn);
+    }
+
+    if (returned || consumed) {
+        evpl_shm_notify_peer(conn, 1);
+    }
+
+    if (conn->blocked && evpl_shm_unblocked(conn)) {
+        bind->protocol->flush(evpl, bind);
+        return 1;
+    }
+
+    return returned || consumed;
+} /* evpl_shm_conn_poll */
+
+static void
+evpl_shm_poll(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_shm      *shm = private_data;
+    struct evpl_shm_conn *conn;
+
+    DL_FOREACH(shm->conns, conn)
+    {
+        if (conn->connected && evpl_shm_conn_poll(evpl, conn)) {
+            evpl_activity(evpl);
+        }
+    }
+} /* evpl_shm_poll */
+
+static void
+evpl_shm_set_sleeping(
+    struct evpl_shm_conn *conn,
+    int                   sleeping)
+{
+    evpl_shm_store(&conn->tx->sleeping, sleeping);
+
+    if (conn->rx) {
+        atomic_store(&conn->rx->sleeping, sleeping);
+    }
+} /* evpl_shm_set_sleeping */
+
+static void
+evpl_shm_poll_enter(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_shm      *shm = private_data;
+    struct evpl_shm_conn *conn;
+
+    shm->polling = 1;
+
+    DL_FOREACH(shm->conns, conn)
+    {
+        evpl_shm_set_sleeping(conn, 0);
+    }
+} /* evpl_shm_poll_enter */
+
+/*
+ * We may block from here on, so peers must wake us.  Anything they
+ * published before they could see that needs us to wake ourselves.
+ */
+static void
+evpl_shm_poll_exit(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_shm      *shm = private_data;
+    struct evpl_shm_conn *conn;
+
+    shm->polling = 0;
+
+    DL_FOREACH(shm->conns, conn)
+    {
+        evpl_shm_set_sleeping(conn, 1);
+    }
+
+    atomic_thread_fence(memory_order_seq_cst);
+
+    DL_FOREACH(shm->conns, conn)
+    {
+        if (!conn->connected) {
+            continue;
+        }
+
+        if (evpl_shm_load(&conn->rx->seg->desc_head) != conn->rx_desc_tail ||
+            atomic_load(&conn->rx->returned) >= 0 ||
+            (conn->blocked && evpl_shm_unblocked(conn))) {
+            evpl_shm_kick(shm->event.fd);
+            break;
+        }
+    }
+} /* evpl_shm_poll_exit */
+
+static void
+evpl_shm_wake(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct evpl_shm *shm = evpl_event_shm(event);
+    eventfd_t        value;
+
+    eventfd_read(event->fd, &value);
+
+    evpl_event_mark_unreadable(event);
+
+    evpl_activity(evpl);
+
+    evpl_shm_poll(evpl, shm);
+} /* evpl_shm_wake */
+
+static void
+evpl_shm_connected(
+    struct evpl          *evpl,
+    struct evpl_bind     *bind,
+    struct evpl_shm_conn *conn)
+{
+    struct evpl_notify notify;
+
+    conn->connected = 1;
+
+    evpl_shm_set_sleeping(conn, !conn->shm->polling);
+
+    if (conn->connector) {
+        notify.notify_type   = EVPL_NOTIFY_CONNECTED;
+        notify.notify_status = 0;
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+
+    evpl_defer(evpl, &bind->flush_deferral);
+} /* evpl_shm_connected */
+
+/*
+ * Nothing follows the hello on the control socket, so once we have it
+ * the socket becoming readable means our peer has closed.
+ */
+static void
+evpl_shm_ctl_read(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct evpl_shm_conn *conn = evpl_event_shm_conn(event);
+    struct evpl_bind     *bind = evpl_private2bind(conn);
+    char                  byte;
+    ssize_t               res;
+    int                   rc;
+
+    if (unlikely(conn->event.fd < 0)) {
+        return;
+    }
+
+    if (!conn->connected) {
+
+        rc = evpl_shm_recv_hello(conn);
+
+        if (rc == 0) {
+            evpl_event_mark_unreadable(event);
+            return;
+        }
+
+        if (rc < 0) {
+            evpl_close(evpl, bind);
+            return;
+        }
+
+        evpl_shm_connected(evpl, bind, conn);
+    }
+
+    res = recv(conn->event.fd, &byte, sizeof(byte), MSG_DONTWAIT);
+
+    if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        evpl_event_mark_unreadable(event);
+        return;
+    }
+
+    /* Deliver whatever our peer sent before it went away */
+    evpl_shm_conn_poll(evpl, conn);
+
+    evpl_close(evpl, bind);
+} /* evpl_shm_ctl_read */
+
+static void
+evpl_shm_ctl_error(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    evpl_event_clear_error(event);
+
+    evpl_shm_ctl_read(evpl, event);
+} /* evpl_shm_ctl_error */
+
+/* Start a connection on an established control socket */
+static void
+evpl_shm_conn_start(
+    struct evpl          *evpl,
+    struct evpl_bind     *bind,
+    struct evpl_shm_conn *conn,
+    int                   fd)
+{
+    conn->event.fd             = fd;
+    conn->event.read_callback  = evpl_shm_ctl_read;
+    conn->event.error_callback = evpl_shm_ctl_error;
+
+    evpl_add_event(evpl, &conn->event);
+    evpl_event_read_interest(evpl, &conn->event);
+
+    evpl_shm_segment_create(conn);
+
+    DL_APPEND(conn->shm->conns, conn);
+    conn->linked = 1;
+
+    if (evpl_shm_send_hello(conn)) {
+        evpl_close(evpl, bind);
+    }
+} /* evpl_shm_conn_start */
+
+static void
+evpl_shm_connect(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_shm_conn *conn = evpl_bind_private(bind);
+    struct sockaddr_un    sun;
+    socklen_t             len;
+    int                   fd, rc;
+
+    evpl_shm_conn_init(evpl, conn);
+
+    conn->connector = 1;
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    evpl_shm_abort_if(fd < 0, "Failed to create unix socket: %s",
+                      strerror(errno));
+
+    len = evpl_shm_sockaddr(&sun, bind->remote, 0);
+    rc  = connect(fd, (struct sockaddr *) &sun, len);
+
+    if (rc && errno == ECONNREFUSED) {
+        /* Try a listener bound to the wildcard address */
+        len = evpl_shm_sockaddr(&sun, bind->remote, 1);
+        rc  = connect(fd, (struct sockaddr *) &sun, len);
+    }
+
+    if (rc) {
+        evpl_shm_debug("Failed to connect to %s: %s", sun.sun_path + 1,
+                       strerror(errno));
+        close(fd);
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    evpl_shm_conn_start(evpl, bind, conn, fd);
+} /* evpl_shm_connect */
+
+static void
+evpl_shm_attach(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    void             *accepted)
+{
+    struct evpl_shm_conn     *conn = evpl_bind_private(bind);
+    struct evpl_shm_accepted *a    = accepted;
+    int                       fd   = a->fd;
+
+    evpl_free(a);
+
+    evpl_shm_conn_init(evpl, conn);
+
+    evpl_shm_conn_start(evpl, bind, conn, fd);
+} /* evpl_shm_attach */
+
+static void
+evpl_shm_accept(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct evpl_shm_conn     *ls          = evpl_event_shm_conn(event);
+    struct evpl_bind         *listen_bind = evpl_private2bind(ls);
+    struct evpl_shm_shared   *shared      = evpl_shared->framework_private[EVPL_FRAMEWORK_SHM];
+    struct evpl_address      *remote_addr;
+    struct evpl_shm_accepted *accepted;
+    struct ucred              cred;
+    socklen_t                 len;
+    int                       fd;
+
+    while (1) {
+
+        remote_addr = evpl_address_alloc();
+
+        remote_addr->addrlen = sizeof(remote_addr->sa);
+
+        fd = accept4(ls->event.fd, remote_addr->addr, &remote_addr->addrlen,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0) {
+            evpl_event_mark_unreadable(event);
+            evpl_free(remote_addr);
+            return;
+        }
+
+        /* Our peer will see what we send, so it must be one of us */
+        len = sizeof(cred);
+
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) ||
+            cred.uid != shared->uid) {
+            evpl_shm_error("Rejecting connection from uid %u", cred.uid);
+            close(fd);
+            evpl_free(remote_addr);
+            continue;
+        }
+
+        accepted = evpl_zalloc(sizeof(*accepted));
+
+        accepted->fd = fd;
+
+        listen_bind->accept_callback(evpl, listen_bind, remote_addr, accepted,
+                                     listen_bind->private_data);
+    }
+} /* evpl_shm_accept */
+
+static void
+evpl_shm_listen(
+    struct evpl      *evpl,
+    struct evpl_bind *listen_bind)
+{
+    struct evpl_shm_conn *ls = evpl_bind_private(listen_bind);
+    struct sockaddr_un    sun;
+    socklen_t             len;
+    int                   rc;
+
+    evpl_shm_conn_init(evpl, ls);
+
+    ls->event.fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    evpl_shm_abort_if(ls->event.fd < 0, "Failed to create unix socket: %s",
+                      strerror(errno));
+
+    len = evpl_shm_sockaddr(&sun, listen_bind->local, 0);
+
+    rc = bind(ls->event.fd, (struct sockaddr *) &sun, len);
+
+    evpl_shm_abort_if(rc < 0, "Failed to bind %s: %s", sun.sun_path + 1,
+                      strerror(errno));
+
+    rc = listen(ls->event.fd, evpl_shared->config->max_pending);
+
+    evpl_shm_fatal_if(rc, "Failed to listen on listener fd");
+
+    ls->event.read_callback = evpl_shm_accept;
+
+    evpl_add_event(evpl, &ls->event);
+    evpl_event_read_interest(evpl, &ls->event);
+} /* evpl_shm_listen */
+
+static void
+evpl_shm_resume_recv(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    /* Our next poll picks up where we left off */
+    evpl_activity(evpl);
+} /* evpl_shm_resume_recv */
+
+static void
+evpl_shm_pending_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_shm_conn *conn = evpl_bind_private(bind);
+
+    if (conn->event.fd >= 0) {
+        evpl_event_read_disinterest(evpl, &conn->event);
+        close(conn->event.fd);
+        conn->event.fd = -1;
+    }
+
+    if (conn->linked) {
+        DL_DELETE(conn->shm->conns, conn);
+        conn->linked = 0;
+    }
+
+    conn->connected = 0;
+} /* evpl_shm_pending_close */
+
+static void
+evpl_shm_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_shm_conn *conn = evpl_bind_private(bind);
+    struct evpl_shm_peer *peer = conn->rx;
+    uint32_t              i;
+
+    if (peer) {
+
+        for (i = 0; i < conn->rx_msg_niov; ++i) {
+            evpl_iovec_release(&conn->rx_msg[i]);
+        }
+
+        atomic_store(&peer->closed, 1);
+
+        /* Chunks our application still holds keep the mapping alive */
+        for (i = 0; i < peer->num_chunks; ++i) {
+            if (peer->open[i]) {
+                peer->open[i] = 0;
+                evpl_buffer_release(&peer->chunks[i]);
+            }
+        }
+
+        evpl_shm_peer_release(peer);
+
+        conn->rx = NULL;
+    }
+
+    if (conn->tx) {
+        munmap(conn->tx, conn->tx_size);
+        conn->tx = NULL;
+    }
+
+    if (conn->tx_memfd >= 0) {
+        close(conn->tx_memfd);
+        conn->tx_memfd = -1;
+    }
+
+    if (conn->peer_wake_fd >= 0) {
+        close(conn->peer_wake_fd);
+        conn->peer_wake_fd = -1;
+    }
+
+    if (conn->tx_free) {
+        evpl_free(conn->tx_free);
+        conn->tx_free = NULL;
+    }
+
+    if (conn->rx_msg) {
+        evpl_free(conn->rx_msg);
+        conn->rx_msg = NULL;
+    }
+} /* evpl_shm_close */
+
+static void *
+evpl_shm_init(void)
+{
+    struct evpl_shm_shared *shared;
+
+    shared = evpl_zalloc(sizeof(*shared));
+
+    shared->uid = geteuid();
+
+    return shared;
+} /* evpl_shm_init */
+
+static void
+evpl_shm_cleanup(void *private_data)
+{
+    evpl_free(private_data);
+} /* evpl_shm_cleanup */
+
+static void *
+evpl_shm_create(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_shm *shm;
+
+    shm = evpl_zalloc(sizeof(*shm));
+
+    shm->event.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    evpl_shm_abort_if(shm->event.fd < 0, "Failed to create eventfd: %s",
+                      strerror(errno));
+
+    shm->event.read_callback = evpl_shm_wake;
+
+    evpl_add_event(evpl, &shm->event);
+    evpl_event_read_interest(evpl, &shm->event);
+
+    shm->poll = evpl_add_poll(evpl, evpl_shm_poll_enter, evpl_shm_poll_exit,
+                              evpl_shm_poll, shm);
+
+    return shm;
+} /* evpl_shm_create */
+
+static void
+evpl_shm_destroy(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_shm *shm = private_data;
+
+    evpl_remove_poll(evpl, shm->poll);
+
+    evpl_remove_event(evpl, &shm->event);
+
+    close(shm->event.fd);
+
+    evpl_free(shm);
+} /* evpl_shm_destroy */
+
+struct evpl_framework evpl_framework_shm = {
+    .id      = EVPL_FRAMEWORK_SHM,
+    .name    = "SHM",
+    .init    = evpl_shm_init,
+    .cleanup = evpl_shm_cleanup,
+    .create  = evpl_shm_create,
+    .destroy = evpl_shm_destroy,
+};
+
+struct evpl_protocol  evpl_shm_datagram = {
+    .id                = EVPL_DATAGRAM_SHM,
+    .connected         = 1,
+    .stream            = 0,
+    .name              = "DATAGRAM_SHM",
+    .framework         = &evpl_framework_shm,
+    .bind_private_size = sizeof(struct evpl_shm_conn),
+    .connect           = evpl_shm_connect,
+    .listen            = evpl_shm_listen,
+    .attach            = evpl_shm_attach,
+    .pending_close     = evpl_shm_pending_close,
+    .close             = evpl_shm_close,
+    .flush             = evpl_shm_flush_datagram,
+};
+
+struct evpl_protocol  evpl_shm_stream = {
+    .id                = EVPL_STREAM_SHM,
+    .connected         = 1,
+    .stream            = 1,
+    .name              = "STREAM_SHM",
+    .framework         = &evpl_framework_shm,
+    .bind_private_size = sizeof(struct evpl_shm_conn),
+    .connect           = evpl_shm_connect,
+    .listen            = evpl_shm_listen,
+    .attach            = evpl_shm_attach,
+    .pending_close     = evpl_shm_pending_close,
+    .close             = evpl_shm_close,
+    .flush             = evpl_shm_flush_stream,
+    .resume_recv       = evpl_shm_resume_recv,
+};
@@ -0,0 +1,9 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#pragma once
+
+extern struct evpl_framework evpl_framework_shm;
+extern struct evpl_protocol  evpl_shm_datagram;
+extern struct evpl_protocol  evpl_shm_stream;
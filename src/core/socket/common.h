@@ -5,11 +5,15 @@
 #pragma once
 
 #include <netinet/tcp.h> // For TCP_NODELAY
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
 
 
 #include "uthash/utlist.h"
 #include "evpl/evpl.h"
 #include "core/evpl_shared.h"
+#include "core/iovec_ring.h"
+#include "core/dgram_ring.h"
 
 extern struct evpl_shared *evpl_shared;
 #define evpl_socket_debug(...) evpl_debug("socket", __FILE__, __LINE__, \
@@ -38,13 +42,32 @@ struct evpl_accepted_socket {
     int fd;
 };
 
+/* Most descriptors passed with a single message on a unix socket */
+#define EVPL_SOCKET_MAX_FDS 16
+
 struct evpl_socket {
     struct evpl_event            event;
     int                          fd;
     int                          connected;
+    int                          zerocopy;
+    int                          gso;
+    int                          gro;
+    int                          rcvlowat;     /* SO_RCVLOWAT currently set */
+    int                          hangup;       /* peer shut down, read to EOF */
+    unsigned int                 timestamping; /* EVPL_TIMESTAMP_* in effect */
+    uint64_t                     tx_ts_count;  /* extends the 32 bit ts ids */
+    uint32_t                     zc_next_id;
+    uint32_t                     zc_done_id;
     struct evpl_socket_datagram *free_datagrams;
-    struct evpl_iovec            recv1;
-    struct evpl_iovec            recv2;
+
+    /* SCM_RIGHTS passing on unix sockets, descriptors waiting to be sent */
+    int                          pass_fds;
+    int                          send_nfds;
+    int                          send_fds[EVPL_SOCKET_MAX_FDS];
+
+    /* references held for MSG_ZEROCOPY sends, one zc_sends entry per send */
+    struct evpl_iovec_ring       zc_held;
+    struct evpl_dgram_ring       zc_sends;
 };
 
 #define evpl_event_socket(eventp) container_of((eventp), struct evpl_socket, \
@@ -87,6 +110,247 @@ evpl_socket_datagram_reload(
                               evpl_shared->config->max_datagram_size);
 } // evpl_socket_msg_reload
 
+/* Room for the control message carrying receive timestamps */
+#define EVPL_SOCKET_TIMESTAMP_CONTROL CMSG_SPACE(sizeof(struct scm_timestamping))
+
+static inline void
+evpl_socket_timestamping_init(struct evpl_socket *s)
+{
+    unsigned int mode  = evpl_shared->config->socket_timestamping;
+    unsigned int flags = 0;
+    int          rc;
+
+    if (!mode) {
+        return;
+    }
+
+    if (mode & EVPL_TIMESTAMP_RX) {
+        flags |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+
+        if (mode & EVPL_TIMESTAMP_HARDWARE) {
+            flags |= SOF_TIMESTAMPING_RX_HARDWARE;
+        }
+    }
+
+    if (mode & EVPL_TIMESTAMP_TX) {
+        /* Number each send so its timestamp can be matched to the stream */
+        flags |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+            SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+
+        if (mode & EVPL_TIMESTAMP_HARDWARE) {
+            flags |= SOF_TIMESTAMPING_TX_HARDWARE;
+        }
+    }
+
+    if (mode & EVPL_TIMESTAMP_HARDWARE) {
+        flags |= SOF_TIMESTAMPING_RAW_HARDWARE;
+    }
+
+    rc = setsockopt(s->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+
+    if (rc) {
+        evpl_socket_debug("SO_TIMESTAMPING unavailable: %s", strerror(errno));
+        return;
+    }
+
+    s->timestamping = mode;
+    s->tx_ts_count  = 0;
+} // evpl_socket_timestamping_init
+
+/* A timestamping control message in ns, preferring the hardware stamp */
+static inline uint64_t
+evpl_socket_timestamp(struct cmsghdr *cm)
+{
+    struct scm_timestamping *tss = (struct scm_timestamping *) CMSG_DATA(cm);
+    struct timespec         *ts  = &tss->ts[0];
+
+    if (tss->ts[2].tv_sec || tss->ts[2].tv_nsec) {
+        ts = &tss->ts[2];
+    }
+
+    return ts->tv_sec * NS_PER_S + ts->tv_nsec;
+} // evpl_socket_timestamp
+
+static inline int
+evpl_socket_is_timestamp(const struct cmsghdr *cm)
+{
+    return cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPING;
+} // evpl_socket_is_timestamp
+
+/*
+ * Report a transmit timestamp from the error queue.  The kernel numbers
+ * sends with 32 bit ids, bytes on TCP and messages on UDP, which we
+ * extend to a count of everything sent on the bind.
+ */
+static inline void
+evpl_socket_sent_timestamp(
+    struct evpl        *evpl,
+    struct evpl_socket *s,
+    uint32_t            id,
+    uint64_t            timestamp)
+{
+    struct evpl_bind  *bind = evpl_private2bind(s);
+    struct evpl_notify notify;
+
+    s->tx_ts_count += (uint32_t) (id + 1 - (uint32_t) s->tx_ts_count);
+
+    if (!bind->notify_callback) {
+        return;
+    }
+
+    notify.notify_type    = EVPL_NOTIFY_SENT_TIMESTAMP;
+    notify.notify_status  = 0;
+    notify.sent.bytes     = bind->protocol->stream ? s->tx_ts_count : 0;
+    notify.sent.msgs      = bind->protocol->stream ? 0 : s->tx_ts_count;
+    notify.sent.timestamp = timestamp;
+
+    bind->notify_callback(evpl, bind, &notify, bind->private_data);
+} // evpl_socket_sent_timestamp
+
+typedef void (*evpl_socket_zerocopy_callback_t)(
+    struct evpl        *evpl,
+    struct evpl_socket *s,
+    uint32_t            last_id);
+
+/*
+ * Drain the socket error queue, passing zero copy completions to the
+ * callback and reporting transmit timestamps.  Returns the number of
+ * entries processed, or -1 if the queue held a real error.
+ */
+static inline int
+evpl_socket_errqueue_reap(
+    struct evpl                    *evpl,
+    struct evpl_socket             *s,
+    evpl_socket_zerocopy_callback_t zerocopy_complete)
+{
+    struct sock_extended_err *serr;
+    struct cmsghdr           *cm;
+    struct msghdr             msg;
+    char                      control[256];
+    uint64_t                  timestamp;
+    int                       rc, n = 0;
+
+    while (1) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        rc = recvmsg(s->fd, &msg, MSG_ERRQUEUE);
+
+        if (rc < 0) {
+            break;
+        }
+
+        timestamp = 0;
+
+        for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+
+            /* The timestamp precedes the error describing which send it is */
+            if (evpl_socket_is_timestamp(cm)) {
+                timestamp = evpl_socket_timestamp(cm);
+                continue;
+            }
+
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 &&
+                   cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+
+            serr = (struct sock_extended_err *) CMSG_DATA(cm);
+
+            if (serr->ee_errno == ENOMSG &&
+                serr->ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+                if (s->timestamping) {
+                    evpl_socket_sent_timestamp(evpl, s, serr->ee_data,
+                                               timestamp);
+                }
+            } else if (serr->ee_errno == 0 &&
+                       serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY &&
+                       zerocopy_complete) {
+                zerocopy_complete(evpl, s, serr->ee_data);
+            } else {
+                return -1;
+            }
+
+            n++;
+        }
+    }
+
+    return n;
+} // evpl_socket_errqueue_reap
+
+/* Room for the control message carrying passed descriptors */
+#define EVPL_SOCKET_FDS_CONTROL CMSG_SPACE(sizeof(int) * EVPL_SOCKET_MAX_FDS)
+
+/*
+ * Attach the descriptors waiting to be sent to 'msg', using 'control',
+ * which must have room for EVPL_SOCKET_FDS_CONTROL bytes.
+ */
+static inline void
+evpl_socket_fds_attach(
+    struct evpl_socket *s,
+    struct msghdr      *msg,
+    char               *control)
+{
+    struct cmsghdr *cm;
+
+    msg->msg_control    = control;
+    msg->msg_controllen = CMSG_SPACE(sizeof(int) * s->send_nfds);
+
+    cm             = CMSG_FIRSTHDR(msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type  = SCM_RIGHTS;
+    cm->cmsg_len   = CMSG_LEN(sizeof(int) * s->send_nfds);
+
+    memcpy(CMSG_DATA(cm), s->send_fds, sizeof(int) * s->send_nfds);
+} // evpl_socket_fds_attach
+
+/* Drop our copies of the waiting descriptors, once sent or on close */
+static inline void
+evpl_socket_fds_release(struct evpl_socket *s)
+{
+    int i;
+
+    for (i = 0; i < s->send_nfds; ++i) {
+        close(s->send_fds[i]);
+    }
+
+    s->send_nfds = 0;
+} // evpl_socket_fds_release
+
+/*
+ * Report descriptors received in a control message, which then belong
+ * to the application.  Returns 1 if 'cm' carried descriptors.
+ */
+static inline int
+evpl_socket_fds_recv(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    struct cmsghdr   *cm)
+{
+    struct evpl_notify notify;
+    int                i, nfds, fd;
+
+    if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) {
+        return 0;
+    }
+
+    nfds = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+    for (i = 0; i < nfds; ++i) {
+        memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+
+        notify.notify_type   = EVPL_NOTIFY_RECV_FD;
+        notify.notify_status = 0;
+        notify.recv_fd.fd    = fd;
+
+        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    }
+
+    return 1;
+} // evpl_socket_fds_recv
+
 static inline void
 evpl_socket_init(
     struct evpl        *evpl,
@@ -98,6 +362,7 @@ evpl_socket_init(
 
     s->fd        = fd;
     s->connected = connected;
+    s->hangup    = 0;
 
 
     flags = fcntl(s->fd, F_GETFL, 0);
@@ -135,17 +400,7 @@ evpl_socket_close(
     struct evpl_socket          *s = evpl_bind_private(bind);
     struct evpl_socket_datagram *datagram;
 
-    if (s->recv1.length) {
-        evpl_iovec_release(&s->recv1);
-        s->recv1.length = 0;
-    }
-
-    if (s->recv2.length) {
-        evpl_iovec_release(&s->recv2);
-        s->recv2.length = 0;
-    }
-
-    if (bind->protocol->id == EVPL_DATAGRAM_SOCKET_UDP) {
+    if (!bind->protocol->connected) {
         struct evpl_dgram *dgram;
 
         while ((dgram = evpl_dgram_ring_tail(&bind->dgram_send)) != NULL) {
@@ -154,6 +409,8 @@ evpl_socket_close(
         }
     }
 
+    evpl_socket_fds_release(s);
+
     while (s->free_datagrams) {
         datagram = s->free_datagrams;
         LL_DELETE(s->free_datagrams, datagram);
@@ -161,6 +418,14 @@ evpl_socket_close(
         evpl_free(datagram);
     }
 
+    if (s->zerocopy) {
+        /* Every send has completed, or pending close would have lingered */
+        evpl_iovec_ring_clear(evpl, &s->zc_held);
+        evpl_iovec_ring_free(&s->zc_held);
+        evpl_dgram_ring_free(&s->zc_sends);
+        s->zerocopy = 0;
+    }
+
 } /* evpl_tcp_close_conn */
 
 static inline void
@@ -2,6 +2,8 @@
 //
 // SPDX-License-Identifier: LGPL
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +14,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <poll.h>
+#include <sys/sendfile.h>
 
 #include "core/internal.h"
 #include "evpl/evpl.h"
@@ -23,6 +27,9 @@
 #include "core/socket/common.h"
 #include "core/socket/tcp.h"
 
+/* The most the kernel will move in a single sendfile call */
+#define EVPL_SOCKET_SENDFILE_MAX 0x7ffff000
+
 static inline void
 evpl_check_conn(
     struct evpl        *evpl,
@@ -51,6 +58,267 @@ evpl_check_conn(
 
 } /* evpl_check_conn */
 
+static void
+evpl_socket_tcp_zerocopy_init(struct evpl_socket *s)
+{
+    int rc, yes = 1;
+
+    if (!evpl_shared->config->socket_zerocopy) {
+        return;
+    }
+
+    rc = setsockopt(s->fd, SOL_SOCKET, SO_ZEROCOPY, &yes, sizeof(yes));
+
+    if (rc) {
+        evpl_socket_debug("SO_ZEROCOPY unavailable, copying sends: %s",
+                          strerror(errno));
+        return;
+    }
+
+    s->zerocopy   = 1;
+    s->zc_next_id = 0;
+    s->zc_done_id = 0;
+
+    evpl_iovec_ring_alloc(&s->zc_held,
+                          evpl_shared->config->iovec_ring_size,
+                          evpl_shared->config->page_size);
+
+    evpl_dgram_ring_alloc(&s->zc_sends,
+                          evpl_shared->config->dgram_ring_size,
+                          evpl_shared->config->page_size);
+} /* evpl_socket_tcp_zerocopy_init */
+
+/*
+ * Take our own references on the first 'length' bytes of the send ring,
+ * which the kernel may still read after they are consumed from the ring.
+ */
+static void
+evpl_socket_tcp_zerocopy_hold(
+    struct evpl_socket *s,
+    struct evpl_bind   *bind,
+    ssize_t             length)
+{
+    struct evpl_iovec *iovec = evpl_iovec_ring_tail(&bind->iovec_send);
+    struct evpl_iovec  held;
+    struct evpl_dgram *send;
+    int                niov = 0;
+
+    while (length) {
+        held = *iovec;
+
+        if (held.length > length) {
+            held.length = length;
+        }
+
+        evpl_iovec_incref(&held);
+        evpl_iovec_ring_add(&s->zc_held, &held);
+
+        length -= held.length;
+        niov++;
+
+        iovec = evpl_iovec_ring_next(&bind->iovec_send, iovec);
+    }
+
+    send         = evpl_dgram_ring_add(&s->zc_sends);
+    send->niov   = niov;
+    send->length = 0;
+    send->addr   = NULL;
+
+    s->zc_next_id++;
+} /* evpl_socket_tcp_zerocopy_hold */
+
+static void
+evpl_socket_tcp_zerocopy_complete(
+    struct evpl        *evpl,
+    struct evpl_socket *s,
+    uint32_t            last_id)
+{
+    struct evpl_dgram *send;
+    struct evpl_iovec  held;
+    int                i;
+
+    /* TCP completes sends in order, so release up to and including last_id */
+    while (s->zc_done_id != last_id + 1 &&
+           !evpl_dgram_ring_is_empty(&s->zc_sends)) {
+
+        send = evpl_dgram_ring_tail(&s->zc_sends);
+
+        for (i = 0; i < send->niov; ++i) {
+            held = *evpl_iovec_ring_tail(&s->zc_held);
+            evpl_iovec_ring_remove(&s->zc_held);
+            evpl_iovec_release(&held);
+        }
+
+        evpl_dgram_ring_remove(&s->zc_sends);
+
+        s->zc_done_id++;
+    }
+} /* evpl_socket_tcp_zerocopy_complete */
+
+/*
+ * A zero copy socket whose bind closed while the kernel still held some
+ * of its sends.  It keeps the descriptor open so completions can still
+ * be read from the error queue, and keeps the references on the send
+ * buffers until the last of them arrives.
+ */
+struct evpl_socket_linger {
+    struct evpl_socket   s;
+    struct evpl_deferral close_deferral;
+};
+
+static void
+evpl_socket_tcp_linger_close(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_socket_linger *linger = private_data;
+    struct evpl_socket        *s      = &linger->s;
+
+    evpl_remove_event(evpl, &s->event);
+    close(s->fd);
+
+    evpl_iovec_ring_free(&s->zc_held);
+    evpl_dgram_ring_free(&s->zc_sends);
+    evpl_free(linger);
+
+    evpl->num_lingering--;
+} /* evpl_socket_tcp_linger_close */
+
+static void
+evpl_socket_tcp_linger_error(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct evpl_socket        *s = evpl_event_socket(event);
+    struct evpl_socket_linger *linger;
+    socklen_t                  len;
+    int                        err;
+
+    linger = container_of(s, struct evpl_socket_linger, s);
+
+    /* A failed connection still completes every send as it is dropped */
+    while (evpl_socket_errqueue_reap(evpl, s,
+                                     evpl_socket_tcp_zerocopy_complete) < 0) {
+    }
+
+    len = sizeof(err);
+    getsockopt(s->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+
+    evpl_event_clear_error(event);
+
+    /* The event may still be on the active list, so free it later */
+    if (evpl_dgram_ring_is_empty(&s->zc_sends)) {
+        evpl_defer(evpl, &linger->close_deferral);
+    }
+} /* evpl_socket_tcp_linger_error */
+
+static void
+evpl_socket_tcp_linger_ignore(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+} /* evpl_socket_tcp_linger_ignore */
+
+/*
+ * Hand the descriptor and outstanding zero copy sends of a closing bind
+ * to a lingering socket, so the bind can be recycled without releasing
+ * pages the kernel may still transmit from.
+ */
+static void
+evpl_socket_tcp_linger(
+    struct evpl        *evpl,
+    struct evpl_socket *s)
+{
+    struct evpl_socket_linger *linger = evpl_zalloc(sizeof(*linger));
+    struct evpl_socket        *ls     = &linger->s;
+
+    evpl_remove_event(evpl, &s->event);
+
+    /* Let the peer see the end of the stream now rather than at close */
+    shutdown(s->fd, SHUT_WR);
+
+    ls->fd         = s->fd;
+    ls->zerocopy   = 1;
+    ls->zc_next_id = s->zc_next_id;
+    ls->zc_done_id = s->zc_done_id;
+    ls->zc_held    = s->zc_held;
+    ls->zc_sends   = s->zc_sends;
+
+    ls->event.fd             = ls->fd;
+    ls->event.read_callback  = evpl_socket_tcp_linger_ignore;
+    ls->event.write_callback = evpl_socket_tcp_linger_ignore;
+    ls->event.error_callback = evpl_socket_tcp_linger_error;
+
+    evpl_deferral_init(&linger->close_deferral,
+                       evpl_socket_tcp_linger_close, linger);
+
+    evpl_add_event(evpl, &ls->event);
+
+    evpl->num_lingering++;
+
+    /* The bind's rings now belong to the lingering socket */
+    memset(&s->zc_held, 0, sizeof(s->zc_held));
+    memset(&s->zc_sends, 0, sizeof(s->zc_sends));
+
+    s->zerocopy = 0;
+    s->fd       = -1;
+
+    /* Completions may have arrived before the descriptor was registered */
+    evpl_event_mark_error(evpl, &ls->event);
+} /* evpl_socket_tcp_linger */
+
+/*
+ * While a framed message is only partly received, have the kernel hold off
+ * waking us until the rest has arrived rather than for every segment.  The
+ * kernel caps the value at half the receive buffer on its own.
+ */
+static inline void
+evpl_socket_tcp_set_rcvlowat(
+    struct evpl_socket *s,
+    int                 lowat)
+{
+    int rc;
+
+    if (lowat == s->rcvlowat || !evpl_shared->config->socket_tcp_rcvlowat) {
+        return;
+    }
+
+    rc = setsockopt(s->fd, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat));
+
+    if (unlikely(rc)) {
+        evpl_socket_debug("Failed to set SO_RCVLOWAT: %s", strerror(errno));
+        return;
+    }
+
+    s->rcvlowat = lowat;
+} /* evpl_socket_tcp_set_rcvlowat */
+
+/* Write with the descriptors waiting to be passed attached */
+static ssize_t
+evpl_socket_tcp_send_fds(
+    struct evpl_socket *s,
+    struct iovec       *iov,
+    int                 niov)
+{
+    struct msghdr msg;
+    char          control[EVPL_SOCKET_FDS_CONTROL];
+    ssize_t       res;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = niov;
+
+    evpl_socket_fds_attach(s, &msg, control);
+
+    res = sendmsg(s->fd, &msg, MSG_NOSIGNAL);
+
+    if (res > 0) {
+        evpl_socket_fds_release(s);
+    }
+
+    return res;
+} /* evpl_socket_tcp_send_fds */
+
 void
 evpl_socket_tcp_read(
     struct evpl       *evpl,
@@ -58,9 +326,14 @@ evpl_socket_tcp_read(
 {
     struct evpl_socket *s    = evpl_event_socket(event);
     struct evpl_bind   *bind = evpl_private2bind(s);
-    struct evpl_iovec  *iovec;
+    struct evpl_iovec  *iovec, *stage;
     struct evpl_notify  notify;
     struct iovec        iov[2];
+    struct msghdr       msg;
+    struct cmsghdr     *cm;
+    char                control[EVPL_SOCKET_TIMESTAMP_CONTROL +
+                                EVPL_SOCKET_FDS_CONTROL];
+    uint64_t            timestamp = 0;
     ssize_t             res, total, remain;
     int                 length, niov, i;
 
@@ -70,27 +343,59 @@ evpl_socket_tcp_read(
 
     evpl_check_conn(evpl, bind, s);
 
-    if (s->recv1.length == 0) {
-        if (s->recv2.length) {
-            s->recv1        = s->recv2;
-            s->recv2.length = 0;
+    /*
+     * Receive into staging buffers shared by every socket on this thread,
+     * taking references only on the bytes actually read, so that idle
+     * sockets do not pin receive buffers of their own.
+     */
+
+    stage = evpl->recv_stage;
+
+    if (stage[0].length == 0) {
+        if (stage[1].length) {
+            stage[0]        = stage[1];
+            stage[1].length = 0;
         } else {
-            evpl_iovec_alloc_whole(evpl, &s->recv1);
+            evpl_iovec_alloc_whole(evpl, &stage[0]);
         }
     }
 
-    if (s->recv2.length == 0) {
-        evpl_iovec_alloc_whole(evpl, &s->recv2);
+    if (stage[1].length == 0) {
+        evpl_iovec_alloc_whole(evpl, &stage[1]);
     }
 
-    iov[0].iov_base = s->recv1.data;
-    iov[0].iov_len  = s->recv1.length;
-    iov[1].iov_base = s->recv2.data;
-    iov[1].iov_len  = s->recv2.length;
+    iov[0].iov_base = stage[0].data;
+    iov[0].iov_len  = stage[0].length;
+    iov[1].iov_base = stage[1].data;
+    iov[1].iov_len  = stage[1].length;
 
     total = iov[0].iov_len + iov[1].iov_len;
 
-    res = readv(s->fd, iov, 2);
+    if ((s->timestamping & EVPL_TIMESTAMP_RX) || s->pass_fds) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov        = iov;
+        msg.msg_iovlen     = 2;
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        res = recvmsg(s->fd, &msg, MSG_CMSG_CLOEXEC);
+
+        for (cm = CMSG_FIRSTHDR(&msg); res > 0 && cm;
+             cm = CMSG_NXTHDR(&msg, cm)) {
+            if (evpl_socket_is_timestamp(cm)) {
+                timestamp = evpl_socket_timestamp(cm);
+            } else if (s->pass_fds) {
+                evpl_socket_fds_recv(evpl, bind, cm);
+            }
+        }
+
+        if (unlikely(res > 0 && (msg.msg_flags & MSG_CTRUNC))) {
+            evpl_socket_error("Control data truncated, passed descriptors "
+                              "may have been dropped");
+        }
+    } else {
+        res = readv(s->fd, iov, 2);
+    }
 
     if (res < 0) {
         if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -102,13 +407,13 @@ evpl_socket_tcp_read(
         goto out;
     }
 
-    if (s->recv1.length >= res) {
-        evpl_iovec_ring_append(evpl, &bind->iovec_recv, &s->recv1, res);
+    if (stage[0].length >= res) {
+        evpl_iovec_ring_append(evpl, &bind->iovec_recv, &stage[0], res);
     } else {
-        remain = res - s->recv1.length;
-        evpl_iovec_ring_append(evpl, &bind->iovec_recv, &s->recv1,
-                               s->recv1.length);
-        evpl_iovec_ring_append(evpl, &bind->iovec_recv, &s->recv2, remain);
+        remain = res - stage[0].length;
+        evpl_iovec_ring_append(evpl, &bind->iovec_recv, &stage[0],
+                               stage[0].length);
+        evpl_iovec_ring_append(evpl, &bind->iovec_recv, &stage[1], remain);
     }
 
     if (bind->segment_callback) {
@@ -132,11 +437,12 @@ evpl_socket_tcp_read(
             niov = evpl_iovec_ring_copyv(evpl, iovec, &bind->iovec_recv,
                                          length);
 
-            notify.notify_type     = EVPL_NOTIFY_RECV_MSG;
-            notify.recv_msg.iovec  = iovec;
-            notify.recv_msg.niov   = niov;
-            notify.recv_msg.length = length;
-            notify.recv_msg.addr   = bind->remote;
+            notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+            notify.recv_msg.iovec     = iovec;
+            notify.recv_msg.niov      = niov;
+            notify.recv_msg.length    = length;
+            notify.recv_msg.addr      = bind->remote;
+            notify.recv_msg.timestamp = timestamp;
 
             bind->notify_callback(evpl, bind, &notify, bind->private_data);
 
@@ -146,32 +452,63 @@ evpl_socket_tcp_read(
 
         }
 
+        /* Unix sockets wake us for any data whatever the low water mark */
+        if (bind->protocol->id == EVPL_STREAM_SOCKET_TCP) {
+            evpl_socket_tcp_set_rcvlowat(s, length ? length -
+                                         evpl_iovec_ring_bytes(&bind->iovec_recv) :
+                                         1);
+        }
+
     } else {
-        notify.notify_type   = EVPL_NOTIFY_RECV_DATA;
-        notify.notify_status = 0;
+        notify.notify_type         = EVPL_NOTIFY_RECV_DATA;
+        notify.notify_status       = 0;
+        notify.recv_data.timestamp = timestamp;
         bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+        if (evpl_bind_recv_full(bind)) {
+            /* Leave the rest in the socket until the application catches up */
+            bind->flags |= EVPL_BIND_RECV_PAUSED;
+            evpl_event_read_disinterest(evpl, event);
+        }
     }
 
  out:
 
-    if (res < total) {
+    /*
+     * Unix sockets end a read early where passed descriptors are attached,
+     * so with those only running dry means there is nothing left.  After a
+     * hangup we keep reading until the end of the stream closes the bind.
+     */
+    if (res < total && (res < 0 || !(s->pass_fds || s->hangup))) {
         evpl_event_mark_unreadable(event);
     }
 
 } /* evpl_read_tcp */
 
+void
+evpl_socket_tcp_resume_recv(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_socket *s = evpl_bind_private(bind);
+
+    evpl_event_read_interest(evpl, &s->event);
+} /* evpl_socket_tcp_resume_recv */
+
 void
 evpl_socket_tcp_write(
     struct evpl       *evpl,
     struct evpl_event *event)
 {
-    struct evpl_socket *s    = evpl_event_socket(event);
-    struct evpl_bind   *bind = evpl_private2bind(s);
-    struct evpl_notify  notify;
-    struct iovec       *iov;
-    int                 maxiov = evpl_shared->config->max_num_iovec;
-    int                 niov, niov_sent, msg_sent = 0;
-    ssize_t             res, total;
+    struct evpl_socket   *s    = evpl_event_socket(event);
+    struct evpl_bind     *bind = evpl_private2bind(s);
+    struct evpl_sendfile *sf   = bind->sendfile;
+    struct iovec         *iov;
+    struct msghdr         msg;
+    int                   maxiov = evpl_shared->config->max_num_iovec;
+    int                   niov, msg_sent = 0, zerocopy = 0;
+    ssize_t               res, total;
+    off_t                 offset;
 
     if (unlikely(s->fd < 0)) {
         return;
@@ -181,14 +518,48 @@ evpl_socket_tcp_write(
 
     evpl_check_conn(evpl, bind, s);
 
-    niov = evpl_iovec_ring_iov(&total, iov, maxiov, &bind->iovec_send);
+    if (sf && sf->gap == 0) {
+        /* Everything queued ahead of this file range has been written */
+        offset = sf->offset;
+        total  = sf->length < EVPL_SOCKET_SENDFILE_MAX ?
+            sf->length : EVPL_SOCKET_SENDFILE_MAX;
+
+        res = sendfile(s->fd, sf->fd, &offset, total);
+
+        goto written;
+    }
+
+    sf = NULL;
+
+    niov = evpl_iovec_ring_iov_limit(&total, iov, maxiov, &bind->iovec_send,
+                                     evpl_bind_sendfile_limit(bind));
 
     if (!niov) {
         res = 0;
         goto out;
     }
 
-    res = writev(s->fd, iov, niov);
+    if (unlikely(s->send_nfds)) {
+        res = evpl_socket_tcp_send_fds(s, iov, niov);
+    } else if (s->zerocopy &&
+               total >= evpl_shared->config->socket_zerocopy_min) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = niov;
+
+        res = sendmsg(s->fd, &msg, MSG_ZEROCOPY);
+
+        if (res >= 0) {
+            zerocopy = 1;
+        } else if (errno == ENOBUFS) {
+            /* Out of optmem for pinning pages, fall back to copying */
+            res = writev(s->fd, iov, niov);
+        }
+    } else {
+        res = writev(s->fd, iov, niov);
+    }
+
+ written:
 
     if (res < 0) {
         if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -200,42 +571,37 @@ evpl_socket_tcp_write(
         goto out;
     }
 
-    niov_sent = evpl_iovec_ring_consume(evpl, &bind->iovec_send, res);
+    if (sf) {
+        sf->offset += res;
+        sf->length -= res;
 
-    if (bind->segment_callback) {
-        while (niov_sent) {
-            struct evpl_dgram *dgram = evpl_dgram_ring_tail(&bind->dgram_send);
+        if (sf->length == 0) {
+            evpl_bind_sendfile_done(evpl, bind);
+        }
+    } else {
+        if (zerocopy) {
+            evpl_socket_tcp_zerocopy_hold(s, bind, res);
+        }
 
-            if (!dgram) {
-                break;
-            }
+        evpl_iovec_ring_consume(evpl, &bind->iovec_send, res);
 
-            if (dgram->niov > niov_sent) {
-                dgram->niov -= niov_sent;
-                break;
-            }
-
-            niov_sent -= dgram->niov;
-            msg_sent++;
-            evpl_dgram_ring_remove(&bind->dgram_send);
-        }
+        evpl_bind_sendfile_advance(bind, res);
     }
 
+    /* Small sends may share iovecs, so messages are retired by length */
+    msg_sent = evpl_dgram_ring_consume(&bind->dgram_send, res);
+
     if (res != total) {
         evpl_event_mark_unwritable(event);
     }
 
-    if (res && (bind->flags & EVPL_BIND_SENT_NOTIFY)) {
-        notify.notify_type   = EVPL_NOTIFY_SENT;
-        notify.notify_status = 0;
-        notify.sent.bytes    = res;
-        notify.sent.msgs     = msg_sent;
-        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    if (res) {
+        evpl_bind_sent(evpl, bind, res, msg_sent);
     }
 
  out:
 
-    if (evpl_iovec_ring_is_empty(&bind->iovec_send)) {
+    if (evpl_bind_send_empty(bind)) {
         evpl_event_write_disinterest(evpl, event);
 
         if (bind->flags & EVPL_BIND_FINISH) {
@@ -256,14 +622,69 @@ evpl_socket_tcp_error(
 {
     struct evpl_socket *s    = evpl_event_socket(event);
     struct evpl_bind   *bind = evpl_private2bind(s);
+    struct pollfd       pfd;
+    socklen_t           len;
+    int                 rc, err = 0;
 
     if (unlikely(s->fd < 0)) {
         return;
     }
 
+    if ((s->zerocopy || (s->timestamping & EVPL_TIMESTAMP_TX)) &&
+        evpl_socket_errqueue_reap(evpl, s,
+                                  evpl_socket_tcp_zerocopy_complete) < 0) {
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    len = sizeof(err);
+    rc  = getsockopt(s->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+
+    if (rc == 0 && err == 0) {
+        /* Only send completions, timestamps or a hangup were pending */
+        evpl_event_clear_error(event);
+
+        pfd.fd      = s->fd;
+        pfd.events  = POLLRDHUP;
+        pfd.revents = 0;
+
+        if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLRDHUP | POLLHUP))) {
+            /*
+             * Data may still be queued ahead of the hangup, and with edge
+             * triggering nothing will report it again, so read on until
+             * the end of the stream closes the bind.
+             */
+            s->hangup = 1;
+            evpl_event_mark_readable(evpl, event);
+        }
+        return;
+    }
+
     evpl_close(evpl, bind);
 } /* evpl_error_tcp */
 
+static void
+evpl_socket_tcp_pending_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_socket *s = evpl_bind_private(bind);
+
+    if (s->zerocopy && s->fd >= 0) {
+        /* Collect whatever completions have arrived before closing */
+        evpl_socket_errqueue_reap(evpl, s, evpl_socket_tcp_zerocopy_complete);
+
+        if (!evpl_dgram_ring_is_empty(&s->zc_sends)) {
+            evpl_event_read_disinterest(evpl, &s->event);
+            evpl_event_write_disinterest(evpl, &s->event);
+            evpl_socket_tcp_linger(evpl, s);
+            return;
+        }
+    }
+
+    evpl_socket_pending_close(evpl, bind);
+} /* evpl_socket_tcp_pending_close */
+
 void
 evpl_socket_tcp_connect(
     struct evpl      *evpl,
@@ -288,6 +709,11 @@ evpl_socket_tcp_connect(
 
     evpl_socket_abort_if(rc, "Failed to set TCP_QUICKACK on socket");
 
+    evpl_socket_tcp_zerocopy_init(s);
+    evpl_socket_timestamping_init(s);
+
+    s->rcvlowat = 1;
+
     s->event.fd             = s->fd;
     s->event.read_callback  = evpl_socket_tcp_read;
     s->event.write_callback = evpl_socket_tcp_write;
@@ -318,6 +744,11 @@ evpl_socket_tcp_attach(
 
     evpl_socket_abort_if(rc, "Failed to set TCP_QUICKACK on socket");
 
+    evpl_socket_tcp_zerocopy_init(s);
+    evpl_socket_timestamping_init(s);
+
+    s->rcvlowat = 1;
+
     s->event.fd             = fd;
     s->event.read_callback  = evpl_socket_tcp_read;
     s->event.write_callback = evpl_socket_tcp_write;
@@ -404,14 +835,18 @@ evpl_socket_tcp_listen(
 } /* evpl_socket_tcp_listen */
 
 struct evpl_protocol evpl_socket_tcp = {
-    .id            = EVPL_STREAM_SOCKET_TCP,
-    .connected     = 1,
-    .stream        = 1,
-    .name          = "STREAM_SOCKET_TCP",
-    .connect       = evpl_socket_tcp_connect,
-    .pending_close = evpl_socket_pending_close,
-    .close         = evpl_socket_close,
-    .listen        = evpl_socket_tcp_listen,
-    .attach        = evpl_socket_tcp_attach,
-    .flush         = evpl_socket_flush,
+    .id                = EVPL_STREAM_SOCKET_TCP,
+    .connected         = 1,
+    .stream            = 1,
+    .name              = "STREAM_SOCKET_TCP",
+    .bind_private_size = sizeof(struct evpl_socket),
+    .coalesce_sends    = 1,
+    .sendfile          = 1,
+    .connect           = evpl_socket_tcp_connect,
+    .pending_close     = evpl_socket_tcp_pending_close,
+    .close             = evpl_socket_close,
+    .listen            = evpl_socket_tcp_listen,
+    .attach            = evpl_socket_tcp_attach,
+    .flush             = evpl_socket_flush,
+    .resume_recv       = evpl_socket_tcp_resume_recv,
 };
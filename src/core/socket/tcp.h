@@ -5,5 +5,35 @@
 #pragma once
 
 struct evpl_protocol;
+struct evpl_event;
+struct evpl_bind;
+struct evpl;
 
 extern struct evpl_protocol evpl_socket_tcp;
+
+/* Shared with unix stream sockets */
+
+void
+evpl_socket_tcp_read(
+    struct evpl       *evpl,
+    struct evpl_event *event);
+
+void
+evpl_socket_tcp_write(
+    struct evpl       *evpl,
+    struct evpl_event *event);
+
+void
+evpl_socket_tcp_error(
+    struct evpl       *evpl,
+    struct evpl_event *event);
+
+void
+evpl_socket_tcp_resume_recv(
+    struct evpl      *evpl,
+    struct evpl_bind *bind);
+
+void
+evpl_accept_tcp(
+    struct evpl       *evpl,
+    struct evpl_event *event);
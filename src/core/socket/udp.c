@@ -12,6 +12,7 @@
 #include <sys/socket.h>
 #include <netdb.h>
 #include <arpa/inet.h>
+#include <netinet/udp.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -26,6 +27,22 @@
 #include "core/socket/common.h"
 #include "core/socket/udp.h"
 
+/* Largest UDP payload over IPv4, and over IPv6 */
+#define EVPL_SOCKET_UDP_MAX_PAYLOAD   65507
+#define EVPL_SOCKET_UDP_GSO_MAX_BYTES 65487
+
+/* Most segments the kernel accepts in one UDP_SEGMENT send */
+#define EVPL_SOCKET_UDP_GSO_MAX_SEGS  64
+
+static inline int
+evpl_socket_udp_same_addr(
+    const struct evpl_address *a,
+    const struct evpl_address *b)
+{
+    return a == b ||
+           (a->addrlen == b->addrlen && memcmp(a->addr, b->addr, a->addrlen) == 0);
+} // evpl_socket_udp_same_addr
+
 void
 evpl_socket_udp_read(
     struct evpl       *evpl,
@@ -39,9 +56,15 @@ evpl_socket_udp_read(
     struct mmsghdr               *msgvecs, *msgvec;
     struct sockaddr_storage      *sockaddrs;
     struct evpl_address          *addr;
+    struct evpl_iovec             segment;
+    struct cmsghdr               *cm;
     struct iovec                 *iov;
+    char                         *control = NULL;
     ssize_t                       res;
     int                           i, nmsg = evpl_shared->config->max_datagram_batch;
+    int                           control_len = 0;
+    unsigned int                  offset, seg_size;
+    uint64_t                      timestamp;
 
     if (unlikely(s->fd < 0)) {
         return;
@@ -52,6 +75,22 @@ evpl_socket_udp_read(
     sockaddrs = alloca(sizeof(struct sockaddr_storage) * nmsg);
     iov       = alloca(sizeof(struct iovec) * nmsg);
 
+    if (s->gro) {
+        control_len += CMSG_SPACE(sizeof(int));
+    }
+
+    if (s->timestamping & EVPL_TIMESTAMP_RX) {
+        control_len += EVPL_SOCKET_TIMESTAMP_CONTROL;
+    }
+
+    if (s->pass_fds) {
+        control_len += EVPL_SOCKET_FDS_CONTROL;
+    }
+
+    if (control_len) {
+        control = alloca(control_len * nmsg);
+    }
+
     for (i = 0; i < nmsg; ++i) {
         msgvec = &msgvecs[i];
 
@@ -65,8 +104,8 @@ evpl_socket_udp_read(
         msghdr->msg_namelen    = sizeof(sockaddrs[i]);
         msghdr->msg_iov        = iov;
         msghdr->msg_iovlen     = 1;
-        msghdr->msg_control    = NULL;
-        msghdr->msg_controllen = 0;
+        msghdr->msg_control    = control ? control + i * control_len : NULL;
+        msghdr->msg_controllen = control ? control_len : 0;
         msghdr->msg_flags      = 0;
 
         iov->iov_base = datagram->iovec.data;
@@ -75,7 +114,8 @@ evpl_socket_udp_read(
         iov++;
     }
 
-    res = recvmmsg(s->fd, msgvecs, nmsg, MSG_NOSIGNAL | MSG_DONTWAIT, NULL);
+    res = recvmmsg(s->fd, msgvecs, nmsg,
+                   MSG_NOSIGNAL | MSG_DONTWAIT | MSG_CMSG_CLOEXEC, NULL);
 
     if (res < 0) {
         if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -89,25 +129,47 @@ evpl_socket_udp_read(
 
     for (i = 0; i < res; ++i) {
 
-        datagram = datagrams[i];
-        msghdr   = &msgvecs[i].msg_hdr;
+        datagram  = datagrams[i];
+        msghdr    = &msgvecs[i].msg_hdr;
+        seg_size  = msgvecs[i].msg_len;
+        timestamp = 0;
+
+        /* A GRO receive holds a run of datagrams of seg_size bytes each */
+        for (cm = CMSG_FIRSTHDR(msghdr); cm; cm = CMSG_NXTHDR(msghdr, cm)) {
+            if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+                memcpy(&seg_size, CMSG_DATA(cm), sizeof(int));
+            } else if (evpl_socket_is_timestamp(cm)) {
+                timestamp = evpl_socket_timestamp(cm);
+            } else if (s->pass_fds) {
+                evpl_socket_fds_recv(evpl, bind, cm);
+            }
+        }
+
+        addr = evpl_address_intern(evpl, msghdr->msg_name,
+                                   msghdr->msg_namelen);
 
-        addr = evpl_address_alloc();
+        for (offset = 0; offset < msgvecs[i].msg_len; offset += seg_size) {
 
-        memcpy(addr->addr, msghdr->msg_name,  msghdr->msg_namelen);
-        addr->addrlen = msghdr->msg_namelen;
+            /* Each datagram is a slice sharing the slot's buffer reference */
+            segment         = datagram->iovec;
+            segment.data   += offset;
+            segment.length  = msgvecs[i].msg_len - offset;
 
-        notify.notify_type   = EVPL_NOTIFY_RECV_MSG;
-        notify.notify_status = 0;
+            if (segment.length > seg_size) {
+                segment.length = seg_size;
+            }
 
-        datagram->iovec.length =  msgvecs[i].msg_len;
+            notify.notify_type   = EVPL_NOTIFY_RECV_MSG;
+            notify.notify_status = 0;
 
-        notify.recv_msg.iovec  = &datagram->iovec;
-        notify.recv_msg.niov   = 1;
-        notify.recv_msg.length = msgvecs[i].msg_len;
-        notify.recv_msg.addr   = addr;
+            notify.recv_msg.iovec     = &segment;
+            notify.recv_msg.niov      = 1;
+            notify.recv_msg.length    = segment.length;
+            notify.recv_msg.addr      = addr;
+            notify.recv_msg.timestamp = timestamp;
 
-        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+            bind->notify_callback(evpl, bind, &notify, bind->private_data);
+        }
 
         evpl_iovec_release(&datagram->iovec);
         evpl_socket_datagram_reload(evpl, s, datagram);
@@ -131,18 +193,23 @@ evpl_socket_udp_write(
     struct evpl       *evpl,
     struct evpl_event *event)
 {
-    struct evpl_socket *s    = evpl_event_socket(event);
-    struct evpl_bind   *bind = evpl_private2bind(s);
-    struct evpl_iovec  *iovec;
-    struct evpl_dgram  *dgram;
-    struct evpl_notify  notify;
-    struct iovec       *iov;
-    int                 nmsg = 0, nmsgleft, i;
-    int                 maxmsg = evpl_shared->config->max_datagram_batch;
-    int                 maxiov = evpl_shared->config->max_num_iovec;
-    struct msghdr      *msghdr;
-    struct mmsghdr     *msgvec;
-    ssize_t             res, total;
+    struct evpl_socket  *s    = evpl_event_socket(event);
+    struct evpl_bind    *bind = evpl_private2bind(s);
+    struct evpl_iovec   *iovec;
+    struct evpl_dgram   *dgram;
+    struct evpl_address *addr;
+    struct cmsghdr      *cm;
+    struct iovec        *iov, *msg_iov;
+    int                  nmsg, nmsgleft, msgs_sent, i, niov, nseg, *ndgram;
+    int                  maxmsg = evpl_shared->config->max_datagram_batch;
+    int                  maxiov = evpl_shared->config->max_num_iovec;
+    int                  control_len = CMSG_SPACE(sizeof(uint16_t));
+    int                  seg_size, last_size, max_seg;
+    char                *control;
+    char                 fds_control[EVPL_SOCKET_FDS_CONTROL];
+    struct msghdr       *msghdr;
+    struct mmsghdr      *msgvec;
+    ssize_t              res, total, bytes;
 
     if (unlikely(s->fd < 0)) {
         return;
@@ -151,43 +218,119 @@ evpl_socket_udp_write(
     dgram = evpl_dgram_ring_tail(&bind->dgram_send);
 
     if (!dgram) {
-        res = -1;
+        res  = -1;
+        nmsg = 0;
         goto out;
     }
 
-    msgvec = alloca(sizeof(struct mmsghdr) * maxmsg);
+    msgvec  = alloca(sizeof(struct mmsghdr) * maxmsg);
+    ndgram  = alloca(sizeof(int) * maxmsg);
+    control = alloca(control_len * maxmsg);
 
     iov = alloca(sizeof(struct iovec) * maxmsg * maxiov);
 
+ again:
+
+    nmsg    = 0;
+    max_seg = 0;
+    msg_iov = iov;
+
+    dgram = evpl_dgram_ring_tail(&bind->dgram_send);
     iovec = evpl_iovec_ring_tail(&bind->iovec_send);
 
     while (dgram && nmsg < maxmsg) {
 
         msghdr = &msgvec[nmsg].msg_hdr;
+        addr   = dgram->addr;
 
-        msghdr->msg_name       = dgram->addr->addr;
-        msghdr->msg_namelen    = dgram->addr->addrlen;
-        msghdr->msg_iov        = iov;
-        msghdr->msg_iovlen     = dgram->niov;
+        msghdr->msg_name       = addr->addr;
+        msghdr->msg_namelen    = addr->addrlen;
+        msghdr->msg_iov        = msg_iov;
         msghdr->msg_control    = NULL;
         msghdr->msg_controllen = 0;
         msghdr->msg_flags      = 0;
 
-        for (i = 0; i < dgram->niov; ++i) {
-            iov->iov_base = iovec->data;
-            iov->iov_len  = iovec->length;
-            iov++;
-            iovec = evpl_iovec_ring_next(&bind->iovec_send, iovec);
+        seg_size  = dgram->length;
+        last_size = seg_size;
+        niov      = 0;
+        nseg      = 0;
+        bytes     = 0;
+
+        /*
+         * With GSO, datagrams of the same size to the same destination
+         * go out as one message which the kernel splits into segments.
+         * Only the last segment of a run may be shorter than the rest.
+         */
+        do {
+            if (nseg && niov + dgram->niov > maxiov) {
+                break;
+            }
+
+            for (i = 0; i < dgram->niov; ++i) {
+                msg_iov->iov_base = iovec->data;
+                msg_iov->iov_len  = iovec->length;
+                msg_iov++;
+                iovec = evpl_iovec_ring_next(&bind->iovec_send, iovec);
+            }
+
+            niov     += dgram->niov;
+            bytes    += dgram->length;
+            last_size = dgram->length;
+            nseg++;
+
+            dgram = evpl_dgram_ring_next(&bind->dgram_send, dgram);
+
+        } while (dgram &&
+                 seg_size <= s->gso &&
+                 last_size == seg_size &&
+                 dgram->length <= seg_size &&
+                 nseg < EVPL_SOCKET_UDP_GSO_MAX_SEGS &&
+                 bytes + dgram->length <= EVPL_SOCKET_UDP_GSO_MAX_BYTES &&
+                 evpl_socket_udp_same_addr(dgram->addr, addr));
+
+        msghdr->msg_iovlen = niov;
+
+        if (nseg > 1) {
+            msghdr->msg_control    = control + nmsg * control_len;
+            msghdr->msg_controllen = control_len;
+
+            cm             = CMSG_FIRSTHDR(msghdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type  = UDP_SEGMENT;
+            cm->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+
+            *(uint16_t *) CMSG_DATA(cm) = seg_size;
+
+            if (seg_size > max_seg) {
+                max_seg = seg_size;
+            }
         }
 
-        dgram = evpl_dgram_ring_next(&bind->dgram_send, dgram);
+        ndgram[nmsg] = nseg;
 
         nmsg++;
     }
 
+    /* Descriptors waiting to be passed go with the first datagram */
+    if (unlikely(s->send_nfds)) {
+        evpl_socket_fds_attach(s, &msgvec[0].msg_hdr, fds_control);
+    }
 
     res = sendmmsg(s->fd, msgvec, nmsg, MSG_NOSIGNAL | MSG_DONTWAIT);
 
+    if (res < 0 && max_seg) {
+        if (errno == EINVAL) {
+            /* Segment too large for the path, stop coalescing at this size */
+            s->gso = max_seg - 1;
+            goto again;
+        } else if (errno == EIO) {
+            /* No checksum offload on the egress device */
+            evpl_socket_debug("UDP GSO unavailable, sending datagrams singly");
+            s->gso = 0;
+            goto again;
+        }
+    }
+
     if (res < 0) {
         if (errno != EAGAIN && errno != EWOULDBLOCK) {
             evpl_close(evpl, bind);
@@ -195,18 +338,29 @@ evpl_socket_udp_write(
         goto out;
     }
 
-    nmsgleft = res;
+    if (unlikely(s->send_nfds) && res > 0) {
+        evpl_socket_fds_release(s);
+    }
+
+    nmsgleft  = res;
+    msgs_sent = 0;
+    total     = 0;
 
-    while (nmsgleft) {
-        dgram = evpl_dgram_ring_tail(&bind->dgram_send);
+    for (i = 0; i < nmsgleft; ++i) {
+        total += msgvec[i].msg_len;
 
-        evpl_address_release(dgram->addr);
+        while (ndgram[i]) {
+            dgram = evpl_dgram_ring_tail(&bind->dgram_send);
 
-        evpl_iovec_ring_consumev(evpl, &bind->iovec_send, dgram->niov);
+            evpl_address_release(dgram->addr);
 
-        evpl_dgram_ring_remove(&bind->dgram_send);
+            evpl_iovec_ring_consumev(evpl, &bind->iovec_send, dgram->niov);
 
-        --nmsgleft;
+            evpl_dgram_ring_remove(&bind->dgram_send);
+
+            ndgram[i]--;
+            msgs_sent++;
+        }
     }
 
     if (evpl_dgram_ring_is_empty(&bind->dgram_send)) {
@@ -217,19 +371,8 @@ evpl_socket_udp_write(
         }
     }
 
-    if (res > 0 && (bind->flags & EVPL_BIND_SENT_NOTIFY)) {
-
-        total = 0;
-
-        for (i = 0; i < res; ++i) {
-            total += msgvec[i].msg_len;
-        }
-
-        notify.notify_type   = EVPL_NOTIFY_SENT;
-        notify.notify_status = 0;
-        notify.sent.bytes    = total;
-        notify.sent.msgs     = res;
-        bind->notify_callback(evpl, bind, &notify, bind->private_data);
+    if (res > 0) {
+        evpl_bind_sent(evpl, bind, total, msgs_sent);
     }
 
  out:
@@ -245,6 +388,15 @@ evpl_socket_udp_error(
     struct evpl       *evpl,
     struct evpl_event *event)
 {
+    struct evpl_socket *s = evpl_event_socket(event);
+
+    if (s->fd >= 0 && (s->timestamping & EVPL_TIMESTAMP_TX) &&
+        evpl_socket_errqueue_reap(evpl, s, NULL) >= 0) {
+        /* Only transmit timestamps were pending */
+        evpl_event_clear_error(event);
+        return;
+    }
+
     evpl_socket_debug("udp socket error");
 } /* evpl_error_udp */
 
@@ -254,7 +406,8 @@ evpl_socket_udp_bind(
     struct evpl_bind *evbind)
 {
     struct evpl_socket     *s = evpl_bind_private(evbind);
-    int                     flags, rc;
+    int                     flags, rc, val, yes = 1;
+    socklen_t               len;
 
     if (unlikely(s->fd < 0)) {
         return;
@@ -284,6 +437,33 @@ evpl_socket_udp_bind(
 
     evpl_socket_abort_if(rc, "Failed to bind socket: %s", strerror(errno));
 
+    s->gso = 0;
+    s->gro = 0;
+
+    /*
+     * Transmit timestamps are numbered per send call, so with coalescing
+     * they could not be matched to the datagrams they cover
+     */
+    if (evpl_shared->config->socket_udp_gso &&
+        !(evpl_shared->config->socket_timestamping & EVPL_TIMESTAMP_TX)) {
+        len = sizeof(val);
+        rc  = getsockopt(s->fd, SOL_UDP, UDP_SEGMENT, &val, &len);
+
+        if (rc == 0) {
+            s->gso = EVPL_SOCKET_UDP_GSO_MAX_BYTES;
+        }
+    }
+
+    /* Coalesced receives may be up to a full UDP payload long */
+    if (evpl_shared->config->socket_udp_gro &&
+        evpl_shared->config->max_datagram_size >= EVPL_SOCKET_UDP_MAX_PAYLOAD) {
+        rc = setsockopt(s->fd, SOL_UDP, UDP_GRO, &yes, sizeof(yes));
+
+        if (rc == 0) {
+            s->gro = 1;
+        }
+    }
+
 #if 0
     rc = getsockname(s->fd, (struct sockaddr *) &addr, &addrlen);
 
@@ -296,6 +476,8 @@ evpl_socket_udp_bind(
     }
 #endif /* if 0 */
 
+    evpl_socket_timestamping_init(s);
+
     evpl_socket_init(evpl, s, s->fd, 0);
 
     s->event.fd             = s->fd;
@@ -308,12 +490,13 @@ evpl_socket_udp_bind(
 } /* evpl_socket_udp_bind */
 
 struct evpl_protocol evpl_socket_udp = {
-    .id            = EVPL_DATAGRAM_SOCKET_UDP,
-    .connected     = 0,
-    .stream        = 0,
-    .name          = "DATAGRAM_SOCKET_UDP",
-    .bind          = evpl_socket_udp_bind,
-    .pending_close = evpl_socket_pending_close,
-    .close         = evpl_socket_close,
-    .flush         = evpl_socket_flush,
+    .id                = EVPL_DATAGRAM_SOCKET_UDP,
+    .connected         = 0,
+    .stream            = 0,
+    .name              = "DATAGRAM_SOCKET_UDP",
+    .bind_private_size = sizeof(struct evpl_socket),
+    .bind              = evpl_socket_udp_bind,
+    .pending_close     = evpl_socket_pending_close,
+    .close             = evpl_socket_close,
+    .flush             = evpl_socket_flush,
 };
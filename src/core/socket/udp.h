@@ -5,5 +5,24 @@
 #pragma once
 
 struct evpl_protocol;
+struct evpl_event;
+struct evpl;
 
 extern struct evpl_protocol evpl_socket_udp;
+
+/* Shared with unix datagram sockets */
+
+void
+evpl_socket_udp_read(
+    struct evpl       *evpl,
+    struct evpl_event *event);
+
+void
+evpl_socket_udp_write(
+    struct evpl       *evpl,
+    struct evpl_event *event);
+
+void
+evpl_socket_udp_error(
+    struct evpl       *evpl,
+    struct evpl_event *event);
@@ -0,0 +1,245 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/buffer.h"
+#include "core/endpoint.h"
+#include "core/bind.h"
+#include "core/protocol.h"
+
+#include "core/socket/common.h"
+#include "core/socket/tcp.h"
+#include "core/socket/udp.h"
+#include "core/socket/unix.h"
+
+/*
+ * Unix sockets move data through the same paths as TCP and UDP sockets,
+ * they differ only in how they are set up and in passing descriptors.
+ */
+
+static void
+evpl_socket_unix_init(
+    struct evpl        *evpl,
+    struct evpl_socket *s,
+    int                 fd,
+    int                 connected)
+{
+    evpl_socket_init(evpl, s, fd, connected);
+
+    s->pass_fds     = evpl_shared->config->socket_unix_pass_fds;
+    s->send_nfds    = 0;
+    s->timestamping = 0;
+} /* evpl_socket_unix_init */
+
+/* A socket left behind in the filesystem by an earlier listener */
+static void
+evpl_socket_unix_unlink_stale(const struct evpl_address *address)
+{
+    const struct sockaddr_un *sun = (const struct sockaddr_un *) address->addr;
+    struct stat               st;
+
+    if (address->addrlen <= offsetof(struct sockaddr_un, sun_path) ||
+        sun->sun_path[0] == '\0') {
+        return;
+    }
+
+    if (stat(sun->sun_path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(sun->sun_path);
+    }
+} /* evpl_socket_unix_unlink_stale */
+
+static int
+evpl_socket_unix_send_fd(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    int               fd)
+{
+    struct evpl_socket *s = evpl_bind_private(bind);
+    int                 dupfd;
+
+    if (!s->pass_fds) {
+        return ENOTSUP;
+    }
+
+    if (s->send_nfds == EVPL_SOCKET_MAX_FDS) {
+        return ENOBUFS;
+    }
+
+    dupfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+
+    evpl_socket_abort_if(dupfd < 0, "Failed to dup passed fd: %s",
+                         strerror(errno));
+
+    s->send_fds[s->send_nfds++] = dupfd;
+
+    return 0;
+} /* evpl_socket_unix_send_fd */
+
+static void
+evpl_socket_unix_stream_connect(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_socket *s = evpl_bind_private(bind);
+    int                 rc;
+
+    s->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    evpl_socket_abort_if(s->fd < 0, "Failed to create unix socket: %s",
+                         strerror(errno));
+
+    rc = connect(s->fd, bind->remote->addr, bind->remote->addrlen);
+
+    evpl_socket_unix_init(evpl, s, s->fd, 0);
+
+    s->event.fd             = s->fd;
+    s->event.read_callback  = evpl_socket_tcp_read;
+    s->event.write_callback = evpl_socket_tcp_write;
+    s->event.error_callback = evpl_socket_tcp_error;
+
+    evpl_add_event(evpl, &s->event);
+
+    if (rc) {
+        /* Unlike TCP, a connection that fails does so at once */
+        evpl_socket_debug("Failed to connect unix socket: %s", strerror(errno));
+        evpl_close(evpl, bind);
+        return;
+    }
+
+    evpl_event_read_interest(evpl, &s->event);
+    evpl_event_write_interest(evpl, &s->event);
+} /* evpl_socket_unix_stream_connect */
+
+static void
+evpl_socket_unix_stream_attach(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    void             *accepted)
+{
+    struct evpl_socket          *s               = evpl_bind_private(bind);
+    struct evpl_accepted_socket *accepted_socket = accepted;
+    int                          fd              = accepted_socket->fd;
+
+    evpl_free(accepted_socket);
+
+    evpl_socket_unix_init(evpl, s, fd, 1);
+
+    s->event.fd             = fd;
+    s->event.read_callback  = evpl_socket_tcp_read;
+    s->event.write_callback = evpl_socket_tcp_write;
+    s->event.error_callback = evpl_socket_tcp_error;
+
+    evpl_add_event(evpl, &s->event);
+    evpl_event_read_interest(evpl, &s->event);
+} /* evpl_socket_unix_stream_attach */
+
+static void
+evpl_socket_unix_stream_listen(
+    struct evpl      *evpl,
+    struct evpl_bind *listen_bind)
+{
+    struct evpl_socket *s = evpl_bind_private(listen_bind);
+    int                 rc;
+
+    s->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    evpl_socket_abort_if(s->fd < 0, "Failed to create unix listen socket: %s",
+                         strerror(errno));
+
+    evpl_socket_unix_unlink_stale(listen_bind->local);
+
+    rc = bind(s->fd, listen_bind->local->addr, listen_bind->local->addrlen);
+
+    evpl_socket_abort_if(rc < 0, "Failed to bind unix listen socket: %s",
+                         strerror(errno));
+
+    rc = listen(s->fd, evpl_shared->config->max_pending);
+
+    evpl_socket_fatal_if(rc, "Failed to listen on listener fd");
+
+    s->event.fd            = s->fd;
+    s->event.read_callback = evpl_accept_tcp;
+
+    evpl_add_event(evpl, &s->event);
+    evpl_event_read_interest(evpl, &s->event);
+} /* evpl_socket_unix_stream_listen */
+
+static void
+evpl_socket_unix_datagram_bind(
+    struct evpl      *evpl,
+    struct evpl_bind *evbind)
+{
+    struct evpl_socket *s = evpl_bind_private(evbind);
+    int                 rc;
+
+    s->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    evpl_socket_abort_if(s->fd < 0, "Failed to create unix socket: %s",
+                         strerror(errno));
+
+    evpl_socket_unix_unlink_stale(evbind->local);
+
+    rc = bind(s->fd, evbind->local->addr, evbind->local->addrlen);
+
+    evpl_socket_abort_if(rc, "Failed to bind unix socket: %s", strerror(errno));
+
+    /* Datagrams are never coalesced on unix sockets */
+    s->gso = 0;
+    s->gro = 0;
+
+    evpl_socket_unix_init(evpl, s, s->fd, 0);
+
+    s->event.fd             = s->fd;
+    s->event.read_callback  = evpl_socket_udp_read;
+    s->event.write_callback = evpl_socket_udp_write;
+    s->event.error_callback = evpl_socket_udp_error;
+
+    evpl_add_event(evpl, &s->event);
+    evpl_event_read_interest(evpl, &s->event);
+} /* evpl_socket_unix_datagram_bind */
+
+struct evpl_protocol evpl_socket_unix_datagram = {
+    .id                = EVPL_DATAGRAM_SOCKET_UNIX,
+    .connected         = 0,
+    .stream            = 0,
+    .name              = "DATAGRAM_SOCKET_UNIX",
+    .bind_private_size = sizeof(struct evpl_socket),
+    .bind              = evpl_socket_unix_datagram_bind,
+    .pending_close     = evpl_socket_pending_close,
+    .close             = evpl_socket_close,
+    .flush             = evpl_socket_flush,
+    .send_fd           = evpl_socket_unix_send_fd,
+};
+
+struct evpl_protocol evpl_socket_unix_stream = {
+    .id                = EVPL_STREAM_SOCKET_UNIX,
+    .connected         = 1,
+    .stream            = 1,
+    .name              = "STREAM_SOCKET_UNIX",
+    .bind_private_size = sizeof(struct evpl_socket),
+    .coalesce_sends    = 1,
+    .sendfile          = 1,
+    .connect           = evpl_socket_unix_stream_connect,
+    .pending_close     = evpl_socket_pending_close,
+    .close             = evpl_socket_close,
+    .listen            = evpl_socket_unix_stream_listen,
+    .attach            = evpl_socket_unix_stream_attach,
+    .flush             = evpl_socket_flush,
+    .resume_recv       = evpl_socket_tcp_resume_recv,
+    .send_fd           = evpl_socket_unix_send_fd,
+};
@@ -0,0 +1,10 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#pragma once
+
+struct evpl_protocol;
+
+extern struct evpl_protocol evpl_socket_unix_datagram;
+extern struct evpl_protocol evpl_socket_unix_stream;
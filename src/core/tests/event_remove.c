@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+/*
+ * Two events become readable in the same wait, and whichever is handled
+ * first removes the other.  The removed one is still on the thread's
+ * active list at that point, and must not be called back again.
+ */
+
+struct test_event {
+    struct evpl_event  event; /* must be first */
+    int                calls;
+    int                removed;
+    struct test_event *other;
+};
+
+static void
+read_callback(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct test_event *te = (struct test_event *) event;
+    uint64_t           value;
+
+    evpl_test_abort_if(te->removed, "removed event was called back");
+
+    te->calls++;
+
+    if (read(event->fd, &value, sizeof(value)) != sizeof(value)) {
+        evpl_event_mark_unreadable(event);
+    }
+
+    if (!te->other->removed) {
+        evpl_remove_event(evpl, &te->other->event);
+        te->other->removed = 1;
+    }
+} /* read_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct test_event          events[2];
+    uint64_t                   one = 1;
+    int                        i;
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    for (i = 0; i < 2; ++i) {
+        events[i].event.fd            = eventfd(0, EFD_NONBLOCK);
+        events[i].event.flags         = 0;
+        events[i].event.read_callback = read_callback;
+        events[i].calls               = 0;
+        events[i].removed             = 0;
+        events[i].other               = &events[!i];
+
+        evpl_add_event(evpl, &events[i].event);
+        evpl_event_read_interest(evpl, &events[i].event);
+    }
+
+    for (i = 0; i < 2; ++i) {
+        evpl_test_abort_if(write(events[i].event.fd, &one, sizeof(one)) !=
+                           sizeof(one), "eventfd write failed");
+    }
+
+    while (events[0].calls + events[1].calls == 0) {
+        evpl_continue(evpl);
+    }
+
+    /* A few more passes for a stale active entry to be picked up */
+    for (i = 0; i < 4; ++i) {
+        evpl_continue(evpl);
+    }
+
+    evpl_test_abort_if(events[0].removed == events[1].removed,
+                       "expected exactly one event to be removed");
+
+    for (i = 0; i < 2; ++i) {
+        if (!events[i].removed) {
+            evpl_remove_event(evpl, &events[i].event);
+        }
+        close(events[i].event.fd);
+    }
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
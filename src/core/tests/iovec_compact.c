@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <string.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+#define LONG_LIVED_SIZE (64 * 1024)
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    struct evpl_global_config *config;
+    struct evpl               *evpl;
+    struct evpl_iovec          iov, long_iov, big_iov;
+    struct evpl_iovec_usage    usage, long_usage;
+    const char                 msg[] = "filehandle";
+    int                        niov, n;
+
+    /* A threshold beyond the long lived buffer size must not be trusted */
+    config = evpl_global_config_init();
+    evpl_global_config_set_long_lived_buffer_size(config, LONG_LIVED_SIZE);
+    evpl_global_config_set_compact_max_length(config, 2 * LONG_LIVED_SIZE);
+    evpl_init(config);
+
+    evpl = evpl_create(NULL);
+
+    niov = evpl_iovec_alloc(evpl, sizeof(msg), 0, 1, &iov);
+
+    evpl_test_abort_if(niov != 1, "failed to allocate short lived iovec");
+
+    memcpy(iov.data, msg, sizeof(msg));
+
+    niov = evpl_iovec_alloc_lifetime(evpl, sizeof(msg), 0, 1,
+                                     EVPL_IOVEC_LIFETIME_LONG, &long_iov);
+
+    evpl_test_abort_if(niov != 1, "failed to allocate long lived iovec");
+
+    evpl_iovec_usage(&iov, &usage);
+    evpl_iovec_usage(&long_iov, &long_usage);
+
+    evpl_test_info("short lived pinned %lu allocated %lu refs %u",
+                   usage.pinned, usage.allocated, usage.refs);
+    evpl_test_info("long lived pinned %lu allocated %lu refs %u",
+                   long_usage.pinned, long_usage.allocated, long_usage.refs);
+
+    evpl_test_abort_if(long_usage.pinned >= usage.pinned,
+                       "long lived arena buffers are not smaller");
+
+    evpl_test_abort_if(usage.allocated < sizeof(msg),
+                       "allocated bytes do not cover allocation");
+
+    n = evpl_iovec_compact(evpl, &iov, 1);
+
+    evpl_test_abort_if(n != 1, "small iovec was not compacted");
+
+    evpl_test_abort_if(memcmp(iov.data, msg, sizeof(msg)),
+                       "compacted iovec contents differ");
+
+    evpl_iovec_usage(&iov, &usage);
+
+    evpl_test_abort_if(usage.pinned != long_usage.pinned,
+                       "compacted iovec not in long lived arena");
+
+    n = evpl_iovec_compact(evpl, &iov, 1);
+
+    evpl_test_abort_if(n != 0, "long lived iovec was compacted again");
+
+    niov = evpl_iovec_alloc(evpl, LONG_LIVED_SIZE + 1, 0, 1, &big_iov);
+
+    evpl_test_abort_if(niov != 1, "failed to allocate large iovec");
+
+    n = evpl_iovec_compact(evpl, &big_iov, 1);
+
+    evpl_test_abort_if(n != 0,
+                       "iovec larger than a long lived buffer was compacted");
+
+    evpl_iovec_release(&big_iov);
+
+    evpl_iovec_release(&iov);
+    evpl_iovec_release(&long_iov);
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <string.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+#define MB (1024 * 1024)
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    struct evpl            *evpl;
+    struct evpl_iovec       iov[4], big, clone;
+    struct evpl_slab_usage  usage[8];
+    const unsigned int      sizes[4] = { 4 * MB, 3 * MB, 32 * MB, 8 * MB };
+    int                     i, n, nslabs;
+
+    evpl = evpl_create(NULL);
+
+    for (i = 0; i < 4; ++i) {
+        n = evpl_iovec_alloc_contiguous(evpl, sizes[i], &iov[i]);
+
+        evpl_test_abort_if(n != 1, "failed to allocate %u contiguous bytes",
+                           sizes[i]);
+
+        evpl_test_abort_if(iov[i].length != sizes[i],
+                           "contiguous iovec has length %u not %u",
+                           iov[i].length, sizes[i]);
+
+        memset(iov[i].data, i + 1, iov[i].length);
+    }
+
+    for (i = 0; i < 4; ++i) {
+        evpl_test_abort_if(((unsigned char *) iov[i].data)[sizes[i] - 1] != i + 1,
+                           "contiguous iovec %d overlaps another", i);
+    }
+
+    nslabs = evpl_slab_usage(usage, 8);
+
+    /* An extra reference must keep the block allocated */
+    clone = iov[2];
+    evpl_iovec_addref(&clone);
+
+    for (i = 0; i < 4; ++i) {
+        evpl_iovec_release(&iov[i]);
+    }
+
+    evpl_test_abort_if(((unsigned char *) clone.data)[0] != 3,
+                       "block released while still referenced");
+
+    evpl_iovec_release(&clone);
+
+    /* With everything released the buddies must have coalesced */
+    n = evpl_iovec_alloc_contiguous(evpl, 512 * MB, &big);
+
+    evpl_test_abort_if(n != 1, "failed to allocate coalesced block");
+
+    evpl_test_abort_if(evpl_slab_usage(usage, 8) != nslabs,
+                       "coalesced allocation required a new slab");
+
+    evpl_iovec_release(&big);
+
+    n = evpl_iovec_alloc_contiguous(evpl, 0xffffffff, &big);
+
+    evpl_test_abort_if(n != 0, "oversized contiguous allocation succeeded");
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+#define NUM_IOVECS 64
+
+static struct evpl_iovec shared[NUM_IOVECS];
+
+static void *
+release_thread(void *arg)
+{
+    int i;
+
+    for (i = 0; i < NUM_IOVECS; ++i) {
+        evpl_iovec_addref(&shared[i]);
+        evpl_iovec_release(&shared[i]);
+        evpl_iovec_release(&shared[i]);
+    }
+
+    return NULL;
+} /* release_thread */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t               thread;
+    struct evpl            *evpl;
+    struct evpl_iovec       iov;
+    struct evpl_iovec_usage usage;
+    int                     i, niov;
+
+    evpl = evpl_create(NULL);
+
+    for (i = 0; i < NUM_IOVECS; ++i) {
+        niov = evpl_iovec_alloc(evpl, 4096, 0, 1, &shared[i]);
+
+        evpl_test_abort_if(niov != 1, "failed to allocate iovec");
+
+        memset(shared[i].data, i, shared[i].length);
+    }
+
+    iov = shared[0];
+    evpl_iovec_addref(&iov);
+
+    /* Every reference handed to the thread is dropped remotely */
+    pthread_create(&thread, NULL, release_thread, NULL);
+    pthread_join(thread, NULL);
+
+    evpl_iovec_usage(&iov, &usage);
+
+    evpl_test_info("after remote release refs %u", usage.refs);
+
+    evpl_test_abort_if(usage.refs < 1, "buffer lost our reference");
+
+    evpl_test_abort_if(((unsigned char *) iov.data)[0] != 0,
+                       "buffer contents changed under our reference");
+
+    /* Let the owner merge the buffers released remotely */
+    evpl_continue(evpl);
+
+    evpl_iovec_release(&iov);
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
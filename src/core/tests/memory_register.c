@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+#define REGION_SIZE (8 * 1024 * 1024)
+
+static int released;
+
+static void
+region_release(
+    void    *ptr,
+    uint64_t length,
+    void    *private_data)
+{
+    evpl_test_abort_if(length != REGION_SIZE, "released wrong length");
+    evpl_test_abort_if(private_data != &released, "released wrong private");
+
+    munmap(ptr, length);
+
+    released++;
+} /* region_release */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    struct evpl            *evpl;
+    struct evpl_memory     *memory, *overlap;
+    struct evpl_iovec       iov;
+    struct evpl_iovec_usage usage;
+    char                   *region;
+    int                     n;
+
+    evpl = evpl_create(NULL);
+
+    region = mmap(NULL, REGION_SIZE, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    evpl_test_abort_if(region == MAP_FAILED, "failed to map region");
+
+    memset(region, 'x', REGION_SIZE);
+
+    memory = evpl_memory_register(region, REGION_SIZE, region_release,
+                                  &released);
+
+    evpl_test_abort_if(!memory, "failed to register region");
+
+    overlap = evpl_memory_register(region + 4096, 4096, NULL, NULL);
+
+    evpl_test_abort_if(overlap, "overlapping registration succeeded");
+
+    n = evpl_memory_iovec(region + REGION_SIZE - 4096, 8192, &iov);
+
+    evpl_test_abort_if(n != 0, "iovec beyond registration succeeded");
+
+    n = evpl_memory_iovec(region + 65536, 4096, &iov);
+
+    evpl_test_abort_if(n != 1, "failed to wrap registered memory");
+
+    evpl_test_abort_if(iov.data != region + 65536 || iov.length != 4096,
+                       "wrapped iovec does not match request");
+
+    evpl_iovec_usage(&iov, &usage);
+
+    evpl_test_abort_if(usage.pinned != REGION_SIZE,
+                       "wrapped iovec does not pin the registration");
+
+    /* The outstanding iovec must keep the registration alive */
+    evpl_memory_unregister(memory);
+
+    evpl_test_abort_if(released, "memory released with iovec outstanding");
+
+    n = evpl_memory_iovec(region + 65536, 4096, &iov);
+
+    evpl_test_abort_if(n != 0, "lookup succeeded after unregister");
+
+    evpl_iovec_release(&iov);
+
+    evpl_test_abort_if(released != 1, "memory not released");
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <string.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+static void
+count_thread(
+    unsigned long                       thread_id,
+    const struct evpl_memory_tag_usage *tags,
+    void                               *private_data)
+{
+    int *nthreads = private_data;
+
+    evpl_test_info("thread %lu core %ld bytes in %lu allocs",
+                   thread_id, tags[EVPL_MEMORY_TAG_CORE].bytes,
+                   tags[EVPL_MEMORY_TAG_CORE].allocs);
+
+    (*nthreads)++;
+} /* count_thread */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    struct evpl                *evpl;
+    struct evpl_iovec           iov;
+    struct evpl_memory_snapshot before, during, after;
+    int                         niov, nthreads = 0;
+
+    evpl_memory_snapshot(&before);
+
+    evpl = evpl_create(NULL);
+
+    niov = evpl_iovec_alloc(evpl, 4096, 0, 1, &iov);
+
+    evpl_test_abort_if(niov != 1, "failed to allocate iovec");
+
+    evpl_memory_snapshot(&during);
+
+    evpl_test_info("slabs %lu slab bytes %lu free %lu used %lu pinned %lu",
+                   during.slabs, during.slab_bytes, during.free_buffers,
+                   during.used_buffers, during.pinned_bytes);
+
+    evpl_test_abort_if(during.tags[EVPL_MEMORY_TAG_CORE].bytes <=
+                       before.tags[EVPL_MEMORY_TAG_CORE].bytes,
+                       "evpl allocations were not accounted");
+
+    evpl_test_abort_if(during.slabs < 1, "no slabs reported");
+
+    evpl_test_abort_if(during.used_buffers < 1 || during.pinned_bytes == 0,
+                       "outstanding iovec not reported as pinned");
+
+    evpl_memory_snapshot_threads(count_thread, &nthreads);
+
+    evpl_test_abort_if(nthreads < 1, "no per-thread counters reported");
+
+    evpl_iovec_release(&iov);
+
+    evpl_destroy(evpl);
+
+    evpl_memory_snapshot(&after);
+
+    evpl_test_abort_if(after.tags[EVPL_MEMORY_TAG_CORE].bytes !=
+                       before.tags[EVPL_MEMORY_TAG_CORE].bytes,
+                       "core allocations leaked %ld bytes",
+                       after.tags[EVPL_MEMORY_TAG_CORE].bytes -
+                       before.tags[EVPL_MEMORY_TAG_CORE].bytes);
+
+    evpl_test_abort_if(after.used_buffers != 0,
+                       "%lu buffers still referenced", after.used_buffers);
+
+    return 0;
+} /* main */
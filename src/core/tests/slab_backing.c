@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    struct evpl_global_config *config = evpl_global_config_init();
+    struct evpl               *evpl;
+    struct evpl_iovec          iov;
+    struct evpl_slab_usage     usage[4];
+    int                        i, n, niov;
+
+    evpl_global_config_set_slab_backing(config, EVPL_SLAB_BACKING_THP);
+
+    evpl_init(config);
+
+    evpl = evpl_create(NULL);
+
+    niov = evpl_iovec_alloc(evpl, 4096, 0, 1, &iov);
+
+    evpl_test_abort_if(niov != 1, "failed to allocate iovec");
+
+    n = evpl_slab_usage(usage, 4);
+
+    evpl_test_abort_if(n < 1, "no slabs reported after allocation");
+
+    for (i = 0; i < n && i < 4; ++i) {
+        evpl_test_info("slab %d size %lu backing %d prefaulted %d",
+                       i, usage[i].size, usage[i].backing,
+                       usage[i].prefaulted);
+
+        /* THP falls back to regular pages but never to hugetlb */
+        evpl_test_abort_if(usage[i].backing != EVPL_SLAB_BACKING_THP &&
+                           usage[i].backing != EVPL_SLAB_BACKING_DEFAULT,
+                           "unexpected slab backing %d", usage[i].backing);
+    }
+
+    evpl_iovec_release(&iov);
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
@@ -0,0 +1,289 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#pragma once
+
+#include <net/if.h>
+#include <pthread.h>
+#include <time.h>
+#include <linux/if_xdp.h>
+
+#include "uthash/uthash.h"
+
+#include "core/internal.h"
+#include "evpl/evpl.h"
+
+#define evpl_xdp_debug(...) evpl_debug("xdp", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_xdp_info(...)  evpl_info("xdp", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_xdp_error(...) evpl_error("xdp", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_xdp_fatal(...) evpl_fatal("xdp", __FILE__, __LINE__, __VA_ARGS__)
+#define evpl_xdp_abort(...) evpl_abort("xdp", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_xdp_fatal_if(cond, ...) \
+        evpl_fatal_if(cond, "xdp", __FILE__, __LINE__, __VA_ARGS__)
+
+#define evpl_xdp_abort_if(cond, ...) \
+        evpl_abort_if(cond, "xdp", __FILE__, __LINE__, __VA_ARGS__)
+
+/*
+ * UMEM frames are page sized, the kernel places received packets
+ * XDP_PACKET_HEADROOM bytes into the frame.
+ */
+#define EVPL_XDP_FRAME_SIZE      4096
+#define EVPL_XDP_FRAME_MAX       (EVPL_XDP_FRAME_SIZE - XDP_PACKET_HEADROOM)
+
+/* Receive frames are carved from chunks allocated out of evpl buffers */
+#define EVPL_XDP_CHUNK_FRAMES    64
+#define EVPL_XDP_CHUNK_SIZE      (EVPL_XDP_FRAME_SIZE * EVPL_XDP_CHUNK_FRAMES)
+
+#define EVPL_XDP_FILL_RING_SIZE  2048
+#define EVPL_XDP_COMP_RING_SIZE  256
+#define EVPL_XDP_RX_RING_SIZE    2048
+#define EVPL_XDP_TX_RING_SIZE    256
+
+/* Transmit frames owned by each socket, one per TX ring slot */
+#define EVPL_XDP_TX_FRAMES       EVPL_XDP_TX_RING_SIZE
+
+/* Most descriptors handled per ring per pass */
+#define EVPL_XDP_BATCH           64
+
+/* Queues per interface we can steer to, the size of the XSKMAP */
+#define EVPL_XDP_MAX_QUEUES      256
+
+/* How long a datagram waits for its next hop to be resolved */
+#define EVPL_XDP_NEIGH_TIMEOUT_NS (NS_PER_S)
+#define EVPL_XDP_NEIGH_RETRY_NS   (NS_PER_S / 100)
+
+struct evpl_xdp_socket;
+
+typedef int (*evpl_xdp_poll_callback_t)(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s);
+
+/*
+ * One of the four single producer, single consumer rings shared with
+ * the kernel.  The fill and TX rings are produced by us, the RX and
+ * completion rings by the kernel.  'cached' is our private copy of
+ * the index we own.
+ */
+struct evpl_xdp_ring {
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void     *ring;
+    uint32_t  mask;
+    uint32_t  cached;
+    void     *map;
+    size_t    map_len;
+};
+
+/* An evpl slab as registered with the framework, the span of a UMEM */
+struct evpl_xdp_region {
+    void    *base;
+    uint64_t size;
+};
+
+/*
+ * A network interface with our XDP program attached.  Each socket on
+ * the interface claims one of its receive queues, the program steers
+ * IPv4 UDP packets for the socket's port to it if they arrived on
+ * that queue and passes everything else to the kernel.
+ */
+struct evpl_xdp_interface {
+    char                       name[IF_NAMESIZE];
+    int                        ifindex;
+    int                        mtu;
+    int                        num_queues;
+    uint8_t                    mac[6];
+    int                        prog_fd;
+    int                        link_fd;
+    int                        xsks_fd;
+    int                        ports_fd;
+    int                        refcnt;
+    uint64_t                   claimed[EVPL_XDP_MAX_QUEUES / 64];
+    struct evpl_xdp_interface *prev;
+    struct evpl_xdp_interface *next;
+};
+
+/* Process global state */
+struct evpl_xdp_shared {
+    pthread_mutex_t            lock;
+    struct evpl_xdp_interface *interfaces;
+};
+
+/* Next hop hardware address, cached on each evpl_address we send to */
+struct evpl_xdp_neigh {
+    uint8_t mac[6];
+};
+
+/*
+ * A chunk of receive frames, each frame is given to the kernel once.
+ * The chunk holds a reference on its buffer until every frame has come
+ * back, received packets borrow that reference while being delivered.
+ */
+struct evpl_xdp_chunk {
+    uint64_t          offset;   /* UMEM offset of the first frame */
+    struct evpl_iovec iovec;
+    int               carved;   /* frames given to the fill ring */
+    int               inflight; /* of those, not yet received */
+    UT_hash_handle    hh;
+};
+
+struct evpl_xdp_socket {
+    struct evpl_event          event; /* must be first */
+    int                        fd;
+    int                        queue;
+    int                        closing;
+    uint16_t                   port;       /* network order */
+    uint32_t                   addr;       /* network order */
+    uint16_t                   ip_id;
+    int                        max_payload;
+    struct evpl_xdp_interface *iface;
+    struct evpl_xdp_region    *region;
+    evpl_xdp_poll_callback_t   poll;
+
+    struct evpl_xdp_ring       fill;
+    struct evpl_xdp_ring       comp;
+    struct evpl_xdp_ring       rx;
+    struct evpl_xdp_ring       tx;
+
+    struct evpl_xdp_chunk     *chunks;
+    struct evpl_xdp_chunk     *carving;
+
+    struct evpl_iovec          tx_block;
+    uint64_t                   tx_offset;  /* UMEM offset of tx_block */
+    uint32_t                  *tx_free;
+    int                        num_tx_free;
+
+    struct timespec            neigh_deadline;
+    struct timespec            neigh_retry;
+    int                        neigh_waiting;
+
+    struct evpl_deferral       retry;
+
+    struct evpl_xdp_socket    *prev;
+    struct evpl_xdp_socket    *next;
+};
+
+/* Per thread state */
+struct evpl_xdp {
+    struct evpl_xdp_shared *shared;
+    struct evpl_poll       *poll;
+    struct evpl_xdp_socket *sockets;
+};
+
+#define evpl_event_xdp_socket(eventp) container_of((eventp), struct evpl_xdp_socket, event)
+
+static inline uint32_t
+evpl_xdp_ring_load(const uint32_t *index)
+{
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+} // evpl_xdp_ring_load
+
+static inline void
+evpl_xdp_ring_store(
+    uint32_t *index,
+    uint32_t  value)
+{
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+} // evpl_xdp_ring_store
+
+/* Entries we may produce into a fill or TX ring */
+static inline uint32_t
+evpl_xdp_ring_free(struct evpl_xdp_ring *ring)
+{
+    return (ring->mask + 1) - (ring->cached - evpl_xdp_ring_load(ring->consumer));
+} // evpl_xdp_ring_free
+
+/* Entries we may consume from an RX or completion ring */
+static inline uint32_t
+evpl_xdp_ring_avail(struct evpl_xdp_ring *ring)
+{
+    return evpl_xdp_ring_load(ring->producer) - ring->cached;
+} // evpl_xdp_ring_avail
+
+static inline uint64_t *
+evpl_xdp_ring_addr(
+    struct evpl_xdp_ring *ring,
+    uint32_t              index)
+{
+    return &((uint64_t *) ring->ring)[index & ring->mask];
+} // evpl_xdp_ring_addr
+
+static inline struct xdp_desc *
+evpl_xdp_ring_desc(
+    struct evpl_xdp_ring *ring,
+    uint32_t              index)
+{
+    return &((struct xdp_desc *) ring->ring)[index & ring->mask];
+} // evpl_xdp_ring_desc
+
+static inline void *
+evpl_xdp_umem(
+    struct evpl_xdp_socket *s,
+    uint64_t                offset)
+{
+    return s->region->base + offset;
+} // evpl_xdp_umem
+
+/* The receive chunk a frame was carved from */
+static inline struct evpl_xdp_chunk *
+evpl_xdp_chunk_lookup(
+    struct evpl_xdp_socket *s,
+    uint64_t                addr)
+{
+    struct evpl_xdp_chunk *chunk;
+    uint64_t               offset = addr & ~((uint64_t) EVPL_XDP_CHUNK_SIZE - 1);
+
+    HASH_FIND(hh, s->chunks, &offset, sizeof(offset), chunk);
+
+    return chunk;
+} // evpl_xdp_chunk_lookup
+
+static inline int
+evpl_xdp_ring_needs_wakeup(struct evpl_xdp_ring *ring)
+{
+    return __atomic_load_n(ring->flags, __ATOMIC_RELAXED) &
+           XDP_RING_NEED_WAKEUP;
+} // evpl_xdp_ring_needs_wakeup
+
+void
+evpl_xdp_socket_open(
+    struct evpl              *evpl,
+    struct evpl_xdp_socket   *s,
+    const struct sockaddr_in *sin,
+    evpl_xdp_poll_callback_t  poll);
+
+void
+evpl_xdp_socket_close(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s);
+
+void
+evpl_xdp_socket_release(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s);
+
+void
+evpl_xdp_socket_refill(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s);
+
+void
+evpl_xdp_socket_reap(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s);
+
+void
+evpl_xdp_socket_kick(struct evpl_xdp_socket *s);
+
+void
+evpl_xdp_chunk_received(
+    struct evpl_xdp_socket *s,
+    struct evpl_xdp_chunk  *chunk);
+
+const uint8_t *
+evpl_xdp_neigh_lookup(
+    struct evpl_xdp_socket *s,
+    struct evpl_address    *address);
@@ -0,0 +1,406 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <net/ethernet.h>
+#include <arpa/inet.h>
+
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/buffer.h"
+#include "core/endpoint.h"
+#include "core/bind.h"
+#include "core/protocol.h"
+#include "core/evpl_shared.h"
+#include "core/xdp/xdp.h"
+#include "core/xdp/common.h"
+
+#define EVPL_XDP_UDP_HDR_LEN (sizeof(struct ether_header) + \
+                              sizeof(struct iphdr) + sizeof(struct udphdr))
+
+static inline uint32_t
+evpl_xdp_csum_partial(
+    const void *data,
+    int         len,
+    uint32_t    sum)
+{
+    const uint16_t *p    = data;
+    uint16_t        last = 0;
+
+    while (len > 1) {
+        sum += *p++;
+        len -= 2;
+    }
+
+    if (len) {
+        memcpy(&last, p, 1);
+        sum += last;
+    }
+
+    return sum;
+} /* evpl_xdp_csum_partial */
+
+static inline uint16_t
+evpl_xdp_csum_fold(uint32_t sum)
+{
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return ~sum;
+} /* evpl_xdp_csum_fold */
+
+/* Checksum of a UDP header and payload with the IPv4 pseudo header */
+static inline uint16_t
+evpl_xdp_udp_csum(
+    const struct iphdr  *ip,
+    const struct udphdr *udp,
+    int                  length)
+{
+    uint32_t sum;
+
+    sum  = evpl_xdp_csum_partial(&ip->saddr, 8, 0);
+    sum += htons(IPPROTO_UDP);
+    sum += udp->len;
+
+    return evpl_xdp_csum_fold(evpl_xdp_csum_partial(udp, length, sum));
+} /* evpl_xdp_udp_csum */
+
+static void
+evpl_xdp_udp_deliver(
+    struct evpl            *evpl,
+    struct evpl_bind       *bind,
+    struct evpl_xdp_socket *s,
+    struct evpl_xdp_chunk  *chunk,
+    const struct xdp_desc  *desc)
+{
+    struct ether_header *eth = evpl_xdp_umem(s, desc->addr);
+    struct iphdr        *ip  = (struct iphdr *) (eth + 1);
+    struct udphdr       *udp = (struct udphdr *) (ip + 1);
+    struct evpl_address *addr;
+    struct evpl_iovec    payload;
+    struct evpl_notify   notify;
+    struct sockaddr_in   sin;
+    int                  ip_len, udp_len;
+
+    if (unlikely(desc->len < EVPL_XDP_UDP_HDR_LEN ||
+                 eth->ether_type != htons(ETHERTYPE_IP) ||
+                 ip->version != 4 || ip->ihl != 5)) {
+        return;
+    }
+
+    ip_len  = ntohs(ip->tot_len);
+    udp_len = ntohs(udp->len);
+
+    if (unlikely(sizeof(*eth) + ip_len > desc->len ||
+                 udp_len < sizeof(*udp) ||
+                 sizeof(*ip) + udp_len > ip_len ||
+                 udp->dest != s->port)) {
+        return;
+    }
+
+    /* A zero UDP checksum means the sender didn't compute one */
+    if (unlikely(evpl_xdp_csum_fold(evpl_xdp_csum_partial(ip, sizeof(*ip), 0)) ||
+                 (udp->check && evpl_xdp_udp_csum(ip, udp, udp_len)))) {
+        evpl_xdp_debug("Dropping datagram with bad checksum");
+        return;
+    }
+
+    memset(&sin, 0, sizeof(sin));
+
+    sin.sin_family      = AF_INET;
+    sin.sin_port        = udp->source;
+    sin.sin_addr.s_addr = ip->saddr;
+
+    addr = evpl_address_intern(evpl, (struct sockaddr *) &sin, sizeof(sin));
+
+    /* The payload borrows the reference the chunk holds on its buffer */
+    payload.data    = udp + 1;
+    payload.length  = udp_len - sizeof(*udp);
+    payload.private = chunk->iovec.private;
+
+    notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+    notify.notify_status      = 0;
+    notify.recv_msg.iovec     = &payload;
+    notify.recv_msg.niov      = 1;
+    notify.recv_msg.length    = payload.length;
+    notify.recv_msg.addr      = addr;
+    notify.recv_msg.timestamp = 0;
+
+    bind->notify_callback(evpl, bind, &notify, bind->private_data);
+
+    evpl_address_release(addr);
+} /* evpl_xdp_udp_deliver */
+
+static void
+evpl_xdp_udp_build(
+    struct evpl_xdp_socket *s,
+    struct evpl_bind       *bind,
+    struct evpl_dgram      *dgram,
+    const uint8_t          *mac,
+    void                   *frame)
+{
+    struct sockaddr_in  *sin = (struct sockaddr_in *) dgram->addr->addr;
+    struct ether_header *eth = frame;
+    struct iphdr        *ip  = (struct iphdr *) (eth + 1);
+    struct udphdr       *udp = (struct udphdr *) (ip + 1);
+    struct evpl_iovec   *iovec;
+    void                *ptr = udp + 1;
+    int                  i;
+
+    memcpy(eth->ether_dhost, mac, ETH_ALEN);
+    memcpy(eth->ether_shost, s->iface->mac, ETH_ALEN);
+    eth->ether_type = htons(ETHERTYPE_IP);
+
+    ip->version  = 4;
+    ip->ihl      = 5;
+    ip->tos      = 0;
+    ip->tot_len  = htons(sizeof(*ip) + sizeof(*udp) + dgram->length);
+    ip->id       = htons(s->ip_id++);
+    ip->frag_off = htons(IP_DF);
+    ip->ttl      = 64;
+    ip->protocol = IPPROTO_UDP;
+    ip->check    = 0;
+    ip->saddr    = s->addr;
+    ip->daddr    = sin->sin_addr.s_addr;
+
+    ip->check = evpl_xdp_csum_fold(evpl_xdp_csum_partial(ip, sizeof(*ip), 0));
+
+    udp->source = s->port;
+    udp->dest   = sin->sin_port;
+    udp->len    = htons(sizeof(*udp) + dgram->length);
+    udp->check  = 0;
+
+    iovec = evpl_iovec_ring_tail(&bind->iovec_send);
+
+    for (i = 0; i < dgram->niov; ++i) {
+        memcpy(ptr, iovec->data, iovec->length);
+        ptr  += iovec->length;
+        iovec = evpl_iovec_ring_next(&bind->iovec_send, iovec);
+    }
+
+    udp->check = evpl_xdp_udp_csum(ip, udp, sizeof(*udp) + dgram->length);
+
+    if (udp->check == 0) {
+        udp->check = 0xffff;
+    }
+} /* evpl_xdp_udp_build */
+
+/*
+ * Copy queued datagrams into transmit frames.  Datagrams wait at the
+ * head of the queue while we are out of frames or resolving their next
+ * hop, and are dropped if they can't be sent at all.
+ */
+static void
+evpl_xdp_udp_send(
+    struct evpl            *evpl,
+    struct evpl_bind       *bind,
+    struct evpl_xdp_socket *s)
+{
+    struct evpl_dgram  *dgram;
+    struct sockaddr_in *sin;
+    struct timespec     now;
+    struct xdp_desc    *desc;
+    const uint8_t      *mac;
+    uint32_t            frame;
+    uint64_t            bytes = 0;
+    int                 nmsg  = 0;
+
+    if (s->closing) {
+        return;
+    }
+
+    evpl_xdp_socket_reap(evpl, s);
+
+    while ((dgram = evpl_dgram_ring_tail(&bind->dgram_send)) != NULL) {
+
+        sin = (struct sockaddr_in *) dgram->addr->addr;
+
+        if (unlikely(sin->sin_family != AF_INET ||
+                     dgram->length > s->max_payload)) {
+            evpl_xdp_debug("Dropping %d byte datagram, limit is %d bytes to "
+                           "IPv4 destinations", dgram->length, s->max_payload);
+            goto consume;
+        }
+
+        mac = evpl_xdp_neigh_lookup(s, dgram->addr);
+
+        if (unlikely(!mac)) {
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+
+            if (!s->neigh_waiting) {
+                s->neigh_waiting  = 1;
+                s->neigh_deadline = now;
+            } else if (evpl_ts_interval(&now, &s->neigh_deadline) >
+                       EVPL_XDP_NEIGH_TIMEOUT_NS) {
+                evpl_xdp_debug("Dropping datagram, next hop unresolved");
+                s->neigh_waiting = 0;
+                goto consume;
+            }
+
+            evpl_defer(evpl, &s->retry);
+            break;
+        }
+
+        s->neigh_waiting = 0;
+
+        if (!s->num_tx_free || !evpl_xdp_ring_free(&s->tx)) {
+            evpl_defer(evpl, &s->retry);
+            break;
+        }
+
+        frame = s->tx_free[--s->num_tx_free];
+
+        desc = evpl_xdp_ring_desc(&s->tx, s->tx.cached++);
+
+        desc->addr    = s->tx_offset + frame * EVPL_XDP_FRAME_SIZE;
+        desc->len     = EVPL_XDP_UDP_HDR_LEN + dgram->length;
+        desc->options = 0;
+
+        evpl_xdp_udp_build(s, bind, dgram, mac, evpl_xdp_umem(s, desc->addr));
+
+        bytes += dgram->length;
+        nmsg++;
+
+ consume:
+        evpl_address_release(dgram->addr);
+        evpl_iovec_ring_consumev(evpl, &bind->iovec_send, dgram->niov);
+        evpl_dgram_ring_remove(&bind->dgram_send);
+    }
+
+    if (nmsg) {
+        evpl_xdp_ring_store(s->tx.producer, s->tx.cached);
+        evpl_xdp_socket_kick(s);
+        evpl_activity(evpl);
+        evpl_bind_sent(evpl, bind, bytes, nmsg);
+    }
+
+    if (evpl_dgram_ring_is_empty(&bind->dgram_send) &&
+        (bind->flags & EVPL_BIND_FINISH)) {
+        evpl_close(evpl, bind);
+    }
+} /* evpl_xdp_udp_send */
+
+static int
+evpl_xdp_udp_poll(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s)
+{
+    struct evpl_bind      *bind = evpl_private2bind(s);
+    struct evpl_xdp_chunk *chunk;
+    struct xdp_desc       *desc;
+    uint32_t               i, n;
+
+    if (s->closing) {
+        return 0;
+    }
+
+    n = evpl_xdp_ring_avail(&s->rx);
+
+    if (n > EVPL_XDP_BATCH) {
+        n = EVPL_XDP_BATCH;
+    }
+
+    for (i = 0; i < n; ++i) {
+
+        desc  = evpl_xdp_ring_desc(&s->rx, s->rx.cached + i);
+        chunk = evpl_xdp_chunk_lookup(s, desc->addr);
+
+        evpl_xdp_abort_if(!chunk, "Received into unknown frame %lx",
+                          desc->addr);
+
+        if (!(bind->flags & EVPL_BIND_PENDING_CLOSED)) {
+            evpl_xdp_udp_deliver(evpl, bind, s, chunk, desc);
+        }
+
+        evpl_xdp_chunk_received(s, chunk);
+    }
+
+    if (n) {
+        s->rx.cached += n;
+        evpl_xdp_ring_store(s->rx.consumer, s->rx.cached);
+
+        evpl_xdp_socket_refill(evpl, s);
+        evpl_activity(evpl);
+    }
+
+    if (!evpl_dgram_ring_is_empty(&bind->dgram_send)) {
+        evpl_xdp_udp_send(evpl, bind, s);
+    } else if (s->num_tx_free < EVPL_XDP_TX_FRAMES) {
+        evpl_xdp_socket_reap(evpl, s);
+    }
+
+    return n;
+} /* evpl_xdp_udp_poll */
+
+static void
+evpl_xdp_udp_retry(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_xdp_socket *s = private_data;
+
+    evpl_xdp_udp_send(evpl, evpl_private2bind(s), s);
+} /* evpl_xdp_udp_retry */
+
+static void
+evpl_xdp_udp_flush(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    evpl_xdp_udp_send(evpl, bind, evpl_bind_private(bind));
+} /* evpl_xdp_udp_flush */
+
+static void
+evpl_xdp_udp_bind(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    struct evpl_xdp_socket *s = evpl_bind_private(bind);
+
+    evpl_xdp_abort_if(bind->local->addr->sa_family != AF_INET,
+                      "XDP UDP supports IPv4 only");
+
+    evpl_deferral_init(&s->retry, evpl_xdp_udp_retry, s);
+
+    evpl_xdp_socket_open(evpl, s, (struct sockaddr_in *) bind->local->addr,
+                         evpl_xdp_udp_poll);
+} /* evpl_xdp_udp_bind */
+
+static void
+evpl_xdp_udp_pending_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    evpl_xdp_socket_close(evpl, evpl_bind_private(bind));
+} /* evpl_xdp_udp_pending_close */
+
+static void
+evpl_xdp_udp_close(
+    struct evpl      *evpl,
+    struct evpl_bind *bind)
+{
+    evpl_xdp_socket_release(evpl, evpl_bind_private(bind));
+} /* evpl_xdp_udp_close */
+
+struct evpl_protocol evpl_xdp_udp = {
+    .id                = EVPL_DATAGRAM_XDP_UDP,
+    .connected         = 0,
+    .stream            = 0,
+    .name              = "DATAGRAM_XDP_UDP",
+    .framework         = &evpl_framework_xdp,
+    .bind_private_size = sizeof(struct evpl_xdp_socket),
+    .bind              = evpl_xdp_udp_bind,
+    .pending_close     = evpl_xdp_udp_pending_close,
+    .close             = evpl_xdp_udp_close,
+    .flush             = evpl_xdp_udp_flush,
+};
@@ -0,0 +1,1118 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+#include <ifaddrs.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/route.h>
+#include <net/if_arp.h>
+#include <netpacket/packet.h>
+#include <linux/bpf.h>
+
+#include "uthash/uthash.h"
+#include "uthash/utlist.h"
+
+#include "core/internal.h"
+#include "evpl/evpl.h"
+#include "core/buffer.h"
+#include "core/endpoint.h"
+#include "core/protocol.h"
+#include "core/evpl_shared.h"
+#include "core/xdp/xdp.h"
+#include "core/xdp/common.h"
+
+extern struct evpl_shared *evpl_shared;
+
+/*
+ * The XDP program is assembled here rather than compiled from C so we
+ * need neither clang nor libbpf.  In C it reads:
+ *
+ *   if (data + 42 > data_end) return XDP_PASS;
+ *   if (eth->h_proto != htons(ETH_P_IP)) return XDP_PASS;
+ *   if (ip->version_ihl != 0x45) return XDP_PASS;
+ *   if (ip->protocol != IPPROTO_UDP) return XDP_PASS;
+ *   if (ip->frag_off & htons(IP_MF | IP_OFFMASK)) return XDP_PASS;
+ *   queue = ports[udp->dest];
+ *   if (!queue || queue - 1 != ctx->rx_queue_index) return XDP_PASS;
+ *   return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+ */
+
+#define EVPL_BPF_INSN(c, d, s, o, i) \
+        ((struct bpf_insn) { .code = (c), .dst_reg = (d), .src_reg = (s), \
+                             .off = (o), .imm = (i) })
+
+#define EVPL_BPF_MOV64_REG(d, s) \
+        EVPL_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X, d, s, 0, 0)
+#define EVPL_BPF_MOV64_IMM(d, i) \
+        EVPL_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_K, d, 0, 0, i)
+#define EVPL_BPF_ADD64_IMM(d, i) \
+        EVPL_BPF_INSN(BPF_ALU64 | BPF_ADD | BPF_K, d, 0, 0, i)
+#define EVPL_BPF_AND64_IMM(d, i) \
+        EVPL_BPF_INSN(BPF_ALU64 | BPF_AND | BPF_K, d, 0, 0, i)
+#define EVPL_BPF_LDX(size, d, s, o) \
+        EVPL_BPF_INSN(BPF_LDX | BPF_MEM | (size), d, s, o, 0)
+#define EVPL_BPF_STX(size, d, s, o) \
+        EVPL_BPF_INSN(BPF_STX | BPF_MEM | (size), d, s, o, 0)
+#define EVPL_BPF_JMP_IMM(op, d, i, o) \
+        EVPL_BPF_INSN(BPF_JMP | (op) | BPF_K, d, 0, o, i)
+#define EVPL_BPF_JMP_REG(op, d, s, o) \
+        EVPL_BPF_INSN(BPF_JMP | (op) | BPF_X, d, s, o, 0)
+#define EVPL_BPF_LD_MAP_FD(d, fd) \
+        EVPL_BPF_INSN(BPF_LD | BPF_DW | BPF_IMM, d, BPF_PSEUDO_MAP_FD, 0, fd), \
+        EVPL_BPF_INSN(0, 0, 0, 0, 0)
+#define EVPL_BPF_CALL(func) \
+        EVPL_BPF_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, func)
+#define EVPL_BPF_EXIT() \
+        EVPL_BPF_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+
+/* Index of the XDP_PASS exit, and the jump offset to it from 'pc' */
+#define EVPL_XDP_PROG_PASS  33
+#define EVPL_XDP_TO_PASS(pc) (EVPL_XDP_PROG_PASS - (pc) - 1)
+
+static inline int
+evpl_xdp_bpf(
+    int             cmd,
+    union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+} /* evpl_xdp_bpf */
+
+static int
+evpl_xdp_map_create(
+    enum bpf_map_type type,
+    const char       *name,
+    int               max_entries)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.map_type    = type;
+    attr.key_size    = sizeof(uint32_t);
+    attr.value_size  = sizeof(uint32_t);
+    attr.max_entries = max_entries;
+
+    strncpy(attr.map_name, name, sizeof(attr.map_name) - 1);
+
+    return evpl_xdp_bpf(BPF_MAP_CREATE, &attr);
+} /* evpl_xdp_map_create */
+
+static int
+evpl_xdp_map_update(
+    int      fd,
+    uint32_t key,
+    uint32_t value)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.map_fd = fd;
+    attr.key    = (uintptr_t) &key;
+    attr.value  = (uintptr_t) &value;
+    attr.flags  = BPF_ANY;
+
+    return evpl_xdp_bpf(BPF_MAP_UPDATE_ELEM, &attr);
+} /* evpl_xdp_map_update */
+
+static int
+evpl_xdp_map_delete(
+    int      fd,
+    uint32_t key)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.map_fd = fd;
+    attr.key    = (uintptr_t) &key;
+
+    return evpl_xdp_bpf(BPF_MAP_DELETE_ELEM, &attr);
+} /* evpl_xdp_map_delete */
+
+static int
+evpl_xdp_prog_load(
+    int ports_fd,
+    int xsks_fd)
+{
+    static char     log[65536];
+    union bpf_attr  attr;
+    int             fd;
+    struct bpf_insn prog[] = {
+        /*  0 */ EVPL_BPF_MOV64_REG(BPF_REG_6, BPF_REG_1),
+        /*  1 */ EVPL_BPF_LDX(BPF_W, BPF_REG_2, BPF_REG_6, 0),
+        /*  2 */ EVPL_BPF_LDX(BPF_W, BPF_REG_3, BPF_REG_6, 4),
+        /*  3 */ EVPL_BPF_MOV64_REG(BPF_REG_4, BPF_REG_2),
+        /*  4 */ EVPL_BPF_ADD64_IMM(BPF_REG_4, 42),
+        /*  5 */ EVPL_BPF_JMP_REG(BPF_JGT, BPF_REG_4, BPF_REG_3,
+                                  EVPL_XDP_TO_PASS(5)),
+        /*  6 */ EVPL_BPF_LDX(BPF_H, BPF_REG_5, BPF_REG_2, 12),
+        /*  7 */ EVPL_BPF_JMP_IMM(BPF_JNE, BPF_REG_5, 0x0008,
+                                  EVPL_XDP_TO_PASS(7)),
+        /*  8 */ EVPL_BPF_LDX(BPF_B, BPF_REG_5, BPF_REG_2, 14),
+        /*  9 */ EVPL_BPF_JMP_IMM(BPF_JNE, BPF_REG_5, 0x45,
+                                  EVPL_XDP_TO_PASS(9)),
+        /* 10 */ EVPL_BPF_LDX(BPF_B, BPF_REG_5, BPF_REG_2, 23),
+        /* 11 */ EVPL_BPF_JMP_IMM(BPF_JNE, BPF_REG_5, IPPROTO_UDP,
+                                  EVPL_XDP_TO_PASS(11)),
+        /* 12 */ EVPL_BPF_LDX(BPF_H, BPF_REG_5, BPF_REG_2, 20),
+        /* 13 */ EVPL_BPF_AND64_IMM(BPF_REG_5, 0xff3f),
+        /* 14 */ EVPL_BPF_JMP_IMM(BPF_JNE, BPF_REG_5, 0,
+                                  EVPL_XDP_TO_PASS(14)),
+        /* 15 */ EVPL_BPF_LDX(BPF_H, BPF_REG_5, BPF_REG_2, 36),
+        /* 16 */ EVPL_BPF_STX(BPF_W, BPF_REG_10, BPF_REG_5, -4),
+        /* 17 */ EVPL_BPF_MOV64_REG(BPF_REG_2, BPF_REG_10),
+        /* 18 */ EVPL_BPF_ADD64_IMM(BPF_REG_2, -4),
+        /* 19 */ EVPL_BPF_LD_MAP_FD(BPF_REG_1, ports_fd),
+        /* 21 */ EVPL_BPF_CALL(BPF_FUNC_map_lookup_elem),
+        /* 22 */ EVPL_BPF_JMP_IMM(BPF_JEQ, BPF_REG_0, 0,
+                                  EVPL_XDP_TO_PASS(22)),
+        /* 23 */ EVPL_BPF_LDX(BPF_W, BPF_REG_1, BPF_REG_0, 0),
+        /* 24 */ EVPL_BPF_JMP_IMM(BPF_JEQ, BPF_REG_1, 0,
+                                  EVPL_XDP_TO_PASS(24)),
+        /* 25 */ EVPL_BPF_ADD64_IMM(BPF_REG_1, -1),
+        /* 26 */ EVPL_BPF_LDX(BPF_W, BPF_REG_2, BPF_REG_6, 16),
+        /* 27 */ EVPL_BPF_JMP_REG(BPF_JNE, BPF_REG_1, BPF_REG_2,
+                                  EVPL_XDP_TO_PASS(27)),
+        /* 28 */ EVPL_BPF_LD_MAP_FD(BPF_REG_1, xsks_fd),
+        /* 30 */ EVPL_BPF_MOV64_IMM(BPF_REG_3, XDP_PASS),
+        /* 31 */ EVPL_BPF_CALL(BPF_FUNC_redirect_map),
+        /* 32 */ EVPL_BPF_EXIT(),
+        /* 33 */ EVPL_BPF_MOV64_IMM(BPF_REG_0, XDP_PASS),
+        /* 34 */ EVPL_BPF_EXIT(),
+    };
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns     = (uintptr_t) prog;
+    attr.insn_cnt  = sizeof(prog) / sizeof(prog[0]);
+    attr.license   = (uintptr_t) "GPL";
+
+    strncpy(attr.prog_name, "evpl_xdp", sizeof(attr.prog_name) - 1);
+
+    fd = evpl_xdp_bpf(BPF_PROG_LOAD, &attr);
+
+    if (fd < 0) {
+        /* Load it again with the verifier log to say why */
+        attr.log_buf   = (uintptr_t) log;
+        attr.log_size  = sizeof(log);
+        attr.log_level = 1;
+
+        evpl_xdp_bpf(BPF_PROG_LOAD, &attr);
+
+        evpl_xdp_error("Failed to load XDP program: %s\n%s",
+                       strerror(errno), log);
+    }
+
+    return fd;
+} /* evpl_xdp_prog_load */
+
+/* Find the interface holding an IPv4 address, and its hardware address */
+static int
+evpl_xdp_find_interface(
+    uint32_t addr,
+    char    *name,
+    uint8_t *mac)
+{
+    struct ifaddrs     *ifap, *ifa;
+    struct sockaddr_ll *sll;
+    int                 found = 0;
+
+    if (getifaddrs(&ifap)) {
+        return 0;
+    }
+
+    for (ifa = ifap; ifa; ifa = ifa->ifa_next) {
+
+        if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_INET ||
+            ((struct sockaddr_in *) ifa->ifa_addr)->sin_addr.s_addr != addr) {
+            continue;
+        }
+
+        snprintf(name, IF_NAMESIZE, "%s", ifa->ifa_name);
+        found = 1;
+        break;
+    }
+
+    for (ifa = ifap; found && ifa; ifa = ifa->ifa_next) {
+
+        if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_PACKET ||
+            strcmp(ifa->ifa_name, name)) {
+            continue;
+        }
+
+        sll = (struct sockaddr_ll *) ifa->ifa_addr;
+
+        memcpy(mac, sll->sll_addr, 6);
+        found = 2;
+        break;
+    }
+
+    freeifaddrs(ifap);
+
+    return found == 2;
+} /* evpl_xdp_find_interface */
+
+static int
+evpl_xdp_count_queues(const char *name)
+{
+    char           path[PATH_MAX];
+    DIR           *dir;
+    struct dirent *de;
+    int            n = 0;
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/queues", name);
+
+    dir = opendir(path);
+
+    if (!dir) {
+        return 1;
+    }
+
+    while ((de = readdir(dir)) != NULL) {
+        if (strncmp(de->d_name, "rx-", 3) == 0) {
+            n++;
+        }
+    }
+
+    closedir(dir);
+
+    if (n > EVPL_XDP_MAX_QUEUES) {
+        n = EVPL_XDP_MAX_QUEUES;
+    }
+
+    return n ? n : 1;
+} /* evpl_xdp_count_queues */
+
+static struct evpl_xdp_interface *
+evpl_xdp_interface_create(
+    const char    *name,
+    const uint8_t *mac)
+{
+    struct evpl_xdp_interface *iface;
+    struct ifreq               ifr;
+    union bpf_attr             attr;
+    int                        fd, rc;
+
+    iface = evpl_zalloc(sizeof(*iface));
+
+    snprintf(iface->name, sizeof(iface->name), "%s", name);
+    memcpy(iface->mac, mac, sizeof(iface->mac));
+
+    iface->ifindex = if_nametoindex(name);
+
+    evpl_xdp_abort_if(!iface->ifindex, "Failed to find interface %s", name);
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", name);
+
+    rc = ioctl(fd, SIOCGIFMTU, &ifr);
+
+    evpl_xdp_abort_if(rc, "Failed to get MTU of %s: %s", name,
+                      strerror(errno));
+
+    close(fd);
+
+    iface->mtu        = ifr.ifr_mtu;
+    iface->num_queues = evpl_xdp_count_queues(name);
+
+    iface->ports_fd = evpl_xdp_map_create(BPF_MAP_TYPE_ARRAY, "evpl_ports",
+                                          65536);
+
+    evpl_xdp_abort_if(iface->ports_fd < 0, "Failed to create port map: %s",
+                      strerror(errno));
+
+    iface->xsks_fd = evpl_xdp_map_create(BPF_MAP_TYPE_XSKMAP, "evpl_xsks",
+                                         EVPL_XDP_MAX_QUEUES);
+
+    evpl_xdp_abort_if(iface->xsks_fd < 0, "Failed to create socket map: %s",
+                      strerror(errno));
+
+    iface->prog_fd = evpl_xdp_prog_load(iface->ports_fd, iface->xsks_fd);
+
+    evpl_xdp_abort_if(iface->prog_fd < 0, "Failed to load XDP program");
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.link_create.prog_fd        = iface->prog_fd;
+    attr.link_create.target_ifindex = iface->ifindex;
+    attr.link_create.attach_type    = BPF_XDP;
+
+    iface->link_fd = evpl_xdp_bpf(BPF_LINK_CREATE, &attr);
+
+    evpl_xdp_abort_if(iface->link_fd < 0,
+                      "Failed to attach XDP program to %s: %s", name,
+                      strerror(errno));
+
+    evpl_xdp_debug("Attached XDP program to %s, mtu %d, %d queues",
+                   name, iface->mtu, iface->num_queues);
+
+    return iface;
+} /* evpl_xdp_interface_create */
+
+static void
+evpl_xdp_interface_destroy(struct evpl_xdp_interface *iface)
+{
+    /* Closing the last link reference detaches the program */
+    close(iface->link_fd);
+    close(iface->prog_fd);
+    close(iface->xsks_fd);
+    close(iface->ports_fd);
+
+    evpl_xdp_debug("Detached XDP program from %s", iface->name);
+
+    evpl_free(iface);
+} /* evpl_xdp_interface_destroy */
+
+/*
+ * Find the interface that owns a local address, attaching our program
+ * to it if no other socket has, and claim a receive queue on it.
+ */
+static struct evpl_xdp_interface *
+evpl_xdp_interface_claim(
+    struct evpl_xdp_shared *shared,
+    uint32_t                addr,
+    int                    *r_queue)
+{
+    struct evpl_xdp_interface *iface;
+    char                       name[IF_NAMESIZE], str[INET_ADDRSTRLEN];
+    uint8_t                    mac[6];
+    int                        queue;
+
+    inet_ntop(AF_INET, &addr, str, sizeof(str));
+
+    evpl_xdp_abort_if(!evpl_xdp_find_interface(addr, name, mac),
+                      "No interface has address %s", str);
+
+    pthread_mutex_lock(&shared->lock);
+
+    DL_FOREACH(shared->interfaces, iface)
+    {
+        if (strcmp(iface->name, name) == 0) {
+            break;
+        }
+    }
+
+    if (!iface) {
+        iface = evpl_xdp_interface_create(name, mac);
+        DL_APPEND(shared->interfaces, iface);
+    }
+
+    for (queue = 0; queue < iface->num_queues; ++queue) {
+        if (!(iface->claimed[queue / 64] & (1ULL << (queue % 64)))) {
+            break;
+        }
+    }
+
+    evpl_xdp_abort_if(queue == iface->num_queues,
+                      "All %d queues of %s are in use", iface->num_queues,
+                      iface->name);
+
+    iface->claimed[queue / 64] |= 1ULL << (queue % 64);
+    iface->refcnt++;
+
+    pthread_mutex_unlock(&shared->lock);
+
+    *r_queue = queue;
+
+    return iface;
+} /* evpl_xdp_interface_claim */
+
+static void
+evpl_xdp_interface_release(
+    struct evpl_xdp_shared    *shared,
+    struct evpl_xdp_interface *iface,
+    int                        queue)
+{
+    pthread_mutex_lock(&shared->lock);
+
+    iface->claimed[queue / 64] &= ~(1ULL << (queue % 64));
+
+    if (--iface->refcnt == 0) {
+        DL_DELETE(shared->interfaces, iface);
+        evpl_xdp_interface_destroy(iface);
+    }
+
+    pthread_mutex_unlock(&shared->lock);
+} /* evpl_xdp_interface_release */
+
+/* The gateway for a destination reached through 'ifname', or 0 if direct */
+static uint32_t
+evpl_xdp_route_gateway(
+    const char *ifname,
+    uint32_t    dst)
+{
+    FILE         *fp;
+    char          line[256], name[IF_NAMESIZE + 1];
+    unsigned long dest, gateway, mask, best_mask = 0;
+    unsigned int  flags;
+    uint32_t      result = 0;
+    int           found  = 0;
+
+    fp = fopen("/proc/net/route", "r");
+
+    if (!fp) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+
+        if (sscanf(line, "%16s %lx %lx %x %*d %*d %*d %lx",
+                   name, &dest, &gateway, &flags, &mask) != 5) {
+            continue;
+        }
+
+        if (strcmp(name, ifname) || !(flags & RTF_UP) ||
+            (dst & mask) != dest) {
+            continue;
+        }
+
+        if (!found || ntohl(mask) >= ntohl(best_mask)) {
+            best_mask = mask;
+            result    = (flags & RTF_GATEWAY) ? gateway : 0;
+            found     = 1;
+        }
+    }
+
+    fclose(fp);
+
+    return result;
+} /* evpl_xdp_route_gateway */
+
+static int
+evpl_xdp_arp_lookup(
+    const char *ifname,
+    uint32_t    ip,
+    uint8_t    *mac)
+{
+    FILE          *fp;
+    char           line[256], addr[64], hwaddr[64], dev[64];
+    unsigned int   hwtype, flags;
+    struct in_addr in;
+    int            found = 0;
+
+    fp = fopen("/proc/net/arp", "r");
+
+    if (!fp) {
+        return 0;
+    }
+
+    while (!found && fgets(line, sizeof(line), fp)) {
+
+        if (sscanf(line, "%63s 0x%x 0x%x %63s %*s %63s",
+                   addr, &hwtype, &flags, hwaddr, dev) != 5) {
+            continue;
+        }
+
+        if (inet_pton(AF_INET, addr, &in) != 1 || in.s_addr != ip ||
+            strcmp(dev, ifname) || !(flags & ATF_COM)) {
+            continue;
+        }
+
+        found = sscanf(hwaddr, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                       &mac[0], &mac[1], &mac[2],
+                       &mac[3], &mac[4], &mac[5]) == 6;
+    }
+
+    fclose(fp);
+
+    return found;
+} /* evpl_xdp_arp_lookup */
+
+/* Have the kernel resolve a next hop we have no entry for */
+static void
+evpl_xdp_arp_solicit(
+    const char *ifname,
+    uint32_t    ip)
+{
+    struct sockaddr_in sin;
+    int                fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (fd < 0) {
+        return;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, ifname, strlen(ifname));
+
+    memset(&sin, 0, sizeof(sin));
+
+    sin.sin_family      = AF_INET;
+    sin.sin_port        = htons(9);
+    sin.sin_addr.s_addr = ip;
+
+    sendto(fd, NULL, 0, MSG_DONTWAIT, (struct sockaddr *) &sin, sizeof(sin));
+
+    close(fd);
+} /* evpl_xdp_arp_solicit */
+
+/*
+ * Find the hardware address to send to for a destination, consulting
+ * the kernel's routing and neighbour tables.  Addresses held by another
+ * local interface resolve to that interface, so the two ends of a veth
+ * pair can reach each other.  Results are cached on the address.
+ */
+const uint8_t *
+evpl_xdp_neigh_lookup(
+    struct evpl_xdp_socket *s,
+    struct evpl_address    *address)
+{
+    struct evpl_xdp_neigh *neigh, *expected = NULL;
+    struct sockaddr_in    *sin;
+    struct timespec        now;
+    char                   name[IF_NAMESIZE];
+    uint8_t                mac[6];
+    uint32_t               nexthop;
+
+    neigh = __atomic_load_n(
+        (struct evpl_xdp_neigh **) &address->framework_private[EVPL_FRAMEWORK_XDP],
+        __ATOMIC_ACQUIRE);
+
+    if (likely(neigh)) {
+        return neigh->mac;
+    }
+
+    /* Don't reread the kernel tables on every pass while we wait */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (s->neigh_waiting &&
+        evpl_ts_interval(&now, &s->neigh_retry) < EVPL_XDP_NEIGH_RETRY_NS) {
+        return NULL;
+    }
+
+    s->neigh_retry = now;
+
+    sin = (struct sockaddr_in *) address->addr;
+
+    if (!evpl_xdp_find_interface(sin->sin_addr.s_addr, name, mac)) {
+
+        nexthop = evpl_xdp_route_gateway(s->iface->name, sin->sin_addr.s_addr);
+
+        if (!nexthop) {
+            nexthop = sin->sin_addr.s_addr;
+        }
+
+        if (!evpl_xdp_arp_lookup(s->iface->name, nexthop, mac)) {
+            evpl_xdp_arp_solicit(s->iface->name, nexthop);
+            return NULL;
+        }
+    }
+
+    neigh = evpl_zalloc(sizeof(*neigh));
+
+    memcpy(neigh->mac, mac, sizeof(neigh->mac));
+
+    /* Another thread may have resolved the same address meanwhile */
+    if (!__atomic_compare_exchange_n(
+            (struct evpl_xdp_neigh **) &address->framework_private[EVPL_FRAMEWORK_XDP],
+            &expected, neigh, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        evpl_free(neigh);
+        neigh = expected;
+    }
+
+    return neigh->mac;
+} /* evpl_xdp_neigh_lookup */
+
+static void
+evpl_xdp_ring_map(
+    int                           fd,
+    struct evpl_xdp_ring         *ring,
+    const struct xdp_ring_offset *off,
+    uint32_t                      size,
+    size_t                        entry_size,
+    off_t                         pgoff)
+{
+    ring->map_len = off->desc + size * entry_size;
+
+    ring->map = mmap(NULL, ring->map_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, pgoff);
+
+    evpl_xdp_abort_if(ring->map == MAP_FAILED, "Failed to map XDP ring: %s",
+                      strerror(errno));
+
+    ring->producer = ring->map + off->producer;
+    ring->consumer = ring->map + off->consumer;
+    ring->flags    = ring->map + off->flags;
+    ring->ring     = ring->map + off->desc;
+    ring->mask     = size - 1;
+    ring->cached   = 0;
+} /* evpl_xdp_ring_map */
+
+static inline void
+evpl_xdp_ring_unmap(struct evpl_xdp_ring *ring)
+{
+    munmap(ring->map, ring->map_len);
+} /* evpl_xdp_ring_unmap */
+
+static void
+evpl_xdp_setsockopt_int(
+    int         fd,
+    int         opt,
+    int         value,
+    const char *what)
+{
+    int rc;
+
+    rc = setsockopt(fd, SOL_XDP, opt, &value, sizeof(value));
+
+    evpl_xdp_abort_if(rc, "Failed to set XDP %s: %s", what, strerror(errno));
+} /* evpl_xdp_setsockopt_int */
+
+static struct evpl_xdp_chunk *
+evpl_xdp_chunk_alloc(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s)
+{
+    struct evpl_xdp_chunk *chunk;
+
+    chunk = evpl_zalloc(sizeof(*chunk));
+
+    evpl_iovec_alloc(evpl, EVPL_XDP_CHUNK_SIZE, EVPL_XDP_CHUNK_SIZE, 1,
+                     &chunk->iovec);
+
+    chunk->offset = chunk->iovec.data - s->region->base;
+
+    /* Frames must lie within the slab registered as our UMEM */
+    if (evpl_buffer_framework_private(evpl_iovec_buffer(&chunk->iovec),
+                                      EVPL_FRAMEWORK_XDP) != s->region) {
+        evpl_iovec_release(&chunk->iovec);
+        evpl_free(chunk);
+        return NULL;
+    }
+
+    HASH_ADD(hh, s->chunks, offset, sizeof(chunk->offset), chunk);
+
+    return chunk;
+} /* evpl_xdp_chunk_alloc */
+
+void
+evpl_xdp_chunk_received(
+    struct evpl_xdp_socket *s,
+    struct evpl_xdp_chunk  *chunk)
+{
+    if (--chunk->inflight || chunk->carved < EVPL_XDP_CHUNK_FRAMES) {
+        return;
+    }
+
+    HASH_DEL(s->chunks, chunk);
+    evpl_iovec_release(&chunk->iovec);
+    evpl_free(chunk);
+} /* evpl_xdp_chunk_received */
+
+/* Top up the fill ring with fresh frames for the kernel to receive into */
+void
+evpl_xdp_socket_refill(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s)
+{
+    struct evpl_xdp_chunk *chunk;
+    uint32_t               i, n;
+
+    n = evpl_xdp_ring_free(&s->fill);
+
+    for (i = 0; i < n; ++i) {
+
+        if (!s->carving) {
+            s->carving = evpl_xdp_chunk_alloc(evpl, s);
+
+            if (!s->carving) {
+                break;
+            }
+        }
+
+        chunk = s->carving;
+
+        *evpl_xdp_ring_addr(&s->fill, s->fill.cached++) =
+            chunk->offset + chunk->carved * EVPL_XDP_FRAME_SIZE;
+
+        chunk->inflight++;
+
+        if (++chunk->carved == EVPL_XDP_CHUNK_FRAMES) {
+            s->carving = NULL;
+        }
+    }
+
+    if (!i) {
+        return;
+    }
+
+    evpl_xdp_ring_store(s->fill.producer, s->fill.cached);
+
+    if (evpl_xdp_ring_needs_wakeup(&s->fill)) {
+        recvfrom(s->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+    }
+} /* evpl_xdp_socket_refill */
+
+/* Return transmit frames the kernel has finished with to the free stack */
+void
+evpl_xdp_socket_reap(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s)
+{
+    uint32_t i, n;
+    uint64_t addr;
+
+    n = evpl_xdp_ring_avail(&s->comp);
+
+    if (!n) {
+        return;
+    }
+
+    for (i = 0; i < n; ++i) {
+        addr = *evpl_xdp_ring_addr(&s->comp, s->comp.cached + i);
+
+        s->tx_free[s->num_tx_free++] =
+            (addr - s->tx_offset) / EVPL_XDP_FRAME_SIZE;
+    }
+
+    s->comp.cached += n;
+
+    evpl_xdp_ring_store(s->comp.consumer, s->comp.cached);
+} /* evpl_xdp_socket_reap */
+
+void
+evpl_xdp_socket_kick(struct evpl_xdp_socket *s)
+{
+    if (evpl_xdp_ring_needs_wakeup(&s->tx)) {
+        sendto(s->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+    }
+} /* evpl_xdp_socket_kick */
+
+static void
+evpl_xdp_socket_read(
+    struct evpl       *evpl,
+    struct evpl_event *event)
+{
+    struct evpl_xdp_socket *s = evpl_event_xdp_socket(event);
+
+    if (s->poll(evpl, s) < EVPL_XDP_BATCH) {
+        evpl_event_mark_unreadable(event);
+    }
+} /* evpl_xdp_socket_read */
+
+/*
+ * Create an AF_XDP socket bound to a queue of the interface owning
+ * 'sin', with its UMEM spanning the evpl slab its frames come from.
+ */
+void
+evpl_xdp_socket_open(
+    struct evpl              *evpl,
+    struct evpl_xdp_socket   *s,
+    const struct sockaddr_in *sin,
+    evpl_xdp_poll_callback_t  poll)
+{
+    struct evpl_xdp        *xdp = evpl_framework_private(evpl, EVPL_FRAMEWORK_XDP);
+    struct xdp_umem_reg     umem;
+    struct xdp_mmap_offsets off;
+    struct sockaddr_xdp     sxdp;
+    socklen_t               optlen;
+    int                     i, rc, mtu;
+
+    evpl_xdp_abort_if(evpl_shared->config->buffer_size % EVPL_XDP_CHUNK_SIZE,
+                      "Buffer size must be a multiple of %u for XDP",
+                      EVPL_XDP_CHUNK_SIZE);
+
+    s->addr = sin->sin_addr.s_addr;
+    s->port = sin->sin_port;
+    s->poll = poll;
+
+    s->iface = evpl_xdp_interface_claim(xdp->shared, s->addr, &s->queue);
+
+    mtu = s->iface->mtu;
+
+    if (mtu > EVPL_XDP_FRAME_MAX - 14) {
+        mtu = EVPL_XDP_FRAME_MAX - 14;
+    }
+
+    s->max_payload = mtu - 28;
+
+    /* The transmit frames decide which slab serves as our UMEM */
+    evpl_iovec_alloc(evpl, EVPL_XDP_TX_FRAMES * EVPL_XDP_FRAME_SIZE,
+                     EVPL_XDP_FRAME_SIZE, 1, &s->tx_block);
+
+    s->region = evpl_buffer_framework_private(evpl_iovec_buffer(&s->tx_block),
+                                              EVPL_FRAMEWORK_XDP);
+
+    evpl_xdp_abort_if(!s->region, "Slab is not registered with XDP");
+
+    s->tx_offset = s->tx_block.data - s->region->base;
+
+    s->tx_free = evpl_zalloc(sizeof(uint32_t) * EVPL_XDP_TX_FRAMES);
+
+    for (i = 0; i < EVPL_XDP_TX_FRAMES; ++i) {
+        s->tx_free[i] = EVPL_XDP_TX_FRAMES - 1 - i;
+    }
+
+    s->num_tx_free = EVPL_XDP_TX_FRAMES;
+
+    s->fd = socket(AF_XDP, SOCK_RAW, 0);
+
+    evpl_xdp_abort_if(s->fd < 0, "Failed to create AF_XDP socket: %s",
+                      strerror(errno));
+
+    memset(&umem, 0, sizeof(umem));
+
+    umem.addr       = (uintptr_t) s->region->base;
+    umem.len        = s->region->size;
+    umem.chunk_size = EVPL_XDP_FRAME_SIZE;
+    umem.headroom   = 0;
+
+    rc = setsockopt(s->fd, SOL_XDP, XDP_UMEM_REG, &umem, sizeof(umem));
+
+    evpl_xdp_abort_if(rc, "Failed to register UMEM: %s", strerror(errno));
+
+    evpl_xdp_setsockopt_int(s->fd, XDP_UMEM_FILL_RING,
+                            EVPL_XDP_FILL_RING_SIZE, "fill ring");
+    evpl_xdp_setsockopt_int(s->fd, XDP_UMEM_COMPLETION_RING,
+                            EVPL_XDP_COMP_RING_SIZE, "completion ring");
+    evpl_xdp_setsockopt_int(s->fd, XDP_RX_RING,
+                            EVPL_XDP_RX_RING_SIZE, "RX ring");
+    evpl_xdp_setsockopt_int(s->fd, XDP_TX_RING,
+                            EVPL_XDP_TX_RING_SIZE, "TX ring");
+
+    optlen = sizeof(off);
+
+    rc = getsockopt(s->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen);
+
+    evpl_xdp_abort_if(rc, "Failed to get XDP ring offsets: %s",
+                      strerror(errno));
+
+    evpl_xdp_ring_map(s->fd, &s->fill, &off.fr, EVPL_XDP_FILL_RING_SIZE,
+                      sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING);
+    evpl_xdp_ring_map(s->fd, &s->comp, &off.cr, EVPL_XDP_COMP_RING_SIZE,
+                      sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING);
+    evpl_xdp_ring_map(s->fd, &s->rx, &off.rx, EVPL_XDP_RX_RING_SIZE,
+                      sizeof(struct xdp_desc), XDP_PGOFF_RX_RING);
+    evpl_xdp_ring_map(s->fd, &s->tx, &off.tx, EVPL_XDP_TX_RING_SIZE,
+                      sizeof(struct xdp_desc), XDP_PGOFF_TX_RING);
+
+    evpl_xdp_socket_refill(evpl, s);
+
+    memset(&sxdp, 0, sizeof(sxdp));
+
+    sxdp.sxdp_family   = AF_XDP;
+    sxdp.sxdp_flags    = XDP_USE_NEED_WAKEUP;
+    sxdp.sxdp_ifindex  = s->iface->ifindex;
+    sxdp.sxdp_queue_id = s->queue;
+
+    rc = bind(s->fd, (struct sockaddr *) &sxdp, sizeof(sxdp));
+
+    evpl_xdp_abort_if(rc, "Failed to bind AF_XDP socket to %s queue %d: %s",
+                      s->iface->name, s->queue, strerror(errno));
+
+    rc = evpl_xdp_map_update(s->iface->xsks_fd, s->queue, s->fd);
+
+    evpl_xdp_abort_if(rc, "Failed to add socket to XSK map: %s",
+                      strerror(errno));
+
+    rc = evpl_xdp_map_update(s->iface->ports_fd, s->port, s->queue + 1);
+
+    evpl_xdp_abort_if(rc, "Failed to add port to port map: %s",
+                      strerror(errno));
+
+    s->event.fd            = s->fd;
+    s->event.read_callback = evpl_xdp_socket_read;
+
+    evpl_add_event(evpl, &s->event);
+    evpl_event_read_interest(evpl, &s->event);
+
+    DL_APPEND(xdp->sockets, s);
+
+    evpl_xdp_debug("Opened AF_XDP socket on %s queue %d port %u",
+                   s->iface->name, s->queue, ntohs(s->port));
+} /* evpl_xdp_socket_open */
+
+/* Stop steering packets to the socket and close it */
+void
+evpl_xdp_socket_close(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s)
+{
+    struct evpl_xdp *xdp = evpl_framework_private(evpl, EVPL_FRAMEWORK_XDP);
+
+    s->closing = 1;
+
+    evpl_remove_deferral(evpl, &s->retry);
+
+    evpl_xdp_map_update(s->iface->ports_fd, s->port, 0);
+    evpl_xdp_map_delete(s->iface->xsks_fd, s->queue);
+
+    evpl_event_read_disinterest(evpl, &s->event);
+
+    DL_DELETE(xdp->sockets, s);
+
+    close(s->fd);
+
+    s->fd = -1;
+} /* evpl_xdp_socket_close */
+
+/* Release the frames and rings of a closed socket, and its queue */
+void
+evpl_xdp_socket_release(
+    struct evpl            *evpl,
+    struct evpl_xdp_socket *s)
+{
+    struct evpl_xdp       *xdp = evpl_framework_private(evpl, EVPL_FRAMEWORK_XDP);
+    struct evpl_xdp_chunk *chunk, *tmp;
+
+    evpl_xdp_ring_unmap(&s->fill);
+    evpl_xdp_ring_unmap(&s->comp);
+    evpl_xdp_ring_unmap(&s->rx);
+    evpl_xdp_ring_unmap(&s->tx);
+
+    /* The kernel no longer holds any frames once the socket is closed */
+    HASH_ITER(hh, s->chunks, chunk, tmp)
+    {
+        HASH_DEL(s->chunks, chunk);
+        evpl_iovec_release(&chunk->iovec);
+        evpl_free(chunk);
+    }
+
+    s->carving = NULL;
+
+    evpl_iovec_release(&s->tx_block);
+    evpl_free(s->tx_free);
+
+    evpl_xdp_interface_release(xdp->shared, s->iface, s->queue);
+} /* evpl_xdp_socket_release */
+
+static void *
+evpl_xdp_init(void)
+{
+    struct evpl_xdp_shared *shared;
+
+    shared = evpl_zalloc(sizeof(*shared));
+
+    pthread_mutex_init(&shared->lock, NULL);
+
+    return shared;
+} /* evpl_xdp_init */
+
+static void
+evpl_xdp_cleanup(void *private_data)
+{
+    struct evpl_xdp_shared    *shared = private_data;
+    struct evpl_xdp_interface *iface;
+
+    while (shared->interfaces) {
+        iface = shared->interfaces;
+        DL_DELETE(shared->interfaces, iface);
+        evpl_xdp_interface_destroy(iface);
+    }
+
+    pthread_mutex_destroy(&shared->lock);
+
+    evpl_free(shared);
+} /* evpl_xdp_cleanup */
+
+static void
+evpl_xdp_poll(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_xdp        *xdp = private_data;
+    struct evpl_xdp_socket *s;
+
+    DL_FOREACH(xdp->sockets, s)
+    {
+        s->poll(evpl, s);
+    }
+} /* evpl_xdp_poll */
+
+static void *
+evpl_xdp_create(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_xdp *xdp;
+
+    xdp = evpl_zalloc(sizeof(*xdp));
+
+    xdp->shared = private_data;
+
+    xdp->poll = evpl_add_poll(evpl, NULL, NULL, evpl_xdp_poll, xdp);
+
+    return xdp;
+} /* evpl_xdp_create */
+
+static void
+evpl_xdp_destroy(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_xdp *xdp = private_data;
+
+    evpl_remove_poll(evpl, xdp->poll);
+
+    evpl_free(xdp);
+} /* evpl_xdp_destroy */
+
+/*
+ * Sockets register the slab holding their frames as UMEM when they
+ * are created, so here we only record where each slab lies.
+ */
+static void *
+evpl_xdp_register(
+    void *buffer,
+    int   size,
+    void *buffer_private,
+    void *private_data)
+{
+    struct evpl_xdp_region *region = buffer_private;
+
+    if (region) {
+        return region;
+    }
+
+    region = evpl_zalloc(sizeof(*region));
+
+    region->base = buffer;
+    region->size = size;
+
+    return region;
+} /* evpl_xdp_register */
+
+static void
+evpl_xdp_unregister(
+    void *buffer_private,
+    void *private_data)
+{
+    evpl_free(buffer_private);
+} /* evpl_xdp_unregister */
+
+static void
+evpl_xdp_release_address(
+    void *address_private,
+    void *private_data)
+{
+    evpl_free(address_private);
+} /* evpl_xdp_release_address */
+
+struct evpl_framework evpl_framework_xdp = {
+    .id                = EVPL_FRAMEWORK_XDP,
+    .name              = "XDP",
+    .init              = evpl_xdp_init,
+    .cleanup           = evpl_xdp_cleanup,
+    .create            = evpl_xdp_create,
+    .destroy           = evpl_xdp_destroy,
+    .register_memory   = evpl_xdp_register,
+    .unregister_memory = evpl_xdp_unregister,
+    .release_address   = evpl_xdp_release_address,
+};
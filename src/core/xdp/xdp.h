@@ -0,0 +1,8 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#pragma once
+
+extern struct evpl_framework evpl_framework_xdp;
+extern struct evpl_protocol  evpl_xdp_udp;
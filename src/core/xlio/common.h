@@ -179,7 +179,7 @@ evpl_xlio_buffer_alloc(
     buffer->data = data;
     buffer->size = len;
     buffer->used = len;
-    atomic_store(&buffer->refcnt, 1);
+    evpl_buffer_set_shared(buffer);
 
     buffer->external1 = xlio;
     buffer->external2 = buff;
@@ -271,9 +271,8 @@ evpl_xlio_send_completion(
     struct evpl_xlio_socket *s,
     int                      length)
 {
-    struct evpl_bind  *bind = evpl_private2bind(s);
-    struct evpl_notify notify;
-    int                msg_sent = 0;
+    struct evpl_bind *bind     = evpl_private2bind(s);
+    int               msg_sent = 0;
 
 
     if (bind->segment_callback) {
@@ -289,15 +288,7 @@ evpl_xlio_send_completion(
         }
     }
 
-    if (bind->flags & EVPL_BIND_SENT_NOTIFY) {
-
-        notify.notify_type   = EVPL_NOTIFY_SENT;
-        notify.notify_status = 0;
-        notify.sent.bytes    = length;
-        notify.sent.msgs     = msg_sent;
-
-        bind->notify_callback(evpl, bind, &notify, bind->private_data);
-    }
+    evpl_bind_sent(evpl, bind, length, msg_sent);
 } /* evpl_xlio_send_completion */
 
 void
@@ -65,7 +65,7 @@ evpl_xlio_prepare_iov(
 
         zc->buffer = iovec->private;
         zc->length = iovec->length;
-        atomic_fetch_add_explicit(&zc->buffer->refcnt, 1, memory_order_relaxed);
+        evpl_buffer_addref(zc->buffer);
 
         s->zc_pending++;
 
@@ -105,11 +105,12 @@ evpl_xlio_tcp_read(
             niov = evpl_iovec_ring_copyv(evpl, iovec, &bind->iovec_recv,
                                          length);
 
-            notify.notify_type     = EVPL_NOTIFY_RECV_MSG;
-            notify.recv_msg.iovec  = iovec;
-            notify.recv_msg.niov   = niov;
-            notify.recv_msg.length = length;
-            notify.recv_msg.addr   = bind->remote;
+            notify.notify_type        = EVPL_NOTIFY_RECV_MSG;
+            notify.recv_msg.iovec     = iovec;
+            notify.recv_msg.niov      = niov;
+            notify.recv_msg.length    = length;
+            notify.recv_msg.addr      = bind->remote;
+            notify.recv_msg.timestamp = 0;
 
             bind->notify_callback(evpl, bind, &notify, bind->private_data);
 
@@ -120,8 +121,9 @@ evpl_xlio_tcp_read(
         }
 
     } else {
-        notify.notify_type   = EVPL_NOTIFY_RECV_DATA;
-        notify.notify_status = 0;
+        notify.notify_type         = EVPL_NOTIFY_RECV_DATA;
+        notify.notify_status       = 0;
+        notify.recv_data.timestamp = 0;
         bind->notify_callback(evpl, bind, &notify, bind->private_data);
     }
 
@@ -141,7 +141,7 @@ evpl_http_request_header_alloc(struct evpl_http_agent *agent)
     if (header) {
         agent->free_headers = header->next;
     } else {
-        header = evpl_zalloc(sizeof(*header));
+        header = evpl_zalloc_tagged(sizeof(*header), EVPL_MEMORY_TAG_HTTP);
     }
 
     return header;
@@ -165,7 +165,7 @@ evpl_http_request_alloc(struct evpl_http_agent *agent)
     if (request) {
         agent->free_requests = request->next;
     } else {
-        request = evpl_zalloc(sizeof(*request));
+        request = evpl_zalloc_tagged(sizeof(*request), EVPL_MEMORY_TAG_HTTP);
         evpl_iovec_ring_alloc(&request->send_ring, 1024, 4096);
         evpl_iovec_ring_alloc(&request->recv_ring, 1024, 4096);
     }
@@ -216,7 +216,7 @@ evpl_http_init(struct evpl *evpl)
 {
     struct evpl_http_agent *agent;
 
-    agent = evpl_zalloc(sizeof(*agent));
+    agent = evpl_zalloc_tagged(sizeof(*agent), EVPL_MEMORY_TAG_HTTP);
 
     agent->evpl = evpl;
 
@@ -232,7 +232,7 @@ evpl_http_destroy(struct evpl_http_agent *agent)
     while (agent->free_headers) {
         header = agent->free_headers;
         LL_DELETE(agent->free_headers, header);
-        evpl_free(header);
+        evpl_free_tagged(header, EVPL_MEMORY_TAG_HTTP);
     }
 
     while (agent->free_requests) {
@@ -240,10 +240,10 @@ evpl_http_destroy(struct evpl_http_agent *agent)
         LL_DELETE(agent->free_requests, request);
         evpl_iovec_ring_free(&request->send_ring);
         evpl_iovec_ring_free(&request->recv_ring);
-        evpl_free(request);
+        evpl_free_tagged(request, EVPL_MEMORY_TAG_HTTP);
     }
 
-    evpl_free(agent);
+    evpl_free_tagged(agent, EVPL_MEMORY_TAG_HTTP);
 } /* evpl_http_destroy */
 
 static inline int
@@ -579,7 +579,7 @@ evpl_http_event(
         case EVPL_NOTIFY_CONNECTED:
             break;
         case EVPL_NOTIFY_DISCONNECTED:
-            free(http_conn);
+            evpl_free_tagged(http_conn, EVPL_MEMORY_TAG_HTTP);
             break;
         case EVPL_NOTIFY_RECV_DATA:
             if (http_conn->is_server) {
@@ -755,7 +755,8 @@ evpl_http_accept(
     struct evpl_http_server *server = private_data;
     struct evpl_http_conn   *http_conn;
 
-    http_conn            = evpl_zalloc(sizeof(*http_conn));
+    http_conn = evpl_zalloc_tagged(sizeof(*http_conn), EVPL_MEMORY_TAG_HTTP);
+
     http_conn->server    = server;
     http_conn->is_server = 1;
     http_conn->agent     = server->agent;
@@ -778,7 +779,7 @@ evpl_http_listen(
 {
     struct evpl_http_server *server;
 
-    server = evpl_zalloc(sizeof(*server));
+    server = evpl_zalloc_tagged(sizeof(*server), EVPL_MEMORY_TAG_HTTP);
 
     server->agent             = agent;
     server->private_data      = private_data;
@@ -800,7 +801,7 @@ evpl_http_server_destroy(
     struct evpl_http_agent  *agent,
     struct evpl_http_server *server)
 {
-    evpl_free(server);
+    evpl_free_tagged(server, EVPL_MEMORY_TAG_HTTP);
 } /* evpl_http_server_destroy */
 
 void
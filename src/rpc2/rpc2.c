@@ -16,6 +16,8 @@
 #include "evpl/evpl_rpc2_program.h"
 #include "evpl/evpl.h"
 
+#define EVPL_RPC2_DBUF_SIZE (128 * 1024)
+
 struct evpl_rpc2_server {
     int                        protocol;
     struct evpl_rpc2_agent    *agent;
@@ -40,9 +42,11 @@ evpl_rpc2_msg_alloc(struct evpl_rpc2_agent *agent)
         msg = agent->free_msg;
         LL_DELETE(agent->free_msg, msg);
     } else {
-        msg        = evpl_zalloc(sizeof(*msg));
-        msg->dbuf  = xdr_dbuf_alloc(128 * 1024);
+        msg        = evpl_zalloc_tagged(sizeof(*msg), EVPL_MEMORY_TAG_RPC2);
+        msg->dbuf  = xdr_dbuf_alloc(EVPL_RPC2_DBUF_SIZE);
         msg->agent = agent;
+
+        evpl_memory_account(EVPL_MEMORY_TAG_RPC2, EVPL_RPC2_DBUF_SIZE);
     }
 
     xdr_dbuf_reset(msg->dbuf);
@@ -131,7 +135,7 @@ evpl_rpc2_init(struct evpl *evpl)
 {
     struct evpl_rpc2_agent *agent;
 
-    agent = evpl_zalloc(sizeof(*agent));
+    agent = evpl_zalloc_tagged(sizeof(*agent), EVPL_MEMORY_TAG_RPC2);
 
     agent->evpl = evpl;
 
@@ -147,9 +151,10 @@ evpl_rpc2_destroy(struct evpl_rpc2_agent *agent)
         msg = agent->free_msg;
         LL_DELETE(agent->free_msg, msg);
         xdr_dbuf_free(msg->dbuf);
-        evpl_free(msg);
+        evpl_memory_account(EVPL_MEMORY_TAG_RPC2, -EVPL_RPC2_DBUF_SIZE);
+        evpl_free_tagged(msg, EVPL_MEMORY_TAG_RPC2);
     }
-    evpl_free(agent);
+    evpl_free_tagged(agent, EVPL_MEMORY_TAG_RPC2);
 } /* evpl_rpc2_agent_destroy */
 
 static inline int
@@ -332,7 +337,7 @@ evpl_rpc2_event(
             evpl_bind_get_local_address(bind, addr_str_local, sizeof(addr_str_local));
             evpl_bind_get_remote_address(bind, addr_str, sizeof(addr_str));
             evpl_rpc2_debug("Connection terminated from %s to %s", addr_str, addr_str_local);
-            free(rpc2_conn);
+            evpl_free_tagged(rpc2_conn, EVPL_MEMORY_TAG_RPC2);
             break;
         case EVPL_NOTIFY_RECV_MSG:
 
@@ -480,7 +485,8 @@ evpl_rpc2_accept(
     struct evpl_rpc2_server *server = private_data;
     struct evpl_rpc2_conn   *rpc2_conn;
 
-    rpc2_conn            = evpl_zalloc(sizeof(*rpc2_conn));
+    rpc2_conn = evpl_zalloc_tagged(sizeof(*rpc2_conn), EVPL_MEMORY_TAG_RPC2);
+
     rpc2_conn->server    = server;
     rpc2_conn->is_server = 1;
     rpc2_conn->agent     = server->agent;
@@ -745,23 +751,25 @@ evpl_rpc2_listen(
 {
     struct evpl_rpc2_server *server;
 
-    server = evpl_zalloc(sizeof(*server));
+    server = evpl_zalloc_tagged(sizeof(*server), EVPL_MEMORY_TAG_RPC2);
 
     server->agent        = agent;
     server->protocol     = protocol;
     server->private_data = private_data;
-    server->programs     = evpl_zalloc(nprograms * sizeof(*programs));
+    server->programs     = evpl_zalloc_tagged(nprograms * sizeof(*programs),
+                                              EVPL_MEMORY_TAG_RPC2);
     server->nprograms    = nprograms;
     memcpy(server->programs, programs, nprograms * sizeof(*programs));
 
-    server->metrics = evpl_zalloc(nprograms * sizeof(*server->metrics));
+    server->metrics = evpl_zalloc_tagged(nprograms * sizeof(*server->metrics),
+                                         EVPL_MEMORY_TAG_RPC2);
 
     for (int i = 0; i < nprograms; i++) {
         server->programs[i]->reply_dispatch = evpl_rpc2_send_reply;
 
-        server->metrics[i] = evpl_zalloc(
-            (server->programs[i]->maxproc + 1) * sizeof(struct evpl_rpc2_metric)
-            );
+        server->metrics[i] = evpl_zalloc_tagged(
+            (server->programs[i]->maxproc + 1) * sizeof(struct evpl_rpc2_metric),
+            EVPL_MEMORY_TAG_RPC2);
     }
 
     server->listener = evpl_listener_create();
@@ -817,12 +825,12 @@ evpl_rpc2_server_destroy(
     }
 
     for (i = 0; i < server->nprograms; i++) {
-        evpl_free(server->metrics[i]);
+        evpl_free_tagged(server->metrics[i], EVPL_MEMORY_TAG_RPC2);
     }
 
-    evpl_free(server->metrics);
-    evpl_free(server->programs);
-    evpl_free(server);
+    evpl_free_tagged(server->metrics, EVPL_MEMORY_TAG_RPC2);
+    evpl_free_tagged(server->programs, EVPL_MEMORY_TAG_RPC2);
+    evpl_free_tagged(server, EVPL_MEMORY_TAG_RPC2);
 } /* evpl_rpc2_server_destroy */
 
 struct evpl_bind *
@@ -835,7 +843,7 @@ evpl_rpc2_connect(
 {
     struct evpl_rpc2_conn *conn;
 
-    conn = evpl_zalloc(sizeof(*conn));
+    conn = evpl_zalloc_tagged(sizeof(*conn), EVPL_MEMORY_TAG_RPC2);
 
     conn->is_server = 0;
     conn->agent     = agent;
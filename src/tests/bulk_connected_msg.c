@@ -188,7 +188,7 @@ main(
 
     evpl = evpl_create(NULL);
 
-    me = evpl_endpoint_create("0.0.0.0", port);
+    me = evpl_endpoint_create(address, port);
 
     listener = evpl_listener_create();
 
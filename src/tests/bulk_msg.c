@@ -15,6 +15,7 @@
 enum evpl_protocol_id proto       = EVPL_DATAGRAM_RDMACM_RC;
 const char            localhost[] = "127.0.0.1";
 const char           *address     = localhost;
+const char           *client_addr = NULL;
 int                   port        = 8000;
 
 
@@ -67,7 +68,7 @@ client_thread(void *arg)
 
     evpl = evpl_create(NULL);
 
-    me     = evpl_endpoint_create(address, port + 1);
+    me     = evpl_endpoint_create(client_addr, port + 1);
     server = evpl_endpoint_create(address, port);
 
     bind = evpl_bind(evpl, proto, me, client_callback, state);
@@ -141,11 +142,14 @@ main(
         .value    = 1,
     };
 
-    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+    while ((opt = getopt(argc, argv, "a:c:p:r:")) != -1) {
         switch (opt) {
             case 'a':
                 address = optarg;
                 break;
+            case 'c':
+                client_addr = optarg;
+                break;
             case 'p':
                 port = atoi(optarg);
                 break;
@@ -158,19 +162,24 @@ main(
                 break;
             default:
                 fprintf(stderr,
-                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        "Usage: %s [-r protocol] [-a address] "
+                        "[-c client address] [-p port]\n",
                         argv[0]);
                 return 1;
         } /* switch */
     }
 
+    if (!client_addr) {
+        client_addr = address;
+    }
+
 
     evpl = evpl_create(NULL);
 
     state.server_evpl = evpl;
 
     me     = evpl_endpoint_create(address, port);
-    client = evpl_endpoint_create(address, port + 1);
+    client = evpl_endpoint_create(client_addr, port + 1);
 
     evpl_bind(evpl, proto, me, server_callback, client);
 
@@ -0,0 +1,544 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+/*
+ * Connection scaling benchmark
+ *
+ * Opens a large number of loopback connections from a set of client threads
+ * to a server threadpool, then reports memory per connection, connect and
+ * accept rates, and echo throughput with a fraction of the connections
+ * active.  Both ends of every connection live in this process, so memory
+ * figures cover a client bind and a server bind together.
+ *
+ * Each client connects to one of several listening ports so that more
+ * connections than there are ephemeral ports can be opened over loopback.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum bench_phase {
+    PHASE_INIT    = 0,
+    PHASE_CONNECT = 1,
+    PHASE_IDLE    = 2,
+    PHASE_ACTIVE  = 3,
+    PHASE_DONE    = 4,
+};
+
+struct bench_client;
+
+struct bench_conn {
+    struct bench_client *client;
+    struct evpl_bind    *bind;
+    int                  connected;
+};
+
+struct bench_client {
+    pthread_t          thread;
+    int                first;
+    int                nconns;
+    struct bench_conn *conns;
+    _Atomic int        connected;
+    _Atomic uint64_t   msgs;
+};
+
+enum evpl_protocol_id proto       = EVPL_STREAM_SOCKET_TCP;
+const char            localhost[] = "127.0.0.1";
+const char           *address     = localhost;
+int                   port        = 8000;
+int                   nports      = 1;
+int                   nconns      = 1000;
+int                   nthreads    = 4;
+int                   active_pct  = 10;
+int                   msg_size    = 4096;
+int                   duration    = 5;
+int                   window      = 64;
+int                   max_pending = 4096;
+uint64_t              max_conn_bytes;
+int                   zerocopy_min = -1;
+
+struct evpl_endpoint **endpoints;
+char                  *msgbuf;
+
+_Atomic int           phase;
+_Atomic int           clients_ready;
+_Atomic int           accepted;
+
+static uint64_t
+bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+} /* bench_now_ns */
+
+static uint64_t
+bench_rss_bytes(void)
+{
+    FILE         *fp;
+    unsigned long size, resident = 0;
+
+    fp = fopen("/proc/self/statm", "r");
+
+    if (fp) {
+        if (fscanf(fp, "%lu %lu", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(fp);
+    }
+
+    return resident * sysconf(_SC_PAGESIZE);
+} /* bench_rss_bytes */
+
+static int64_t
+bench_heap_bytes(void)
+{
+    struct evpl_memory_snapshot snapshot;
+    int64_t                     bytes = 0;
+    int                         i;
+
+    evpl_memory_snapshot(&snapshot);
+
+    for (i = 0; i < EVPL_MEMORY_TAG_MAX; ++i) {
+        bytes += snapshot.tags[i].bytes;
+    }
+
+    return bytes;
+} /* bench_heap_bytes */
+
+static int
+bench_segment_callback(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    void             *private_data)
+{
+    return msg_size;
+} /* bench_segment_callback */
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct bench_conn   *conn   = private_data;
+    struct bench_client *client = conn->client;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_CONNECTED:
+            conn->connected = 1;
+            atomic_fetch_add(&client->connected, 1);
+            break;
+        case EVPL_NOTIFY_RECV_MSG:
+            atomic_fetch_add_explicit(&client->msgs, 1, memory_order_relaxed);
+
+            if (atomic_load(&phase) == PHASE_ACTIVE) {
+                evpl_send(evpl, bind, msgbuf, msg_size);
+            }
+            break;
+        case EVPL_NOTIFY_DISCONNECTED:
+            evpl_test_abort_if(atomic_load(&phase) < PHASE_DONE,
+                               "client connection lost");
+            break;
+    } /* switch */
+
+} /* client_callback */
+
+static void *
+client_thread(void *arg)
+{
+    struct bench_client       *client = arg;
+    struct bench_conn         *conn;
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    int                        i, issued = 0;
+
+    /* Wake periodically so phase changes are noticed while idle */
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    atomic_fetch_add(&clients_ready, 1);
+
+    while (atomic_load(&phase) == PHASE_INIT) {
+        usleep(100);
+    }
+
+    while (atomic_load(&client->connected) < client->nconns) {
+
+        while (issued < client->nconns &&
+               issued - atomic_load(&client->connected) < window) {
+
+            conn = &client->conns[issued];
+
+            conn->client = client;
+            conn->bind   = evpl_connect(evpl, proto, NULL,
+                                        endpoints[(client->first + issued) %
+                                                  nports],
+                                        client_callback, bench_segment_callback,
+                                        conn);
+            issued++;
+        }
+
+        evpl_continue(evpl);
+    }
+
+    while (atomic_load(&phase) < PHASE_ACTIVE) {
+        evpl_continue(evpl);
+    }
+
+    for (i = 0; i < client->nconns; ++i) {
+        if ((client->first + i) % 100 < active_pct) {
+            evpl_send(evpl, client->conns[i].bind, msgbuf, msg_size);
+        }
+    }
+
+    while (atomic_load(&phase) < PHASE_DONE) {
+        evpl_continue(evpl);
+    }
+
+    evpl_destroy(evpl);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    int i;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_RECV_MSG:
+
+            for (i = 0; i < notify->recv_msg.niov; ++i) {
+                evpl_iovec_addref(&notify->recv_msg.iovec[i]);
+            }
+
+            evpl_sendv(evpl, bind, notify->recv_msg.iovec,
+                       notify->recv_msg.niov, notify->recv_msg.length);
+            break;
+    } /* switch */
+
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *accepted_bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    *notify_callback   = server_callback;
+    *segment_callback  = bench_segment_callback;
+    *conn_private_data = NULL;
+
+    atomic_fetch_add(&accepted, 1);
+} /* accept_callback */
+
+static void *
+server_init(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_listener *listener = private_data;
+
+    evpl_listener_attach(evpl, listener, accept_callback, NULL);
+
+    return listener;
+} /* server_init */
+
+static void
+server_shutdown(
+    struct evpl *evpl,
+    void        *private_data)
+{
+    struct evpl_listener *listener = private_data;
+
+    evpl_listener_detach(evpl, listener);
+} /* server_shutdown */
+
+static void
+bench_raise_fd_limit(void)
+{
+    struct rlimit rl;
+    uint64_t      need = 2 * (uint64_t) nconns + 64;
+
+    getrlimit(RLIMIT_NOFILE, &rl);
+
+    if (rl.rlim_cur < need) {
+        rl.rlim_cur = rl.rlim_max < need ? rl.rlim_max : need;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    evpl_test_abort_if(rl.rlim_cur < need,
+                       "need %lu file descriptors but limit is %lu",
+                       need, (uint64_t) rl.rlim_cur);
+} /* bench_raise_fd_limit */
+
+static uint64_t
+bench_total_connected(struct bench_client *clients)
+{
+    uint64_t total = 0;
+    int      i;
+
+    for (i = 0; i < nthreads; ++i) {
+        total += atomic_load(&clients[i].connected);
+    }
+
+    return total;
+} /* bench_total_connected */
+
+static uint64_t
+bench_total_msgs(struct bench_client *clients)
+{
+    uint64_t total = 0;
+    int      i;
+
+    for (i = 0; i < nthreads; ++i) {
+        total += atomic_load(&clients[i].msgs);
+    }
+
+    return total;
+} /* bench_total_msgs */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    struct evpl_global_config *global_config;
+    struct evpl_threadpool    *threadpool;
+    struct evpl_listener      *listener;
+    struct bench_client       *clients;
+    struct bench_conn         *conns;
+    uint64_t                   rss0, rss1, start, connect_ns = 0, accept_ns = 0;
+    uint64_t                   msgs0, msgs1, elapsed;
+    int64_t                    heap0, heap1;
+    const char                *proto_name = NULL;
+    int                        rc, opt, i, first, nactive;
+
+    while ((opt = getopt(argc, argv, "a:b:c:d:f:m:n:p:P:r:t:w:z:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'b':
+                msg_size = atoi(optarg);
+                break;
+            case 'c':
+                max_pending = atoi(optarg);
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            case 'f':
+                active_pct = atoi(optarg);
+                break;
+            case 'm':
+                max_conn_bytes = strtoull(optarg, NULL, 0);
+                break;
+            case 'n':
+                nconns = atoi(optarg);
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'P':
+                nports = atoi(optarg);
+                break;
+            case 'r':
+                proto_name = optarg;
+                break;
+            case 't':
+                nthreads = atoi(optarg);
+                break;
+            case 'w':
+                window = atoi(optarg);
+                break;
+            case 'z':
+                zerocopy_min = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port] "
+                        "[-P nports] [-n connections] [-t threads] "
+                        "[-f active percent] [-b message size] "
+                        "[-d seconds] [-w connect window] [-c backlog] "
+                        "[-m max bytes per connection] "
+                        "[-z zero copy minimum length]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    evpl_test_abort_if(nconns < 1 || nthreads < 1 || nports < 1,
+                       "invalid connection, thread or port count");
+
+    bench_raise_fd_limit();
+
+    global_config = evpl_global_config_init();
+    evpl_global_config_set_max_pending(global_config, max_pending);
+
+    if (zerocopy_min >= 0) {
+        evpl_global_config_set_socket_zerocopy(global_config, 1);
+        evpl_global_config_set_socket_zerocopy_min(global_config,
+                                                   zerocopy_min);
+    }
+    evpl_init(global_config);
+
+    /* Looked up only now since a lookup initializes the library */
+    if (proto_name) {
+        rc = evpl_protocol_lookup(&proto, proto_name);
+        if (rc) {
+            fprintf(stderr, "Invalid protocol '%s'\n", proto_name);
+            return 1;
+        }
+    }
+
+    evpl_test_abort_if(!evpl_protocol_is_stream(proto),
+                       "connection scaling requires a stream protocol");
+
+
+    msgbuf = calloc(1, msg_size);
+
+    listener = evpl_listener_create();
+
+    threadpool = evpl_threadpool_create(NULL, nthreads, server_init,
+                                        server_shutdown, listener);
+
+    endpoints = calloc(nports, sizeof(*endpoints));
+
+    for (i = 0; i < nports; ++i) {
+        endpoints[i] = evpl_endpoint_create(address, port + i);
+        evpl_listen(listener, proto, endpoints[i]);
+    }
+
+    /* evpl_listen() is asynchronous, give the listener a moment */
+    usleep(100000);
+
+    clients = calloc(nthreads, sizeof(*clients));
+    conns   = calloc(nconns, sizeof(*conns));
+
+    for (i = 0, first = 0; i < nthreads; ++i) {
+        clients[i].first  = first;
+        clients[i].nconns = nconns / nthreads + (i < nconns % nthreads);
+        clients[i].conns  = &conns[first];
+        first            += clients[i].nconns;
+
+        pthread_create(&clients[i].thread, NULL, client_thread, &clients[i]);
+    }
+
+    while (atomic_load(&clients_ready) < nthreads) {
+        usleep(100);
+    }
+
+    rss0  = bench_rss_bytes();
+    heap0 = bench_heap_bytes();
+    start = bench_now_ns();
+
+    atomic_store(&phase, PHASE_CONNECT);
+
+    while (!connect_ns || !accept_ns) {
+
+        if (!connect_ns && bench_total_connected(clients) == (uint64_t) nconns) {
+            connect_ns = bench_now_ns() - start;
+        }
+
+        if (!accept_ns && atomic_load(&accepted) == nconns) {
+            accept_ns = bench_now_ns() - start;
+        }
+
+        usleep(100);
+    }
+
+    atomic_store(&phase, PHASE_IDLE);
+
+    /* Let every thread reach its idle trim before measuring */
+    usleep(1500000);
+
+    rss1  = bench_rss_bytes();
+    heap1 = bench_heap_bytes();
+
+    nactive = 0;
+
+    for (i = 0; i < nconns; ++i) {
+        nactive += (i % 100 < active_pct);
+    }
+
+    atomic_store(&phase, PHASE_ACTIVE);
+
+    /* Skip the first second so the measurement reflects steady state */
+    sleep(1);
+
+    msgs0 = bench_total_msgs(clients);
+    start = bench_now_ns();
+
+    sleep(duration);
+
+    msgs1   = bench_total_msgs(clients);
+    elapsed = bench_now_ns() - start;
+
+    atomic_store(&phase, PHASE_DONE);
+
+    for (i = 0; i < nthreads; ++i) {
+        pthread_join(clients[i].thread, NULL);
+    }
+
+    printf("connections            %d over %d threads and %d ports\n",
+           nconns, nthreads, nports);
+    printf("connect rate           %.0f/s\n",
+           nconns / (connect_ns / 1e9));
+    printf("accept rate            %.0f/s\n",
+           nconns / (accept_ns / 1e9));
+    printf("rss per connection     %.0f bytes\n",
+           (double) (int64_t) (rss1 - rss0) / nconns);
+    printf("evpl heap per conn     %.0f bytes\n",
+           (double) (heap1 - heap0) / nconns);
+    printf("active connections     %d with %d byte messages\n",
+           nactive, msg_size);
+    printf("throughput             %.0f msgs/s %.1f MB/s\n",
+           (msgs1 - msgs0) / (elapsed / 1e9),
+           (msgs1 - msgs0) * (double) msg_size / (elapsed / 1e3));
+
+    evpl_test_abort_if(max_conn_bytes &&
+                       heap1 - heap0 > (int64_t) (max_conn_bytes * nconns),
+                       "evpl heap per connection %ld exceeds budget %lu",
+                       (heap1 - heap0) / nconns, max_conn_bytes);
+
+    evpl_threadpool_destroy(threadpool);
+
+    evpl_listener_destroy(listener);
+
+    for (i = 0; i < nports; ++i) {
+        evpl_endpoint_close(endpoints[i]);
+    }
+
+    free(endpoints);
+    free(conns);
+    free(clients);
+    free(msgbuf);
+
+    return 0;
+} /* main */
@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto       = EVPL_DATAGRAM_SOCKET_UDP;
+const char            localhost[] = "127.0.0.1";
+const char           *address     = localhost;
+int                   port        = 8000;
+
+#define NROUNDS 16
+
+/*
+ * Each round sends to a freshly created endpoint that alternates between
+ * two receivers, and closes it as soon as the datagram has arrived.  The
+ * next endpoint is usually handed the memory of the one just closed, and
+ * is sent to well within the thread's address cache epoch, so a stale
+ * cached address would deliver it to the wrong receiver.
+ */
+
+struct receiver {
+    int received;
+};
+
+static void
+receiver_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct receiver *receiver = private_data;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_RECV_MSG:
+            receiver->received++;
+            break;
+    } /* switch */
+
+} /* receiver_callback */
+
+static void
+sender_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+} /* sender_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    struct evpl          *evpl;
+    struct evpl_endpoint *me, *local[2], *ep, *prev = NULL;
+    struct evpl_bind     *sender;
+    struct receiver       receivers[2];
+    int                   opt, rc, i, target, reused = 0;
+    const char            hello[] = "Hello World!";
+
+    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                rc = evpl_protocol_lookup(&proto, optarg);
+                if (rc) {
+                    fprintf(stderr, "Invalid protocol '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    evpl = evpl_create(NULL);
+
+    me = evpl_endpoint_create(address, port);
+
+    sender = evpl_bind(evpl, proto, me, sender_callback, NULL);
+
+    for (i = 0; i < 2; ++i) {
+        receivers[i].received = 0;
+
+        local[i] = evpl_endpoint_create(address, port + 1 + i);
+
+        evpl_bind(evpl, proto, local[i], receiver_callback, &receivers[i]);
+    }
+
+    for (i = 0; i < NROUNDS; ++i) {
+
+        target = i & 1;
+
+        ep = evpl_endpoint_create(address, port + 1 + target);
+
+        if (ep == prev) {
+            reused++;
+        }
+
+        evpl_sendtoep(evpl, sender, ep, hello, sizeof(hello));
+
+        while (receivers[0].received + receivers[1].received <= i) {
+            evpl_continue(evpl);
+        }
+
+        evpl_test_abort_if(receivers[target].received != (i >> 1) + 1,
+                           "round %d was delivered to receiver %d",
+                           i, !target);
+
+        evpl_endpoint_close(ep);
+
+        prev = ep;
+    }
+
+    evpl_test_info("%d rounds delivered, %d to a reused endpoint",
+                   NROUNDS, reused);
+
+    evpl_destroy(evpl);
+
+    evpl_endpoint_close(me);
+    evpl_endpoint_close(local[0]);
+    evpl_endpoint_close(local[1]);
+
+    return 0;
+} /* main */
@@ -0,0 +1,260 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto       = EVPL_STREAM_SOCKET_TCP;
+const char            localhost[] = "127.0.0.1";
+const char           *address     = localhost;
+int                   port        = 8000;
+int                   zerocopy    = 0;
+
+#define NCONNS     8
+#define TOTAL_SIZE (16 * 1024 * 1024)
+#define SEND_SIZE  (256 * 1024)
+
+/*
+ * The server queues a large stream and finishes the bind straight away,
+ * so most of it is still in flight when the server side closes.  Every
+ * byte must still reach the client before it sees the disconnect.
+ */
+
+struct client_state {
+    int      run;
+    int      conn;
+    uint64_t received;
+};
+
+struct test_state {
+    atomic_int run;
+    int        accepted;
+};
+
+static inline unsigned char
+pattern(
+    int      conn,
+    uint64_t offset)
+{
+    return (conn * 13 + offset % 251) & 0xff;
+} /* pattern */
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct client_state *state = private_data;
+    unsigned char        buffer[65536];
+    int                  length, i;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_RECV_DATA:
+
+            while ((length = evpl_read(evpl, bind, buffer,
+                                       sizeof(buffer))) > 0) {
+
+                for (i = 0; i < length; ++i) {
+                    evpl_test_abort_if(buffer[i] !=
+                                       pattern(state->conn,
+                                               state->received + i),
+                                       "connection %d mismatch at offset %lu",
+                                       state->conn, state->received + i);
+                }
+
+                state->received += length;
+            }
+
+            break;
+        case EVPL_NOTIFY_DISCONNECTED:
+            state->run = 0;
+            break;
+    } /* switch */
+
+} /* client_callback */
+
+static void *
+client_thread(void *arg)
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *server;
+    struct test_state         *test = arg;
+    struct client_state        state;
+    int                        i;
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    server = evpl_endpoint_create(address, port);
+
+    for (i = 0; i < NCONNS; ++i) {
+
+        state.run      = 1;
+        state.conn     = i;
+        state.received = 0;
+
+        evpl_connect(evpl, proto, NULL, server, client_callback, NULL, &state);
+
+        while (state.run) {
+            evpl_continue(evpl);
+        }
+
+        evpl_test_abort_if(state.received != TOTAL_SIZE,
+                           "connection %d received %lu bytes, expected %u",
+                           i, state.received, TOTAL_SIZE);
+
+        evpl_test_info("connection %d received all %lu bytes", i,
+                       state.received);
+    }
+
+    evpl_destroy(evpl);
+
+    atomic_store(&test->run, 0);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    struct test_state *state = private_data;
+    unsigned char     *data;
+    uint64_t           offset;
+    int                conn = state->accepted++, i;
+
+    *notify_callback   = server_callback;
+    *conn_private_data = state;
+
+    data = malloc(SEND_SIZE);
+
+    for (offset = 0; offset < TOTAL_SIZE; offset += SEND_SIZE) {
+
+        for (i = 0; i < SEND_SIZE; ++i) {
+            data[i] = pattern(conn, offset + i);
+        }
+
+        evpl_send(evpl, bind, data, SEND_SIZE);
+    }
+
+    free(data);
+
+    evpl_finish(evpl, bind);
+} /* accept_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t                  thr;
+    struct evpl_global_config *global_config;
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_listener      *listener;
+    struct evpl_endpoint      *me;
+    const char                *proto_name = NULL;
+    int                        rc, opt;
+    struct test_state          state = {
+        .run      = 1,
+        .accepted = 0,
+    };
+
+    while ((opt = getopt(argc, argv, "a:p:r:z")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                proto_name = optarg;
+                break;
+            case 'z':
+                zerocopy = 1;
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port] [-z]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    if (zerocopy) {
+        global_config = evpl_global_config_init();
+        evpl_global_config_set_socket_zerocopy(global_config, 1);
+        evpl_global_config_set_socket_zerocopy_min(global_config, 0);
+        evpl_init(global_config);
+    }
+
+    /* Looked up only now since a lookup initializes the library */
+    if (proto_name) {
+        rc = evpl_protocol_lookup(&proto, proto_name);
+        if (rc) {
+            fprintf(stderr, "Invalid protocol '%s'\n", proto_name);
+            return 1;
+        }
+    }
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    me = evpl_endpoint_create(address, port);
+
+    listener = evpl_listener_create();
+
+    evpl_listener_attach(evpl, listener, accept_callback, &state);
+
+    evpl_listen(listener, proto, me);
+
+    pthread_create(&thr, NULL, client_thread, &state);
+
+    while (atomic_load(&state.run)) {
+        evpl_continue(evpl);
+    }
+
+    pthread_join(thr, NULL);
+
+    evpl_listener_detach(evpl, listener);
+
+    evpl_destroy(evpl);
+
+    evpl_listener_destroy(listener);
+
+    return 0;
+} /* main */
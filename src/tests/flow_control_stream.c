@@ -0,0 +1,261 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto       = EVPL_STREAM_SOCKET_TCP;
+const char            localhost[] = "127.0.0.1";
+const char           *address     = localhost;
+int                   port        = 8000;
+
+#define CHUNK_SIZE   (16 * 1024)
+#define CONSUME_SIZE (64 * 1024)
+#define SEND_HIGH    (256 * 1024)
+#define SEND_LOW     (64 * 1024)
+#define RECV_MAX     (64 * 1024)
+
+struct test_state {
+    atomic_int       run;
+    atomic_ulong     received;
+    unsigned long    total;
+
+    /* client side */
+    unsigned long    sent;
+    int              blocked;
+    int              nblocked;
+    int              nwritable;
+
+    /* server side */
+    struct evpl_bind *server_bind;
+};
+
+static inline unsigned char
+pattern(unsigned long offset)
+{
+    return offset % 251;
+} /* pattern */
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_SEND_BLOCKED:
+            evpl_test_abort_if(state->blocked, "send blocked twice");
+            state->blocked = 1;
+            state->nblocked++;
+            break;
+        case EVPL_NOTIFY_WRITABLE:
+            evpl_test_abort_if(!state->blocked, "writable while not blocked");
+            state->blocked = 0;
+            state->nwritable++;
+            break;
+    } /* switch */
+
+} /* client_callback */
+
+static void *
+client_thread(void *arg)
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *server;
+    struct evpl_bind          *bind;
+    struct test_state         *state = arg;
+    unsigned char              chunk[CHUNK_SIZE];
+    int                        i;
+
+    /* Wake periodically to notice the server has consumed everything */
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    server = evpl_endpoint_create(address, port);
+
+    bind = evpl_connect(evpl, proto, NULL, server, client_callback, NULL,
+                        state);
+
+    evpl_bind_set_send_watermarks(evpl, bind, SEND_HIGH, SEND_LOW);
+
+    while (atomic_load(&state->received) < state->total || state->blocked) {
+
+        while (!state->blocked && state->sent < state->total) {
+
+            for (i = 0; i < CHUNK_SIZE; ++i) {
+                chunk[i] = pattern(state->sent + i);
+            }
+
+            evpl_send(evpl, bind, chunk, CHUNK_SIZE);
+
+            state->sent += CHUNK_SIZE;
+        }
+
+        evpl_continue(evpl);
+    }
+
+    evpl_test_abort_if(state->nblocked == 0, "sender was never blocked");
+
+    evpl_test_abort_if(state->nblocked != state->nwritable,
+                       "blocked %d times but writable %d times",
+                       state->nblocked, state->nwritable);
+
+    evpl_test_info("client blocked %d times", state->nblocked);
+
+    atomic_store(&state->run, 0);
+
+    evpl_destroy(evpl);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_DISCONNECTED:
+            state->server_bind = NULL;
+            break;
+    } /* switch */
+
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    struct test_state *state = private_data;
+
+    *notify_callback   = server_callback;
+    *conn_private_data = private_data;
+
+    evpl_bind_set_recv_max(evpl, bind, RECV_MAX);
+
+    state->server_bind = bind;
+} /* accept_callback */
+
+/*
+ * Consume a bounded amount of received data per loop iteration so the
+ * server falls behind the client and receive is paused at the cap.
+ */
+static void
+server_consume(
+    struct evpl       *evpl,
+    struct test_state *state)
+{
+    static unsigned char buf[CONSUME_SIZE];
+    unsigned long        offset = atomic_load(&state->received);
+    int                  i, length;
+
+    if (!state->server_bind) {
+        return;
+    }
+
+    length = evpl_recv(evpl, state->server_bind, buf, sizeof(buf));
+
+    for (i = 0; i < length; ++i) {
+        evpl_test_abort_if(buf[i] != pattern(offset + i),
+                           "data mismatch at offset %lu", offset + i);
+    }
+
+    if (length > 0) {
+        atomic_fetch_add(&state->received, length);
+    }
+} /* server_consume */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t                  thr;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *me;
+    struct evpl_listener      *listener;
+    struct evpl_thread_config *config;
+    int                        rc, opt;
+    struct test_state          state = {
+        .run      = 1,
+        .received = 0,
+        .total    = 32 * 1024 * 1024,
+    };
+
+    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                rc = evpl_protocol_lookup(&proto, optarg);
+                if (rc) {
+                    fprintf(stderr, "Invalid protocol '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    /* The server consumes between waits, so it must not block in them */
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    me = evpl_endpoint_create(address, port);
+
+    listener = evpl_listener_create();
+
+    evpl_listener_attach(evpl, listener, accept_callback, &state);
+
+    evpl_listen(listener, proto, me);
+
+    pthread_create(&thr, NULL, client_thread, &state);
+
+    while (atomic_load(&state.run)) {
+        evpl_continue(evpl);
+        server_consume(evpl, &state);
+    }
+
+    pthread_join(thr, NULL);
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
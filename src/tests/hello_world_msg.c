@@ -18,6 +18,7 @@ const int             hellolen = strlen(hello) + 1;
 enum evpl_protocol_id proto       = EVPL_DATAGRAM_SOCKET_UDP;
 const char            localhost[] = "127.0.0.1";
 const char           *address     = localhost;
+const char           *client_addr = NULL;
 int                   port        = 8000;
 
 void
@@ -53,7 +54,7 @@ client_thread(void *arg)
 
     evpl = evpl_create(NULL);
 
-    me     = evpl_endpoint_create(address, port + 1);
+    me     = evpl_endpoint_create(client_addr, port + 1);
     server = evpl_endpoint_create(address, port);
 
     bind = evpl_bind(evpl, proto, me, client_callback, &run);
@@ -85,7 +86,7 @@ server_callback(
             evpl_test_info("server received '%s'",
                            notify->recv_msg.iovec[0].data);
 
-            client = evpl_endpoint_create(address, port + 1);
+            client = evpl_endpoint_create(client_addr, port + 1);
 
             evpl_sendtoep(evpl, bind, client, hello, hellolen);
 
@@ -111,11 +112,14 @@ main(
     int                   opt, rc, run = 1;
     struct evpl_endpoint *ep;
 
-    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+    while ((opt = getopt(argc, argv, "a:c:p:r:")) != -1) {
         switch (opt) {
             case 'a':
                 address = optarg;
                 break;
+            case 'c':
+                client_addr = optarg;
+                break;
             case 'p':
                 port = atoi(optarg);
                 break;
@@ -128,12 +132,17 @@ main(
                 break;
             default:
                 fprintf(stderr,
-                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        "Usage: %s [-r protocol] [-a address] "
+                        "[-c client address] [-p port]\n",
                         argv[0]);
                 return 1;
         } /* switch */
     }
 
+    if (!client_addr) {
+        client_addr = address;
+    }
+
 
     evpl = evpl_create(NULL);
 
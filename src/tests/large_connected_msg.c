@@ -0,0 +1,240 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto       = EVPL_STREAM_SOCKET_TCP;
+const char            localhost[] = "127.0.0.1";
+const char           *address     = localhost;
+int                   port        = 8000;
+
+#define NMSGS    64
+#define MIN_SIZE (256 * 1024)
+#define MAX_SIZE (1024 * 1024)
+
+/*
+ * Messages are framed by a 32 bit length header, and are large enough
+ * that each one arrives over many socket reads.
+ */
+
+struct test_state {
+    atomic_int run;
+    int        received;
+};
+
+static inline unsigned char
+pattern(
+    int      msg,
+    uint32_t offset)
+{
+    return (msg * 7 + offset) & 0xff;
+} /* pattern */
+
+static inline uint32_t
+msg_size(int msg)
+{
+    return MIN_SIZE + (msg * 40961) % (MAX_SIZE - MIN_SIZE);
+} /* msg_size */
+
+static int
+test_segment_callback(
+    struct evpl      *evpl,
+    struct evpl_bind *bind,
+    void             *private_data)
+{
+    uint32_t hdr;
+
+    if (evpl_peek(evpl, bind, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return 0;
+    }
+
+    return hdr;
+} /* test_segment_callback */
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+} /* client_callback */
+
+static void *
+client_thread(void *arg)
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *server;
+    struct evpl_bind          *bind;
+    struct test_state         *state = arg;
+    unsigned char             *msg;
+    uint32_t                   size, j;
+    int                        i;
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    server = evpl_endpoint_create(address, port);
+
+    bind = evpl_connect(evpl, proto, NULL, server, client_callback,
+                        test_segment_callback, state);
+
+    msg = malloc(MAX_SIZE);
+
+    for (i = 0; i < NMSGS; ++i) {
+
+        size = msg_size(i);
+
+        memcpy(msg, &size, sizeof(size));
+
+        for (j = sizeof(size); j < size; ++j) {
+            msg[j] = pattern(i, j);
+        }
+
+        evpl_send(evpl, bind, msg, size);
+    }
+
+    free(msg);
+
+    while (atomic_load(&state->run)) {
+        evpl_continue(evpl);
+    }
+
+    evpl_destroy(evpl);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+    unsigned char     *data;
+    uint32_t           offset = 0, j;
+    int                i;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_RECV_MSG:
+
+            evpl_test_abort_if(notify->recv_msg.length !=
+                               msg_size(state->received),
+                               "message %d is %u bytes, expected %u",
+                               state->received, notify->recv_msg.length,
+                               msg_size(state->received));
+
+            for (i = 0; i < notify->recv_msg.niov; ++i) {
+
+                data = notify->recv_msg.iovec[i].data;
+
+                for (j = 0; j < notify->recv_msg.iovec[i].length; ++j) {
+                    evpl_test_abort_if(offset + j >= sizeof(uint32_t) &&
+                                       data[j] != pattern(state->received,
+                                                          offset + j),
+                                       "message %d mismatch at offset %u",
+                                       state->received, offset + j);
+                }
+
+                offset += notify->recv_msg.iovec[i].length;
+            }
+
+            if (++state->received == NMSGS) {
+                atomic_store(&state->run, 0);
+            }
+
+            break;
+    } /* switch */
+
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    *notify_callback   = server_callback;
+    *segment_callback  = test_segment_callback;
+    *conn_private_data = private_data;
+} /* accept_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t             thr;
+    struct evpl          *evpl;
+    struct evpl_listener *listener;
+    struct evpl_endpoint *me;
+    int                   rc, opt;
+    struct test_state     state = {
+        .run      = 1,
+        .received = 0,
+    };
+
+    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                rc = evpl_protocol_lookup(&proto, optarg);
+                if (rc) {
+                    fprintf(stderr, "Invalid protocol '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    evpl = evpl_create(NULL);
+
+    me = evpl_endpoint_create(address, port);
+
+    listener = evpl_listener_create();
+
+    evpl_listener_attach(evpl, listener, accept_callback, &state);
+
+    evpl_listen(listener, proto, me);
+
+    pthread_create(&thr, NULL, client_thread, &state);
+
+    while (atomic_load(&state.run)) {
+        evpl_continue(evpl);
+    }
+
+    pthread_join(thr, NULL);
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
@@ -0,0 +1,272 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto         = EVPL_STREAM_SOCKET_UNIX;
+const char            unix_address[] = "@evpl-pass-fd";
+const char           *address        = unix_address;
+const char           *client_addr    = NULL;
+int                   port           = 8000;
+
+#define NFDS     8
+#define MSG_SIZE 100
+
+const char            payload[] = "passed through a descriptor";
+
+struct test_state {
+    int        stream;
+    atomic_int server_done;
+
+    /* server side */
+    int        fds;
+    uint64_t   received;
+};
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+} /* client_callback */
+
+static void *
+client_thread(void *arg)
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *me, *server;
+    struct evpl_bind          *bind;
+    struct test_state         *state = arg;
+    unsigned char              msg[MSG_SIZE];
+    int                        i, rc, pipefd[2];
+
+    /* Nothing wakes us once the server is done, so poll for it */
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    server = evpl_endpoint_create(address, port);
+
+    memset(msg, 0xab, sizeof(msg));
+
+    if (state->stream) {
+        bind = evpl_connect(evpl, proto, NULL, server, client_callback, NULL,
+                            state);
+    } else {
+        me = evpl_endpoint_create(client_addr, port + 1);
+
+        bind = evpl_bind(evpl, proto, me, client_callback, state);
+    }
+
+    for (i = 0; i < NFDS; ++i) {
+
+        /* The server reads what we wrote through the descriptor it gets */
+        rc = pipe(pipefd);
+
+        evpl_test_abort_if(rc, "pipe failed");
+
+        rc = write(pipefd[1], payload, sizeof(payload));
+
+        evpl_test_abort_if(rc != sizeof(payload), "pipe write failed");
+
+        rc = evpl_send_fd(evpl, bind, pipefd[0]);
+
+        evpl_test_abort_if(rc, "evpl_send_fd failed: %s", strerror(rc));
+
+        close(pipefd[0]);
+        close(pipefd[1]);
+
+        if (state->stream) {
+            evpl_send(evpl, bind, msg, sizeof(msg));
+        } else {
+            evpl_sendtoep(evpl, bind, server, msg, sizeof(msg));
+        }
+
+        evpl_continue(evpl);
+    }
+
+    while (!atomic_load(&state->server_done)) {
+        evpl_continue(evpl);
+    }
+
+    evpl_destroy(evpl);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_check_done(struct test_state *state)
+{
+    uint64_t total = state->stream ? NFDS * MSG_SIZE : NFDS;
+
+    if (state->fds == NFDS && state->received == total) {
+        atomic_store(&state->server_done, 1);
+    }
+} /* server_check_done */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+    unsigned char      buf[4096];
+    int                length;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_RECV_FD:
+
+            length = read(notify->recv_fd.fd, buf, sizeof(buf));
+
+            evpl_test_abort_if(length != sizeof(payload) ||
+                               memcmp(buf, payload, sizeof(payload)),
+                               "unexpected data read from passed fd");
+
+            close(notify->recv_fd.fd);
+
+            state->fds++;
+
+            server_check_done(state);
+            break;
+
+        case EVPL_NOTIFY_RECV_DATA:
+
+            while ((length = evpl_read(evpl, bind, buf, sizeof(buf))) > 0) {
+                state->received += length;
+            }
+
+            evpl_test_abort_if(state->fds * MSG_SIZE < state->received,
+                               "data arrived ahead of its descriptor");
+
+            server_check_done(state);
+            break;
+
+        case EVPL_NOTIFY_RECV_MSG:
+
+            ++state->received;
+
+            evpl_test_abort_if(state->fds < state->received,
+                               "datagram arrived ahead of its descriptor");
+
+            server_check_done(state);
+            break;
+    } /* switch */
+
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    *notify_callback   = server_callback;
+    *conn_private_data = private_data;
+} /* accept_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t                  thr;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *me;
+    struct evpl_listener      *listener;
+    struct evpl_global_config *global_config;
+    const char                *proto_name = NULL;
+    int                        rc, opt;
+    struct test_state          state = {
+        .server_done = 0,
+    };
+
+    while ((opt = getopt(argc, argv, "a:c:p:r:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'c':
+                client_addr = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                proto_name = optarg;
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] "
+                        "[-c client address] [-p port]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    if (!client_addr) {
+        client_addr = address;
+    }
+
+    global_config = evpl_global_config_init();
+
+    evpl_global_config_set_socket_unix_pass_fds(global_config, 1);
+
+    evpl_init(global_config);
+
+    /* Looked up only now since a lookup initializes the library */
+    if (proto_name) {
+        rc = evpl_protocol_lookup(&proto, proto_name);
+        if (rc) {
+            fprintf(stderr, "Invalid protocol '%s'\n", proto_name);
+            return 1;
+        }
+    }
+
+    state.stream = evpl_protocol_is_stream(proto);
+
+    evpl = evpl_create(NULL);
+
+    me = evpl_endpoint_create(address, port);
+
+    if (state.stream) {
+        listener = evpl_listener_create();
+
+        evpl_listener_attach(evpl, listener, accept_callback, &state);
+
+        evpl_listen(listener, proto, me);
+    } else {
+        evpl_bind(evpl, proto, me, server_callback, &state);
+    }
+
+    pthread_create(&thr, NULL, client_thread, &state);
+
+    while (!atomic_load(&state.server_done)) {
+        evpl_continue(evpl);
+    }
+
+    pthread_join(thr, NULL);
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
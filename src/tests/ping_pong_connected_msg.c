@@ -192,7 +192,7 @@ main(
 
     state.server_evpl = evpl;
 
-    me = evpl_endpoint_create("0.0.0.0", port);
+    me = evpl_endpoint_create(address, port);
 
     listener = evpl_listener_create();
 
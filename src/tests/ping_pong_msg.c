@@ -15,15 +15,17 @@
 enum evpl_protocol_id proto       = EVPL_DATAGRAM_SOCKET_UDP;
 const char            localhost[] = "127.0.0.1";
 const char           *address     = localhost;
+const char           *client_addr = NULL;
 int                   port        = 8000;
 
 
 struct client_state {
-    int          sent;
-    int          recv;
-    int          niters;
-    uint32_t     value;
-    struct evpl *server_evpl;
+    int                        sent;
+    int                        recv;
+    int                        niters;
+    uint32_t                   value;
+    struct evpl               *server_evpl;
+    const struct evpl_address *server_addr;
 };
 
 void
@@ -40,6 +42,14 @@ client_callback(
 
             state->recv++;
 
+            /* Repeat peers are reported with the same address */
+            if (state->recv == 1) {
+                state->server_addr = notify->recv_msg.addr;
+            }
+
+            evpl_test_abort_if(notify->recv_msg.addr != state->server_addr,
+                               "server address changed identity");
+
             evpl_test_info("client received %u sent %u recv %u",
                            *(uint32_t *) notify->recv_msg.iovec[0].data,
                            state->sent, state->recv);
@@ -59,7 +69,7 @@ client_thread(void *arg)
 
     evpl = evpl_create(NULL);
 
-    me = evpl_endpoint_create(address, port + 1);
+    me = evpl_endpoint_create(client_addr, port + 1);
 
     server = evpl_endpoint_create(address, port);
 
@@ -129,11 +139,14 @@ main(
         .value  = 1
     };
 
-    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+    while ((opt = getopt(argc, argv, "a:c:p:r:")) != -1) {
         switch (opt) {
             case 'a':
                 address = optarg;
                 break;
+            case 'c':
+                client_addr = optarg;
+                break;
             case 'p':
                 port = atoi(optarg);
                 break;
@@ -146,19 +159,24 @@ main(
                 break;
             default:
                 fprintf(stderr,
-                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        "Usage: %s [-r protocol] [-a address] "
+                        "[-c client address] [-p port]\n",
                         argv[0]);
                 return 1;
         } /* switch */
     }
 
+    if (!client_addr) {
+        client_addr = address;
+    }
+
 
     evpl = evpl_create(NULL);
 
     state.server_evpl = evpl;
 
     me     = evpl_endpoint_create(address, port);
-    client = evpl_endpoint_create(address, port + 1);
+    client = evpl_endpoint_create(client_addr, port + 1);
 
     evpl_bind(evpl, proto, me, server_callback, client);
 
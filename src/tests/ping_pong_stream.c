@@ -194,7 +194,7 @@ main(
 
     evpl = evpl_create(NULL);
 
-    ep = evpl_endpoint_create("0.0.0.0", port);
+    ep = evpl_endpoint_create(address, port);
 
     listener = evpl_listener_create();
 
@@ -0,0 +1,239 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto       = EVPL_STREAM_SOCKET_TCP;
+const char            localhost[] = "127.0.0.1";
+const char           *address     = localhost;
+int                   port        = 8000;
+
+#define TOTAL_SIZE (8 * 1024 * 1024)
+#define SEND_SIZE  (64 * 1024)
+#define MAX_IOVECS 256
+
+/*
+ * The client streams more than fits in one receive buffer, and the
+ * server only reads once all of it has arrived, so evpl_peek() and
+ * evpl_recv() each copy it out of several received iovecs at once.
+ */
+
+struct test_state {
+    atomic_int run;
+};
+
+static inline unsigned char
+pattern(uint64_t offset)
+{
+    return (offset % 251) & 0xff;
+} /* pattern */
+
+static void
+verify(
+    const unsigned char *buffer,
+    const char          *what)
+{
+    uint64_t i;
+
+    for (i = 0; i < TOTAL_SIZE; ++i) {
+        evpl_test_abort_if(buffer[i] != pattern(i),
+                           "%s mismatch at offset %lu", what, i);
+    }
+} /* verify */
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+} /* client_callback */
+
+static void *
+client_thread(void *arg)
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *server;
+    struct evpl_bind          *bind;
+    struct test_state         *state = arg;
+    unsigned char             *data;
+    uint64_t                   offset;
+    int                        i;
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    server = evpl_endpoint_create(address, port);
+
+    bind = evpl_connect(evpl, proto, NULL, server, client_callback, NULL,
+                        state);
+
+    data = malloc(SEND_SIZE);
+
+    for (offset = 0; offset < TOTAL_SIZE; offset += SEND_SIZE) {
+
+        for (i = 0; i < SEND_SIZE; ++i) {
+            data[i] = pattern(offset + i);
+        }
+
+        evpl_send(evpl, bind, data, SEND_SIZE);
+    }
+
+    free(data);
+
+    while (atomic_load(&state->run)) {
+        evpl_continue(evpl);
+    }
+
+    evpl_destroy(evpl);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+    struct evpl_iovec  iovecs[MAX_IOVECS];
+    unsigned char     *buffer;
+    uint64_t           avail = 0;
+    int                niov, i;
+
+    if (notify->notify_type != EVPL_NOTIFY_RECV_DATA) {
+        return;
+    }
+
+    niov = evpl_peekv(evpl, bind, iovecs, MAX_IOVECS, TOTAL_SIZE);
+
+    for (i = 0; i < niov; ++i) {
+        avail += iovecs[i].length;
+    }
+
+    if (avail < TOTAL_SIZE) {
+        return;
+    }
+
+    evpl_test_info("stream arrived in %d iovecs", niov);
+
+    evpl_test_abort_if(niov < 2, "stream arrived in a single iovec");
+
+    buffer = malloc(TOTAL_SIZE);
+
+    evpl_test_abort_if(evpl_peek(evpl, bind, buffer, TOTAL_SIZE) != TOTAL_SIZE,
+                       "short peek");
+
+    verify(buffer, "peek");
+
+    memset(buffer, 0, TOTAL_SIZE);
+
+    evpl_test_abort_if(evpl_recv(evpl, bind, buffer, TOTAL_SIZE) != TOTAL_SIZE,
+                       "short recv");
+
+    verify(buffer, "recv");
+
+    free(buffer);
+
+    atomic_store(&state->run, 0);
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    *notify_callback   = server_callback;
+    *conn_private_data = private_data;
+} /* accept_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t                  thr;
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_listener      *listener;
+    struct evpl_endpoint      *me;
+    int                        rc, opt;
+    struct test_state          state = {
+        .run = 1,
+    };
+
+    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                rc = evpl_protocol_lookup(&proto, optarg);
+                if (rc) {
+                    fprintf(stderr, "Invalid protocol '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    me = evpl_endpoint_create(address, port);
+
+    listener = evpl_listener_create();
+
+    evpl_listener_attach(evpl, listener, accept_callback, &state);
+
+    evpl_listen(listener, proto, me);
+
+    pthread_create(&thr, NULL, client_thread, &state);
+
+    while (atomic_load(&state.run)) {
+        evpl_continue(evpl);
+    }
+
+    pthread_join(thr, NULL);
+
+    evpl_listener_detach(evpl, listener);
+
+    evpl_destroy(evpl);
+
+    evpl_listener_destroy(listener);
+
+    return 0;
+} /* main */
@@ -0,0 +1,204 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto       = EVPL_STREAM_SOCKET_TCP;
+const char            localhost[] = "localhost";
+const char           *address     = localhost;
+int                   port        = 8000;
+
+/* Names in .invalid never resolve */
+const char            bad_address[] = "evpl-resolve-test.invalid";
+
+const char            hello[] = "hello";
+
+struct test_state {
+    atomic_int run;
+    int        bad_disconnected;
+};
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+} /* client_callback */
+
+static void
+bad_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_DISCONNECTED:
+            state->bad_disconnected = 1;
+            break;
+        default:
+            evpl_test_abort("unexpected notify %d on unresolvable connect",
+                            notify->notify_type);
+    } /* switch */
+
+} /* bad_callback */
+
+static void *
+client_thread(void *arg)
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *server, *bad;
+    struct evpl_bind          *bind, *bad_bind;
+    struct test_state         *state = arg;
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    server = evpl_endpoint_create(address, port);
+    bad    = evpl_endpoint_create(bad_address, port);
+
+    bind = evpl_connect(evpl, proto, NULL, server, client_callback, NULL,
+                        state);
+
+    /* Queued until the connection is made */
+    evpl_send(evpl, bind, hello, sizeof(hello));
+
+    bad_bind = evpl_connect(evpl, proto, NULL, bad, bad_callback, NULL,
+                            state);
+
+    while (atomic_load(&state->run) || !state->bad_disconnected) {
+
+        /*
+         * Keep a flush armed on the unresolvable bind, so that one is
+         * still pending when the failed lookup is noticed
+         */
+        if (!state->bad_disconnected) {
+            evpl_send(evpl, bad_bind, hello, sizeof(hello));
+        }
+
+        evpl_continue(evpl);
+    }
+
+    evpl_destroy(evpl);
+
+    evpl_endpoint_close(bad);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+    char               buf[sizeof(hello)];
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_RECV_DATA:
+
+            if (evpl_recv(evpl, bind, buf, sizeof(buf)) == sizeof(buf)) {
+
+                evpl_test_abort_if(memcmp(buf, hello, sizeof(hello)),
+                                   "data mismatch");
+
+                atomic_store(&state->run, 0);
+            }
+            break;
+    } /* switch */
+
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    *notify_callback   = server_callback;
+    *conn_private_data = private_data;
+} /* accept_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t             thr;
+    struct evpl          *evpl;
+    struct evpl_endpoint *me;
+    struct evpl_listener *listener;
+    int                   rc, opt;
+    struct test_state     state = {
+        .run = 1,
+    };
+
+    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                rc = evpl_protocol_lookup(&proto, optarg);
+                if (rc) {
+                    fprintf(stderr, "Invalid protocol '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    evpl = evpl_create(NULL);
+
+    /* Listen on whatever the name resolves to, so the client finds us */
+    me = evpl_endpoint_create(address, port);
+
+    listener = evpl_listener_create();
+
+    evpl_listener_attach(evpl, listener, accept_callback, &state);
+
+    evpl_listen(listener, proto, me);
+
+    pthread_create(&thr, NULL, client_thread, &state);
+
+    while (atomic_load(&state.run)) {
+        evpl_continue(evpl);
+    }
+
+    pthread_join(thr, NULL);
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */
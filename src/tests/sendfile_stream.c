@@ -0,0 +1,289 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto       = EVPL_STREAM_SOCKET_TCP;
+const char            localhost[] = "127.0.0.1";
+const char           *address     = localhost;
+int                   port        = 8000;
+
+#define FILE_SIZE (4 * 1024 * 1024 + 123)
+#define NITERS    64
+
+struct test_state {
+    atomic_int     run;
+    int            fd;
+
+    /* the byte stream the server should see */
+    unsigned char *expect;
+    uint64_t       total;
+
+    /* client side */
+    uint64_t       sent;
+
+    /* server side */
+    uint64_t       received;
+};
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_SENT:
+            state->sent += notify->sent.bytes;
+            break;
+    } /* switch */
+
+} /* client_callback */
+
+static void
+range_for_iter(
+    int       i,
+    uint64_t *offset,
+    uint64_t *length)
+{
+    *length = 1 + (i * 65537) % (FILE_SIZE / 4);
+    *offset = (i * 4099) % (FILE_SIZE - *length);
+} /* range_for_iter */
+
+/* Build the stream the client will produce, so the server can check it */
+static void
+build_expect(struct test_state *state)
+{
+    uint64_t header, offset, length;
+    uint32_t trailer;
+    ssize_t  res;
+    int      i;
+
+    state->expect = malloc(NITERS * (FILE_SIZE / 4 + 16));
+
+    for (i = 0; i < NITERS; ++i) {
+
+        range_for_iter(i, &offset, &length);
+
+        header = (offset << 32) | length;
+        memcpy(state->expect + state->total, &header, sizeof(header));
+        state->total += sizeof(header);
+
+        res = pread(state->fd, state->expect + state->total, length, offset);
+        evpl_test_abort_if(res != length, "pread failed");
+        state->total += length;
+
+        trailer = ~i;
+        memcpy(state->expect + state->total, &trailer, sizeof(trailer));
+        state->total += sizeof(trailer);
+    }
+} /* build_expect */
+
+/* Interleave small sends with file ranges to exercise ordering */
+static void
+client_queue(
+    struct evpl       *evpl,
+    struct evpl_bind  *bind,
+    struct test_state *state)
+{
+    uint64_t header, offset, length;
+    uint32_t trailer;
+    int      i;
+
+    for (i = 0; i < NITERS; ++i) {
+
+        range_for_iter(i, &offset, &length);
+
+        header = (offset << 32) | length;
+        evpl_send(evpl, bind, &header, sizeof(header));
+
+        evpl_sendfile(evpl, bind, state->fd, offset, length);
+
+        trailer = ~i;
+        evpl_send(evpl, bind, &trailer, sizeof(trailer));
+    }
+} /* client_queue */
+
+static void *
+client_thread(void *arg)
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *server;
+    struct evpl_bind          *bind;
+    struct test_state         *state = arg;
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    server = evpl_endpoint_create(address, port);
+
+    bind = evpl_connect(evpl, proto, NULL, server, client_callback, NULL,
+                        state);
+
+    evpl_bind_request_send_notifications(evpl, bind);
+
+    client_queue(evpl, bind, state);
+
+    /* Completions may still be reported after the server has it all */
+    while (atomic_load(&state->run) || state->sent < state->total) {
+        evpl_continue(evpl);
+    }
+
+    evpl_test_abort_if(state->sent != state->total,
+                       "sent %lu bytes of %lu", state->sent, state->total);
+
+    evpl_destroy(evpl);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+    unsigned char      buf[65536];
+    int                length;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_RECV_DATA:
+
+            while ((length = evpl_read(evpl, bind, buf, sizeof(buf))) > 0) {
+
+                evpl_test_abort_if(state->received + length > state->total,
+                                   "received more than was sent");
+
+                evpl_test_abort_if(memcmp(buf, state->expect + state->received,
+                                          length),
+                                   "data mismatch near offset %lu",
+                                   state->received);
+
+                state->received += length;
+            }
+
+            if (state->received == state->total) {
+                atomic_store(&state->run, 0);
+            }
+
+            break;
+    } /* switch */
+
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    *notify_callback   = server_callback;
+    *conn_private_data = private_data;
+} /* accept_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t             thr;
+    struct evpl          *evpl;
+    struct evpl_endpoint *me;
+    struct evpl_listener *listener;
+    char                  path[] = "/tmp/evpl_sendfile_XXXXXX";
+    unsigned char        *data;
+    int                   i, rc, opt;
+    struct test_state     state = {
+        .run = 1,
+    };
+
+    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                rc = evpl_protocol_lookup(&proto, optarg);
+                if (rc) {
+                    fprintf(stderr, "Invalid protocol '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    state.fd = mkstemp(path);
+
+    evpl_test_abort_if(state.fd < 0, "failed to create temporary file");
+
+    unlink(path);
+
+    data = malloc(FILE_SIZE);
+
+    for (i = 0; i < FILE_SIZE; ++i) {
+        data[i] = (i * 31 + i / 4096) & 0xff;
+    }
+
+    rc = write(state.fd, data, FILE_SIZE);
+
+    evpl_test_abort_if(rc != FILE_SIZE, "failed to write temporary file");
+
+    free(data);
+
+    build_expect(&state);
+
+    evpl = evpl_create(NULL);
+
+    me = evpl_endpoint_create(address, port);
+
+    listener = evpl_listener_create();
+
+    evpl_listener_attach(evpl, listener, accept_callback, &state);
+
+    evpl_listen(listener, proto, me);
+
+    pthread_create(&thr, NULL, client_thread, &state);
+
+    while (atomic_load(&state.run)) {
+        evpl_continue(evpl);
+    }
+
+    pthread_join(thr, NULL);
+
+    evpl_destroy(evpl);
+
+    free(state.expect);
+    close(state.fd);
+
+    return 0;
+} /* main */
@@ -0,0 +1,270 @@
+// SPDX-FileCopyrightText: 2025 Ben Jarvis
+//
+// SPDX-License-Identifier: LGPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "core/test_log.h"
+#include "evpl/evpl.h"
+
+enum evpl_protocol_id proto       = EVPL_DATAGRAM_SOCKET_UDP;
+const char            localhost[] = "127.0.0.1";
+const char           *address     = localhost;
+int                   port        = 8000;
+
+#define NMSGS    64
+#define MSG_SIZE 100
+
+struct test_state {
+    int        stream;
+    atomic_int server_done;
+
+    /* client side, bytes on streams and messages on datagrams */
+    uint64_t   tx_stamped;
+
+    /* server side */
+    uint64_t   received;
+};
+
+/* Kernel timestamps are wall clock, so they should be close to ours */
+static void
+check_timestamp(
+    uint64_t    timestamp,
+    const char *what)
+{
+    struct timespec now;
+    uint64_t        now_ns;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    now_ns = now.tv_sec * 1000000000UL + now.tv_nsec;
+
+    evpl_test_abort_if(timestamp == 0, "no %s timestamp", what);
+
+    evpl_test_abort_if(timestamp > now_ns ||
+                       now_ns - timestamp > 60 * 1000000000UL,
+                       "%s timestamp %lu too far from now %lu",
+                       what, timestamp, now_ns);
+} /* check_timestamp */
+
+static void
+client_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+    uint64_t           count;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_SENT_TIMESTAMP:
+
+            check_timestamp(notify->sent.timestamp, "transmit");
+
+            count = state->stream ? notify->sent.bytes : notify->sent.msgs;
+
+            evpl_test_abort_if(count <= state->tx_stamped,
+                               "transmit timestamp went backwards");
+
+            state->tx_stamped = count;
+            break;
+    } /* switch */
+
+} /* client_callback */
+
+static void *
+client_thread(void *arg)
+{
+    struct evpl_thread_config *config;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *me, *server;
+    struct evpl_bind          *bind;
+    struct test_state         *state = arg;
+    unsigned char              msg[MSG_SIZE];
+    uint64_t                   total;
+    int                        i;
+
+    config = evpl_thread_config_init();
+    evpl_thread_config_set_wait_ms(config, 1);
+
+    evpl = evpl_create(config);
+
+    evpl_thread_config_release(config);
+
+    server = evpl_endpoint_create(address, port);
+
+    memset(msg, 0xab, sizeof(msg));
+
+    if (state->stream) {
+        bind = evpl_connect(evpl, proto, NULL, server, client_callback, NULL,
+                            state);
+
+        total = NMSGS * MSG_SIZE;
+    } else {
+        me = evpl_endpoint_create(address, port + 1);
+
+        bind = evpl_bind(evpl, proto, me, client_callback, state);
+
+        total = NMSGS;
+    }
+
+    for (i = 0; i < NMSGS; ++i) {
+        if (state->stream) {
+            evpl_send(evpl, bind, msg, sizeof(msg));
+        } else {
+            evpl_sendtoep(evpl, bind, server, msg, sizeof(msg));
+        }
+
+        evpl_continue(evpl);
+    }
+
+    while (!atomic_load(&state->server_done) || state->tx_stamped < total) {
+        evpl_continue(evpl);
+    }
+
+    evpl_test_abort_if(state->tx_stamped != total,
+                       "transmit timestamps cover %lu of %lu",
+                       state->tx_stamped, total);
+
+    evpl_destroy(evpl);
+
+    return NULL;
+} /* client_thread */
+
+static void
+server_callback(
+    struct evpl        *evpl,
+    struct evpl_bind   *bind,
+    struct evpl_notify *notify,
+    void               *private_data)
+{
+    struct test_state *state = private_data;
+    unsigned char      buf[4096];
+    int                length;
+
+    switch (notify->notify_type) {
+        case EVPL_NOTIFY_RECV_DATA:
+
+            check_timestamp(notify->recv_data.timestamp, "receive");
+
+            while ((length = evpl_read(evpl, bind, buf, sizeof(buf))) > 0) {
+                state->received += length;
+            }
+
+            if (state->received == NMSGS * MSG_SIZE) {
+                atomic_store(&state->server_done, 1);
+            }
+            break;
+
+        case EVPL_NOTIFY_RECV_MSG:
+
+            check_timestamp(notify->recv_msg.timestamp, "receive");
+
+            if (++state->received == NMSGS) {
+                atomic_store(&state->server_done, 1);
+            }
+            break;
+    } /* switch */
+
+} /* server_callback */
+
+static void
+accept_callback(
+    struct evpl             *evpl,
+    struct evpl_bind        *bind,
+    evpl_notify_callback_t  *notify_callback,
+    evpl_segment_callback_t *segment_callback,
+    void                   **conn_private_data,
+    void                    *private_data)
+{
+    *notify_callback   = server_callback;
+    *conn_private_data = private_data;
+} /* accept_callback */
+
+int
+main(
+    int   argc,
+    char *argv[])
+{
+    pthread_t                  thr;
+    struct evpl               *evpl;
+    struct evpl_endpoint      *me;
+    struct evpl_listener      *listener;
+    struct evpl_global_config *global_config;
+    const char                *proto_name = NULL;
+    int                        rc, opt;
+    struct test_state          state = {
+        .server_done = 0,
+    };
+
+    while ((opt = getopt(argc, argv, "a:p:r:")) != -1) {
+        switch (opt) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                proto_name = optarg;
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-r protocol] [-a address] [-p port]\n",
+                        argv[0]);
+                return 1;
+        } /* switch */
+    }
+
+    global_config = evpl_global_config_init();
+
+    evpl_global_config_set_socket_timestamping(global_config,
+                                               EVPL_TIMESTAMP_RX |
+                                               EVPL_TIMESTAMP_TX);
+
+    evpl_init(global_config);
+
+    /* Looked up only now since a lookup initializes the library */
+    if (proto_name) {
+        rc = evpl_protocol_lookup(&proto, proto_name);
+        if (rc) {
+            fprintf(stderr, "Invalid protocol '%s'\n", proto_name);
+            return 1;
+        }
+    }
+
+    state.stream = evpl_protocol_is_stream(proto);
+
+    evpl = evpl_create(NULL);
+
+    me = evpl_endpoint_create(address, port);
+
+    if (state.stream) {
+        listener = evpl_listener_create();
+
+        evpl_listener_attach(evpl, listener, accept_callback, &state);
+
+        evpl_listen(listener, proto, me);
+    } else {
+        evpl_bind(evpl, proto, me, server_callback, &state);
+    }
+
+    pthread_create(&thr, NULL, client_thread, &state);
+
+    while (!atomic_load(&state.server_done)) {
+        evpl_continue(evpl);
+    }
+
+    pthread_join(thr, NULL);
+
+    evpl_destroy(evpl);
+
+    return 0;
+} /* main */